@@ -0,0 +1,69 @@
+#include "assetsystem.h"
+#include <exception>
+
+using namespace components;
+namespace assetsystem
+{
+
+static uint64_t duration_us(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+AssetSystem::AssetSystem(size_t loader_threads, const std::string& cache_dir)
+    : m_cache(cache_dir.empty() ? nullptr : std::make_unique<MeshCache>(cache_dir)), m_loader(loader_threads)
+{
+}
+
+void AssetSystem::load_visual(Entity e, const std::string& path)
+{
+    PendingVisual pending;
+    pending.path = path;
+    pending.requested = std::chrono::steady_clock::now();
+    pending.result = m_loader.submit([path, requested = pending.requested, cache = m_cache.get()]() {
+        auto start = std::chrono::steady_clock::now();
+        Visual3d visual = cache != nullptr ? cache->load(path) : Visual3d::from_gltf_mapped(path);
+        auto end = std::chrono::steady_clock::now();
+        return LoadResult{std::move(visual), duration_us(requested, start), duration_us(start, end)};
+    });
+    e.add_component(Visual3d::placeholder());
+    e.add_component(std::move(pending));
+}
+
+void AssetSystem::process(Registry& registry, uint64_t elapsed_us)
+{
+    // components cannot be added or removed while iterating, so collect the finished loads first
+    m_finished.clear();
+    m_pending.each(registry, [this](Entity e, PendingVisual& pending) {
+        if (pending.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            m_finished.push_back(e);
+        }
+    });
+
+    for (Entity e : m_finished)
+    {
+        PendingVisual* pending = e.get_component<PendingVisual>();
+        LoadRecord record;
+        record.path = pending->path;
+        const auto requested = pending->requested;
+        std::future<LoadResult> result = std::move(pending->result);
+        e.remove_component<PendingVisual>();
+        try
+        {
+            LoadResult loaded = result.get();
+            record.queue_us = loaded.queue_us;
+            record.load_us = loaded.load_us;
+            e.add_component(std::move(loaded.visual));
+        }
+        catch (const std::exception& ex)
+        {
+            record.failed = true;
+            record.error = ex.what();
+        }
+        record.latency_us = duration_us(requested, std::chrono::steady_clock::now());
+        m_records.push_back(std::move(record));
+    }
+}
+
+} // namespace assetsystem
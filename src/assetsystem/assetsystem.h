@@ -0,0 +1,79 @@
+#pragma once
+#include "entity.h"
+#include "meshcache.h"
+#include "registry.h"
+#include "taskqueue.h"
+#include "view.h"
+#include "visual.h"
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace assetsystem
+{
+
+/**
+ * Timing of one asset load, all in microseconds.
+ */
+struct LoadRecord
+{
+    std::string path;
+    uint64_t queue_us = 0;   // waiting for a loader thread
+    uint64_t load_us = 0;    // parsing and vertex conversion on the loader thread
+    uint64_t latency_us = 0; // from the request until the visual was swapped into the scene
+    bool failed = false;
+    std::string error; // why the load failed, empty otherwise
+};
+
+struct LoadResult
+{
+    components::Visual3d visual;
+    uint64_t queue_us;
+    uint64_t load_us;
+};
+
+/**
+ * Marks an entity whose Visual3d is still the placeholder while its actual geometry loads.
+ */
+struct PendingVisual : public components::Component
+{
+    DEFINE_COMPONENT_ID(PendingVisual);
+    std::string path;
+    std::chrono::steady_clock::time_point requested;
+    std::future<LoadResult> result;
+};
+
+/**
+ * Load visuals on background threads and swap them into the scene once they are ready, so the frame loop never
+ * waits for file parsing.
+ */
+class AssetSystem
+{
+  public:
+    // visuals are baked into cache_dir on first import and read from there afterwards, an empty cache_dir disables it
+    explicit AssetSystem(size_t loader_threads = 1, const std::string& cache_dir = "");
+    /**
+     * Give e a placeholder visual now and replace it by the .gltf or .glb file at path once loaded. A load that fails
+     * keeps the placeholder.
+     */
+    void load_visual(components::Entity e, const std::string& path);
+    // swap finished loads into the scene, never blocks
+    void process(components::Registry& registry, uint64_t elapsed_us);
+    // finished loads in completion order
+    const std::vector<LoadRecord>& load_records() const
+    {
+        return m_records;
+    }
+
+  private:
+    std::unique_ptr<components::MeshCache> m_cache; // before m_loader, which finishes running loads on destruction
+    jobs::TaskQueue m_loader;
+    std::vector<LoadRecord> m_records;
+    std::vector<components::Entity> m_finished;
+    components::View<PendingVisual> m_pending;
+};
+
+} // namespace assetsystem
@@ -0,0 +1,84 @@
+#include "assetsystem.h"
+#include "coordsys.h"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <thread>
+
+using namespace assetsystem;
+using namespace components;
+
+// poll like the frame loop does until no load is pending
+static void process_until_loaded(AssetSystem& assets, Registry& registry)
+{
+    View<PendingVisual> pending;
+    for (int i = 0; i < 10000 && pending.size(registry) > 0; i++)
+    {
+        assets.process(registry, 1000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(pending.size(registry) == 0);
+}
+
+TEST_CASE("AssetSystem shows the placeholder until the load finished")
+{
+    Registry registry;
+    AssetSystem assets(2);
+    Entity e = registry.create(CoordSys());
+    assets.load_visual(e, "does_not_exist.gltf");
+    REQUIRE(e.has_component<PendingVisual>());
+    REQUIRE(e.get_component<Visual3d>()->geometry_id() == Visual3d::placeholder().geometry_id());
+
+    process_until_loaded(assets, registry);
+    // a failed load keeps the placeholder
+    REQUIRE_FALSE(e.has_component<PendingVisual>());
+    REQUIRE(e.get_component<Visual3d>()->geometry_id() == Visual3d::placeholder().geometry_id());
+    REQUIRE(assets.load_records().size() == 1);
+    REQUIRE(assets.load_records()[0].failed);
+    REQUIRE_FALSE(assets.load_records()[0].error.empty());
+    REQUIRE(assets.load_records()[0].path == "does_not_exist.gltf");
+}
+
+TEST_CASE("AssetSystem swaps loaded visuals into the scene")
+{
+    Registry registry;
+    AssetSystem assets(2);
+    std::vector<Entity> entities;
+    for (int i = 0; i < 4; i++)
+    {
+        entities.push_back(registry.create(CoordSys()));
+        assets.load_visual(entities.back(), ASSETS_DIR "/torus_smooth.gltf");
+    }
+    process_until_loaded(assets, registry);
+
+    REQUIRE(assets.load_records().size() == entities.size());
+    for (const LoadRecord& record : assets.load_records())
+    {
+        REQUIRE_FALSE(record.failed);
+        REQUIRE(record.error.empty());
+        REQUIRE(record.latency_us >= record.queue_us + record.load_us);
+    }
+    for (Entity e : entities)
+    {
+        const Visual3d* viz = e.get_component<Visual3d>();
+        REQUIRE(viz->geometry_id() != Visual3d::placeholder().geometry_id());
+        REQUIRE_FALSE(viz->vertices().empty());
+    }
+}
+
+TEST_CASE("AssetSystem loads through the mesh cache")
+{
+    const std::string cache_dir = "assetsystem_test_cache";
+    std::filesystem::remove_all(cache_dir);
+    for (int run = 0; run < 2; run++)
+    {
+        Registry registry;
+        AssetSystem assets(1, cache_dir);
+        Entity e = registry.create(CoordSys());
+        assets.load_visual(e, ASSETS_DIR "/torus_smooth.gltf");
+        process_until_loaded(assets, registry);
+        REQUIRE_FALSE(assets.load_records()[0].failed);
+        REQUIRE(e.get_component<Visual3d>()->indices().size() == 3456);
+    }
+    REQUIRE(std::filesystem::exists(MeshCache(cache_dir).entry_path(ASSETS_DIR "/torus_smooth.gltf")));
+    std::filesystem::remove_all(cache_dir);
+}
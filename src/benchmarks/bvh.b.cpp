@@ -0,0 +1,122 @@
+#include "bvh.h"
+#include "camera.h"
+#include "culling.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace spatial;
+
+// unit boxes spread so the density stays the same for every object count, less than a tenth end up in the frustum
+static std::vector<Aabb> make_scene(size_t count)
+{
+    std::mt19937 rng(1);
+    const float half_size = 150.0f * std::cbrt(count / 100'000.0f);
+    std::uniform_real_distribution<float> position(-half_size, half_size);
+    std::vector<Aabb> boxes(count);
+    for (Aabb& box : boxes)
+    {
+        box.min = glm::vec3(position(rng), position(rng), position(rng));
+        box.max = box.min + glm::vec3(1.0f);
+    }
+    return boxes;
+}
+
+TEST_CASE("Bvh build, refit and queries", "[bvh]")
+{
+    for (size_t count : {10'000, 100'000, 1'000'000})
+    {
+        const std::string n = std::to_string(count / 1000) + "k";
+        const std::vector<Aabb> boxes = make_scene(count);
+        std::vector<uint32_t> user_data(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            user_data[i] = i;
+        }
+        std::vector<uint32_t> leaves;
+        Bvh bvh;
+        bvh.build(boxes, user_data, &leaves);
+
+        components::Camera camera(4 / 3.0f, 60.0f);
+        const rendersystem::Frustum frustum =
+            rendersystem::frustum_from_matrix(camera.projection_mat() * camera.view_mat());
+        size_t visible = 0;
+        bvh.query(frustum.planes, 6, [&visible](uint32_t) { visible++; });
+        INFO(n << " objects, height " << bvh.height() << ", " << visible << " in the frustum");
+        REQUIRE(visible > 0);
+
+        BENCHMARK("top-down build, " + n)
+        {
+            bvh.build(boxes, user_data, &leaves);
+            return bvh.size();
+        };
+        if (count <= 100'000)
+        {
+            BENCHMARK("incremental inserts, " + n)
+            {
+                Bvh inserted;
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    inserted.insert(boxes[i], i);
+                }
+                return inserted.size();
+            };
+        }
+        // a tenth of the objects move every frame, back and forth so the tree does not degrade
+        float direction = 1.0f;
+        BENCHMARK("refit 10% moved, " + n)
+        {
+            direction = -direction;
+            const glm::vec3 delta(0.25f * direction, 0.0f, 0.0f);
+            for (uint32_t i = 0; i < count; i += 10)
+            {
+                const Aabb& box = bvh.bounds(leaves[i]);
+                bvh.refit(leaves[i], Aabb{box.min + delta, box.max + delta});
+            }
+            return direction;
+        };
+        BENCHMARK("rebuild, " + n)
+        {
+            bvh.rebuild();
+            return bvh.height();
+        };
+        BENCHMARK("frustum query, " + n)
+        {
+            size_t hits = 0;
+            bvh.query(frustum.planes, 6, [&hits](uint32_t) { hits++; });
+            return hits;
+        };
+        // what a query costs without the tree
+        BENCHMARK("frustum test of every box, " + n)
+        {
+            size_t hits = 0;
+            for (const Aabb& box : boxes)
+            {
+                bool inside = true;
+                for (const glm::vec4& p : frustum.planes)
+                {
+                    const glm::vec3 normal(p);
+                    inside &= glm::dot(normal, box.center()) + p.w >= -glm::dot(glm::abs(normal), box.extent());
+                }
+                hits += inside ? 1 : 0;
+            }
+            return hits;
+        };
+        BENCHMARK("closest ray hit, " + n)
+        {
+            float closest = 1000.0f;
+            bvh.raycast(glm::vec3(0.5f), glm::normalize(glm::vec3(1, 0.3f, 0.2f)), closest,
+                        [&closest](uint32_t, float t) { return closest = t; });
+            return closest;
+        };
+        BENCHMARK("box query, " + n)
+        {
+            size_t hits = 0;
+            bvh.query(Aabb{glm::vec3(-10.0f), glm::vec3(10.0f)}, [&hits](uint32_t) { hits++; });
+            return hits;
+        };
+    }
+}
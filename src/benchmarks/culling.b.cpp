@@ -0,0 +1,57 @@
+#include "camera.h"
+#include "coordsys.h"
+#include "culling.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+using namespace rendersystem;
+using namespace components;
+
+TEST_CASE("Frustum culling of 100k objects", "[culling]")
+{
+    const size_t kObjectCount = 100'000;
+
+    // objects scattered around the camera, less than a tenth end up in the field of view
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+    std::vector<CoordSys> coords(kObjectCount);
+    for (CoordSys& coord : coords)
+    {
+        coord.position() = glm::vec3(position(rng), position(rng), position(rng));
+    }
+    const float radius = 1.0f;
+
+    Camera camera(4 / 3.0f, 60.0f);
+    const Frustum frustum = frustum_from_matrix(camera.projection_mat() * camera.view_mat());
+    BoundingSpheres spheres;
+    for (const CoordSys& coord : coords)
+    {
+        spheres.push_back(coord.position(), radius);
+    }
+    std::vector<uint8_t> visible(kObjectCount);
+    const CullingStats stats = spheres.cull(frustum, visible.data());
+    INFO(stats.visible << " visible, " << stats.culled << " culled");
+    REQUIRE(stats.visible > 0);
+    REQUIRE(stats.culled > 0);
+
+    BENCHMARK("scalar, 100k spheres")
+    {
+        return spheres.cull_scalar(frustum, visible.data());
+    };
+    BENCHMARK("vectorized, 100k spheres")
+    {
+        return spheres.cull(frustum, visible.data());
+    };
+    // what RenderSystem::process does per frame: gather the world-space bounds, then cull
+    BENCHMARK("gather and vectorized, 100k spheres")
+    {
+        spheres.clear();
+        for (const CoordSys& coord : coords)
+        {
+            spheres.push_back(coord.position(), radius);
+        }
+        return spheres.cull(frustum, visible.data());
+    };
+}
@@ -0,0 +1,95 @@
+#include "coordsys.h"
+#include "registry.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <unordered_map>
+
+using namespace components;
+
+namespace
+{
+/**
+ * The former map-based entity, kept as baseline: one heap allocated component per entry and a hash lookup per
+ * access.
+ */
+class MapEntity
+{
+  public:
+    template <typename T> void add_component(std::shared_ptr<T> cmp)
+    {
+        m_components[T::id()] = cmp;
+    }
+    template <typename T> std::shared_ptr<T> get_component() const
+    {
+        auto it = m_components.find(T::id());
+        if (it != m_components.end())
+        {
+            return std::static_pointer_cast<T>(it->second);
+        }
+        return std::shared_ptr<T>();
+    }
+
+  private:
+    std::unordered_map<uint32_t, std::shared_ptr<Component>> m_components;
+};
+
+struct Tag : public Component
+{
+    DEFINE_COMPONENT_ID(Tag)
+};
+} // namespace
+
+TEST_CASE("Entity component iteration", "[entity]")
+{
+    const size_t kEntityCount = 50'000;
+
+    std::vector<MapEntity> map_entities(kEntityCount);
+    Registry registry;
+    std::vector<Entity> handles;
+    handles.reserve(kEntityCount);
+    for (size_t i = 0; i < kEntityCount; i++)
+    {
+        auto coords = std::make_shared<CoordSys>();
+        coords->position().x = (float)i;
+        map_entities[i].add_component(coords);
+        map_entities[i].add_component(std::make_shared<Tag>());
+
+        CoordSys c;
+        c.position().x = (float)i;
+        handles.push_back(registry.create(c, Tag()));
+    }
+
+    BENCHMARK("map entity, copy per iteration")
+    {
+        float sum = 0;
+        for (auto e : map_entities)
+        {
+            sum += e.get_component<CoordSys>()->position().x;
+        }
+        return sum;
+    };
+    BENCHMARK("map entity, by reference")
+    {
+        float sum = 0;
+        for (auto& e : map_entities)
+        {
+            sum += e.get_component<CoordSys>()->position().x;
+        }
+        return sum;
+    };
+    BENCHMARK("registry, entity handles")
+    {
+        float sum = 0;
+        for (auto e : handles)
+        {
+            sum += e.get_component<CoordSys>()->position().x;
+        }
+        return sum;
+    };
+    BENCHMARK("registry, query")
+    {
+        float sum = 0;
+        registry.query<CoordSys>([&sum](Entity, CoordSys& c) { sum += c.position().x; });
+        return sum;
+    };
+}
@@ -0,0 +1,39 @@
+#include "gridfiles.h"
+#include "visual.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using namespace benchmarks;
+using namespace components;
+
+TEST_CASE("gltf loading")
+{
+    for (uint32_t n : {64, 512})
+    {
+        GridFiles files(n);
+        const std::string size = std::to_string(n * n) + " vertices";
+        REQUIRE(Visual3d::from_gltf_mapped(files.glb()).indices().size() == files.index_count());
+
+        BENCHMARK("tinygltf, base64 .gltf, " + size)
+        {
+            return Visual3d::from_gltf_file(files.embedded());
+        };
+        BENCHMARK("tinygltf, .glb, " + size)
+        {
+            return Visual3d::from_gltf_file(files.glb());
+        };
+        BENCHMARK("mmap, base64 .gltf, " + size)
+        {
+            return Visual3d::from_gltf_mapped(files.embedded());
+        };
+        BENCHMARK("mmap, external .bin, " + size)
+        {
+            return Visual3d::from_gltf_mapped(files.external());
+        };
+        BENCHMARK("mmap, .glb, " + size)
+        {
+            return Visual3d::from_gltf_mapped(files.glb());
+        };
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+/**
+ * Grid of n x n vertices with separate position, normal and uv views, written as embedded base64 .gltf, as .gltf
+ * with an external .bin and as .glb.
+ */
+class GridFiles
+{
+  public:
+    explicit GridFiles(uint32_t n) : m_prefix("gltf_benchmark_" + std::to_string(n))
+    {
+        const size_t vertex_count = (size_t)n * n;
+        std::vector<float> positions, normals, uvs;
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y < n; y++)
+        {
+            for (uint32_t x = 0; x < n; x++)
+            {
+                positions.insert(positions.end(), {(float)x, 0.0f, (float)y});
+                normals.insert(normals.end(), {0.0f, 1.0f, 0.0f});
+                uvs.insert(uvs.end(), {x / (float)(n - 1), y / (float)(n - 1)});
+                if (x + 1 < n && y + 1 < n)
+                {
+                    const uint32_t i = y * n + x;
+                    indices.insert(indices.end(), {i, i + n, i + 1, i + 1, i + n, i + n + 1});
+                }
+            }
+        }
+        m_index_count = indices.size();
+        std::vector<unsigned char> bin;
+        auto append = [&bin](const void* data, size_t size) {
+            bin.insert(bin.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+        };
+        append(positions.data(), positions.size() * sizeof(float));
+        append(normals.data(), normals.size() * sizeof(float));
+        append(uvs.data(), uvs.size() * sizeof(float));
+        append(indices.data(), indices.size() * sizeof(uint32_t));
+
+        const size_t vec3_bytes = vertex_count * 12;
+        const size_t vec2_bytes = vertex_count * 8;
+        auto json = [&](const std::string& buffer_uri) {
+            std::string uri = buffer_uri.empty() ? "" : ", \"uri\": \"" + buffer_uri + "\"";
+            return "{\"asset\": {\"version\": \"2.0\"}, \"meshes\": [{\"primitives\": [{\"attributes\": "
+                   "{\"POSITION\": 0, \"NORMAL\": 1, \"TEXCOORD_0\": 2}, \"indices\": 3}]}],"
+                   "\"accessors\": ["
+                   "{\"bufferView\": 0, \"componentType\": 5126, \"count\": " +
+                   std::to_string(vertex_count) +
+                   ", \"type\": \"VEC3\"},"
+                   "{\"bufferView\": 1, \"componentType\": 5126, \"count\": " +
+                   std::to_string(vertex_count) +
+                   ", \"type\": \"VEC3\"},"
+                   "{\"bufferView\": 2, \"componentType\": 5126, \"count\": " +
+                   std::to_string(vertex_count) +
+                   ", \"type\": \"VEC2\"},"
+                   "{\"bufferView\": 3, \"componentType\": 5125, \"count\": " +
+                   std::to_string(m_index_count) +
+                   ", \"type\": \"SCALAR\"}],"
+                   "\"bufferViews\": [" +
+                   view(0, vec3_bytes) + "," + view(vec3_bytes, vec3_bytes) + "," + view(2 * vec3_bytes, vec2_bytes) +
+                   "," + view(2 * vec3_bytes + vec2_bytes, m_index_count * 4) + "]," +
+                   "\"buffers\": [{\"byteLength\": " + std::to_string(bin.size()) + uri + "}]}";
+        };
+
+        std::ofstream(embedded(), std::ios::binary) << json("data:application/octet-stream;base64," + base64(bin));
+        std::ofstream(m_prefix + ".bin", std::ios::binary).write((const char*)bin.data(), bin.size());
+        std::ofstream(external(), std::ios::binary) << json(m_prefix + ".bin");
+
+        std::string glb_json = json("");
+        glb_json.resize((glb_json.size() + 3) / 4 * 4, ' ');
+        const uint32_t header[] = {0x46546C67, 2, (uint32_t)(12 + 8 + glb_json.size() + 8 + bin.size())};
+        const uint32_t json_chunk[] = {(uint32_t)glb_json.size(), 0x4E4F534A};
+        const uint32_t bin_chunk[] = {(uint32_t)bin.size(), 0x004E4942};
+        std::ofstream out(glb(), std::ios::binary);
+        out.write((const char*)header, sizeof(header));
+        out.write((const char*)json_chunk, sizeof(json_chunk));
+        out.write(glb_json.data(), glb_json.size());
+        out.write((const char*)bin_chunk, sizeof(bin_chunk));
+        out.write((const char*)bin.data(), bin.size());
+    }
+    ~GridFiles()
+    {
+        std::remove(embedded().c_str());
+        std::remove(external().c_str());
+        std::remove((m_prefix + ".bin").c_str());
+        std::remove(glb().c_str());
+    }
+    std::string embedded() const
+    {
+        return m_prefix + "_embedded.gltf";
+    }
+    std::string external() const
+    {
+        return m_prefix + ".gltf";
+    }
+    std::string glb() const
+    {
+        return m_prefix + ".glb";
+    }
+    size_t index_count() const
+    {
+        return m_index_count;
+    }
+
+  private:
+    static std::string view(size_t offset, size_t length)
+    {
+        return "{\"buffer\": 0, \"byteOffset\": " + std::to_string(offset) +
+               ", \"byteLength\": " + std::to_string(length) + "}";
+    }
+    static std::string base64(const std::vector<unsigned char>& data)
+    {
+        static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        out.reserve((data.size() + 2) / 3 * 4);
+        for (size_t i = 0; i < data.size(); i += 3)
+        {
+            uint32_t bits = data[i] << 16;
+            bits |= i + 1 < data.size() ? data[i + 1] << 8 : 0;
+            bits |= i + 2 < data.size() ? data[i + 2] : 0;
+            out += alphabet[(bits >> 18) & 63];
+            out += alphabet[(bits >> 12) & 63];
+            out += i + 1 < data.size() ? alphabet[(bits >> 6) & 63] : '=';
+            out += i + 2 < data.size() ? alphabet[bits & 63] : '=';
+        }
+        return out;
+    }
+
+  private:
+    std::string m_prefix;
+    size_t m_index_count;
+};
+} // namespace benchmarks
@@ -0,0 +1,57 @@
+#include "camera.h"
+#include "coordsys.h"
+#include "headlessdevice.h"
+#include "registry.h"
+#include "rendersystem.h"
+#include "visual.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using namespace rendersystem;
+using namespace components;
+
+// Thumbnail rendering: how much the readback of each frame costs, and how much of it the frames in flight hide
+TEST_CASE("Headless frames with and without readback", "[headless]")
+{
+    const int kTriangles = 1'000;
+    const uint32_t kWidth = 256;
+    const uint32_t kHeight = 256;
+
+    for (uint32_t frames_in_flight : {1u, 2u})
+    {
+        RenderSettings settings;
+        settings.frames_in_flight = frames_in_flight;
+        settings.pipeline_cache_path = "";
+        RenderSystem rs(settings);
+        if (!create_headless_device([&] { rs.create_headless(kWidth, kHeight); }))
+        {
+            return;
+        }
+        Registry registry;
+        for (int i = 0; i < kTriangles; i++)
+        {
+            CoordSys coord;
+            coord.position() = glm::vec3((i % 40) * 0.1f - 2.0f, (i / 40) * 0.1f - 1.2f, 0.0f);
+            registry.create(coord, Visual3d::make_triangle());
+        }
+        Camera cam(1.0f, 60.0f);
+        cam.position() = glm::vec3(0, 0, -4);
+        registry.create(cam);
+        render_until_uploaded(rs, registry);
+
+        const std::string name = std::to_string(frames_in_flight) + " frame(s) in flight";
+        uint64_t checksum = 0;
+        BENCHMARK("frame, " + name + ", no readback")
+        {
+            rs.process(registry, 0);
+        };
+        rs.set_readback([&](const ReadbackImage& image) { checksum += image.pixels[image.row_pitch * kHeight / 2]; });
+        BENCHMARK("frame, " + name + ", readback")
+        {
+            rs.process(registry, 0);
+            return checksum;
+        };
+        rs.destroy();
+    }
+}
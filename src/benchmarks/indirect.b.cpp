@@ -0,0 +1,125 @@
+#include "camerauniforms.h"
+#include "coordsys.h"
+#include "core.h"
+#include "descriptors.h"
+#include "headlessdevice.h"
+#include "hostbuffer.h"
+#include "instances.h"
+#include "pass.h"
+#include "pipeline.h"
+#include "pipelineregistry.h"
+#include "recording.h"
+#include "rendersystem.h"
+#include "threadpool.h"
+#include "visual.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using namespace rendersystem;
+using namespace components;
+
+TEST_CASE("Indirect against direct drawing", "[indirect]")
+{
+    const uint32_t kMeshCount = 2'000;
+    const uint32_t kInstancesPerMesh = 5;
+
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("indirect_benchmark", 1024, 768); }))
+    {
+        return;
+    }
+    if (!core.draw_indirect_first_instance)
+    {
+        WARN("skipping, the device does not support drawIndirectFirstInstance");
+        destroy_core(&core);
+        return;
+    }
+    SwapChainData offscreen = {};
+    offscreen.swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
+    offscreen.depth_image_format = VK_FORMAT_D32_SFLOAT;
+    PassData pass = create_basic_pass(core, offscreen);
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+    PipelineRegistry pipelines(0);
+    pipelines.create(core.device, VK_NULL_HANDLE);
+    MeshPipelineData pipeline =
+        create_mesh_pipeline(core.device, pass.render_pass, core.window_size, &layouts, &pipelines);
+
+    // distinct meshes, so every mesh is one instance batch
+    GeometryArena geometry;
+    geometry.create(core, kMeshCount * 3, kMeshCount * 3);
+    UploadManager uploads;
+    uploads.create(core, 1 << 20);
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    std::vector<InstanceBatch> batches;
+    for (uint32_t i = 0; i < kMeshCount; i++)
+    {
+        Visual3d triangle = Visual3d::make_triangle();
+        triangle.vertices()[0].position.z = (float)i;
+        meshes.push_back(create_mesh_from_vertex_data(triangle.vertices(), triangle.indices()));
+        meshes.back()->create(geometry, uploads);
+        batches.push_back(InstanceBatch{meshes.back().get(), i * kInstancesPerMesh, kInstancesPerMesh});
+    }
+    uploads.wait(meshes.back()->upload_batch());
+
+    const uint32_t instance_count = kMeshCount * kInstancesPerMesh;
+    HostBufferData instances =
+        create_host_buffer(core, instance_count * sizeof(InstanceAttributes), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    auto* models = (InstanceAttributes*)instances.data;
+    for (uint32_t i = 0; i < instance_count; i++)
+    {
+        models[i].model = glm::mat4(1.0f);
+    }
+    HostBufferData commands = create_host_buffer(core, kMeshCount * sizeof(VkDrawIndexedIndirectCommand),
+                                                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+    HostBufferData camera = create_host_buffer(core, sizeof(CameraUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    *(CameraUniforms*)camera.data = make_camera_uniforms(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f));
+    DescriptorAllocator descriptors;
+    descriptors.create(core.device);
+    DrawState state = {};
+    state.render_pass = pass.render_pass;
+    state.framebuffer = VK_NULL_HANDLE;
+    state.pipeline = pipeline.pipeline;
+    state.pipeline_layout = pipeline.pipeline_layout;
+    state.vertex_buffer = geometry.vertex_buffer();
+    state.index_buffer = geometry.index_buffer();
+    state.frame_set = write_mesh_set(core.device, &descriptors, pipeline, camera.buffer, instances.buffer);
+
+    const std::string draws = std::to_string(kMeshCount) + " draws";
+    jobs::ThreadPool pool(0);
+    RecordingData recording = create_recording(core, (uint32_t)pool.size());
+    BENCHMARK("direct, " + draws + ", " + std::to_string(pool.size()) + " threads")
+    {
+        return record_draws(core.device, &recording, pool, state, batches);
+    };
+    jobs::ThreadPool single(1);
+    BENCHMARK("direct, " + draws + ", 1 thread")
+    {
+        return record_draws(core.device, &recording, single, state, batches);
+    };
+    BENCHMARK("indirect, " + draws + (core.multi_draw_indirect ? ", multi draw" : ", one call per draw"))
+    {
+        write_draw_commands(batches, (VkDrawIndexedIndirectCommand*)commands.data);
+        return record_indirect_draws(core.device, &recording, state, commands.buffer, kMeshCount,
+                                     core.multi_draw_indirect);
+    };
+    destroy_recording(core.device, &recording);
+
+    destroy_host_buffer(&commands);
+    destroy_host_buffer(&instances);
+    for (auto& mesh : meshes)
+    {
+        mesh->destroy(geometry);
+    }
+    uploads.destroy();
+    geometry.destroy();
+    descriptors.destroy();
+    destroy_host_buffer(&camera);
+    pipelines.destroy();
+    destroy_mesh_pipeline(core.device, &pipeline);
+    layouts.destroy();
+    destroy_pass(core.device, &pass);
+    destroy_core(&core);
+}
@@ -0,0 +1,109 @@
+#include "camerauniforms.h"
+#include "coordsys.h"
+#include "core.h"
+#include "descriptors.h"
+#include "headlessdevice.h"
+#include "hostbuffer.h"
+#include "instances.h"
+#include "pass.h"
+#include "pipeline.h"
+#include "pipelineregistry.h"
+#include "recording.h"
+#include "rendersystem.h"
+#include "threadpool.h"
+#include "visual.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <iostream>
+
+using namespace rendersystem;
+using namespace components;
+
+TEST_CASE("Instanced drawing of entities sharing a mesh", "[instancing]")
+{
+    const uint32_t kInstanceCount = 10'000;
+
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("instancing_benchmark", 1024, 768); }))
+    {
+        return;
+    }
+    SwapChainData offscreen = {};
+    offscreen.swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
+    offscreen.depth_image_format = VK_FORMAT_D32_SFLOAT;
+    PassData pass = create_basic_pass(core, offscreen);
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+    PipelineRegistry pipelines(0);
+    pipelines.create(core.device, VK_NULL_HANDLE);
+    MeshPipelineData pipeline =
+        create_mesh_pipeline(core.device, pass.render_pass, core.window_size, &layouts, &pipelines);
+
+    Visual3d torus = Visual3d::from_gltf_mapped(ASSETS_DIR "/torus_smooth.gltf");
+    GeometryArena geometry;
+    geometry.create(core, (uint32_t)torus.vertices().size(), (uint32_t)torus.indices().size());
+    UploadManager uploads;
+    uploads.create(core, 4 << 20);
+    auto mesh = create_mesh_from_visual(torus, geometry, uploads);
+    uploads.wait(mesh->upload_batch());
+
+    std::vector<CoordSys> coords(kInstanceCount);
+    std::vector<DrawItem> items;
+    for (uint32_t i = 0; i < kInstanceCount; i++)
+    {
+        coords[i].position() = glm::vec3((float)(i % 100), (float)(i / 100), 0.0f);
+        items.push_back(DrawItem{&coords[i], mesh.get()});
+    }
+    HostBufferData instances =
+        create_host_buffer(core, kInstanceCount * sizeof(InstanceAttributes), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    auto* models = (InstanceAttributes*)instances.data;
+    // the path before instancing: one draw per entity
+    std::vector<InstanceBatch> per_entity;
+    for (uint32_t i = 0; i < kInstanceCount; i++)
+    {
+        models[i].model = coords[i].transform();
+        per_entity.push_back(InstanceBatch{mesh.get(), i, 1});
+    }
+    InstanceBatcher batcher;
+    const size_t instanced_draws = batcher.build(items, models).size();
+    REQUIRE(instanced_draws == 1);
+    std::cout << kInstanceCount << " tori: " << per_entity.size() << " draw calls per entity, " << instanced_draws
+              << " instanced" << std::endl;
+
+    HostBufferData camera = create_host_buffer(core, sizeof(CameraUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    *(CameraUniforms*)camera.data = make_camera_uniforms(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f));
+    DescriptorAllocator descriptors;
+    descriptors.create(core.device);
+    DrawState state = {};
+    state.render_pass = pass.render_pass;
+    state.framebuffer = VK_NULL_HANDLE;
+    state.pipeline = pipeline.pipeline;
+    state.pipeline_layout = pipeline.pipeline_layout;
+    state.vertex_buffer = geometry.vertex_buffer();
+    state.index_buffer = geometry.index_buffer();
+    state.frame_set = write_mesh_set(core.device, &descriptors, pipeline, camera.buffer, instances.buffer);
+
+    jobs::ThreadPool pool(0);
+    RecordingData recording = create_recording(core, (uint32_t)pool.size());
+    BENCHMARK("record " + std::to_string(kInstanceCount) + " draws, one per entity")
+    {
+        return record_draws(core.device, &recording, pool, state, per_entity);
+    };
+    BENCHMARK("batch and record " + std::to_string(kInstanceCount) + " instances")
+    {
+        return record_draws(core.device, &recording, pool, state, batcher.build(items, models));
+    };
+    destroy_recording(core.device, &recording);
+
+    destroy_host_buffer(&instances);
+    mesh->destroy(geometry);
+    uploads.destroy();
+    geometry.destroy();
+    descriptors.destroy();
+    destroy_host_buffer(&camera);
+    pipelines.destroy();
+    destroy_mesh_pipeline(core.device, &pipeline);
+    layouts.destroy();
+    destroy_pass(core.device, &pass);
+    destroy_core(&core);
+}
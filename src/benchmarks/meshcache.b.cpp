@@ -0,0 +1,39 @@
+#include "gridfiles.h"
+#include "meshcache.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <string>
+
+using namespace benchmarks;
+using namespace components;
+
+TEST_CASE("mesh cache startup")
+{
+    const std::string cache_dir = "meshcache_benchmark";
+    for (uint32_t n : {64, 512})
+    {
+        GridFiles files(n);
+        const std::string size = std::to_string(n * n) + " vertices";
+        MeshCache cache(cache_dir);
+        bool hit = false;
+        cache.load(files.glb(), &hit);
+        REQUIRE_FALSE(hit);
+
+        BENCHMARK("cold import, base64 .gltf, " + size)
+        {
+            return Visual3d::from_gltf_mapped(files.embedded());
+        };
+        BENCHMARK("cold import, .glb, " + size)
+        {
+            return Visual3d::from_gltf_mapped(files.glb());
+        };
+        BENCHMARK("cached load, " + size)
+        {
+            return cache.load(files.glb());
+        };
+        cache.load(files.glb(), &hit);
+        REQUIRE(hit);
+    }
+    std::filesystem::remove_all(cache_dir);
+}
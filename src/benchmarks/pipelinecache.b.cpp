@@ -0,0 +1,74 @@
+#include "core.h"
+#include "descriptors.h"
+#include "gpuculling.h"
+#include "headlessdevice.h"
+#include "pass.h"
+#include "pipeline.h"
+#include "pipelinecache.h"
+#include "pipelineregistry.h"
+#include "swapchain.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+
+using namespace rendersystem;
+
+// Drivers with their own shader cache on disk (e.g. Mesa) make the cold case look warm, disable it for a fair
+// comparison: MESA_SHADER_CACHE_DISABLE=true
+TEST_CASE("Pipeline creation with a cold and a warm pipeline cache", "[pipelinecache]")
+{
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("pipelinecache_benchmark", 1024, 768); }))
+    {
+        return;
+    }
+    SwapChainData offscreen = {};
+    offscreen.swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
+    offscreen.depth_image_format = VK_FORMAT_D32_SFLOAT;
+    PassData pass = create_basic_pass(core, offscreen);
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+
+    // the pipelines RenderSystem::create builds
+    auto create_pipelines = [&](VkPipelineCache cache) {
+        PipelineRegistry pipelines(0);
+        pipelines.create(core.device, cache);
+        MeshPipelineData mesh =
+            create_mesh_pipeline(core.device, pass.render_pass, core.window_size, &layouts, &pipelines);
+        CullPipelineData cull = create_cull_pipeline(core.device, &layouts, cache);
+        destroy_cull_pipeline(core.device, &cull);
+        pipelines.destroy();
+        destroy_mesh_pipeline(core.device, &mesh);
+    };
+    BENCHMARK("mesh and cull pipelines, no cache")
+    {
+        create_pipelines(VK_NULL_HANDLE);
+    };
+    // a new cache every time, as on the first start
+    BENCHMARK("mesh and cull pipelines, cold cache")
+    {
+        PipelineCacheData pc = create_pipeline_cache(core, "");
+        create_pipelines(pc.cache);
+        destroy_pipeline_cache(core.device, &pc);
+    };
+
+    const std::string path = (std::filesystem::temp_directory_path() / "pipelinecache_benchmark.bin").string();
+    PipelineCacheData pc = create_pipeline_cache(core, path);
+    create_pipelines(pc.cache);
+    save_pipeline_cache(core, pc);
+    destroy_pipeline_cache(core.device, &pc);
+    // loading the file is part of every later start, so it is measured as well
+    BENCHMARK("mesh and cull pipelines, warm cache from file")
+    {
+        PipelineCacheData warm = create_pipeline_cache(core, path);
+        create_pipelines(warm.cache);
+        const bool was_warm = warm.warm;
+        destroy_pipeline_cache(core.device, &warm);
+        return was_warm;
+    };
+    std::filesystem::remove(path);
+
+    layouts.destroy();
+    destroy_pass(core.device, &pass);
+    destroy_core(&core);
+}
@@ -0,0 +1,101 @@
+#include "camerauniforms.h"
+#include "coordsys.h"
+#include "core.h"
+#include "descriptors.h"
+#include "headlessdevice.h"
+#include "hostbuffer.h"
+#include "instances.h"
+#include "pass.h"
+#include "pipeline.h"
+#include "pipelineregistry.h"
+#include "recording.h"
+#include "rendersystem.h"
+#include "threadpool.h"
+#include "visual.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+
+using namespace rendersystem;
+using namespace components;
+
+TEST_CASE("Parallel command buffer recording", "[recording]")
+{
+    const size_t kDrawCount = 20'000;
+
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("recording_benchmark", 1024, 768); }))
+    {
+        return;
+    }
+    // only formats are needed to create the render pass, secondary buffers are recorded without framebuffer
+    SwapChainData offscreen = {};
+    offscreen.swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
+    offscreen.depth_image_format = VK_FORMAT_D32_SFLOAT;
+    PassData pass = create_basic_pass(core, offscreen);
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+    PipelineRegistry pipelines(0);
+    pipelines.create(core.device, VK_NULL_HANDLE);
+    MeshPipelineData pipeline =
+        create_mesh_pipeline(core.device, pass.render_pass, core.window_size, &layouts, &pipelines);
+
+    Visual3d triangle = Visual3d::make_triangle();
+    GeometryArena geometry;
+    geometry.create(core, 1024, 1024);
+    UploadManager uploads;
+    uploads.create(core, 1 << 16);
+    auto mesh = create_mesh_from_vertex_data(triangle.vertices(), triangle.indices());
+    mesh->create(geometry, uploads);
+    uploads.wait(mesh->upload_batch());
+
+    // one draw per instance, so every draw is recorded individually
+    HostBufferData instances =
+        create_host_buffer(core, kDrawCount * sizeof(InstanceAttributes), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    auto* models = (InstanceAttributes*)instances.data;
+    std::vector<InstanceBatch> batches;
+    for (uint32_t i = 0; i < kDrawCount; i++)
+    {
+        CoordSys coord;
+        coord.position() = glm::vec3((float)(i % 100), (float)(i / 100), 0.0f);
+        models[i].model = coord.transform();
+        batches.push_back(InstanceBatch{mesh.get(), i, 1});
+    }
+    HostBufferData camera = create_host_buffer(core, sizeof(CameraUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    *(CameraUniforms*)camera.data = make_camera_uniforms(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f));
+    DescriptorAllocator descriptors;
+    descriptors.create(core.device);
+    DrawState state = {};
+    state.render_pass = pass.render_pass;
+    state.framebuffer = VK_NULL_HANDLE;
+    state.pipeline = pipeline.pipeline;
+    state.pipeline_layout = pipeline.pipeline_layout;
+    state.vertex_buffer = geometry.vertex_buffer();
+    state.index_buffer = geometry.index_buffer();
+    state.frame_set = write_mesh_set(core.device, &descriptors, pipeline, camera.buffer, instances.buffer);
+
+    const uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        jobs::ThreadPool pool(threads);
+        RecordingData recording = create_recording(core, threads);
+        BENCHMARK("record " + std::to_string(kDrawCount) + " draws, " + std::to_string(threads) + " threads")
+        {
+            return record_draws(core.device, &recording, pool, state, batches);
+        };
+        destroy_recording(core.device, &recording);
+    }
+
+    destroy_host_buffer(&instances);
+    mesh->destroy(geometry);
+    uploads.destroy();
+    geometry.destroy();
+    descriptors.destroy();
+    destroy_host_buffer(&camera);
+    pipelines.destroy();
+    destroy_mesh_pipeline(core.device, &pipeline);
+    layouts.destroy();
+    destroy_pass(core.device, &pass);
+    destroy_core(&core);
+}
@@ -0,0 +1,141 @@
+#include "culling.h"
+#include "gridfiles.h"
+#include "headlessdevice.h"
+#include "rendersystem.h"
+#include "syntheticscene.h"
+#include "view.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+using namespace benchmarks;
+using namespace scenes;
+using namespace components;
+using namespace rendersystem;
+
+// The [scene] benchmarks run against a generated scene, sized with BENCHMARK_SCENE, see syntheticscene.h.
+// The benchmark_results target runs all benchmarks and writes benchmark_results.json.
+
+TEST_CASE("Scene: entity component lookup", "[scene]")
+{
+    SyntheticScene scene(scene_config());
+    Registry& registry = scene.registry();
+    const std::string size = ", " + scene.config().name;
+    std::vector<Entity> handles;
+    registry.query<CoordSys>([&handles](Entity e, CoordSys&) { handles.push_back(e); });
+    REQUIRE(handles.size() == scene.config().entities);
+
+    BENCHMARK("entity handles, get_component" + size)
+    {
+        float sum = 0;
+        for (Entity e : handles)
+        {
+            sum += e.get_component<CoordSys>()->position().x;
+        }
+        return sum;
+    };
+    BENCHMARK("Registry::query, two components" + size)
+    {
+        float sum = 0;
+        registry.query<CoordSys, Visual3d>([&sum](Entity, CoordSys& c, Visual3d&) { sum += c.position().x; });
+        return sum;
+    };
+    View<CoordSys, Visual3d> drawables;
+    BENCHMARK("View::each, two components" + size)
+    {
+        float sum = 0;
+        drawables.each(registry, [&sum](Entity, CoordSys& c, Visual3d&) { sum += c.position().x; });
+        return sum;
+    };
+}
+
+TEST_CASE("Scene: CoordSys::transform", "[scene]")
+{
+    SyntheticScene scene(scene_config());
+    std::vector<glm::mat4> models(scene.config().entities);
+    BENCHMARK("CoordSys::transform of every entity, " + scene.config().name)
+    {
+        size_t i = 0;
+        scene.registry().query<CoordSys>([&](Entity, CoordSys& c) { models[i++] = c.transform(); });
+        return models.back()[3][0];
+    };
+}
+
+TEST_CASE("Scene: glTF import", "[scene]")
+{
+    const SceneConfig config = scene_config();
+    GridFiles files(config.gltf_grid);
+    const std::string size = ", " + std::to_string(config.gltf_grid * config.gltf_grid) + " vertices";
+    REQUIRE(Visual3d::from_gltf_file(files.glb()).indices().size() == files.index_count());
+
+    BENCHMARK("Visual3d::from_gltf_file, .glb" + size)
+    {
+        return Visual3d::from_gltf_file(files.glb());
+    };
+    BENCHMARK("Visual3d::from_gltf_file, base64 .gltf" + size)
+    {
+        return Visual3d::from_gltf_file(files.embedded());
+    };
+}
+
+TEST_CASE("Scene: create_mesh_from_vertex_data", "[scene]")
+{
+    SyntheticScene scene(scene_config());
+    BENCHMARK("create_mesh_from_vertex_data of every mesh, " + std::to_string(scene.meshes().size()) + " meshes")
+    {
+        size_t vertices = 0;
+        for (const Visual3d& viz : scene.meshes())
+        {
+            vertices += create_mesh_from_vertex_data(viz.vertices(), viz.indices())->vertices().size();
+        }
+        return vertices;
+    };
+}
+
+TEST_CASE("Scene: frustum culling", "[scene]")
+{
+    SyntheticScene scene(scene_config());
+    Camera camera(4 / 3.0f, 60.0f);
+    const Frustum frustum = frustum_from_matrix(camera.projection_mat() * camera.view_mat());
+    BoundingSpheres spheres;
+    std::vector<uint8_t> visible(scene.config().entities);
+    // what RenderSystem::process does per frame: gather the world-space bounds, then cull
+    BENCHMARK("gather and cull every entity, " + scene.config().name)
+    {
+        spheres.clear();
+        scene.registry().query<CoordSys, Visual3d>([&spheres](Entity, CoordSys& c, Visual3d& v) {
+            spheres.push_back(c.position() + c.rotation() * v.bounds().center, v.bounds().radius);
+        });
+        return spheres.cull(frustum, visible.data());
+    };
+}
+
+TEST_CASE("Scene: headless frames", "[scene]")
+{
+    SyntheticScene scene(scene_config());
+    RenderSettings settings;
+    settings.pipeline_cache_path = "";
+    RenderSystem rs(settings);
+    if (!create_headless_device([&] { rs.create_headless(1024, 768); }))
+    {
+        return;
+    }
+    render_until_uploaded(rs, scene.registry());
+    // the camera at the origin sees part of the scene, otherwise the frames below would not draw anything
+    INFO(rs.culling_stats().visible << " of " << scene.config().entities << " entities visible");
+    REQUIRE(rs.culling_stats().visible > 0);
+
+    // culling, model matrices, command recording and submission
+    BENCHMARK("RenderSystem::process, direct drawing, " + scene.config().name)
+    {
+        rs.process(scene.registry(), 0);
+    };
+    rs.set_draw_mode(DrawMode::indirect);
+    BENCHMARK("RenderSystem::process, " + std::string(rs.draw_mode() == DrawMode::indirect ? "indirect" : "direct") +
+              " drawing, " + scene.config().name)
+    {
+        rs.process(scene.registry(), 0);
+    };
+    rs.destroy();
+}
@@ -0,0 +1,91 @@
+#include "coordsys.h"
+#include "threadpool.h"
+#include "transformhierarchy.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+using namespace components;
+
+// 1000 trees of 100 transforms with random parents inside the tree
+static std::vector<uint32_t> make_forest(TransformHierarchy& hierarchy, size_t count)
+{
+    std::mt19937 rng(3);
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t tree_start = i - i % 100;
+        const uint32_t parent = tree_start == i ? TransformHierarchy::kNone
+                                                : ids[std::uniform_int_distribution<size_t>(tree_start, i - 1)(rng)];
+        ids.push_back(hierarchy.create(parent));
+        hierarchy.set_local(ids.back(), glm::vec3(1.0f, 0.0f, 0.0f), glm::quat(1, 0, 0, 0));
+    }
+    hierarchy.update();
+    return ids;
+}
+
+TEST_CASE("Transform hierarchy update", "[transform]")
+{
+    const size_t count = 100'000;
+    TransformHierarchy hierarchy;
+    const std::vector<uint32_t> ids = make_forest(hierarchy, count);
+    jobs::ThreadPool pool;
+
+    // a hundredth of the transforms changes every frame, the update recomputes them and their descendants
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<size_t> pick(0, count - 1);
+    float angle = 0.0f;
+    auto move_some = [&]() {
+        angle += 0.01f;
+        const glm::quat rotation = glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f));
+        for (size_t i = 0; i < count / 100; i++)
+        {
+            hierarchy.set_local(ids[pick(rng)], glm::vec3(1.0f, 0.0f, 0.0f), rotation);
+        }
+    };
+    BENCHMARK("1% changed, 100k transforms")
+    {
+        move_some();
+        hierarchy.update();
+        return hierarchy.world_matrix(ids[0]);
+    };
+    BENCHMARK("1% changed, 100k transforms, thread pool")
+    {
+        move_some();
+        hierarchy.update(&pool);
+        return hierarchy.world_matrix(ids[0]);
+    };
+    auto move_all = [&]() {
+        angle += 0.01f;
+        const glm::quat rotation = glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f));
+        for (uint32_t id : ids)
+        {
+            hierarchy.set_local(id, glm::vec3(1.0f, 0.0f, 0.0f), rotation);
+        }
+    };
+    BENCHMARK("all changed, 100k transforms")
+    {
+        move_all();
+        hierarchy.update();
+        return hierarchy.world_matrix(ids[0]);
+    };
+    BENCHMARK("all changed, 100k transforms, thread pool")
+    {
+        move_all();
+        hierarchy.update(&pool);
+        return hierarchy.world_matrix(ids[0]);
+    };
+
+    // what the renderer does today: every CoordSys builds its matrix every frame, without parents
+    std::vector<CoordSys> coords(count);
+    BENCHMARK("CoordSys::transform(), 100k")
+    {
+        glm::vec4 sum(0.0f);
+        for (const CoordSys& coord : coords)
+        {
+            sum += coord.transform()[3];
+        }
+        return sum;
+    };
+}
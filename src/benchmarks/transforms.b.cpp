@@ -0,0 +1,83 @@
+#include "camera.h"
+#include "coordsys.h"
+#include "instances.h"
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace rendersystem;
+using namespace components;
+
+// the per-frame cost of turning the transforms of the visible objects into per-instance model matrices
+TEST_CASE("Model matrices of visible objects", "[transforms]")
+{
+    for (size_t count : {10'000, 100'000, 1'000'000})
+    {
+        const std::string n = std::to_string(count / 1000) + "k";
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+        std::vector<CoordSys> coords(count);
+        for (CoordSys& coord : coords)
+        {
+            coord.position() = 100.0f * glm::vec3(value(rng), value(rng), value(rng));
+            coord.rotation() = glm::angleAxis(3.0f * value(rng), glm::normalize(glm::vec3(value(rng), 1.0f, 0.5f)));
+        }
+        // the renderer writes into a mapped buffer, this is cached memory
+        std::vector<InstanceAttributes> instances(count);
+        Camera camera(4 / 3.0f, 60.0f);
+
+        // what the renderer did before the instance buffer: one model-view-projection per draw, recomputing the view
+        BENCHMARK("projection * view * model per object, " + n)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                instances[i].model = camera.projection_mat() * camera.view_mat() * coords[i].transform();
+            }
+            return instances[count - 1].model[3][0];
+        };
+        BENCHMARK("CoordSys::transform() per object, " + n)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                instances[i].model = coords[i].transform();
+            }
+            return instances[count - 1].model[3][0];
+        };
+
+        ModelTransforms transforms;
+        for (const CoordSys& coord : coords)
+        {
+            transforms.push_back(coord.position(), coord.rotation());
+        }
+        BENCHMARK("batched, scalar, " + n)
+        {
+            transforms.write_models_scalar(nullptr, instances.data());
+            return instances[count - 1].model[3][0];
+        };
+        BENCHMARK("batched, SSE, " + n)
+        {
+            transforms.write_models(nullptr, instances.data());
+            return instances[count - 1].model[3][0];
+        };
+        // what RenderSystem::process does: gather the transforms, then write each model to the instance of its batch
+        std::vector<uint32_t> shuffled(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            shuffled[i] = i;
+        }
+        std::shuffle(shuffled.begin(), shuffled.end(), rng);
+        BENCHMARK("gather and batched SSE to shuffled instances, " + n)
+        {
+            transforms.clear();
+            for (const CoordSys& coord : coords)
+            {
+                transforms.push_back(coord.position(), coord.rotation());
+            }
+            transforms.write_models(shuffled.data(), instances.data());
+            return instances[count - 1].model[3][0];
+        };
+    }
+}
@@ -0,0 +1,43 @@
+#include "syntheticscene.h"
+#include "vertexformat.h"
+#include "visual.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace scenes;
+using namespace rendersystem;
+using namespace components;
+
+// vertex memory of the meshes of a scene in both formats, and the CPU cost of compacting them on upload
+TEST_CASE("Vertex formats", "[vertexformat]")
+{
+    SyntheticScene scene(scene_config());
+    std::vector<Visual3d> meshes = scene.meshes();
+    meshes.push_back(Visual3d::from_gltf_mapped(ASSETS_DIR "/torus_smooth.gltf"));
+    size_t vertex_count = 0;
+    for (const Visual3d& viz : meshes)
+    {
+        vertex_count += viz.vertices().size();
+    }
+    const size_t standard_size = vertex_count * vertex_stride(VertexFormat::standard);
+    const size_t compact_size = vertex_count * vertex_stride(VertexFormat::compact);
+    printf("%zu meshes, %zu vertices: standard %.1f KiB, compact %.1f KiB (%.0f%%)\n", meshes.size(), vertex_count,
+           standard_size / 1024.0, compact_size / 1024.0, 100.0 * compact_size / standard_size);
+
+    std::vector<CompactVertex> compact(vertex_count);
+    BENCHMARK("encode the vertices of " + std::to_string(meshes.size()) + " meshes, " + scene.config().name)
+    {
+        CompactVertex* out = compact.data();
+        for (const Visual3d& viz : meshes)
+        {
+            const VertexAttributes* vertices = reinterpret_cast<const VertexAttributes*>(viz.vertices().data());
+            const PositionDecode decode = position_decode(vertices, viz.vertices().size());
+            encode_compact(vertices, viz.vertices().size(), decode, out);
+            out += viz.vertices().size();
+        }
+        return compact[0].position[0];
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "entity.h"
+#include "transformhierarchy.h"
 
 #include "glm/gtc/quaternion.hpp"
 #include "glm/mat4x4.hpp"
@@ -13,6 +14,21 @@ class CoordSys : public Component
     DEFINE_COMPONENT_ID(CoordSys);
     CoordSys() : m_rotation{1, 0, 0, 0}, m_position{} {};
 
+    /**
+     * The transform of a TransformHierarchy whose world position and rotation this coordinate system follows,
+     * TransformHierarchy::kNone if it is placed by position() and rotation() alone. The RenderSystem copies the
+     * world transform of its hierarchy into the attached coordinate systems it draws, every frame. Once the transform
+     * is destroyed, its id stays invalid and the coordinate system keeps the last world transform it was given.
+     */
+    uint32_t node() const
+    {
+        return m_node;
+    }
+    void attach(uint32_t node)
+    {
+        m_node = node;
+    }
+
     const glm::vec3& position() const
     {
         return m_position;
@@ -41,5 +57,6 @@ class CoordSys : public Component
   private:
     glm::vec3 m_position;
     glm::quat m_rotation;
+    uint32_t m_node = TransformHierarchy::kNone;
 };
 } // namespace components
\ No newline at end of file
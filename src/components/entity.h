@@ -1,53 +1,73 @@
 #pragma once
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <memory>
-#include <unordered_map>
 #include <vector>
 
 namespace components
 {
+/**
+ * Base of all components. Components live by value inside the columns of a Registry, so their address is only
+ * stable until the archetype owning them is modified and must not be used as identity.
+ */
 class Component
 {
-  public:
-    size_t hash()
-    {
-        return (size_t)(this);
-    }
 };
 
 inline constexpr uint32_t id_from_name(const char* str, size_t n, uint32_t basis = UINT32_C(2166136261))
 {
     return n == 0 ? basis : id_from_name(str + 1, n - 1, (basis ^ str[0]) * UINT32_C(16777619));
 }
-#define COMPONENT_ID(NAME) id_from_name(#NAME, strlen(#NAME))
+#define COMPONENT_ID(NAME) ::components::id_from_name(#NAME, strlen(#NAME))
 #define DEFINE_COMPONENT_ID(NAME)                                                                                      \
     constexpr static const uint32_t id()                                                                               \
     {                                                                                                                  \
         return COMPONENT_ID(NAME);                                                                                     \
     }
 
+class Registry;
+
+/**
+ * Lightweight handle to an entity living in a Registry. Copying an Entity copies the handle, never the components.
+ * The component accessors are defined in registry.h.
+ */
 class Entity
 {
   public:
-    template <typename T> void add_component(std::shared_ptr<T> cmp)
+    Entity() : m_registry(nullptr), m_index(0), m_generation(0)
+    {
+    }
+    Entity(Registry* registry, uint32_t index, uint32_t generation)
+        : m_registry(registry), m_index(index), m_generation(generation)
+    {
+    }
+    template <typename T> T* add_component(T cmp);
+    template <typename T> T* get_component() const;
+    template <typename T> bool has_component() const;
+    template <typename T> void remove_component();
+    bool valid() const;
+
+    uint32_t index() const
+    {
+        return m_index;
+    }
+    uint32_t generation() const
+    {
+        return m_generation;
+    }
+    bool operator==(const Entity& rhs) const
     {
-        m_components[T::id()] = cmp;
+        return m_registry == rhs.m_registry && m_index == rhs.m_index && m_generation == rhs.m_generation;
     }
-    template <typename T> std::shared_ptr<T> get_component() const
+    bool operator!=(const Entity& rhs) const
     {
-        auto it = m_components.find(T::id());
-        if (it != m_components.end())
-        {
-            return std::static_pointer_cast<T>(it->second);
-        }
-        else
-        {
-            return std::shared_ptr<T>();
-        }
+        return !(*this == rhs);
     }
 
   private:
-    std::unordered_map<uint32_t, std::shared_ptr<Component>> m_components;
+    Registry* m_registry;
+    uint32_t m_index;
+    uint32_t m_generation;
 };
-} // namespace components
\ No newline at end of file
+} // namespace components
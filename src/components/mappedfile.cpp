@@ -0,0 +1,73 @@
+#include "mappedfile.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace components
+{
+
+MappedFile::MappedFile(const std::string& fn) : m_data(nullptr), m_size(0)
+{
+    int fd = open(fn.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("cannot open " + fn);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("cannot stat " + fn);
+    }
+    m_size = (size_t)st.st_size;
+    if (m_size > 0)
+    {
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("cannot map " + fn);
+        }
+        m_data = (const unsigned char*)p;
+    }
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept : m_data(rhs.m_data), m_size(rhs.m_size)
+{
+    rhs.m_data = nullptr;
+    rhs.m_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        unmap();
+        m_data = rhs.m_data;
+        m_size = rhs.m_size;
+        rhs.m_data = nullptr;
+        rhs.m_size = 0;
+    }
+    return *this;
+}
+
+void MappedFile::unmap()
+{
+    if (m_data != nullptr)
+    {
+        munmap((void*)m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+} // namespace components
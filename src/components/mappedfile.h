@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace components
+{
+
+/**
+ * Read-only memory mapping of a whole file. Pages are loaded on first access, so data can be decoded straight out of
+ * the mapping without reading the file into a buffer first.
+ */
+class MappedFile
+{
+  public:
+    MappedFile() : m_data(nullptr), m_size(0)
+    {
+    }
+    // throws if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& fn);
+    ~MappedFile();
+    MappedFile(const MappedFile& rhs) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+    MappedFile(MappedFile&& rhs) noexcept;
+    MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+    const unsigned char* data() const
+    {
+        return m_data;
+    }
+    size_t size() const
+    {
+        return m_size;
+    }
+
+  private:
+    void unmap();
+
+  private:
+    const unsigned char* m_data;
+    size_t m_size;
+};
+
+} // namespace components
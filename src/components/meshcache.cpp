@@ -0,0 +1,254 @@
+#include "meshcache.h"
+#include "mappedfile.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+namespace components
+{
+
+namespace
+{
+const char kMagic[4] = {'V', 'H', 'M', 'C'};
+const uint64_t kBlobAlignment = 64;
+
+uint64_t align_up(uint64_t v)
+{
+    return (v + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+}
+
+uint64_t fnv1a(const unsigned char* data, size_t size)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < size; i++)
+    {
+        h = (h ^ data[i]) * UINT64_C(1099511628211);
+    }
+    return h;
+}
+
+uint64_t hash_file(const std::string& fn)
+{
+    MappedFile file(fn);
+    return fnv1a(file.data(), file.size());
+}
+
+uint64_t mtime_of(const std::string& fn)
+{
+    return (uint64_t)std::filesystem::last_write_time(fn).time_since_epoch().count();
+}
+
+// a modification time in the entry which is out of date
+struct TouchedTime
+{
+    uint64_t offset;
+    uint64_t mtime;
+};
+
+// whether fn still has the recorded size and either the recorded modification time or content
+bool same_file(const std::string& fn, uint64_t size, uint64_t mtime, uint64_t hash, uint64_t* current_mtime)
+{
+    std::error_code error;
+    if (std::filesystem::file_size(fn, error) != size || error)
+    {
+        return false;
+    }
+    // a different modification time alone, e.g. after a checkout, does not invalidate the entry
+    *current_mtime = mtime_of(fn);
+    return *current_mtime == mtime || hash_file(fn) == hash;
+}
+
+// the entry if it is complete and was baked from the current content of source and its external buffers
+bool read_entry(const MappedFile& entry, const std::string& source, Visual3d* viz, std::vector<TouchedTime>* touched)
+{
+    MeshCacheHeader header;
+    if (entry.size() < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, entry.data(), sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != MeshCache::kVersion ||
+        header.vertex_stride != sizeof(StandardVertex) ||
+        header.vertex_offset + (uint64_t)header.vertex_count * sizeof(StandardVertex) > entry.size() ||
+        header.index_offset + (uint64_t)header.index_count * sizeof(uint32_t) > entry.size())
+    {
+        return false;
+    }
+    uint64_t mtime = 0;
+    if (!same_file(source, header.source_size, header.source_mtime, header.source_hash, &mtime))
+    {
+        return false;
+    }
+    if (mtime != header.source_mtime)
+    {
+        touched->push_back(TouchedTime{offsetof(MeshCacheHeader, source_mtime), mtime});
+    }
+    uint64_t pos = header.dependency_offset;
+    for (uint32_t i = 0; i < header.dependency_count; i++)
+    {
+        MeshCacheDependency dependency;
+        if (pos + sizeof(dependency) > entry.size())
+        {
+            return false;
+        }
+        memcpy(&dependency, entry.data() + pos, sizeof(dependency));
+        if (pos + sizeof(dependency) + dependency.path_length > entry.size())
+        {
+            return false;
+        }
+        const std::string path((const char*)entry.data() + pos + sizeof(dependency), dependency.path_length);
+        if (!same_file(path, dependency.size, dependency.mtime, dependency.hash, &mtime))
+        {
+            return false;
+        }
+        if (mtime != dependency.mtime)
+        {
+            touched->push_back(TouchedTime{pos + offsetof(MeshCacheDependency, mtime), mtime});
+        }
+        pos += sizeof(dependency) + dependency.path_length;
+    }
+    // the blobs are copied out of the mapping, so the visual does not depend on the entry file
+    const StandardVertex* vertices = reinterpret_cast<const StandardVertex*>(entry.data() + header.vertex_offset);
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(entry.data() + header.index_offset);
+    viz->vertices().assign(vertices, vertices + header.vertex_count);
+    viz->indices().assign(indices, indices + header.index_count);
+    return true;
+}
+
+// replace fn with what write(out) writes, false if that failed, e.g. in a full or read-only directory, and fn stays as
+// it was
+template <typename Write> bool replace_file(const std::string& fn, Write&& write)
+{
+    // write to a temporary file unique across processes sharing the directory first, so that concurrent readers only
+    // ever see complete entries
+    static std::atomic<uint64_t> counter{0};
+    const std::string tmp = fn + ".tmp" + std::to_string(getpid()) + "." + std::to_string(counter++);
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        write(out);
+        if (!out)
+        {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tmp, fn, error);
+    if (error)
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool write_entry(const std::string& fn, const Visual3d& viz, const MeshCacheHeader& header,
+                 const std::string& dependencies)
+{
+    return replace_file(fn, [&](std::ofstream& out) {
+        const char padding[kBlobAlignment] = {};
+        out.write((const char*)&header, sizeof(header));
+        out.write(padding, header.vertex_offset - sizeof(header));
+        out.write((const char*)viz.vertices().data(), viz.vertices().size() * sizeof(StandardVertex));
+        out.write(padding, header.index_offset - header.vertex_offset - viz.vertices().size() * sizeof(StandardVertex));
+        out.write((const char*)viz.indices().data(), viz.indices().size() * sizeof(uint32_t));
+        out.write(dependencies.data(), dependencies.size());
+    });
+}
+
+// a copy of entry with the new times, written like a new entry since other processes may be reading the old one
+bool write_touched(const std::string& fn, const MappedFile& entry, const std::vector<TouchedTime>& touched)
+{
+    std::string data((const char*)entry.data(), entry.size());
+    for (const TouchedTime& t : touched)
+    {
+        memcpy(&data[t.offset], &t.mtime, sizeof(t.mtime));
+    }
+    return replace_file(fn, [&](std::ofstream& out) { out.write(data.data(), data.size()); });
+}
+} // namespace
+
+MeshCache::MeshCache(const std::string& directory) : m_directory(directory)
+{
+    std::filesystem::create_directories(directory);
+}
+
+std::string MeshCache::entry_path(const std::string& source) const
+{
+    const std::string key = std::filesystem::absolute(source).lexically_normal().string();
+    char name[32];
+    const uint64_t key_hash = fnv1a((const unsigned char*)key.data(), key.size());
+    snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)key_hash);
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+Visual3d MeshCache::load(const std::string& source, bool* hit) const
+{
+    const std::string entry = entry_path(source);
+    const uint64_t source_mtime = mtime_of(source);
+    const uint64_t source_size = std::filesystem::file_size(source);
+    if (std::filesystem::is_regular_file(entry))
+    {
+        Visual3d viz;
+        std::vector<TouchedTime> touched;
+        const MappedFile mapped(entry);
+        if (read_entry(mapped, source, &viz, &touched))
+        {
+            if (!touched.empty())
+            {
+                // record the new times, so the next load skips hashing the files. If that fails, it hashes them again
+                write_touched(entry, mapped, touched);
+            }
+            if (hit != nullptr)
+            {
+                *hit = true;
+            }
+            viz.update_bounds();
+            return viz;
+        }
+    }
+
+    std::vector<std::string> external_files;
+    Visual3d viz = Visual3d::from_gltf_mapped(source, &external_files);
+    std::string dependencies;
+    for (const std::string& file : external_files)
+    {
+        const std::string path = std::filesystem::absolute(file).lexically_normal().string();
+        MeshCacheDependency dependency = {};
+        dependency.mtime = mtime_of(path);
+        dependency.size = std::filesystem::file_size(path);
+        dependency.hash = hash_file(path);
+        dependency.path_length = (uint32_t)path.size();
+        dependencies.append((const char*)&dependency, sizeof(dependency));
+        dependencies.append(path);
+    }
+    MeshCacheHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.source_mtime = source_mtime;
+    header.source_size = source_size;
+    header.source_hash = hash_file(source);
+    header.vertex_stride = sizeof(StandardVertex);
+    header.vertex_count = (uint32_t)viz.vertices().size();
+    header.index_count = (uint32_t)viz.indices().size();
+    header.vertex_offset = align_up(sizeof(header));
+    header.index_offset = align_up(header.vertex_offset + viz.vertices().size() * sizeof(StandardVertex));
+    header.dependency_count = (uint32_t)external_files.size();
+    header.dependency_offset = header.index_offset + viz.indices().size() * sizeof(uint32_t);
+    // the import succeeded, a cache that cannot be written only costs the next load another import
+    write_entry(entry, viz, header, dependencies);
+    if (hit != nullptr)
+    {
+        *hit = false;
+    }
+    return viz;
+}
+
+} // namespace components
@@ -0,0 +1,67 @@
+#pragma once
+#include "visual.h"
+#include <cstdint>
+#include <string>
+
+namespace components
+{
+
+/**
+ * File header of a baked mesh. The vertex and index blobs follow at aligned offsets, vertices in the StandardVertex
+ * layout (which the render system uploads as is), indices as uint32_t. Then come the external buffers the source
+ * references, each a MeshCacheDependency followed by its path.
+ */
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t source_mtime; // last write time of the imported file
+    uint64_t source_size;
+    uint64_t source_hash; // FNV-1a of the imported file content
+    uint32_t vertex_stride;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t dependency_count;
+    uint64_t vertex_offset;
+    uint64_t index_offset;
+    uint64_t dependency_offset;
+};
+
+// external file the mesh was imported from besides the source
+struct MeshCacheDependency
+{
+    uint64_t mtime;
+    uint64_t size;
+    uint64_t hash;
+    uint32_t path_length; // bytes of the absolute path following the record
+    uint32_t reserved;
+};
+
+/**
+ * Directory of baked meshes, one file per imported source. An entry is valid if the source and its external buffers
+ * still have the recorded sizes and either the recorded modification times or content hashes, so loading it needs no
+ * parsing at all.
+ */
+class MeshCache
+{
+  public:
+    static const uint32_t kVersion = 2;
+
+    // creates the directory if necessary
+    explicit MeshCache(const std::string& directory);
+
+    /**
+     * Return the visual of the gltf file source. It is read from the cache if there is a valid entry, otherwise it
+     * is imported with Visual3d::from_gltf_mapped and stored, if the directory is writable. If hit is given, it tells
+     * whether the cache was used.
+     * Safe to call from several threads.
+     */
+    Visual3d load(const std::string& source, bool* hit = nullptr) const;
+    // cache file for source
+    std::string entry_path(const std::string& source) const;
+
+  private:
+    std::string m_directory;
+};
+
+} // namespace components
@@ -0,0 +1,377 @@
+#pragma once
+#include "entity.h"
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace components
+{
+
+namespace detail
+{
+/**
+ * Type-erased, contiguous storage of one component type within an archetype.
+ */
+class ColumnBase
+{
+  public:
+    virtual ~ColumnBase() = default;
+    virtual std::unique_ptr<ColumnBase> make_empty() const = 0;
+    // append the element at row to dst, which must be a column of the same type
+    virtual void move_row_to(size_t row, ColumnBase& dst) = 0;
+    // remove the element at row by moving the last element into its place
+    virtual void swap_remove(size_t row) = 0;
+};
+
+template <typename T> class Column : public ColumnBase
+{
+  public:
+    std::unique_ptr<ColumnBase> make_empty() const override
+    {
+        return std::make_unique<Column<T>>();
+    }
+    void move_row_to(size_t row, ColumnBase& dst) override
+    {
+        static_cast<Column<T>&>(dst).m_data.push_back(std::move(m_data[row]));
+    }
+    void swap_remove(size_t row) override
+    {
+        if (row + 1 != m_data.size())
+        {
+            m_data[row] = std::move(m_data.back());
+        }
+        m_data.pop_back();
+    }
+    std::vector<T>& data()
+    {
+        return m_data;
+    }
+
+  private:
+    std::vector<T> m_data;
+};
+} // namespace detail
+
+template <typename... Ts> class View;
+
+/**
+ * All entities owning exactly the same set of components. Each component type is kept in its own contiguous column
+ * (struct-of-arrays); row i of every column belongs to the entity at entities()[i].
+ */
+class Archetype
+{
+  public:
+    explicit Archetype(std::vector<uint32_t> signature) : m_signature(std::move(signature))
+    {
+    }
+    const std::vector<uint32_t>& signature() const
+    {
+        return m_signature;
+    }
+    bool contains(uint32_t id) const
+    {
+        return std::binary_search(m_signature.begin(), m_signature.end(), id);
+    }
+    template <typename T> T* column()
+    {
+        auto it = std::lower_bound(m_signature.begin(), m_signature.end(), T::id());
+        if (it == m_signature.end() || *it != T::id())
+        {
+            return nullptr;
+        }
+        return static_cast<detail::Column<T>&>(*m_columns[it - m_signature.begin()]).data().data();
+    }
+    const std::vector<uint32_t>& entities() const
+    {
+        return m_entities;
+    }
+    size_t size() const
+    {
+        return m_entities.size();
+    }
+
+  private:
+    friend class Registry;
+    std::vector<uint32_t> m_signature;                          // sorted component ids
+    std::vector<std::unique_ptr<detail::ColumnBase>> m_columns; // parallel to m_signature
+    std::vector<uint32_t> m_entities;                           // entity index per row
+    std::unordered_map<uint32_t, Archetype*> m_add_edges;       // archetype reached by adding a component id
+    std::unordered_map<uint32_t, Archetype*> m_remove_edges;    // archetype reached by removing a component id
+};
+
+/**
+ * Owns all entities and their components. Entities with the same component set share an Archetype, so iterating
+ * over a component set touches contiguous memory only.
+ */
+class Registry
+{
+  public:
+    Registry()
+    {
+        m_root = find_or_create_archetype({}, nullptr, 0, nullptr);
+    }
+    Registry(const Registry& rhs) = delete;
+    Registry& operator=(const Registry& rhs) = delete;
+
+    Entity create()
+    {
+        uint32_t index;
+        if (!m_free.empty())
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            index = (uint32_t)m_records.size();
+            m_records.push_back(Record{0, nullptr, 0});
+        }
+        Record& rec = m_records[index];
+        rec.archetype = m_root;
+        rec.row = (uint32_t)m_root->m_entities.size();
+        m_root->m_entities.push_back(index);
+        m_alive++;
+        return Entity(this, index, rec.generation);
+    }
+
+    template <typename... Ts> Entity create(Ts... cmps)
+    {
+        Entity e = create();
+        (add_component(e, std::move(cmps)), ...);
+        return e;
+    }
+
+    void destroy(Entity e)
+    {
+        if (!valid(e))
+        {
+            return;
+        }
+        Record& rec = m_records[e.index()];
+        for (auto& col : rec.archetype->m_columns)
+        {
+            col->swap_remove(rec.row);
+        }
+        remove_row(rec.archetype, rec.row);
+        rec.archetype = nullptr;
+        rec.generation++;
+        m_free.push_back(e.index());
+        m_alive--;
+    }
+
+    bool valid(Entity e) const
+    {
+        return e.index() < m_records.size() && m_records[e.index()].generation == e.generation() &&
+               m_records[e.index()].archetype != nullptr;
+    }
+
+    /**
+     * Add (or replace) a component. Adding a new component type moves the entity into another archetype, which
+     * invalidates previously returned component pointers of that entity.
+     */
+    template <typename T> T* add_component(Entity e, T cmp)
+    {
+        assert(valid(e));
+        if (T* existing = get_component<T>(e); existing != nullptr)
+        {
+            *existing = std::move(cmp);
+            return existing;
+        }
+        Archetype* src = m_records[e.index()].archetype;
+        Archetype* dst = nullptr;
+        if (auto it = src->m_add_edges.find(T::id()); it != src->m_add_edges.end())
+        {
+            dst = it->second;
+        }
+        else
+        {
+            std::vector<uint32_t> signature = src->m_signature;
+            signature.insert(std::lower_bound(signature.begin(), signature.end(), T::id()), T::id());
+            detail::Column<T> prototype;
+            dst = find_or_create_archetype(signature, src, T::id(), &prototype);
+            src->m_add_edges[T::id()] = dst;
+            dst->m_remove_edges[T::id()] = src;
+        }
+        relocate(e.index(), dst);
+        auto& data = static_cast<detail::Column<T>&>(*dst->m_columns[column_index(dst, T::id())]).data();
+        data.push_back(std::move(cmp));
+        return &data.back();
+    }
+
+    template <typename T> T* get_component(Entity e)
+    {
+        if (!valid(e))
+        {
+            return nullptr;
+        }
+        const Record& rec = m_records[e.index()];
+        T* column = rec.archetype->column<T>();
+        return column != nullptr ? column + rec.row : nullptr;
+    }
+
+    template <typename T> bool has_component(Entity e) const
+    {
+        return valid(e) && m_records[e.index()].archetype->contains(T::id());
+    }
+
+    template <typename T> void remove_component(Entity e)
+    {
+        if (!has_component<T>(e))
+        {
+            return;
+        }
+        Archetype* src = m_records[e.index()].archetype;
+        Archetype* dst = nullptr;
+        if (auto it = src->m_remove_edges.find(T::id()); it != src->m_remove_edges.end())
+        {
+            dst = it->second;
+        }
+        else
+        {
+            std::vector<uint32_t> signature = src->m_signature;
+            signature.erase(std::lower_bound(signature.begin(), signature.end(), T::id()));
+            dst = find_or_create_archetype(signature, src, 0, nullptr);
+            src->m_remove_edges[T::id()] = dst;
+            dst->m_add_edges[T::id()] = src;
+        }
+        relocate(e.index(), dst);
+    }
+
+    /**
+     * Call fn(Entity, Ts&...) for every entity owning all components Ts. The callback must not add or remove
+     * components or entities.
+     */
+    template <typename... Ts, typename F> void query(F&& fn)
+    {
+        for (auto& arch : m_archetypes)
+        {
+            if (arch->m_entities.empty() || !(arch->contains(Ts::id()) && ...))
+            {
+                continue;
+            }
+            std::tuple<Ts*...> columns{arch->column<Ts>()...};
+            const uint32_t* entities = arch->m_entities.data();
+            const size_t count = arch->m_entities.size();
+            for (size_t row = 0; row < count; row++)
+            {
+                fn(Entity(this, entities[row], m_records[entities[row]].generation), std::get<Ts*>(columns)[row]...);
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return m_alive;
+    }
+    const std::vector<std::unique_ptr<Archetype>>& archetypes() const
+    {
+        return m_archetypes;
+    }
+
+  private:
+    template <typename... Ts> friend class View;
+
+    struct Record
+    {
+        uint32_t generation;
+        Archetype* archetype;
+        uint32_t row;
+    };
+
+    static size_t column_index(const Archetype* arch, uint32_t id)
+    {
+        return std::lower_bound(arch->m_signature.begin(), arch->m_signature.end(), id) - arch->m_signature.begin();
+    }
+
+    // columns of the new archetype are cloned from `base`, plus `extra` for the component id `extra_id`
+    Archetype* find_or_create_archetype(const std::vector<uint32_t>& signature, const Archetype* base,
+                                        uint32_t extra_id, const detail::ColumnBase* extra)
+    {
+        if (auto it = m_archetype_index.find(signature); it != m_archetype_index.end())
+        {
+            return it->second;
+        }
+        auto arch = std::make_unique<Archetype>(signature);
+        for (uint32_t id : signature)
+        {
+            if (extra != nullptr && id == extra_id)
+            {
+                arch->m_columns.push_back(extra->make_empty());
+            }
+            else
+            {
+                arch->m_columns.push_back(base->m_columns[column_index(base, id)]->make_empty());
+            }
+        }
+        Archetype* result = arch.get();
+        m_archetypes.push_back(std::move(arch));
+        m_archetype_index[signature] = result;
+        return result;
+    }
+
+    // move all components shared by the current archetype of `index` and dst, dropping the others
+    void relocate(uint32_t index, Archetype* dst)
+    {
+        Record& rec = m_records[index];
+        Archetype* src = rec.archetype;
+        for (size_t i = 0; i < src->m_signature.size(); i++)
+        {
+            if (dst->contains(src->m_signature[i]))
+            {
+                src->m_columns[i]->move_row_to(rec.row, *dst->m_columns[column_index(dst, src->m_signature[i])]);
+            }
+            src->m_columns[i]->swap_remove(rec.row);
+        }
+        remove_row(src, rec.row);
+        rec.archetype = dst;
+        rec.row = (uint32_t)dst->m_entities.size();
+        dst->m_entities.push_back(index);
+    }
+
+    void remove_row(Archetype* arch, uint32_t row)
+    {
+        const uint32_t last = (uint32_t)arch->m_entities.size() - 1;
+        const uint32_t moved = arch->m_entities[last];
+        arch->m_entities[row] = moved;
+        arch->m_entities.pop_back();
+        if (row != last)
+        {
+            m_records[moved].row = row;
+        }
+    }
+
+  private:
+    std::vector<Record> m_records;
+    std::vector<uint32_t> m_free;
+    std::vector<std::unique_ptr<Archetype>> m_archetypes;
+    std::map<std::vector<uint32_t>, Archetype*> m_archetype_index;
+    Archetype* m_root;
+    size_t m_alive = 0;
+};
+
+template <typename T> T* Entity::add_component(T cmp)
+{
+    return m_registry->add_component(*this, std::move(cmp));
+}
+template <typename T> T* Entity::get_component() const
+{
+    return m_registry != nullptr ? m_registry->get_component<T>(*this) : nullptr;
+}
+template <typename T> bool Entity::has_component() const
+{
+    return m_registry != nullptr && m_registry->has_component<T>(*this);
+}
+template <typename T> void Entity::remove_component()
+{
+    m_registry->remove_component<T>(*this);
+}
+inline bool Entity::valid() const
+{
+    return m_registry != nullptr && m_registry->valid(*this);
+}
+
+} // namespace components
@@ -0,0 +1,29 @@
+#include "allocationcounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> g_allocations{0};
+
+size_t allocation_count()
+{
+    return g_allocations;
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocations++;
+    if (void* p = std::malloc(size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * Heap allocations of the test binary so far, counted by the global operator new in allocationcounter.cpp. Tests
+ * compare two counts to check that a code path does not allocate.
+ */
+size_t allocation_count();
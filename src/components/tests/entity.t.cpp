@@ -1,4 +1,5 @@
 #include "entity.h"
+#include "registry.h"
 #include <catch2/catch_test_macros.hpp>
 #include <cstring>
 
@@ -18,15 +19,35 @@ class OtherComponent : public Component
 
 TEST_CASE("Adding components to an entity")
 {
-    Entity e;
-    e.add_component(std::make_shared<MyComponent>());
+    Registry registry;
+    Entity e = registry.create();
+    e.add_component(MyComponent());
 
     auto e2 = e.get_component<MyComponent>();
     REQUIRE(e2->id() == COMPONENT_ID(MyComponent));
 
     auto e3 = e.get_component<OtherComponent>();
     REQUIRE(e3 == nullptr);
-    e.add_component(std::make_shared<OtherComponent>());
+    e.add_component(OtherComponent());
     e3 = e.get_component<OtherComponent>();
     REQUIRE(e3->id() == COMPONENT_ID(OtherComponent));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Entity handles are invalidated on destroy")
+{
+    Registry registry;
+    Entity e = registry.create(MyComponent());
+    Entity copy = e;
+    REQUIRE(copy == e);
+    REQUIRE(copy.valid());
+
+    registry.destroy(e);
+    REQUIRE_FALSE(copy.valid());
+    REQUIRE(copy.get_component<MyComponent>() == nullptr);
+
+    // the slot is recycled with a new generation
+    Entity reused = registry.create();
+    REQUIRE(reused.index() == e.index());
+    REQUIRE(reused != e);
+    REQUIRE_FALSE(Entity().valid());
+}
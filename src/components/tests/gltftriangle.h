@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// a triangle with interleaved position/normal/uv, 16 bit indices
+inline std::string triangle_json(const std::string& buffer_uri)
+{
+    return R"({"asset": {"version": "2.0"},
+        "meshes": [{"primitives": [{"attributes": {"POSITION": 0, "NORMAL": 1, "TEXCOORD_0": 2}, "indices": 3}]}],
+        "accessors": [
+            {"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3"},
+            {"bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 3, "type": "VEC3"},
+            {"bufferView": 0, "byteOffset": 24, "componentType": 5126, "count": 3, "type": "VEC2"},
+            {"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"}],
+        "bufferViews": [
+            {"buffer": 0, "byteOffset": 0, "byteLength": 96, "byteStride": 32},
+            {"buffer": 0, "byteOffset": 96, "byteLength": 6}],
+        "buffers": [{"byteLength": 102)" +
+           (buffer_uri.empty() ? std::string() : R"(, "uri": ")" + buffer_uri + "\"") + "}]}";
+}
+
+inline std::vector<unsigned char> triangle_bin()
+{
+    // position, normal and uv of each vertex
+    const float vertices[] = {0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 1, 1, 1};
+    const uint16_t indices[] = {2, 1, 0};
+    std::vector<unsigned char> bin(sizeof(vertices) + sizeof(indices));
+    memcpy(bin.data(), vertices, sizeof(vertices));
+    memcpy(bin.data() + sizeof(vertices), indices, sizeof(indices));
+    return bin;
+}
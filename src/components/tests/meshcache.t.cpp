@@ -0,0 +1,122 @@
+#include "gltftriangle.h"
+#include "meshcache.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace components;
+namespace fs = std::filesystem;
+
+static bool same_geometry(const Visual3d& a, const Visual3d& b)
+{
+    return a.indices() == b.indices() && a.vertices().size() == b.vertices().size() &&
+           memcmp(a.vertices().data(), b.vertices().data(), a.vertices().size() * sizeof(StandardVertex)) == 0;
+}
+
+TEST_CASE("MeshCache stores imports and loads them on the next run")
+{
+    const fs::path dir = fs::temp_directory_path() / "meshcache_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string source = (dir / "torus.gltf").string();
+    fs::copy_file(ASSETS_DIR "/torus_smooth.gltf", source);
+    const Visual3d imported = Visual3d::from_gltf_mapped(source);
+
+    MeshCache cache((dir / "cache").string());
+    bool hit = true;
+    REQUIRE(same_geometry(cache.load(source, &hit), imported));
+    REQUIRE_FALSE(hit);
+    REQUIRE(fs::exists(cache.entry_path(source)));
+    REQUIRE(same_geometry(cache.load(source, &hit), imported));
+    REQUIRE(hit);
+
+    SECTION("a touched source with the same content stays cached")
+    {
+        fs::last_write_time(source, fs::last_write_time(source) + std::chrono::hours(1));
+        REQUIRE(same_geometry(cache.load(source, &hit), imported));
+        REQUIRE(hit);
+    }
+    SECTION("a modified source is imported again")
+    {
+        // a different size invalidates the entry without hashing
+        std::ofstream(source, std::ios::app) << " ";
+        cache.load(source, &hit);
+        REQUIRE_FALSE(hit);
+        cache.load(source, &hit);
+        REQUIRE(hit);
+    }
+    SECTION("entries of another format version are ignored")
+    {
+        std::fstream entry(cache.entry_path(source), std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t version = MeshCache::kVersion + 1;
+        entry.seekp(offsetof(MeshCacheHeader, version));
+        entry.write((const char*)&version, sizeof(version));
+        entry.close();
+        REQUIRE(same_geometry(cache.load(source, &hit), imported));
+        REQUIRE_FALSE(hit);
+    }
+    SECTION("an entry which cannot be written leaves the import uncached")
+    {
+        // a directory in place of the entry makes the rename fail
+        fs::remove(cache.entry_path(source));
+        fs::create_directories(fs::path(cache.entry_path(source)) / "blocker");
+        REQUIRE(same_geometry(cache.load(source, &hit), imported));
+        REQUIRE_FALSE(hit);
+        for (const fs::directory_entry& file : fs::directory_iterator(dir / "cache"))
+        {
+            REQUIRE(file.path().string().find(".tmp") == std::string::npos);
+        }
+    }
+    SECTION("truncated entries are ignored")
+    {
+        fs::resize_file(cache.entry_path(source), sizeof(MeshCacheHeader) + 10);
+        REQUIRE(same_geometry(cache.load(source, &hit), imported));
+        REQUIRE_FALSE(hit);
+    }
+    fs::remove_all(dir);
+}
+
+TEST_CASE("MeshCache validates the external buffers of a source")
+{
+    const fs::path dir = fs::temp_directory_path() / "meshcache_external_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string source = (dir / "triangle.gltf").string();
+    const std::string buffer = (dir / "triangle.bin").string();
+    std::vector<unsigned char> bin = triangle_bin();
+    std::ofstream(buffer, std::ios::binary).write((const char*)bin.data(), bin.size());
+    std::ofstream(source) << triangle_json("triangle.bin");
+
+    MeshCache cache((dir / "cache").string());
+    bool hit = true;
+    cache.load(source, &hit);
+    REQUIRE_FALSE(hit);
+    REQUIRE(cache.load(source, &hit).vertices()[1].position == glm::vec3(1, 0, 0));
+    REQUIRE(hit);
+
+    SECTION("a touched buffer with the same content stays cached")
+    {
+        fs::last_write_time(buffer, fs::last_write_time(buffer) + std::chrono::hours(1));
+        cache.load(source, &hit);
+        REQUIRE(hit);
+    }
+    SECTION("a buffer modified in place is imported again")
+    {
+        // same size, so only the content hash tells the difference
+        const float x = 2;
+        memcpy(bin.data() + 32, &x, sizeof(x));
+        const fs::file_time_type mtime = fs::last_write_time(buffer);
+        std::ofstream(buffer, std::ios::binary).write((const char*)bin.data(), bin.size());
+        fs::last_write_time(buffer, mtime + std::chrono::hours(1));
+        REQUIRE(cache.load(source, &hit).vertices()[1].position == glm::vec3(2, 0, 0));
+        REQUIRE_FALSE(hit);
+    }
+    SECTION("a missing buffer invalidates the entry")
+    {
+        fs::remove(buffer);
+        REQUIRE_THROWS(cache.load(source, &hit));
+    }
+    fs::remove_all(dir);
+}
@@ -0,0 +1,77 @@
+#include "registry.h"
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using namespace components;
+
+struct Position : public Component
+{
+    DEFINE_COMPONENT_ID(Position)
+    float x = 0;
+};
+
+struct Name : public Component
+{
+    DEFINE_COMPONENT_ID(Name)
+    std::string value;
+};
+
+TEST_CASE("Entities with the same components share an archetype")
+{
+    Registry registry;
+    Entity a = registry.create(Position{{}, 1}, Name{{}, "a"});
+    Entity b = registry.create(Name{{}, "b"}, Position{{}, 2});
+    registry.create(Position{{}, 3});
+
+    REQUIRE(registry.size() == 3);
+    Position* pa = a.get_component<Position>();
+    Position* pb = b.get_component<Position>();
+    REQUIRE(pb == pa + 1);
+}
+
+TEST_CASE("Query visits all entities owning the component set")
+{
+    Registry registry;
+    for (int i = 0; i < 10; i++)
+    {
+        Entity e = registry.create(Position{{}, (float)i});
+        if (i % 2 == 0)
+        {
+            e.add_component(Name{{}, std::to_string(i)});
+        }
+    }
+    float sum = 0;
+    registry.query<Position>([&sum](Entity, Position& p) { sum += p.x; });
+    REQUIRE(sum == 45);
+
+    int named = 0;
+    registry.query<Position, Name>([&named](Entity e, Position& p, Name& n) {
+        REQUIRE(std::to_string((int)p.x) == n.value);
+        REQUIRE(e.get_component<Name>() == &n);
+        named++;
+    });
+    REQUIRE(named == 5);
+}
+
+TEST_CASE("Removing components and entities keeps the remaining rows consistent")
+{
+    Registry registry;
+    std::vector<Entity> entities;
+    for (int i = 0; i < 5; i++)
+    {
+        entities.push_back(registry.create(Position{{}, (float)i}, Name{{}, std::to_string(i)}));
+    }
+    registry.destroy(entities[1]);
+    entities[3].remove_component<Name>();
+    REQUIRE_FALSE(entities[3].has_component<Name>());
+    REQUIRE(entities[3].get_component<Position>()->x == 3);
+
+    for (int i : {0, 2, 4})
+    {
+        REQUIRE(entities[i].get_component<Position>()->x == i);
+        REQUIRE(entities[i].get_component<Name>()->value == std::to_string(i));
+    }
+    entities[3].add_component(Name{{}, "three"});
+    REQUIRE(entities[3].get_component<Name>()->value == "three");
+    REQUIRE(registry.size() == 4);
+}
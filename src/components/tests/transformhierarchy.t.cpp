@@ -0,0 +1,234 @@
+#include "coordsys.h"
+#include "threadpool.h"
+#include "transformhierarchy.h"
+#include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+using namespace components;
+
+static bool near(const glm::mat4& a, const glm::mat4& b)
+{
+    for (int c = 0; c < 4; c++)
+    {
+        for (int r = 0; r < 4; r++)
+        {
+            if (std::abs(a[c][r] - b[c][r]) > 1e-4f)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static glm::mat4 local_of(const TransformHierarchy& h, uint32_t id)
+{
+    CoordSys coord;
+    coord.position() = h.local_position(id);
+    coord.rotation() = h.local_rotation(id);
+    return coord.transform();
+}
+
+// the world position and rotation describe the world matrix
+static bool near_world(const TransformHierarchy& h, uint32_t id)
+{
+    CoordSys coord;
+    coord.position() = h.world_position(id);
+    coord.rotation() = h.world_rotation(id);
+    return near(coord.transform(), h.world_matrix(id));
+}
+
+// world matrix by walking up to the root
+static glm::mat4 reference_world(const TransformHierarchy& h, uint32_t id)
+{
+    glm::mat4 world = local_of(h, id);
+    for (uint32_t p = h.parent(id); p != TransformHierarchy::kNone; p = h.parent(p))
+    {
+        world = local_of(h, p) * world;
+    }
+    return world;
+}
+
+TEST_CASE("Transform hierarchy composes parent and child")
+{
+    TransformHierarchy h;
+    const uint32_t root = h.create();
+    const uint32_t child = h.create(root);
+    const uint32_t grand_child = h.create(child);
+    h.set_local(root, glm::vec3(10, 0, 0), glm::angleAxis(glm::radians(90.0f), glm::vec3(0, 0, 1)));
+    h.set_local(child, glm::vec3(1, 0, 0), glm::quat(1, 0, 0, 0));
+    h.set_local(grand_child, glm::vec3(0, 2, 0), glm::quat(1, 0, 0, 0));
+    h.update();
+    REQUIRE(h.size() == 3);
+    // the quarter turn of the root maps the child's x offset to y and the grand child's y offset to -x
+    REQUIRE(near(h.world_matrix(child), glm::translate(glm::mat4(1.0f), glm::vec3(10, 1, 0)) *
+                                            glm::mat4_cast(h.local_rotation(root))));
+    const glm::vec3 origin(h.world_matrix(grand_child)[3]);
+    REQUIRE(glm::length(origin - glm::vec3(8, 1, 0)) < 1e-4f);
+    REQUIRE(h.world_changed(grand_child));
+
+    // nothing changed
+    h.update();
+    REQUIRE(!h.world_changed(root));
+    REQUIRE(!h.world_changed(grand_child));
+
+    // moving the child moves the grand child but not the root
+    h.set_local(child, glm::vec3(2, 0, 0), glm::quat(1, 0, 0, 0));
+    h.update();
+    REQUIRE(!h.world_changed(root));
+    REQUIRE(h.world_changed(child));
+    REQUIRE(h.world_changed(grand_child));
+    REQUIRE(near(h.world_matrix(grand_child), reference_world(h, grand_child)));
+    REQUIRE(near_world(h, grand_child));
+}
+
+TEST_CASE("Transform hierarchy reparenting and destroying")
+{
+    TransformHierarchy h;
+    const uint32_t a = h.create();
+    const uint32_t b = h.create();
+    const uint32_t a_child = h.create(a);
+    const uint32_t a_grand_child = h.create(a_child);
+    h.set_local(a, glm::vec3(1, 0, 0), glm::quat(1, 0, 0, 0));
+    h.set_local(b, glm::vec3(0, 5, 0), glm::quat(1, 0, 0, 0));
+    h.set_local(a_child, glm::vec3(0, 0, 1), glm::quat(1, 0, 0, 0));
+    h.update();
+    REQUIRE(near(h.world_matrix(a_grand_child), glm::translate(glm::mat4(1.0f), glm::vec3(1, 0, 1))));
+
+    // the subtree moves along with its root
+    h.set_parent(a_child, b);
+    h.update();
+    REQUIRE(h.parent(a_child) == b);
+    REQUIRE(h.world_changed(a_grand_child));
+    REQUIRE(near(h.world_matrix(a_grand_child), glm::translate(glm::mat4(1.0f), glm::vec3(0, 5, 1))));
+    REQUIRE(h.local_position(a_child) == glm::vec3(0, 0, 1));
+    REQUIRE(h.world_position(a_grand_child) == glm::vec3(0, 5, 1));
+
+    // destroying b takes the moved subtree with it
+    h.destroy(b);
+    REQUIRE(!h.valid(b));
+    h.update();
+    REQUIRE(h.size() == 1);
+    REQUIRE(h.valid(a));
+    REQUIRE(!h.valid(a_child));
+    REQUIRE(!h.valid(a_grand_child));
+    REQUIRE(near(h.world_matrix(a), glm::translate(glm::mat4(1.0f), glm::vec3(1, 0, 0))));
+
+    // indices are reused, the ids of the destroyed transforms stay invalid
+    const uint32_t c = h.create(a);
+    REQUIRE(TransformHierarchy::index(c) < 4);
+    REQUIRE(h.valid(c));
+    REQUIRE(c != b);
+    REQUIRE(c != a_child);
+    REQUIRE(c != a_grand_child);
+    REQUIRE(!h.valid(b));
+    REQUIRE(!h.valid(a_child));
+    REQUIRE(!h.valid(a_grand_child));
+    REQUIRE(h.parent(c) == a);
+    h.update();
+    REQUIRE(h.size() == 2);
+    REQUIRE(near(h.world_matrix(c), h.world_matrix(a)));
+}
+
+TEST_CASE("Transform hierarchy ids of recycled indices stay invalid")
+{
+    TransformHierarchy h;
+    const uint32_t root = h.create();
+    uint32_t stale = h.create(root);
+    for (uint32_t i = 0; i < TransformHierarchy::kMaxGenerations - 1; i++)
+    {
+        h.destroy(stale);
+        h.update();
+        const uint32_t reused = h.create(root);
+        REQUIRE(TransformHierarchy::index(reused) == TransformHierarchy::index(stale));
+        REQUIRE(h.valid(reused));
+        REQUIRE(!h.valid(stale));
+        stale = reused;
+    }
+    REQUIRE(!h.valid(TransformHierarchy::kNone));
+}
+
+TEST_CASE("Transform hierarchy ignores stale ids")
+{
+    TransformHierarchy h;
+    const uint32_t root = h.create();
+    const uint32_t stale = h.create(root);
+    h.destroy(stale);
+    // a second destroy of the same id is ignored, before and after the update
+    h.destroy(stale);
+    REQUIRE(h.size() == 1);
+    h.update();
+    h.destroy(stale);
+    REQUIRE(h.size() == 1);
+    // before its index is reused, and after
+    h.set_local(stale, glm::vec3(1, 2, 3), glm::quat(1, 0, 0, 0));
+    const uint32_t reused = h.create(root);
+    REQUIRE(TransformHierarchy::index(reused) == TransformHierarchy::index(stale));
+    h.set_local(reused, glm::vec3(0, 0, 1), glm::quat(1, 0, 0, 0));
+    h.set_local(stale, glm::vec3(5, 5, 5), glm::quat(1, 0, 0, 0));
+    h.set_parent(stale, TransformHierarchy::kNone);
+    h.destroy(stale);
+    h.update();
+    REQUIRE(h.valid(reused));
+    REQUIRE(h.size() == 2);
+    REQUIRE(h.parent(reused) == root);
+    REQUIRE(h.local_position(reused) == glm::vec3(0, 0, 1));
+    REQUIRE(h.world_position(reused) == glm::vec3(0, 0, 1));
+    // a stale parent is ignored as well
+    h.set_parent(reused, stale);
+    h.update();
+    REQUIRE(h.parent(reused) == root);
+}
+
+TEST_CASE("Parallel transform update matches the reference")
+{
+    // a forest with one large tree and many small ones, so the update splits below the roots
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    TransformHierarchy h;
+    std::vector<uint32_t> ids;
+    ids.push_back(h.create());
+    for (int i = 1; i < 20'000; i++)
+    {
+        // the first half hangs below the first root, the rest forms trees of ten
+        const int tree_start = i < 10'000 ? 0 : i - i % 10;
+        if (tree_start == i)
+        {
+            ids.push_back(h.create());
+        }
+        else
+        {
+            ids.push_back(h.create(ids[std::uniform_int_distribution<int>(tree_start, i - 1)(rng)]));
+        }
+    }
+    auto randomize = [&](uint32_t id) {
+        const glm::vec3 axis = glm::normalize(glm::vec3(offset(rng), offset(rng), 1.0f));
+        h.set_local(id, glm::vec3(offset(rng), offset(rng), offset(rng)), glm::angleAxis(offset(rng), axis));
+    };
+    for (uint32_t id : ids)
+    {
+        randomize(id);
+    }
+    jobs::ThreadPool pool(4);
+    h.update(&pool);
+    for (uint32_t id : ids)
+    {
+        REQUIRE(h.world_changed(id));
+    }
+    for (int frame = 0; frame < 3; frame++)
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            randomize(ids[std::uniform_int_distribution<size_t>(0, ids.size() - 1)(rng)]);
+        }
+        h.update(&pool);
+        // a few levels of float rounding per transform
+        for (size_t i = 0; i < ids.size(); i += 7)
+        {
+            REQUIRE(near(h.world_matrix(ids[i]), reference_world(h, ids[i])));
+            REQUIRE(near_world(h, ids[i]));
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include "allocationcounter.h"
+#include "view.h"
+#include <catch2/catch_test_macros.hpp>
+
+using namespace components;
+
+struct Velocity : public Component
+{
+    DEFINE_COMPONENT_ID(Velocity)
+    float v = 1;
+};
+
+struct Mass : public Component
+{
+    DEFINE_COMPONENT_ID(Mass)
+    float m = 2;
+};
+
+TEST_CASE("View visits matching entities by reference")
+{
+    Registry registry;
+    View<Velocity> velocities;
+    View<Velocity, Mass> bodies;
+    registry.create(Velocity());
+    registry.create(Velocity(), Mass());
+    REQUIRE(velocities.size(registry) == 2);
+    REQUIRE(bodies.size(registry) == 1);
+
+    velocities.each(registry, [](Entity, Velocity& vel) { vel.v += 1; });
+    bodies.each(registry, [](Entity e, Velocity& vel, Mass& mass) {
+        REQUIRE(vel.v == 2);
+        REQUIRE(e.get_component<Mass>() == &mass);
+    });
+
+    // archetypes created after the first use are picked up
+    registry.create(Mass(), Velocity());
+    REQUIRE(bodies.size(registry) == 2);
+}
+
+TEST_CASE("Iterating a view performs no heap allocation in steady state")
+{
+    Registry registry;
+    for (int i = 0; i < 1000; i++)
+    {
+        Entity e = registry.create(Velocity());
+        if (i % 3 == 0)
+        {
+            e.add_component(Mass());
+        }
+    }
+    View<Velocity> velocities;
+    View<Velocity, Mass> bodies;
+    auto update = [&]() {
+        velocities.each(registry, [](Entity, Velocity& vel) { vel.v *= 0.5f; });
+        bodies.each(registry, [](Entity, Velocity& vel, Mass& mass) { vel.v += mass.m; });
+    };
+    // the first pass caches the matching archetypes
+    update();
+    const size_t allocations = allocation_count();
+    for (int i = 0; i < 10; i++)
+    {
+        update();
+    }
+    REQUIRE(allocation_count() == allocations);
+}
@@ -1,11 +1,81 @@
+#include "gltftriangle.h"
 #include "tiny_gltf.h"
 #include "visual.h"
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 
 using namespace components;
 
 TEST_CASE("from gltf")
 {
     Visual3d::from_gltf_file("/home/tlangmo/dev/vulkan-human/assets/torus.gltf");
-}
\ No newline at end of file
+}
+static void check_triangle(const Visual3d& viz)
+{
+    REQUIRE(viz.vertices().size() == 3);
+    REQUIRE(viz.indices() == std::vector<uint32_t>{2, 1, 0});
+    REQUIRE(viz.vertices()[1].position == glm::vec3(1, 0, 0));
+    REQUIRE(viz.vertices()[1].normal == glm::vec3(0, 0, 1));
+    REQUIRE(viz.vertices()[1].uv == glm::vec2(1, 0));
+    REQUIRE(viz.vertices()[2].uv == glm::vec2(1, 1));
+    // the loaders compute the bounds
+    REQUIRE(viz.bounds().min == glm::vec3(0, 0, 0));
+    REQUIRE(viz.bounds().max == glm::vec3(1, 1, 0));
+    REQUIRE(viz.bounds().center == glm::vec3(0.5f, 0.5f, 0));
+    REQUIRE(std::abs(viz.bounds().radius - std::sqrt(0.5f)) < 1e-6f);
+}
+
+TEST_CASE("from gltf mapped, glb")
+{
+    std::string json = triangle_json("");
+    json.resize((json.size() + 3) / 4 * 4, ' ');
+    std::vector<unsigned char> bin = triangle_bin();
+    bin.resize((bin.size() + 3) / 4 * 4, 0);
+    const uint32_t header[] = {0x46546C67, 2, (uint32_t)(12 + 8 + json.size() + 8 + bin.size())};
+    const uint32_t json_chunk[] = {(uint32_t)json.size(), 0x4E4F534A};
+    const uint32_t bin_chunk[] = {(uint32_t)bin.size(), 0x004E4942};
+
+    const std::string fn = "visual_test_triangle.glb";
+    std::ofstream out(fn, std::ios::binary);
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)json_chunk, sizeof(json_chunk));
+    out.write(json.data(), json.size());
+    out.write((const char*)bin_chunk, sizeof(bin_chunk));
+    out.write((const char*)bin.data(), bin.size());
+    out.close();
+
+    check_triangle(Visual3d::from_gltf_mapped(fn));
+    std::remove(fn.c_str());
+}
+
+TEST_CASE("from gltf mapped, external bin")
+{
+    std::vector<unsigned char> bin = triangle_bin();
+    std::ofstream("visual_test_triangle.bin", std::ios::binary).write((const char*)bin.data(), bin.size());
+    std::ofstream("visual_test_triangle.gltf") << triangle_json("visual_test_triangle.bin");
+
+    check_triangle(Visual3d::from_gltf_mapped("visual_test_triangle.gltf"));
+    std::remove("visual_test_triangle.bin");
+    std::remove("visual_test_triangle.gltf");
+
+    REQUIRE_THROWS(Visual3d::from_gltf_mapped("visual_test_does_not_exist.glb"));
+}
+
+TEST_CASE("from gltf mapped, embedded base64")
+{
+    Visual3d viz = Visual3d::from_gltf_mapped(ASSETS_DIR "/torus_smooth.gltf");
+    REQUIRE(viz.vertices().size() == 637);
+    REQUIRE(viz.indices().size() == 3456);
+    for (const StandardVertex& v : viz.vertices())
+    {
+        // bounds from the accessor min/max
+        REQUIRE(std::abs(v.position.x) <= 1.25f);
+        REQUIRE(std::abs(v.position.y) <= 0.25f);
+        REQUIRE(std::abs(glm::length(v.normal) - 1.0f) < 1e-3f);
+        REQUIRE(v.uv.x >= 0.0f);
+        REQUIRE(v.uv.x <= 1.0f);
+    }
+}
@@ -0,0 +1,298 @@
+#include "transformhierarchy.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace components
+{
+
+// smallest number of transforms worth a task of their own
+static const size_t kMinRangeSize = 1024;
+
+uint32_t TransformHierarchy::create(uint32_t parent)
+{
+    assert(parent == kNone || valid(parent));
+    uint32_t id;
+    if (!m_free_ids.empty())
+    {
+        id = m_free_ids.back();
+        m_free_ids.pop_back();
+    }
+    else
+    {
+        if (m_parent.size() == kMaxTransforms)
+        {
+            throw std::length_error("too many transforms in the hierarchy");
+        }
+        id = (uint32_t)m_parent.size();
+        m_parent.push_back(kNone);
+        m_slot.push_back(kNone);
+        m_alive.push_back(0);
+        m_generations.push_back(0);
+    }
+    m_parent[id] = parent == kNone ? kNone : index(parent);
+    m_alive[id] = 1;
+    m_live_count++;
+    append_slot(id);
+    // a new root at the end keeps the depth-first order
+    if (parent != kNone)
+    {
+        m_order_dirty = true;
+    }
+    return make_id(id);
+}
+
+void TransformHierarchy::append_slot(uint32_t id)
+{
+    m_slot[id] = (uint32_t)m_ids.size();
+    m_ids.push_back(id);
+    m_parent_slots.push_back(kNone);
+    m_subtree_sizes.push_back(1);
+    m_positions.push_back(glm::vec3(0.0f));
+    m_rotations.push_back(glm::quat(1, 0, 0, 0));
+    m_locals.push_back(glm::mat4(1.0f));
+    m_worlds.push_back(glm::mat4(1.0f));
+    m_world_positions.push_back(glm::vec3(0.0f));
+    m_world_rotations.push_back(glm::quat(1, 0, 0, 0));
+    m_flags.push_back(kLocalDirty);
+}
+
+void TransformHierarchy::destroy(uint32_t id)
+{
+    if (!valid(id))
+    {
+        return;
+    }
+    // the descendants are found and dropped by the next reorder
+    m_alive[index(id)] = 0;
+    m_live_count--;
+    m_order_dirty = true;
+}
+
+void TransformHierarchy::set_parent(uint32_t id, uint32_t parent)
+{
+    if (!valid(id) || (parent != kNone && !valid(parent)))
+    {
+        return;
+    }
+    id = index(id);
+    m_parent[id] = parent == kNone ? kNone : index(parent);
+    m_flags[m_slot[id]] |= kLocalDirty;
+    m_order_dirty = true;
+}
+
+void TransformHierarchy::set_local(uint32_t id, const glm::vec3& position, const glm::quat& rotation)
+{
+    if (!valid(id))
+    {
+        return;
+    }
+    const uint32_t slot = m_slot[index(id)];
+    m_positions[slot] = position;
+    m_rotations[slot] = rotation;
+    m_flags[slot] |= kLocalDirty;
+}
+
+void TransformHierarchy::reorder()
+{
+    const uint32_t id_count = (uint32_t)m_parent.size();
+    const size_t slot_count = m_ids.size();
+    auto in_tree = [this](uint32_t id) { return m_alive[id] && (m_parent[id] == kNone || m_alive[m_parent[id]]); };
+
+    // children per id as offsets into m_children, in the order of their current slots
+    m_child_offsets.assign(id_count + 1, 0);
+    for (uint32_t id = 0; id < id_count; id++)
+    {
+        if (in_tree(id) && m_parent[id] != kNone)
+        {
+            m_child_offsets[m_parent[id] + 1]++;
+        }
+    }
+    for (uint32_t id = 0; id < id_count; id++)
+    {
+        m_child_offsets[id + 1] += m_child_offsets[id];
+    }
+    m_children.resize(m_child_offsets[id_count]);
+    m_order.assign(m_child_offsets.begin(), m_child_offsets.end() - 1); // write cursor per id
+    for (size_t s = 0; s < slot_count; s++)
+    {
+        const uint32_t id = m_ids[s];
+        if (m_slot[id] == s && in_tree(id) && m_parent[id] != kNone)
+        {
+            m_children[m_order[m_parent[id]]++] = id;
+        }
+    }
+
+    // depth-first from the roots; transforms below a destroyed one are not reached
+    m_order.clear();
+    for (size_t s = 0; s < slot_count; s++)
+    {
+        const uint32_t root = m_ids[s];
+        if (m_slot[root] != s || !m_alive[root] || m_parent[root] != kNone)
+        {
+            continue;
+        }
+        m_stack.assign(1, root);
+        while (!m_stack.empty())
+        {
+            const uint32_t id = m_stack.back();
+            m_stack.pop_back();
+            m_order.push_back(id);
+            for (uint32_t c = m_child_offsets[id + 1]; c > m_child_offsets[id]; c--)
+            {
+                m_stack.push_back(m_children[c - 1]);
+            }
+        }
+    }
+
+    std::vector<uint32_t> parent_slots(m_order.size());
+    std::vector<uint32_t> subtree_sizes(m_order.size(), 1);
+    std::vector<glm::vec3> positions(m_order.size());
+    std::vector<glm::quat> rotations(m_order.size());
+    std::vector<glm::mat4> locals(m_order.size());
+    std::vector<glm::mat4> worlds(m_order.size());
+    std::vector<glm::vec3> world_positions(m_order.size());
+    std::vector<glm::quat> world_rotations(m_order.size());
+    std::vector<uint8_t> flags(m_order.size());
+    // m_slot still maps to the old slots, the new slot of each id goes to m_child_offsets
+    std::vector<uint32_t>& new_slot = m_child_offsets;
+    std::fill(new_slot.begin(), new_slot.end(), kNone);
+    for (uint32_t s = 0; s < m_order.size(); s++)
+    {
+        const uint32_t id = m_order[s];
+        const uint32_t old = m_slot[id];
+        new_slot[id] = s;
+        // parents come first, so their new slot is known
+        parent_slots[s] = m_parent[id] == kNone ? kNone : new_slot[m_parent[id]];
+        positions[s] = m_positions[old];
+        rotations[s] = m_rotations[old];
+        locals[s] = m_locals[old];
+        worlds[s] = m_worlds[old];
+        world_positions[s] = m_world_positions[old];
+        world_rotations[s] = m_world_rotations[old];
+        flags[s] = m_flags[old];
+    }
+    for (size_t s = m_order.size(); s-- > 1;)
+    {
+        if (parent_slots[s] != kNone)
+        {
+            subtree_sizes[parent_slots[s]] += subtree_sizes[s];
+        }
+    }
+    // ids which had a slot and were not reached are free now, their next use gets another generation
+    for (uint32_t id = 0; id < id_count; id++)
+    {
+        if (m_slot[id] != kNone && new_slot[id] == kNone)
+        {
+            if (m_alive[id])
+            {
+                m_alive[id] = 0;
+                m_live_count--;
+            }
+            m_generations[id] = (uint16_t)((m_generations[id] + 1) % kMaxGenerations);
+            m_free_ids.push_back(id);
+        }
+        m_slot[id] = new_slot[id];
+    }
+
+    m_ids.swap(m_order);
+    m_parent_slots.swap(parent_slots);
+    m_subtree_sizes.swap(subtree_sizes);
+    m_positions.swap(positions);
+    m_rotations.swap(rotations);
+    m_locals.swap(locals);
+    m_worlds.swap(worlds);
+    m_world_positions.swap(world_positions);
+    m_world_rotations.swap(world_rotations);
+    m_flags.swap(flags);
+    m_order_dirty = false;
+}
+
+void TransformHierarchy::update_range(size_t begin, size_t end)
+{
+    for (size_t s = begin; s < end; s++)
+    {
+        const uint8_t flags = m_flags[s];
+        const uint32_t parent = m_parent_slots[s];
+        // the parent was updated before, its flags tell about this update
+        const bool parent_changed = parent != kNone && (m_flags[parent] & kWorldChanged) != 0;
+        if (flags & kLocalDirty)
+        {
+            m_locals[s] = glm::mat4_cast(m_rotations[s]);
+            m_locals[s][3] = glm::vec4(m_positions[s], 1.0f);
+        }
+        const bool changed = (flags & kLocalDirty) || parent_changed;
+        if (changed && parent == kNone)
+        {
+            m_worlds[s] = m_locals[s];
+            m_world_positions[s] = m_positions[s];
+            m_world_rotations[s] = m_rotations[s];
+        }
+        else if (changed)
+        {
+            m_worlds[s] = m_worlds[parent] * m_locals[s];
+            m_world_positions[s] = m_world_positions[parent] + m_world_rotations[parent] * m_positions[s];
+            m_world_rotations[s] = m_world_rotations[parent] * m_rotations[s];
+        }
+        m_flags[s] = changed ? kWorldChanged : 0;
+    }
+}
+
+void TransformHierarchy::update(jobs::ThreadPool* pool)
+{
+    if (m_order_dirty)
+    {
+        reorder();
+    }
+    const size_t count = m_ids.size();
+    const size_t target = pool == nullptr ? count : std::max(kMinRangeSize, count / (pool->size() * 4));
+    if (pool == nullptr || pool->size() == 1 || count <= target)
+    {
+        update_range(0, count);
+        return;
+    }
+
+    // split the forest into subtrees of at most target transforms, the roots of larger subtrees are updated serially
+    m_serial_slots.clear();
+    m_ranges.clear();
+    m_stack.clear();
+    for (uint32_t s = 0; s < count; s += m_subtree_sizes[s])
+    {
+        m_stack.push_back(s);
+    }
+    std::reverse(m_stack.begin(), m_stack.end());
+    while (!m_stack.empty())
+    {
+        const uint32_t s = m_stack.back();
+        const uint32_t size = m_subtree_sizes[s];
+        m_stack.pop_back();
+        if (size > target)
+        {
+            m_serial_slots.push_back(s);
+            const size_t first_child = m_stack.size();
+            for (uint32_t c = s + 1; c < s + size; c += m_subtree_sizes[c])
+            {
+                m_stack.push_back(c);
+            }
+            std::reverse(m_stack.begin() + first_child, m_stack.end());
+        }
+        else if (!m_ranges.empty() && m_ranges.back().second == s && s + size - m_ranges.back().first <= target)
+        {
+            // neighbouring small subtrees share a task
+            m_ranges.back().second = s + size;
+        }
+        else
+        {
+            m_ranges.push_back({s, s + size});
+        }
+    }
+    // serial slots were found in depth-first order, so parents come first
+    for (uint32_t s : m_serial_slots)
+    {
+        update_range(s, s + 1);
+    }
+    pool->parallel_for(m_ranges.size(), [this](size_t i) { update_range(m_ranges[i].first, m_ranges[i].second); });
+}
+
+} // namespace components
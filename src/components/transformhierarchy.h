@@ -0,0 +1,163 @@
+#pragma once
+#include "glm/gtc/quaternion.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace jobs
+{
+class ThreadPool;
+}
+
+namespace components
+{
+
+/**
+ * Parent/child hierarchy of rigid transforms with cached local and world matrices. Transforms are identified by the
+ * id create() returned. Setters only mark a transform dirty; update() recomputes the matrices of the dirty transforms
+ * and of their descendants in one pass.
+ *
+ * An id is the index of the transform plus a generation, so the id of a destroyed transform stays invalid when its
+ * index is reused, up to kMaxGenerations reuses of the same index.
+ *
+ * The data is stored as struct-of-arrays in depth-first order, so parents come before their children and every
+ * subtree is a contiguous range. Structural changes reorder the arrays once, at the next update().
+ */
+class TransformHierarchy
+{
+  public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr uint32_t kIndexBits = 22;
+    // the index of kNone is never used
+    static constexpr uint32_t kMaxTransforms = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kMaxGenerations = 1u << (32 - kIndexBits);
+
+    // the index of the transform id, reused once the transform is destroyed
+    static uint32_t index(uint32_t id)
+    {
+        return id & kMaxTransforms;
+    }
+
+    // add a transform with identity local transform, as a root or as the last child of parent, which must be valid
+    uint32_t create(uint32_t parent = kNone);
+    // destroy the transform and all its descendants. The setters ignore ids which are not valid(), the getters
+    // assert them
+    void destroy(uint32_t id);
+    bool valid(uint32_t id) const
+    {
+        const uint32_t i = index(id);
+        return i < m_alive.size() && m_alive[i] && m_generations[i] == id >> kIndexBits;
+    }
+    // parent must not be a descendant of id; kNone makes id a root
+    void set_parent(uint32_t id, uint32_t parent);
+    uint32_t parent(uint32_t id) const
+    {
+        assert(valid(id));
+        const uint32_t p = m_parent[index(id)];
+        return p == kNone ? kNone : make_id(p);
+    }
+
+    void set_local(uint32_t id, const glm::vec3& position, const glm::quat& rotation);
+    const glm::vec3& local_position(uint32_t id) const
+    {
+        return m_positions[slot(id)];
+    }
+    const glm::quat& local_rotation(uint32_t id) const
+    {
+        return m_rotations[slot(id)];
+    }
+    // matrices as of the last update()
+    const glm::mat4& local_matrix(uint32_t id) const
+    {
+        return m_locals[slot(id)];
+    }
+    const glm::mat4& world_matrix(uint32_t id) const
+    {
+        return m_worlds[slot(id)];
+    }
+    // the world matrix as a position and a rotation, e.g. for a CoordSys attached to id
+    const glm::vec3& world_position(uint32_t id) const
+    {
+        return m_world_positions[slot(id)];
+    }
+    const glm::quat& world_rotation(uint32_t id) const
+    {
+        return m_world_rotations[slot(id)];
+    }
+    // true if the last update() changed the world matrix
+    bool world_changed(uint32_t id) const
+    {
+        return (m_flags[slot(id)] & kWorldChanged) != 0;
+    }
+
+    /**
+     * Recompute the matrices of dirty transforms and their descendants. With a pool, subtrees which do not depend on
+     * each other are updated in parallel; the few ancestors shared by several of them are updated first.
+     */
+    void update(jobs::ThreadPool* pool = nullptr);
+
+    // number of live transforms
+    size_t size() const
+    {
+        return m_live_count;
+    }
+
+  private:
+    uint32_t make_id(uint32_t i) const
+    {
+        return i | (uint32_t)m_generations[i] << kIndexBits;
+    }
+    uint32_t slot(uint32_t id) const
+    {
+        assert(valid(id));
+        return m_slot[index(id)];
+    }
+
+  private:
+    enum Flags : uint8_t
+    {
+        kLocalDirty = 1,
+        kWorldChanged = 2,
+    };
+    // appends a slot for id at the end of the arrays, the order is restored by reorder()
+    void append_slot(uint32_t id);
+    // sort the slots depth-first and drop the destroyed transforms
+    void reorder();
+    void update_range(size_t begin, size_t end);
+
+  private:
+    // per index, the parents and the ids below are indices too
+    std::vector<uint32_t> m_parent;
+    std::vector<uint32_t> m_slot;
+    std::vector<uint8_t> m_alive;
+    std::vector<uint16_t> m_generations;
+    std::vector<uint32_t> m_free_ids;
+    size_t m_live_count = 0;
+
+    // per slot, in depth-first order unless m_order_dirty
+    std::vector<uint32_t> m_ids;
+    std::vector<uint32_t> m_parent_slots;
+    std::vector<uint32_t> m_subtree_sizes;
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::mat4> m_locals;
+    std::vector<glm::mat4> m_worlds;
+    std::vector<glm::vec3> m_world_positions;
+    std::vector<glm::quat> m_world_rotations;
+    std::vector<uint8_t> m_flags;
+    bool m_order_dirty = false;
+
+    // scratch space of reorder() and update(), kept to reuse the capacity
+    std::vector<uint32_t> m_child_offsets;
+    std::vector<uint32_t> m_children;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_stack;
+    std::vector<uint32_t> m_serial_slots;
+    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
+};
+
+} // namespace components
@@ -0,0 +1,78 @@
+#pragma once
+#include "registry.h"
+#include <tuple>
+#include <vector>
+
+namespace components
+{
+
+/**
+ * Cached query over all entities owning the components Ts. The matching archetypes are remembered between calls and
+ * only archetypes created since the last call are inspected, so iterating a view in steady state performs no heap
+ * allocation. Keep views as members of a system; a view must not outlive the registry it was last used with.
+ */
+template <typename... Ts> class View
+{
+  public:
+    /**
+     * Call fn(Entity, Ts&...) for every matching entity. The callback must not add or remove components or entities.
+     */
+    template <typename F> void each(Registry& registry, F&& fn)
+    {
+        refresh(registry);
+        for (Archetype* arch : m_archetypes)
+        {
+            const size_t count = arch->size();
+            if (count == 0)
+            {
+                continue;
+            }
+            std::tuple<Ts*...> columns{arch->column<Ts>()...};
+            const uint32_t* entities = arch->entities().data();
+            for (size_t row = 0; row < count; row++)
+            {
+                fn(Entity(&registry, entities[row], registry.m_records[entities[row]].generation),
+                   std::get<Ts*>(columns)[row]...);
+            }
+        }
+    }
+
+    // number of entities currently matching the view
+    size_t size(Registry& registry)
+    {
+        refresh(registry);
+        size_t count = 0;
+        for (Archetype* arch : m_archetypes)
+        {
+            count += arch->size();
+        }
+        return count;
+    }
+
+  private:
+    void refresh(Registry& registry)
+    {
+        if (m_registry != &registry)
+        {
+            m_registry = &registry;
+            m_archetypes.clear();
+            m_checked = 0;
+        }
+        // archetypes are never removed from a registry, so only the new ones need checking
+        const auto& archetypes = registry.archetypes();
+        for (; m_checked < archetypes.size(); m_checked++)
+        {
+            if ((archetypes[m_checked]->contains(Ts::id()) && ...))
+            {
+                m_archetypes.push_back(archetypes[m_checked].get());
+            }
+        }
+    }
+
+  private:
+    Registry* m_registry = nullptr;
+    size_t m_checked = 0;
+    std::vector<Archetype*> m_archetypes;
+};
+
+} // namespace components
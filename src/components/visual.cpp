@@ -4,15 +4,22 @@
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "tiny_gltf.h"
-#include <iostream>
+#include "glm/glm.hpp"
+#include "mappedfile.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <map>
 
 namespace components
 {
 
-std::shared_ptr<Visual3d> Visual3d::make_triangle()
+Visual3d Visual3d::make_triangle()
 {
-    auto comp = std::make_shared<Visual3d>();
-    std::vector<StandardVertex>& vertices = comp->vertices();
+    Visual3d comp;
+    std::vector<StandardVertex>& vertices = comp.vertices();
     vertices.resize(3);
     vertices[0].position = {1.f, 1.f, 0.0f};
     vertices[1].position = {-1.f, 1.f, 0.0f};
@@ -25,17 +32,118 @@ std::shared_ptr<Visual3d> Visual3d::make_triangle()
     vertices[0].color = {1.f, 0.f, 0.0f};
     vertices[1].color = {0.f, 1.f, 0.0f};
     vertices[2].color = {0.f, 0.f, 1.0f};
-    comp->indices() = {0, 1, 2};
+    comp.indices() = {0, 1, 2};
+    comp.update_bounds();
     return comp;
 }
 
-std::shared_ptr<Visual3d> Visual3d::from_gltf_file(const std::string& fn)
+const Visual3d& Visual3d::placeholder()
+{
+    static const Visual3d comp = []() {
+        Visual3d c;
+        const glm::vec3 corners[] = {{0.25f, 0, 0}, {-0.25f, 0, 0}, {0, 0.25f, 0},
+                                     {0, -0.25f, 0}, {0, 0, 0.25f}, {0, 0, -0.25f}};
+        for (const glm::vec3& p : corners)
+        {
+            c.vertices().push_back(StandardVertex{p, p * 4.0f, glm::vec2(0.0f), glm::vec3(0.5f)});
+        }
+        c.indices() = {0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5};
+        c.update_bounds();
+        return c;
+    }();
+    return comp;
+}
+
+uint64_t Visual3d::content_hash() const
+{
+    // MurmurHash64A over 64 bit words, the zero padded tail and the sizes are mixed in the same way. Unlike FNV-1a
+    // over words, every input bit reaches every hash bit, e.g. sign flips in the high half of a word
+    const uint64_t m = UINT64_C(0xc6a4a7935bd1e995);
+    uint64_t h = UINT64_C(14695981039346656037);
+    auto mix_word = [&h, m](uint64_t k) {
+        k *= m;
+        k ^= k >> 47;
+        k *= m;
+        h = (h ^ k) * m;
+    };
+    auto mix = [&mix_word](const void* data, size_t size) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (; size >= 8; p += 8, size -= 8)
+        {
+            uint64_t word;
+            memcpy(&word, p, 8);
+            mix_word(word);
+        }
+        if (size > 0)
+        {
+            uint64_t word = 0;
+            memcpy(&word, p, size);
+            mix_word(word);
+        }
+    };
+    const uint64_t sizes[] = {m_vertices.size(), m_indices.size()};
+    mix(sizes, sizeof(sizes));
+    mix(m_vertices.data(), m_vertices.size() * sizeof(StandardVertex));
+    mix(m_indices.data(), m_indices.size() * sizeof(uint32_t));
+    // the same geometry stored differently is a different GPU mesh
+    if (m_compact_vertices)
+    {
+        mix_word(1);
+    }
+    h ^= h >> 47;
+    h *= m;
+    h ^= h >> 47;
+    return h;
+}
+
+bool Visual3d::same_content(const Visual3d& other) const
+{
+    return m_compact_vertices == other.m_compact_vertices && m_vertices.size() == other.m_vertices.size() &&
+           m_indices == other.m_indices &&
+           (m_vertices.empty() ||
+            memcmp(m_vertices.data(), other.m_vertices.data(), m_vertices.size() * sizeof(StandardVertex)) == 0);
+}
+
+void Visual3d::update_bounds()
+{
+    if (m_vertices.empty())
+    {
+        m_bounds = Bounds{};
+        return;
+    }
+    Bounds b = {m_vertices[0].position, m_vertices[0].position, glm::vec3(0.0f), 0.0f};
+    for (const StandardVertex& v : m_vertices)
+    {
+        b.min = glm::min(b.min, v.position);
+        b.max = glm::max(b.max, v.position);
+    }
+    b.center = (b.min + b.max) * 0.5f;
+    float radius_sq = 0.0f;
+    for (const StandardVertex& v : m_vertices)
+    {
+        const glm::vec3 d = v.position - b.center;
+        radius_sq = std::max(radius_sq, glm::dot(d, d));
+    }
+    b.radius = std::sqrt(radius_sq);
+    m_bounds = b;
+}
+
+size_t Visual3d::next_geometry_id()
+{
+    static std::atomic<size_t> next_id{1};
+    return next_id++;
+}
+
+Visual3d Visual3d::from_gltf_file(const std::string& fn)
 {
     tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
     tinygltf::Model model;
-    if (loader.LoadASCIIFromFile(&model, &err, &warn, fn) == false)
+    const bool binary = fn.size() > 4 && fn.compare(fn.size() - 4, 4, ".glb") == 0;
+    const bool loaded = binary ? loader.LoadBinaryFromFile(&model, &err, &warn, fn)
+                               : loader.LoadASCIIFromFile(&model, &err, &warn, fn);
+    if (loaded == false)
     {
         throw std::runtime_error("cannot load gltf file");
     }
@@ -45,8 +153,8 @@ std::shared_ptr<Visual3d> Visual3d::from_gltf_file(const std::string& fn)
         throw std::runtime_error("gltf file contains more than one mesh! unsupported.");
     }
 
-    auto comp = std::make_shared<Visual3d>();
-    std::vector<StandardVertex>& vertices = comp->vertices();
+    Visual3d comp;
+    std::vector<StandardVertex>& vertices = comp.vertices();
 
     // // extract the indicies for the first model;
     const tinygltf::Mesh& m = model.meshes[0];
@@ -59,7 +167,7 @@ std::shared_ptr<Visual3d> Visual3d::from_gltf_file(const std::string& fn)
     {
         const unsigned char* p_start = index_buffer.data.data() + index_view.byteOffset + acc_index.byteOffset;
         const unsigned char* p_end = p_start + index_view.byteLength;
-        comp->indices() = (acc_index.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+        comp.indices() = (acc_index.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
                               ? load_indices_raw<uint16_t>(p_start, p_end)
                               : load_indices_raw<uint32_t>(p_start, p_end);
     }
@@ -93,15 +201,281 @@ std::shared_ptr<Visual3d> Visual3d::from_gltf_file(const std::string& fn)
         {
             throw std::runtime_error("gltf attributes are of inconsistent size.unsupported!");
         }
-        iterate_accessor<glm::vec3>(acc, model, [&vertices, &p_va](const glm::vec2& tex_coords) {
+        iterate_accessor<glm::vec2>(acc, model, [&vertices, &p_va](const glm::vec2& tex_coords) {
             p_va->uv = tex_coords;
             p_va++;
         });
     }
 
-    std::cout << "Mesh stats:\n#vertices:\t" << comp->vertices().size() << "\n#indices:\t" << comp->indices().size()
-              << std::endl;
+    comp.update_bounds();
+    return comp;
+}
+
+namespace
+{
+const uint32_t kGlbMagic = 0x46546C67; // "glTF"
+const uint32_t kGlbChunkJson = 0x4E4F534A;
+const uint32_t kGlbChunkBin = 0x004E4942;
+
+struct BufferData
+{
+    const unsigned char* data;
+    size_t size;
+};
+
+// strided elements of one accessor, pointing into a buffer
+struct AccessorData
+{
+    const unsigned char* data;
+    size_t stride;
+    size_t count;
+    int component_type;
+};
+
+std::vector<unsigned char> decode_base64(const char* p, size_t n)
+{
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::vector<unsigned char> out;
+    out.reserve(n / 4 * 3);
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (size_t i = 0; i < n && p[i] != '='; i++)
+    {
+        const char* v = p[i] != 0 ? strchr(alphabet, p[i]) : nullptr;
+        if (v == nullptr)
+        {
+            throw std::runtime_error("gltf buffer has invalid base64 data");
+        }
+        bits = (bits << 6) | (uint32_t)(v - alphabet);
+        bit_count += 6;
+        if (bit_count >= 8)
+        {
+            bit_count -= 8;
+            out.push_back((unsigned char)(bits >> bit_count));
+        }
+    }
+    return out;
+}
+
+size_t component_size(int component_type)
+{
+    switch (component_type)
+    {
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        return 1;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        return 2;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        return 4;
+    }
+    throw std::runtime_error("gltf accessor has an invalid component type");
+}
+
+size_t component_count(const std::string& type)
+{
+    static const std::map<std::string, size_t> counts = {{"SCALAR", 1}, {"VEC2", 2}, {"VEC3", 3}, {"VEC4", 4}};
+    auto it = counts.find(type);
+    if (it == counts.end())
+    {
+        throw std::runtime_error("gltf accessor has unsupported type " + type);
+    }
+    return it->second;
+}
+
+AccessorData get_accessor(const nlohmann::json& doc, const std::vector<BufferData>& buffers, int index,
+                          const char* type)
+{
+    const nlohmann::json& acc = doc.at("accessors").at(index);
+    if (acc.at("type").get<std::string>() != type || !acc.contains("bufferView"))
+    {
+        throw std::runtime_error(std::string("gltf accessor is not a ") + type + " backed by a buffer view");
+    }
+    const nlohmann::json& view = doc.at("bufferViews").at(acc.at("bufferView").get<int>());
+    const BufferData& buffer = buffers.at(view.at("buffer").get<int>());
 
+    AccessorData data;
+    data.count = acc.at("count").get<size_t>();
+    data.component_type = acc.at("componentType").get<int>();
+    const size_t element_size = component_size(data.component_type) * component_count(type);
+    data.stride = view.value("byteStride", (size_t)0);
+    if (data.stride == 0)
+    {
+        data.stride = element_size;
+    }
+    const size_t view_offset = view.value("byteOffset", (size_t)0);
+    const size_t view_length = view.at("byteLength").get<size_t>();
+    const size_t offset = acc.value("byteOffset", (size_t)0);
+    if (view_offset + view_length > buffer.size ||
+        (data.count > 0 && offset + data.stride * (data.count - 1) + element_size > view_length))
+    {
+        throw std::runtime_error("gltf accessor exceeds its buffer");
+    }
+    data.data = buffer.data + view_offset + offset;
+    return data;
+}
+
+// copy count float vectors of accessor into the member at member_offset of consecutive vertices
+template <typename T> void read_floats(const AccessorData& acc, StandardVertex* vertices, size_t member_offset)
+{
+    if (acc.component_type != TINYGLTF_COMPONENT_TYPE_FLOAT)
+    {
+        throw std::runtime_error("gltf vertex attributes must be floats");
+    }
+    for (size_t i = 0; i < acc.count; i++)
+    {
+        // glTF only guarantees 4 byte alignment
+        memcpy((char*)&vertices[i] + member_offset, acc.data + i * acc.stride, sizeof(T));
+    }
+}
+
+template <typename T> void read_indices(const AccessorData& acc, uint32_t* indices)
+{
+    for (size_t i = 0; i < acc.count; i++)
+    {
+        T idx;
+        memcpy(&idx, acc.data + i * acc.stride, sizeof(T));
+        indices[i] = idx;
+    }
+}
+} // namespace
+
+Visual3d Visual3d::from_gltf_mapped(const std::string& fn, std::vector<std::string>* external_files)
+{
+    MappedFile file(fn);
+    const unsigned char* json_begin = file.data();
+    size_t json_size = file.size();
+    BufferData glb_bin = {nullptr, 0};
+
+    uint32_t header[3] = {};
+    if (file.size() >= sizeof(header))
+    {
+        memcpy(header, file.data(), sizeof(header));
+    }
+    if (header[0] == kGlbMagic)
+    {
+        // header (magic, version, length), then a JSON chunk and an optional BIN chunk, each with length and type
+        size_t pos = sizeof(header);
+        while (pos + 8 <= file.size() && pos + 8 <= header[2])
+        {
+            uint32_t chunk[2];
+            memcpy(chunk, file.data() + pos, sizeof(chunk));
+            pos += 8;
+            if (pos + chunk[0] > file.size())
+            {
+                throw std::runtime_error("glb chunk exceeds the file: " + fn);
+            }
+            if (chunk[1] == kGlbChunkJson)
+            {
+                json_begin = file.data() + pos;
+                json_size = chunk[0];
+            }
+            else if (chunk[1] == kGlbChunkBin)
+            {
+                glb_bin = BufferData{file.data() + pos, chunk[0]};
+            }
+            pos += chunk[0];
+        }
+    }
+    const nlohmann::json doc = nlohmann::json::parse(json_begin, json_begin + json_size);
+
+    // buffers point into the mappings, only data URIs need a decoded copy
+    const std::string dir = fn.find_last_of('/') == std::string::npos ? "" : fn.substr(0, fn.find_last_of('/') + 1);
+    std::vector<MappedFile> bin_files;
+    std::vector<std::vector<unsigned char>> decoded;
+    std::vector<BufferData> buffers;
+    bin_files.reserve(doc.value("buffers", nlohmann::json::array()).size());
+    for (const nlohmann::json& buffer : doc.value("buffers", nlohmann::json::array()))
+    {
+        const std::string uri = buffer.value("uri", "");
+        if (uri.empty())
+        {
+            buffers.push_back(glb_bin);
+        }
+        else if (uri.compare(0, 5, "data:") == 0)
+        {
+            const size_t comma = uri.find(',');
+            if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos)
+            {
+                throw std::runtime_error("gltf data uri is not base64 encoded");
+            }
+            decoded.push_back(decode_base64(uri.data() + comma + 1, uri.size() - comma - 1));
+            buffers.push_back(BufferData{decoded.back().data(), decoded.back().size()});
+        }
+        else
+        {
+            bin_files.emplace_back(dir + uri);
+            if (external_files != nullptr)
+            {
+                external_files->push_back(dir + uri);
+            }
+            buffers.push_back(BufferData{bin_files.back().data(), bin_files.back().size()});
+        }
+        if (buffers.back().size < buffer.at("byteLength").get<size_t>())
+        {
+            throw std::runtime_error("gltf buffer is smaller than its byteLength");
+        }
+    }
+
+    // we only support single meshes for now. Validate
+    const nlohmann::json& meshes = doc.at("meshes");
+    if (meshes.size() != 1 || meshes[0].at("primitives").size() != 1)
+    {
+        throw std::runtime_error("gltf file contains more than one mesh! unsupported.");
+    }
+    const nlohmann::json& primitive = meshes[0].at("primitives")[0];
+    const nlohmann::json& attributes = primitive.at("attributes");
+
+    Visual3d comp;
+    AccessorData positions = get_accessor(doc, buffers, attributes.at("POSITION").get<int>(), "VEC3");
+    comp.vertices().resize(positions.count, StandardVertex{glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f),
+                                                           glm::vec3(1.0, 0.0, 1.0)});
+    read_floats<glm::vec3>(positions, comp.vertices().data(), offsetof(StandardVertex, position));
+    if (attributes.contains("NORMAL"))
+    {
+        AccessorData normals = get_accessor(doc, buffers, attributes["NORMAL"].get<int>(), "VEC3");
+        if (normals.count != positions.count)
+        {
+            throw std::runtime_error("gltf attributes are of inconsistent size.unsupported!");
+        }
+        read_floats<glm::vec3>(normals, comp.vertices().data(), offsetof(StandardVertex, normal));
+    }
+    if (attributes.contains("TEXCOORD_0"))
+    {
+        AccessorData uvs = get_accessor(doc, buffers, attributes["TEXCOORD_0"].get<int>(), "VEC2");
+        if (uvs.count != positions.count)
+        {
+            throw std::runtime_error("gltf attributes are of inconsistent size.unsupported!");
+        }
+        read_floats<glm::vec2>(uvs, comp.vertices().data(), offsetof(StandardVertex, uv));
+    }
+
+    AccessorData indices = get_accessor(doc, buffers, primitive.at("indices").get<int>(), "SCALAR");
+    comp.indices().resize(indices.count);
+    switch (indices.component_type)
+    {
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        read_indices<uint8_t>(indices, comp.indices().data());
+        break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        read_indices<uint16_t>(indices, comp.indices().data());
+        break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        read_indices<uint32_t>(indices, comp.indices().data());
+        break;
+    default:
+        throw std::runtime_error("gltf indices must be unsigned integers");
+    }
+    for (uint32_t idx : comp.indices())
+    {
+        if (idx >= comp.vertices().size())
+        {
+            throw std::runtime_error("gltf index out of range");
+        }
+    }
+    comp.update_bounds();
     return comp;
 }
 
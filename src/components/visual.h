@@ -17,6 +17,18 @@ struct StandardVertex
     glm::vec3 color;
 };
 
+/**
+ * Bounds of the vertex positions in model space. The sphere is centered in the box, with the radius of the farthest
+ * vertex, so it is usually tighter than the sphere around the box.
+ */
+struct Bounds
+{
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec3 center;
+    float radius;
+};
+
 /**A simple 3D mesh
  *
  */
@@ -24,9 +36,47 @@ class Visual3d : public Component
 {
   public:
     DEFINE_COMPONENT_ID(Visual3d);
-    Visual3d()
+    Visual3d() : m_geometry_id(next_geometry_id())
+    {
+    }
+    /**
+     * Identity of the geometry, shared by copies of the component and stable when the registry moves the component.
+     * Separately created visuals have distinct ids even if their geometry is equal, see content_hash().
+     */
+    size_t geometry_id() const
+    {
+        return m_geometry_id;
+    }
+    // hash of the vertex and index data and compact_vertices(), O(size) so callers should cache it per geometry_id()
+    uint64_t content_hash() const;
+    // whether the vertex and index data and compact_vertices() are equal byte for byte, for content_hash() collisions
+    bool same_content(const Visual3d& other) const;
+    /**
+     * Hint for the renderer to store the vertices quantized, in less than half the memory: positions to 1/65535 of the
+     * largest extent of bounds(), normals to about 0.01 degrees, uvs as half floats and colors with 8 bits. The
+     * RenderSystem needs a non-zero RenderSettings::geometry_max_compact_vertices for it, unless all its meshes are
+     * compact.
+     */
+    bool compact_vertices() const
+    {
+        return m_compact_vertices;
+    }
+    // a changed hint makes the visual a new geometry, so copies and cached meshes of the old one are not affected
+    void set_compact_vertices(bool compact)
     {
+        if (compact != m_compact_vertices)
+        {
+            m_compact_vertices = compact;
+            m_geometry_id = next_geometry_id();
+        }
     }
+    // bounds as of the last update_bounds(), the loaders call it
+    const Bounds& bounds() const
+    {
+        return m_bounds;
+    }
+    // recompute bounds() after modifying vertices()
+    void update_bounds();
     const std::vector<StandardVertex>& vertices() const
     {
         return m_vertices;
@@ -44,12 +94,27 @@ class Visual3d : public Component
         return m_indices;
     };
 
-    static std::shared_ptr<Visual3d> make_triangle();
-    static std::shared_ptr<Visual3d> from_gltf_file(const std::string& fn);
+    static Visual3d make_triangle();
+    // small octahedron shown while the actual geometry loads. All placeholders share one geometry id
+    static const Visual3d& placeholder();
+    // parse with tinygltf, .gltf (ASCII) or .glb depending on the extension
+    static Visual3d from_gltf_file(const std::string& fn);
+    /**
+     * Load a single-mesh .gltf or .glb file. The file and external .bin buffers are memory-mapped and the accessors
+     * are decoded straight from the mapping into the vertices; only base64 data URIs need an intermediate copy. If
+     * external_files is given, the paths of the external buffers read are appended to it.
+     */
+    static Visual3d from_gltf_mapped(const std::string& fn, std::vector<std::string>* external_files = nullptr);
+
+  private:
+    static size_t next_geometry_id();
 
   private:
     std::vector<StandardVertex> m_vertices;
     std::vector<uint32_t> m_indices;
+    size_t m_geometry_id;
+    Bounds m_bounds{};
+    bool m_compact_vertices = false;
 };
 
 std::vector<StandardVertex> create_triangle_data();
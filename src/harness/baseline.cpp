@@ -0,0 +1,146 @@
+#include "baseline.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace harness
+{
+
+namespace
+{
+
+const double kRelativeEpsilon = 1e-9;
+
+double tolerance_of(const std::map<std::string, double>& tolerances, const std::string& name)
+{
+    auto it = tolerances.find(name);
+    return it != tolerances.end() ? it->second : 0.0;
+}
+
+// nearest rank percentile
+double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    const size_t rank = (size_t)std::ceil(p * values.size());
+    return values[std::max<size_t>(rank, 1) - 1];
+}
+
+double mean(const std::vector<double>& values)
+{
+    double sum = 0.0;
+    for (double v : values)
+    {
+        sum += v;
+    }
+    return sum / values.size();
+}
+
+} // namespace
+
+const std::map<std::string, double>& default_tolerances()
+{
+    static const std::map<std::string, double> tolerances = {{"cpu_ms_mean", 0.15}, {"cpu_ms_p95", 0.25},
+                                                             {"gpu_ms_mean", 0.15}, {"gpu_ms_p95", 0.25},
+                                                             {"draws_mean", 0.0},   {"instances_mean", 0.0}};
+    return tolerances;
+}
+
+std::vector<Metric> summarize(const std::vector<FrameSample>& samples, const std::map<std::string, double>& tolerances)
+{
+    std::vector<Metric> metrics;
+    if (samples.empty())
+    {
+        return metrics;
+    }
+    std::vector<double> cpu, gpu, draws, instances;
+    for (const FrameSample& s : samples)
+    {
+        cpu.push_back(s.cpu_ms);
+        draws.push_back(s.draws);
+        instances.push_back(s.instances);
+        if (s.gpu_valid)
+        {
+            gpu.push_back(s.gpu_ms);
+        }
+    }
+    auto add = [&metrics, &tolerances](const std::string& name, double value) {
+        metrics.push_back(Metric{name, value, tolerance_of(tolerances, name)});
+    };
+    add("cpu_ms_mean", mean(cpu));
+    add("cpu_ms_p95", percentile(cpu, 0.95));
+    if (!gpu.empty())
+    {
+        add("gpu_ms_mean", mean(gpu));
+        add("gpu_ms_p95", percentile(gpu, 0.95));
+    }
+    add("draws_mean", mean(draws));
+    add("instances_mean", mean(instances));
+    return metrics;
+}
+
+void write_baseline(std::ostream& out, const std::vector<Metric>& metrics)
+{
+    out << "# name value tolerance\n";
+    // enough digits to read back the same doubles, a rounded mean would regress against itself with tolerance 0
+    out << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (const Metric& m : metrics)
+    {
+        out << m.name << " " << m.value << " " << m.tolerance << "\n";
+    }
+}
+
+std::vector<Metric> read_baseline(std::istream& in)
+{
+    std::vector<Metric> metrics;
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text))
+    {
+        line++;
+        text = text.substr(0, text.find('#'));
+        std::istringstream args(text);
+        Metric m;
+        if (!(args >> m.name))
+        {
+            continue;
+        }
+        std::string rest;
+        if (!(args >> m.value >> m.tolerance) || m.tolerance < 0.0 || args >> rest)
+        {
+            throw std::runtime_error("baseline line " + std::to_string(line) + ": expected name value tolerance");
+        }
+        metrics.push_back(m);
+    }
+    return metrics;
+}
+
+std::vector<Comparison> compare(const std::vector<Metric>& baseline, const std::vector<Metric>& measured,
+                                const std::map<std::string, double>& tolerance_overrides)
+{
+    std::vector<Comparison> result;
+    for (const Metric& b : baseline)
+    {
+        Comparison c = {b.name, b.value, 0.0, b.tolerance, false, false};
+        auto it = tolerance_overrides.find(b.name);
+        if (it != tolerance_overrides.end())
+        {
+            c.tolerance = it->second;
+        }
+        auto m = std::find_if(measured.begin(), measured.end(), [&b](const Metric& x) { return x.name == b.name; });
+        if (m != measured.end())
+        {
+            c.measured = m->value;
+            c.measured_valid = true;
+            // only getting slower or drawing more is a regression, the baseline is rewritten to lock in improvements
+            // the epsilon absorbs rounding of means which summed the same samples in another order
+            c.regressed = c.measured > c.baseline * (1.0 + c.tolerance + kRelativeEpsilon);
+        }
+        result.push_back(c);
+    }
+    return result;
+}
+
+} // namespace harness
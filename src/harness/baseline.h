@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace harness
+{
+
+/**
+ * Measurements of one frame. The CPU time excludes the time RenderSystem::process blocked on fences, which belongs
+ * to the GPU time of earlier frames.
+ */
+struct FrameSample
+{
+    double cpu_ms = 0.0;
+    double gpu_ms = 0.0;
+    bool gpu_valid = false; // the device has timestamps and the frame's queries were read
+    uint32_t draws = 0;
+    uint32_t instances = 0;
+};
+
+/**
+ * A summary value of a run, lower is better. A measurement regresses when it exceeds the baseline value by more than
+ * the relative tolerance.
+ */
+struct Metric
+{
+    std::string name;
+    double value;
+    double tolerance;
+};
+
+// default tolerances: frame times are noisy, the draw counts of a scripted run are exact
+const std::map<std::string, double>& default_tolerances();
+
+// mean and 95th percentile of the CPU and GPU times and mean draw and instance counts, GPU ones only if measured
+std::vector<Metric> summarize(const std::vector<FrameSample>& samples,
+                              const std::map<std::string, double>& tolerances = default_tolerances());
+
+// one metric per line: name value tolerance
+void write_baseline(std::ostream& out, const std::vector<Metric>& metrics);
+// throws std::runtime_error on a malformed line
+std::vector<Metric> read_baseline(std::istream& in);
+
+struct Comparison
+{
+    std::string name;
+    double baseline;
+    double measured;
+    double tolerance;
+    bool measured_valid; // false when the run lacks the metric, e.g. on a device without timestamps
+    bool regressed;
+};
+
+// every baseline metric against the measured one, with the baseline tolerance unless overridden
+std::vector<Comparison> compare(const std::vector<Metric>& baseline, const std::vector<Metric>& measured,
+                                const std::map<std::string, double>& tolerance_overrides = {});
+
+} // namespace harness
@@ -0,0 +1,312 @@
+#include "assetsystem.h"
+#include "baseline.h"
+#include "components/camera.h"
+#include "components/coordsys.h"
+#include "components/registry.h"
+#include "rendersystem.h"
+#include "script.h"
+#include "syntheticscene.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace rendersystem;
+using namespace components;
+
+namespace
+{
+
+const int kPass = 0;
+const int kRegression = 1;
+const int kError = 2;
+
+struct Options
+{
+    std::string script;
+    std::string baseline;
+    std::string csv;
+    bool write_baseline = false;
+    std::map<std::string, double> tolerances;
+};
+
+void usage()
+{
+    std::cerr << "usage: frame_regression <script> [--baseline <file>] [--write-baseline]"
+                 " [--tolerance <metric>=<value>] [--csv <file>]\n"
+                 "exits with 0 when no metric regressed, 1 on a regression and 2 on an error"
+              << std::endl;
+}
+
+Options parse_options(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--baseline") == 0 && has_value)
+        {
+            options.baseline = argv[++i];
+        }
+        else if (strcmp(argv[i], "--csv") == 0 && has_value)
+        {
+            options.csv = argv[++i];
+        }
+        else if (strcmp(argv[i], "--write-baseline") == 0)
+        {
+            options.write_baseline = true;
+        }
+        else if (strcmp(argv[i], "--tolerance") == 0 && has_value)
+        {
+            const std::string arg = argv[++i];
+            const size_t eq = arg.find('=');
+            char* end = nullptr;
+            const double value = eq != std::string::npos ? std::strtod(arg.c_str() + eq + 1, &end) : -1.0;
+            if (eq == std::string::npos || *end != '\0' || value < 0.0)
+            {
+                throw std::invalid_argument("--tolerance expects <metric>=<relative tolerance>, got " + arg);
+            }
+            options.tolerances[arg.substr(0, eq)] = value;
+        }
+        else if (argv[i][0] != '-' && options.script.empty())
+        {
+            options.script = argv[i];
+        }
+        else
+        {
+            throw std::invalid_argument(std::string("unexpected argument ") + argv[i]);
+        }
+    }
+    if (options.script.empty() || (options.write_baseline && options.baseline.empty()))
+    {
+        throw std::invalid_argument("a script is required, --write-baseline also needs --baseline");
+    }
+    return options;
+}
+
+DrawMode draw_mode_of(const std::string& name)
+{
+    if (name == "indirect")
+    {
+        return DrawMode::indirect;
+    }
+    return name == "gpu_culled" ? DrawMode::gpu_culled : DrawMode::direct;
+}
+
+void place_camera(Registry& registry, const harness::CameraKey& key)
+{
+    registry.query<Camera>([&key](Entity, Camera& camera) {
+        camera.reset();
+        camera.position() = key.position;
+        camera.rotate(glm::radians(key.yaw_degrees), glm::radians(key.pitch_degrees));
+    });
+}
+
+bool assets_pending(Registry& registry)
+{
+    bool pending = false;
+    registry.query<assetsystem::PendingVisual>([&pending](Entity, assetsystem::PendingVisual&) { pending = true; });
+    return pending;
+}
+
+// the scene, a camera path and a fixed frame time, nothing depends on the wall clock except the measurements
+std::vector<harness::FrameSample> run(const harness::Script& script)
+{
+    scenes::SceneConfig config = {script.name, script.entities, script.meshes, 8, 0, script.extent, script.seed};
+    scenes::SyntheticScene scene(config);
+    Registry& registry = scene.registry();
+    // without a loader cache, the models are imported the same way in every run
+    assetsystem::AssetSystem assets(1);
+    const size_t slash = script.name.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "" : script.name.substr(0, slash + 1);
+    for (const harness::ModelPlacement& model : script.models)
+    {
+        CoordSys coord;
+        coord.position() = model.position;
+        assets.load_visual(registry.create(coord), dir + model.path);
+    }
+
+    RenderSettings settings;
+    settings.pipeline_cache_path = "";
+    settings.vertex_format = script.vertex_format == "compact" ? VertexFormat::compact : VertexFormat::standard;
+    RenderSystem rs(settings);
+    rs.create_headless(script.width, script.height);
+    rs.set_draw_mode(draw_mode_of(script.draw_mode));
+    // a device without drawIndirectFirstInstance draws direct, which must not be measured against another mode
+    if (rs.draw_mode() != draw_mode_of(script.draw_mode))
+    {
+        rs.destroy();
+        throw std::runtime_error("the device cannot draw in the " + script.draw_mode + " mode of the script");
+    }
+    const uint64_t kFrameUs = 16'667;
+
+    // loads and uploads finish at machine dependent frames, measuring starts once the scene is complete
+    place_camera(registry, harness::camera_at(script, 0));
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    do
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            rs.destroy();
+            throw std::runtime_error("the scene did not finish loading within 60 s");
+        }
+        assets.process(registry, kFrameUs);
+        rs.process(registry, kFrameUs);
+    } while (assets_pending(registry) || rs.frame_stats().uploading > 0);
+    for (uint64_t i = 0; i < script.warmup; i++)
+    {
+        rs.process(registry, kFrameUs);
+    }
+
+    std::vector<harness::FrameSample> samples(script.frames);
+    uint64_t first_frame = 0;
+    uint64_t gpu_samples = 0;
+    auto take_gpu_time = [&](const FrameStats& stats) {
+        if (stats.gpu_frame_valid && stats.gpu_frame_number >= first_frame &&
+            stats.gpu_frame_number < first_frame + samples.size())
+        {
+            harness::FrameSample& sample = samples[stats.gpu_frame_number - first_frame];
+            sample.gpu_ms = stats.gpu_frame_ns / 1e6;
+            sample.gpu_valid = true;
+            gpu_samples++;
+        }
+    };
+    for (uint64_t i = 0; i < script.frames; i++)
+    {
+        place_camera(registry, harness::camera_at(script, i));
+        const auto start = std::chrono::steady_clock::now();
+        rs.process(registry, kFrameUs);
+        const auto end = std::chrono::steady_clock::now();
+        const FrameStats& stats = rs.frame_stats();
+        if (i == 0)
+        {
+            first_frame = stats.frame_number;
+        }
+        const uint64_t blocked_us = stats.fence_wait_us + stats.acquire_wait_us;
+        const uint64_t process_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        samples[i].cpu_ms = (process_us - std::min(process_us, blocked_us)) / 1e3;
+        samples[i].draws = stats.draw_count;
+        samples[i].instances = stats.instance_count;
+        take_gpu_time(stats);
+    }
+    // the GPU times of the last frames arrive when their resources are reused
+    for (int i = 0; i < 8 && gpu_samples > 0 && gpu_samples < samples.size(); i++)
+    {
+        rs.process(registry, kFrameUs);
+        take_gpu_time(rs.frame_stats());
+    }
+    rs.destroy();
+    return samples;
+}
+
+void write_csv(const std::string& path, const std::vector<harness::FrameSample>& samples)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+    file << "frame,cpu_ms,gpu_ms,draws,instances\n";
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        const harness::FrameSample& s = samples[i];
+        file << i << "," << s.cpu_ms << "," << (s.gpu_valid ? std::to_string(s.gpu_ms) : "") << "," << s.draws << ","
+             << s.instances << "\n";
+    }
+    file.close();
+    if (!file)
+    {
+        throw std::runtime_error("cannot write " + path);
+    }
+}
+
+int report(const std::vector<harness::Comparison>& comparisons)
+{
+    bool regressed = false;
+    printf("%-16s %12s %12s %8s %10s\n", "metric", "baseline", "measured", "change", "tolerance");
+    for (const harness::Comparison& c : comparisons)
+    {
+        if (!c.measured_valid)
+        {
+            printf("%-16s %12.4f %12s %8s %9.0f%%  not measured\n", c.name.c_str(), c.baseline, "-", "-",
+                   c.tolerance * 100);
+            continue;
+        }
+        const double change = c.baseline != 0.0 ? (c.measured / c.baseline - 1.0) * 100 : 0.0;
+        printf("%-16s %12.4f %12.4f %+7.1f%% %9.0f%%%s\n", c.name.c_str(), c.baseline, c.measured, change,
+               c.tolerance * 100, c.regressed ? "  REGRESSION" : "");
+        regressed = regressed || c.regressed;
+    }
+    return regressed ? kRegression : kPass;
+}
+
+} // namespace
+
+// e.g. with lavapipe from the build/src directory, so the shaders are found:
+// ./harness/frame_regression ../../assets/harness/orbit.txt --baseline orbit.baseline
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const Options options = parse_options(argc, argv);
+        const harness::Script script = harness::load_script(options.script);
+        const std::vector<harness::FrameSample> samples = run(script);
+        if (!options.csv.empty())
+        {
+            write_csv(options.csv, samples);
+        }
+        std::map<std::string, double> tolerances = harness::default_tolerances();
+        for (const auto& [name, tolerance] : options.tolerances)
+        {
+            tolerances[name] = tolerance;
+        }
+        const std::vector<harness::Metric> metrics = harness::summarize(samples, tolerances);
+        // baselines are machine specific, write one per machine and driver
+        if (options.write_baseline)
+        {
+            std::ofstream file(options.baseline);
+            if (!file)
+            {
+                throw std::runtime_error("cannot open " + options.baseline);
+            }
+            harness::write_baseline(file, metrics);
+            file.close();
+            if (!file)
+            {
+                throw std::runtime_error("cannot write " + options.baseline);
+            }
+            std::cout << "wrote " << options.baseline << std::endl;
+        }
+        if (options.baseline.empty() || options.write_baseline)
+        {
+            for (const harness::Metric& m : metrics)
+            {
+                printf("%-16s %12.4f\n", m.name.c_str(), m.value);
+            }
+            return kPass;
+        }
+        std::ifstream file(options.baseline);
+        if (!file)
+        {
+            throw std::runtime_error("cannot open " + options.baseline + ", create it with --write-baseline");
+        }
+        return report(harness::compare(harness::read_baseline(file), metrics, options.tolerances));
+    }
+    catch (const std::invalid_argument& e)
+    {
+        std::cerr << e.what() << std::endl;
+        usage();
+        return kError;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "error: " << e.what() << std::endl;
+        return kError;
+    }
+}
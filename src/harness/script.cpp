@@ -0,0 +1,183 @@
+#include "script.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace harness
+{
+
+namespace
+{
+
+[[noreturn]] void fail(const std::string& name, int line, const std::string& message)
+{
+    throw std::runtime_error(name + ":" + std::to_string(line) + ": " + message);
+}
+
+// reads exactly count values of the directive, optional ones follow in the same stream
+template <typename T>
+void read_values(std::istringstream& args, T* values, int count, const std::string& name, int line,
+                 const std::string& directive)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!(args >> values[i]))
+        {
+            fail(name, line, directive + " expects " + std::to_string(count) + " numbers");
+        }
+    }
+}
+
+} // namespace
+
+Script parse_script(std::istream& in, const std::string& name)
+{
+    Script script;
+    script.name = name;
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text))
+    {
+        line++;
+        text = text.substr(0, text.find('#'));
+        std::istringstream args(text);
+        std::string directive;
+        if (!(args >> directive))
+        {
+            continue;
+        }
+        if (directive == "resolution")
+        {
+            uint32_t size[2];
+            read_values(args, size, 2, name, line, directive);
+            if (size[0] == 0 || size[1] == 0)
+            {
+                fail(name, line, "resolution must not be empty");
+            }
+            script.width = size[0];
+            script.height = size[1];
+        }
+        else if (directive == "warmup")
+        {
+            read_values(args, &script.warmup, 1, name, line, directive);
+        }
+        else if (directive == "frames")
+        {
+            read_values(args, &script.frames, 1, name, line, directive);
+            if (script.frames == 0)
+            {
+                fail(name, line, "frames must be at least 1");
+            }
+        }
+        else if (directive == "draw_mode")
+        {
+            if (!(args >> script.draw_mode) ||
+                (script.draw_mode != "direct" && script.draw_mode != "indirect" && script.draw_mode != "gpu_culled"))
+            {
+                fail(name, line, "draw_mode expects direct, indirect or gpu_culled");
+            }
+        }
+        else if (directive == "vertex_format")
+        {
+            if (!(args >> script.vertex_format) ||
+                (script.vertex_format != "standard" && script.vertex_format != "compact"))
+            {
+                fail(name, line, "vertex_format expects standard or compact");
+            }
+        }
+        else if (directive == "spheres")
+        {
+            uint32_t counts[2];
+            read_values(args, counts, 2, name, line, directive);
+            read_values(args, &script.extent, 1, name, line, directive);
+            if (counts[1] == 0 || script.extent <= 0.0f)
+            {
+                fail(name, line, "spheres needs at least one mesh and a positive extent");
+            }
+            script.entities = counts[0];
+            script.meshes = counts[1];
+            // the seed is optional, anything else after the extent is an error
+            uint32_t seed = 0;
+            if (args >> seed)
+            {
+                script.seed = seed;
+            }
+            else if (!args.eof())
+            {
+                fail(name, line, "spheres expects a seed after the extent");
+            }
+        }
+        else if (directive == "model")
+        {
+            ModelPlacement model;
+            float position[3];
+            if (!(args >> model.path))
+            {
+                fail(name, line, "model expects a path and a position");
+            }
+            read_values(args, position, 3, name, line, directive);
+            model.position = glm::vec3(position[0], position[1], position[2]);
+            script.models.push_back(model);
+        }
+        else if (directive == "camera")
+        {
+            CameraKey key;
+            float pose[5];
+            read_values(args, &key.frame, 1, name, line, directive);
+            read_values(args, pose, 5, name, line, directive);
+            key.position = glm::vec3(pose[0], pose[1], pose[2]);
+            key.yaw_degrees = pose[3];
+            key.pitch_degrees = pose[4];
+            if (!script.camera.empty() && key.frame <= script.camera.back().frame)
+            {
+                fail(name, line, "camera keys must be in increasing frame order");
+            }
+            script.camera.push_back(key);
+        }
+        else
+        {
+            fail(name, line, "unknown directive " + directive);
+        }
+        std::string rest;
+        if (args >> rest)
+        {
+            fail(name, line, "unexpected " + rest);
+        }
+    }
+    return script;
+}
+
+Script load_script(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+    return parse_script(file, path);
+}
+
+CameraKey camera_at(const Script& script, uint64_t frame)
+{
+    if (script.camera.empty())
+    {
+        return CameraKey{frame, glm::vec3(0.0f), 0.0f, 0.0f};
+    }
+    auto next = std::upper_bound(script.camera.begin(), script.camera.end(), frame,
+                                 [](uint64_t f, const CameraKey& key) { return f < key.frame; });
+    if (next == script.camera.begin() || next == script.camera.end())
+    {
+        CameraKey key = next == script.camera.begin() ? script.camera.front() : script.camera.back();
+        key.frame = frame;
+        return key;
+    }
+    const CameraKey& a = *(next - 1);
+    const CameraKey& b = *next;
+    const float t = (frame - a.frame) / (float)(b.frame - a.frame);
+    return CameraKey{frame, a.position + (b.position - a.position) * t,
+                     a.yaw_degrees + (b.yaw_degrees - a.yaw_degrees) * t,
+                     a.pitch_degrees + (b.pitch_degrees - a.pitch_degrees) * t};
+}
+
+} // namespace harness
@@ -0,0 +1,65 @@
+#pragma once
+#include "glm/vec3.hpp"
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace harness
+{
+
+/**
+ * Camera pose at a measured frame, poses between keys are interpolated linearly.
+ */
+struct CameraKey
+{
+    uint64_t frame;
+    glm::vec3 position;
+    float yaw_degrees;
+    float pitch_degrees;
+};
+
+struct ModelPlacement
+{
+    std::string path; // relative to the script
+    glm::vec3 position;
+};
+
+/**
+ * A scene, a camera path and the frames to render. Everything is fixed by the script, so two runs on the same machine
+ * render the same frames. A script is a text file with one directive per line and # comments:
+ *
+ *   resolution 1024 768
+ *   warmup 30                     frames rendered before measuring, after all meshes were uploaded
+ *   frames 300                    measured frames
+ *   draw_mode indirect            direct, indirect or gpu_culled
+ *   vertex_format compact         standard or compact, of all meshes
+ *   spheres 10000 64 200 [seed]   entities, distinct meshes and the edge length of the cube they fill
+ *   model torus.gltf 0 0 5        a glTF file placed at a position
+ *   camera 0 0 0 -50 0 0          frame, position, yaw and pitch in degrees
+ */
+struct Script
+{
+    std::string name;
+    uint32_t width = 1024;
+    uint32_t height = 768;
+    uint64_t warmup = 30;
+    uint64_t frames = 300;
+    std::string draw_mode = "direct";
+    std::string vertex_format = "standard";
+    uint32_t entities = 0;
+    uint32_t meshes = 1;
+    float extent = 100.0f;
+    uint32_t seed = 1;
+    std::vector<ModelPlacement> models;
+    std::vector<CameraKey> camera; // sorted by frame
+};
+
+// throws std::runtime_error naming the line of the first error
+Script parse_script(std::istream& in, const std::string& name);
+Script load_script(const std::string& path);
+
+// the camera pose at a measured frame, held before the first and after the last key
+CameraKey camera_at(const Script& script, uint64_t frame);
+
+} // namespace harness
@@ -0,0 +1,166 @@
+#include "baseline.h"
+#include "script.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+using namespace harness;
+
+static Script parse(const std::string& text)
+{
+    std::istringstream in(text);
+    return parse_script(in, "test.txt");
+}
+
+static const Metric* find(const std::vector<Metric>& metrics, const std::string& name)
+{
+    for (const Metric& m : metrics)
+    {
+        if (m.name == name)
+        {
+            return &m;
+        }
+    }
+    return nullptr;
+}
+
+TEST_CASE("Scripts set the scene, the frames and the camera path")
+{
+    const Script script = parse("# orbit\n"
+                                "resolution 320 240\n"
+                                "frames 100   # measured\n"
+                                "warmup 5\n"
+                                "draw_mode gpu_culled\n"
+                                "vertex_format compact\n"
+                                "spheres 500 8 50 7\n"
+                                "model torus.gltf 1 2 3\n"
+                                "\n"
+                                "camera 0 0 0 -10 0 0\n"
+                                "camera 50 0 0 -10 90 -20\n");
+    REQUIRE(script.width == 320);
+    REQUIRE(script.height == 240);
+    REQUIRE(script.frames == 100);
+    REQUIRE(script.warmup == 5);
+    REQUIRE(script.draw_mode == "gpu_culled");
+    REQUIRE(script.vertex_format == "compact");
+    REQUIRE(script.entities == 500);
+    REQUIRE(script.meshes == 8);
+    REQUIRE(script.extent == 50.0f);
+    REQUIRE(script.seed == 7);
+    REQUIRE(script.models.size() == 1);
+    REQUIRE(script.models[0].path == "torus.gltf");
+    REQUIRE(script.models[0].position.z == 3.0f);
+    REQUIRE(script.camera.size() == 2);
+
+    // halfway between the keys, then held after the last one
+    const CameraKey mid = camera_at(script, 25);
+    REQUIRE(std::abs(mid.position.z + 10.0f) < 1e-5f);
+    REQUIRE(std::abs(mid.yaw_degrees - 45.0f) < 1e-5f);
+    REQUIRE(std::abs(mid.pitch_degrees + 10.0f) < 1e-5f);
+    const CameraKey end = camera_at(script, 99);
+    REQUIRE(end.frame == 99);
+    REQUIRE(end.yaw_degrees == 90.0f);
+
+    // the seed is optional
+    REQUIRE(parse("spheres 10 2 5").seed == 1);
+}
+
+TEST_CASE("Script errors name the line")
+{
+    auto error_of = [](const std::string& text) {
+        try
+        {
+            parse(text);
+        }
+        catch (const std::runtime_error& e)
+        {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    REQUIRE(error_of("frames 10\nfly 1 2\n").rfind("test.txt:2:", 0) == 0);
+    REQUIRE(error_of("frames ten\n").rfind("test.txt:1:", 0) == 0);
+    REQUIRE_FALSE(error_of("frames 0\n").empty());
+    REQUIRE_FALSE(error_of("draw_mode fast\n").empty());
+    REQUIRE_FALSE(error_of("vertex_format tiny\n").empty());
+    REQUIRE_FALSE(error_of("spheres 10 2 5 x\n").empty());
+    REQUIRE_FALSE(error_of("resolution 640 480 60\n").empty());
+    REQUIRE_FALSE(error_of("camera 10 0 0 0 0 0\ncamera 10 0 0 0 0 0\n").empty());
+}
+
+TEST_CASE("Runs are summarized and compared against a baseline")
+{
+    std::vector<FrameSample> samples;
+    for (int i = 1; i <= 100; i++)
+    {
+        samples.push_back(FrameSample{(double)i, 2.0, true, 4, 40});
+    }
+    const std::vector<Metric> metrics = summarize(samples);
+    REQUIRE(std::abs(find(metrics, "cpu_ms_mean")->value - 50.5) < 1e-9);
+    REQUIRE(find(metrics, "cpu_ms_p95")->value == 95.0);
+    REQUIRE(find(metrics, "gpu_ms_mean")->value == 2.0);
+    REQUIRE(find(metrics, "draws_mean")->value == 4.0);
+    REQUIRE(find(metrics, "draws_mean")->tolerance == 0.0);
+
+    // written and read back unchanged
+    std::stringstream file;
+    write_baseline(file, metrics);
+    const std::vector<Metric> baseline = read_baseline(file);
+    REQUIRE(baseline.size() == metrics.size());
+    REQUIRE(find(baseline, "cpu_ms_p95")->value == 95.0);
+    REQUIRE(find(baseline, "cpu_ms_mean")->tolerance == find(metrics, "cpu_ms_mean")->tolerance);
+
+    // slower within the tolerance, faster on the GPU and one more draw
+    for (FrameSample& s : samples)
+    {
+        s.cpu_ms *= 1.1;
+        s.gpu_ms = 1.0;
+        s.draws = 5;
+    }
+    std::vector<Comparison> result = compare(baseline, summarize(samples));
+    for (const Comparison& c : result)
+    {
+        REQUIRE(c.measured_valid);
+        REQUIRE(c.regressed == (c.name == "draws_mean"));
+    }
+    // a tighter tolerance from the command line
+    result = compare(baseline, summarize(samples), {{"cpu_ms_mean", 0.05}});
+    REQUIRE(result[0].name == "cpu_ms_mean");
+    REQUIRE(result[0].regressed);
+    for (FrameSample& s : samples)
+    {
+        s.gpu_valid = false;
+    }
+    result = compare(baseline, summarize(samples));
+    REQUIRE_FALSE(find(summarize(samples), "gpu_ms_mean"));
+    for (const Comparison& c : result)
+    {
+        REQUIRE(c.measured_valid == (c.name.rfind("gpu", 0) != 0));
+    }
+
+    std::istringstream malformed("cpu_ms_mean 1.0\n");
+    REQUIRE_THROWS_AS(read_baseline(malformed), std::runtime_error);
+}
+
+TEST_CASE("A baseline with fractional means does not regress against itself")
+{
+    // instance counts of CPU culling change along the camera path, their mean does not terminate
+    std::vector<FrameSample> samples;
+    for (int i = 0; i < 300; i++)
+    {
+        samples.push_back(FrameSample{1.0 / 3.0, 0.0, false, 7, (uint32_t)(3000 + i % 7 + (i % 3 == 0 ? 1 : 0))});
+    }
+    const std::vector<Metric> metrics = summarize(samples);
+    REQUIRE(find(metrics, "instances_mean")->value != std::floor(find(metrics, "instances_mean")->value));
+
+    std::stringstream file;
+    write_baseline(file, metrics);
+    const std::vector<Metric> baseline = read_baseline(file);
+    REQUIRE(find(baseline, "instances_mean")->value == find(metrics, "instances_mean")->value);
+    for (const Comparison& c : compare(baseline, metrics))
+    {
+        REQUIRE(c.measured_valid);
+        REQUIRE_FALSE(c.regressed);
+    }
+}
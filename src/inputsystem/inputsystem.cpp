@@ -1,6 +1,8 @@
 #include "inputsystem.h"
 #include "camera.h"
 #include "coordsys.h"
+#include "profiler.h"
+#include "registry.h"
 namespace inputsystem
 {
 
@@ -38,47 +40,49 @@ void InputSystem::on_mouse(glm::vec2 mouse_pos)
     m_cur_mouse_pos = mouse_pos;
 }
 
-void InputSystem::process(const std::vector<components::Entity>& entities, uint64_t elapsed_us)
+void InputSystem::process(components::Registry& registry, uint64_t elapsed_us)
 {
+    PROFILE_SCOPE("InputSystem::process");
     float elapsed_sec = (float)elapsed_us / 1'000'000;
-    for (auto& e : entities)
-    {
-        if (auto cam = e.get_component<components::Camera>(); cam != nullptr)
+    m_cameras.each(registry, [&](components::Entity, components::Camera& cam) {
+        float speed = cam.sensitivity();
+        if (m_active_keys.find(GLFW_KEY_W) != m_active_keys.end())
         {
-            float speed = cam->sensitivity();
-            if (m_active_keys.find(GLFW_KEY_W) != m_active_keys.end())
-            {
-                cam->position() += speed * (float)elapsed_sec * cam->forward();
-            }
-            if (m_active_keys.find(GLFW_KEY_S) != m_active_keys.end())
-            {
-                cam->position() += speed * (float)elapsed_sec * -cam->forward();
-            }
-            if (m_active_keys.find(GLFW_KEY_A) != m_active_keys.end())
-            {
-                cam->position() += speed * (float)elapsed_sec * cam->right();
-            }
-            if (m_active_keys.find(GLFW_KEY_D) != m_active_keys.end())
-            {
-                cam->position() += speed * (float)elapsed_sec * -cam->right();
-            }
-            if (m_active_keys.find(GLFW_KEY_R) != m_active_keys.end())
-            {
-                cam->reset();
-            }
-            if (m_prev_mouse_pos != glm::vec2{0})
-            {
-                glm::vec2 delta_mouse = m_prev_mouse_pos - m_cur_mouse_pos;
-                cam->rotate(delta_mouse.x / m_width, delta_mouse.y / m_height);
-            }
-            m_prev_mouse_pos = m_cur_mouse_pos;
+            cam.position() += speed * (float)elapsed_sec * cam.forward();
         }
-    }
+        if (m_active_keys.find(GLFW_KEY_S) != m_active_keys.end())
+        {
+            cam.position() += speed * (float)elapsed_sec * -cam.forward();
+        }
+        if (m_active_keys.find(GLFW_KEY_A) != m_active_keys.end())
+        {
+            cam.position() += speed * (float)elapsed_sec * cam.right();
+        }
+        if (m_active_keys.find(GLFW_KEY_D) != m_active_keys.end())
+        {
+            cam.position() += speed * (float)elapsed_sec * -cam.right();
+        }
+        if (m_active_keys.find(GLFW_KEY_R) != m_active_keys.end())
+        {
+            cam.reset();
+        }
+        if (m_prev_mouse_pos != glm::vec2{0})
+        {
+            glm::vec2 delta_mouse = m_prev_mouse_pos - m_cur_mouse_pos;
+            cam.rotate(delta_mouse.x / m_width, delta_mouse.y / m_height);
+        }
+        m_prev_mouse_pos = m_cur_mouse_pos;
+    });
 }
 
-InputSystem::InputSystem(GLFWwindow* app_window) : m_app_window(app_window), m_prev_mouse_pos{0}, m_cur_mouse_pos{0}
+InputSystem::InputSystem(GLFWwindow* app_window)
+    : m_app_window(app_window), m_prev_mouse_pos{0}, m_cur_mouse_pos{0}, m_width(1), m_height(1)
 {
     instance = this;
+    if (app_window == nullptr)
+    {
+        return;
+    }
     glfwSetKeyCallback(app_window, static_on_key);
     glfwSetCursorPosCallback(app_window, static_on_mouse);
     glfwSetInputMode(app_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -1,5 +1,7 @@
 #pragma once
+#include "camera.h"
 #include "entity.h"
+#include "view.h"
 #include "glm/vec2.hpp"
 #include <GLFW/glfw3.h>
 #include <unordered_map>
@@ -9,10 +11,14 @@ namespace inputsystem
 class InputSystem
 {
   public:
+    /**
+     * Register the input callbacks of app_window. Passing nullptr drives the system without a window, key and mouse
+     * state is then only fed through on_key/on_mouse.
+     */
     InputSystem(GLFWwindow* app_window);
     void on_key(int key, int scancode, int action, int mods);
     void on_mouse(glm::vec2 mouse_pos);
-    void process(const std::vector<components::Entity>& entities, uint64_t elapsed_us);
+    void process(components::Registry& registry, uint64_t elapsed_us);
 
   private:
     GLFWwindow* m_app_window;
@@ -21,6 +27,7 @@ class InputSystem
     glm::vec2 m_cur_mouse_pos;
     int m_width;
     int m_height;
+    components::View<components::Camera> m_cameras;
 };
 
 } // namespace inputsystem
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "allocationcounter.h"
+#include "camera.h"
+#include "coordsys.h"
+#include "inputsystem.h"
+#include "registry.h"
+#include <catch2/catch_test_macros.hpp>
+
+using namespace components;
+using namespace inputsystem;
+
+TEST_CASE("InputSystem moves the camera")
+{
+    Registry registry;
+    Entity cam = registry.create(Camera(1.0f, 60.0f));
+    cam.get_component<Camera>()->reset();
+
+    InputSystem insystem(nullptr);
+    insystem.on_key(GLFW_KEY_W, 0, GLFW_PRESS, 0);
+    insystem.process(registry, 1'000'000);
+    REQUIRE(cam.get_component<Camera>()->position().z > 0);
+}
+
+TEST_CASE("InputSystem::process performs no heap allocation in steady state")
+{
+    Registry registry;
+    for (int i = 0; i < 1000; i++)
+    {
+        registry.create(CoordSys());
+    }
+    Entity cam = registry.create(Camera(1.0f, 60.0f));
+    cam.get_component<Camera>()->reset();
+
+    InputSystem insystem(nullptr);
+    insystem.on_key(GLFW_KEY_W, 0, GLFW_PRESS, 0);
+    insystem.on_mouse(glm::vec2(10, 10));
+    // the first frame caches the matching archetypes
+    insystem.process(registry, 16'000);
+
+    const size_t allocations = allocation_count();
+    for (int i = 0; i < 100; i++)
+    {
+        insystem.process(registry, 16'000);
+    }
+    REQUIRE(allocation_count() == allocations);
+}
@@ -0,0 +1,57 @@
+#include "taskqueue.h"
+#include <algorithm>
+
+namespace jobs
+{
+
+TaskQueue::TaskQueue(size_t thread_count)
+{
+    for (size_t i = 0; i < std::max<size_t>(1, thread_count); i++)
+    {
+        m_threads.emplace_back(&TaskQueue::worker_loop, this);
+    }
+}
+
+TaskQueue::~TaskQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_tasks.clear();
+    }
+    m_wake.notify_all();
+    for (auto& t : m_threads)
+    {
+        t.join();
+    }
+}
+
+void TaskQueue::push(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void TaskQueue::worker_loop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_stop)
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace jobs
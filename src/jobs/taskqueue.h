@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace jobs
+{
+
+/**
+ * Worker threads running independent, long-running tasks (e.g. loading files) in submission order. Unlike the
+ * ThreadPool, the caller never waits: submit() returns a future for the result of the task.
+ */
+class TaskQueue
+{
+  public:
+    explicit TaskQueue(size_t thread_count = 1);
+    // tasks which did not start yet are dropped, their futures report std::future_errc::broken_promise
+    ~TaskQueue();
+    TaskQueue(const TaskQueue& rhs) = delete;
+    TaskQueue& operator=(const TaskQueue& rhs) = delete;
+
+    size_t size() const
+    {
+        return m_threads.size();
+    }
+
+    // run fn() on a worker thread. Exceptions thrown by fn are rethrown by the future's get()
+    template <typename F> std::future<std::invoke_result_t<F>> submit(F&& fn)
+    {
+        using R = std::invoke_result_t<F>;
+        // std::function needs a copyable callable, the packaged_task is shared instead
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        std::future<R> result = task->get_future();
+        push([task]() { (*task)(); });
+        return result;
+    }
+
+  private:
+    void push(std::function<void()> task);
+    void worker_loop();
+
+  private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stop = false;
+};
+
+} // namespace jobs
@@ -0,0 +1,59 @@
+#include "taskqueue.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace jobs;
+
+TEST_CASE("TaskQueue returns results through futures")
+{
+    TaskQueue queue(3);
+    REQUIRE(queue.size() == 3);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; i++)
+    {
+        results.push_back(queue.submit([i]() { return i * i; }));
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        REQUIRE(results[i].get() == i * i);
+    }
+}
+
+TEST_CASE("TaskQueue forwards exceptions and move-only results")
+{
+    TaskQueue queue;
+    auto failing = queue.submit([]() -> std::string { throw std::runtime_error("load failed"); });
+    auto moved = queue.submit([]() { return std::make_unique<int>(7); });
+    REQUIRE_THROWS_AS(failing.get(), std::runtime_error);
+    REQUIRE(*moved.get() == 7);
+}
+
+TEST_CASE("TaskQueue shuts down with queued tasks")
+{
+    std::vector<std::future<int>> results;
+    {
+        TaskQueue queue(1);
+        for (int i = 0; i < 1000; i++)
+        {
+            results.push_back(queue.submit([i]() { return i; }));
+        }
+    }
+    // every task either ran or was dropped with a broken promise, no future is left waiting forever
+    for (int i = 0; i < 1000; i++)
+    {
+        int value = -1;
+        try
+        {
+            value = results[i].get();
+        }
+        catch (const std::future_error& e)
+        {
+            REQUIRE(e.code() == std::future_errc::broken_promise);
+            continue;
+        }
+        REQUIRE(value == i);
+    }
+}
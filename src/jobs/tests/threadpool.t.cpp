@@ -0,0 +1,35 @@
+#include "threadpool.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using namespace jobs;
+
+TEST_CASE("ThreadPool runs every index exactly once")
+{
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        ThreadPool pool(threads);
+        REQUIRE(pool.size() == threads);
+        for (size_t count : {0, 1, 3, 100})
+        {
+            std::vector<std::atomic<int>> hits(count);
+            pool.parallel_for(count, [&hits](size_t i) { hits[i]++; });
+            for (auto& h : hits)
+            {
+                REQUIRE(h == 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("ThreadPool can be reused for many consecutive runs")
+{
+    ThreadPool pool(4);
+    std::atomic<size_t> sum{0};
+    for (size_t run = 0; run < 1000; run++)
+    {
+        pool.parallel_for(4, [&sum](size_t i) { sum += i; });
+    }
+    REQUIRE(sum == 1000 * 6);
+}
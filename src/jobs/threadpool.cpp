@@ -0,0 +1,95 @@
+#include "threadpool.h"
+#include <algorithm>
+
+namespace jobs
+{
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 1; i < thread_count; i++)
+    {
+        m_threads.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_threads)
+    {
+        t.join();
+    }
+}
+
+void ThreadPool::run(size_t count, TaskFn fn, void* ctx)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fn = fn;
+        m_ctx = ctx;
+        m_count = count;
+        m_next = 0;
+        m_remaining = count;
+        generation = ++m_generation;
+    }
+    if (count > 1)
+    {
+        m_wake.notify_all();
+    }
+    execute(generation);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_remaining == 0; });
+}
+
+void ThreadPool::execute(uint64_t generation)
+{
+    // indices are handed out under the lock together with the generation check, so a worker waking up late can
+    // never claim work of a later run
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_generation == generation && m_next < m_count)
+    {
+        size_t index = m_next++;
+        lock.unlock();
+        m_fn(m_ctx, index);
+        lock.lock();
+        if (--m_remaining == 0)
+        {
+            m_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::worker_loop()
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        uint64_t generation;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_stop || m_generation != seen; });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = seen = m_generation;
+        }
+        execute(generation);
+    }
+}
+
+} // namespace jobs
@@ -0,0 +1,60 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace jobs
+{
+
+/**
+ * Fixed set of worker threads for fork-join parallelism. The calling thread takes part in the work, so a pool of
+ * size n runs n-1 background threads and a pool of size 1 runs everything inline.
+ */
+class ThreadPool
+{
+  public:
+    // thread_count == 0 uses one thread per hardware core
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool& rhs) = delete;
+    ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+    size_t size() const
+    {
+        return m_threads.size() + 1;
+    }
+
+    /**
+     * Call fn(i) for every i in [0, count) and return once all calls finished. Calls run concurrently, so distinct
+     * indices must not share mutable state. Does not allocate.
+     */
+    template <typename F> void parallel_for(size_t count, F&& fn)
+    {
+        run(count, [](void* ctx, size_t i) { (*static_cast<std::remove_reference_t<F>*>(ctx))(i); }, &fn);
+    }
+
+  private:
+    using TaskFn = void (*)(void* ctx, size_t index);
+    void run(size_t count, TaskFn fn, void* ctx);
+    void execute(uint64_t generation);
+    void worker_loop();
+
+  private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    TaskFn m_fn = nullptr;
+    void* m_ctx = nullptr;
+    size_t m_count = 0;
+    size_t m_next = 0;
+    size_t m_remaining = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+};
+
+} // namespace jobs
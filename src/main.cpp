@@ -1,64 +1,193 @@
 #include <stdio.h>
 
+#include "assetsystem.h"
 #include "components/camera.h"
 #include "components/coordsys.h"
+#include "components/registry.h"
 #include "components/visual.h"
 #include "entity.h"
 #include "glm/gtx/transform.hpp"
 #include "inputsystem.h"
+#include "profiler.h"
 #include "rendersystem.h"
 #include <GLFW/glfw3.h>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 using namespace rendersystem;
 using namespace components;
 
-Entity create_triangle()
+Entity create_triangle(Registry& registry)
 {
-    Entity e;
-    auto coords = std::make_shared<CoordSys>();
-    e.add_component(coords);
-    e.add_component(Visual3d::make_triangle());
-    return e;
+    return registry.create(CoordSys(), Visual3d::make_triangle());
 }
 
-Entity create_torus()
+Entity create_torus(Registry& registry, assetsystem::AssetSystem& assets)
 {
-    Entity e;
-    auto coords = std::make_shared<CoordSys>();
-    e.add_component(coords);
-    e.add_component(Visual3d::from_gltf_file("../assets/torus_smooth.gltf"));
+    Entity e = registry.create(CoordSys());
+    assets.load_visual(e, "../assets/torus_smooth.gltf");
     return e;
 }
 
-Entity create_camera(float aspect)
+Entity create_camera(Registry& registry, float aspect)
 {
-    Entity e;
-    auto cam = std::make_shared<Camera>(aspect, 60.0f);
-    cam->position() = glm::vec3(0, 1, -2);
-    cam->rotate(0, glm::radians(-30.0f));
-    e.add_component(cam);
-    return e;
+    Camera cam(aspect, 60.0f);
+    cam.position() = glm::vec3(0, 1, -2);
+    cam.rotate(0, glm::radians(-30.0f));
+    return registry.create(cam);
+}
+// binary PPM, which any image viewer opens
+void write_ppm(const std::string& path, const ReadbackImage& image)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << image.width << " " << image.height << "\n255\n";
+    const bool bgr = image.format == VK_FORMAT_B8G8R8A8_UNORM || image.format == VK_FORMAT_B8G8R8A8_SRGB;
+    std::vector<char> row(image.width * 3);
+    for (uint32_t y = 0; y < image.height; y++)
+    {
+        const uint8_t* texel = image.pixels + y * image.row_pitch;
+        for (uint32_t x = 0; x < image.width; x++, texel += 4)
+        {
+            row[x * 3 + 0] = (char)texel[bgr ? 2 : 0];
+            row[x * 3 + 1] = (char)texel[1];
+            row[x * 3 + 2] = (char)texel[bgr ? 0 : 2];
+        }
+        file.write(row.data(), row.size());
+    }
+}
+
+// the loads finished since the last call, printed counts the records already printed
+void print_loads(const assetsystem::AssetSystem& assets, size_t* printed)
+{
+    const std::vector<assetsystem::LoadRecord>& records = assets.load_records();
+    for (; *printed < records.size(); (*printed)++)
+    {
+        const assetsystem::LoadRecord& record = records[*printed];
+        if (!record.failed)
+        {
+            std::cout << "loaded " << record.path << " in " << record.latency_us / 1000.0 << "ms (queued "
+                      << record.queue_us / 1000.0 << "ms, loading " << record.load_us / 1000.0 << "ms)" << std::endl;
+        }
+        else
+        {
+            std::cerr << "cannot load " << record.path << ": " << record.error << std::endl;
+        }
+    }
+}
+
+// time per frame of every profiled scope over the recent frames
+void print_profile(const profiler::Profiler& profiler)
+{
+    printf("%-36s %6s %10s %10s %10s\n", "scope", "calls", "min us", "avg us", "p99 us");
+    for (const profiler::ScopeStats& stats : profiler.stats())
+    {
+        printf("%-36s %6u %10.1f %10.1f %10.1f\n", stats.name.c_str(), stats.calls, stats.min_us, stats.avg_us,
+               stats.p99_us);
+    }
+    fflush(stdout);
+}
+
+// render frame_count frames without a window as fast as possible and write the last one to frame.ppm
+int run_headless(Registry& registry, assetsystem::AssetSystem& assets, uint64_t frame_count)
+{
+    RenderSystem rs;
+    rs.create_headless(1024, 768);
+    uint64_t read_count = 0;
+    rs.set_readback([&](const ReadbackImage& image) {
+        read_count++;
+        if (image.frame_number + 1 == frame_count)
+        {
+            write_ppm("frame.ppm", image);
+        }
+    });
+    size_t printed_loads = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < frame_count; i++)
+    {
+        assets.process(registry, 0);
+        print_loads(assets, &printed_loads);
+        rs.process(registry, 0);
+        profiler::global().end_frame();
+    }
+    rs.finish_readbacks();
+    const double seconds =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1e6;
+    std::cout << read_count << " frames read back in " << seconds << " s, " << read_count / seconds << " frames/s"
+              << std::endl;
+    print_profile(profiler::global());
+    rs.destroy();
+    return 0;
 }
+
 int main(int argc, char* argv[])
 {
-    auto e0 = create_triangle();
-    auto e1 = create_torus();
-    auto cam = create_camera(4 / 3.0f);
+    Registry registry;
+    assetsystem::AssetSystem assets(1, "mesh_cache");
+    auto e0 = create_triangle(registry);
+    create_torus(registry, assets);
+    create_camera(registry, 4 / 3.0f);
     e0.get_component<CoordSys>()->position() = glm::vec3(0, 0, 0);
-    std::vector<Entity> entities = {e0, e1, cam};
+    profiler::global().set_enabled(true);
 
-    RenderSystem rs;
+    // e.g. on a render farm: vulkan_human --headless 1000
+    if (argc == 3 && strcmp(argv[1], "--headless") == 0)
+    {
+        return run_headless(registry, assets, std::strtoull(argv[2], nullptr, 10));
+    }
+
+    // the interactive app is where validation messages are read
+    RenderSettings settings;
+    settings.validation_layers = true;
+    RenderSystem rs(settings);
 
     GLFWwindow* app_window = rs.create(1024, 768);
+    const StartupStats& startup = rs.startup_stats();
+    std::cout << "render system created in " << startup.create_us / 1000.0 << " ms, pipelines "
+              << startup.pipelines_us / 1000.0 << " ms with a " << (startup.pipeline_cache_warm ? "warm" : "cold")
+              << " pipeline cache" << std::endl;
     inputsystem::InputSystem insystem(app_window);
     auto prev_ts = std::chrono::high_resolution_clock::now();
+    bool toggle_pressed = false;
+    bool wireframe_pressed = false;
+    bool profile_pressed = false;
+    bool trace_pending = false;
+    size_t printed_loads = 0;
     while (!glfwWindowShouldClose(app_window))
     {
         if (glfwGetKey(app_window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         {
             glfwSetWindowShouldClose(app_window, true);
         }
+        // cycle through direct, indirect and GPU culled drawing with the I key
+        const bool toggle = glfwGetKey(app_window, GLFW_KEY_I) == GLFW_PRESS;
+        if (toggle && !toggle_pressed)
+        {
+            static const char* mode_names[] = {"direct", "indirect", "gpu culled"};
+            rs.set_draw_mode((DrawMode)(((int)rs.draw_mode() + 1) % 3));
+            std::cout << mode_names[(int)rs.draw_mode()] << " drawing" << std::endl;
+        }
+        toggle_pressed = toggle;
+        // switch between solid and wireframe shading with the F key
+        const bool wireframe = glfwGetKey(app_window, GLFW_KEY_F) == GLFW_PRESS;
+        if (wireframe && !wireframe_pressed)
+        {
+            rs.set_shading_mode(rs.shading_mode() == ShadingMode::solid ? ShadingMode::wireframe : ShadingMode::solid);
+            std::cout << (rs.shading_mode() == ShadingMode::solid ? "solid" : "wireframe") << " shading" << std::endl;
+        }
+        wireframe_pressed = wireframe;
+        // print the frame profile and capture a trace of the next frames with the P key
+        const bool profile = glfwGetKey(app_window, GLFW_KEY_P) == GLFW_PRESS;
+        if (profile && !profile_pressed && !trace_pending)
+        {
+            print_profile(profiler::global());
+            profiler::global().capture(120);
+            trace_pending = true;
+        }
+        profile_pressed = profile;
         if (glfwGetMouseButton(app_window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS)
         {
             std::cout << "right mouse button pressed" << std::endl;
@@ -68,8 +197,20 @@ int main(int argc, char* argv[])
         auto elapsed_time = std::chrono::duration_cast<std::chrono::microseconds>(now_ts - prev_ts);
         prev_ts = now_ts;
         glfwPollEvents();
-        insystem.process(entities, elapsed_time.count());
-        rs.process(entities, elapsed_time.count());
+        insystem.process(registry, elapsed_time.count());
+        assets.process(registry, elapsed_time.count());
+        print_loads(assets, &printed_loads);
+        rs.process(registry, elapsed_time.count());
+
+        profiler::global().end_frame();
+        if (trace_pending && !profiler::global().capturing())
+        {
+            // open in chrome://tracing or https://ui.perfetto.dev
+            std::ofstream trace("frame_trace.json");
+            profiler::global().write_chrome_trace(trace);
+            std::cout << "wrote frame_trace.json" << std::endl;
+            trace_pending = false;
+        }
     }
     glfwDestroyWindow(app_window);
     glfwTerminate();
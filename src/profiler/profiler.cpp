@@ -0,0 +1,230 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace profiler
+{
+
+namespace
+{
+// the ring the calling thread used last, so only the first event of a thread takes the lock
+struct ThreadCache
+{
+    uint32_t profiler_id = 0;
+    void* thread_ring = nullptr;
+};
+thread_local ThreadCache t_cache;
+std::atomic<uint32_t> g_next_profiler_id{1};
+
+void write_json_string(std::ostream& out, const char* s)
+{
+    out << '"';
+    for (; *s != '\0'; s++)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            out << '\\';
+        }
+        out << *s;
+    }
+    out << '"';
+}
+
+// microseconds with nanosecond resolution, the default precision of a stream would round long traces
+void write_us(std::ostream& out, uint64_t ns)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.3f", ns / 1e3);
+    out << text;
+}
+} // namespace
+
+EventRing::EventRing(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+    m_events.resize(size);
+    m_mask = size - 1;
+}
+
+Profiler::Profiler(size_t window_frames, size_t ring_capacity, bool enabled)
+    : m_id(g_next_profiler_id.fetch_add(1)), m_window_frames(std::max<size_t>(1, window_frames)),
+      m_ring_capacity(ring_capacity), m_enabled(enabled)
+{
+}
+
+Profiler::ThreadRing& Profiler::thread_ring()
+{
+    if (t_cache.profiler_id == m_id)
+    {
+        return *static_cast<ThreadRing*>(t_cache.thread_ring);
+    }
+    // first event of this thread, or the thread used another profiler in between
+    std::lock_guard<std::mutex> lock(m_threads_mutex);
+    const std::thread::id thread = std::this_thread::get_id();
+    auto it = std::find_if(m_threads.begin(), m_threads.end(),
+                           [thread](const std::unique_ptr<ThreadRing>& tr) { return tr->thread == thread; });
+    if (it == m_threads.end())
+    {
+        m_threads.push_back(std::make_unique<ThreadRing>(thread, (uint32_t)m_threads.size(), m_ring_capacity));
+        it = m_threads.end() - 1;
+    }
+    t_cache.profiler_id = m_id;
+    t_cache.thread_ring = it->get();
+    return **it;
+}
+
+void Profiler::end_frame()
+{
+    const bool keep = m_capture_frames > 0;
+    auto collect = [this, keep](const Event& event) {
+        // names are compared by content, equal literals of different translation units may have distinct pointers
+        Series*& cached = m_series_by_pointer[event.name];
+        if (cached == nullptr)
+        {
+            cached = &m_series[event.name];
+            cached->frame_ns.reserve(m_window_frames);
+        }
+        Series& series = *cached;
+        series.current_ns += event.end_ns - event.begin_ns;
+        series.current_calls++;
+        series.gpu = event.track == kGpuTrack;
+        if (keep)
+        {
+            m_trace.push_back(event);
+        }
+    };
+    {
+        std::lock_guard<std::mutex> lock(m_threads_mutex);
+        for (const std::unique_ptr<ThreadRing>& tr : m_threads)
+        {
+            tr->ring.drain(collect);
+        }
+    }
+    if (keep)
+    {
+        m_capture_frames--;
+    }
+
+    // the stats of the previous frame are overwritten, so their names keep their capacity
+    size_t stats_count = 0;
+    for (auto& [name, series] : m_series)
+    {
+        if (series.current_calls > 0)
+        {
+            if (series.frame_ns.size() < m_window_frames)
+            {
+                series.frame_ns.push_back(series.current_ns);
+            }
+            else
+            {
+                series.frame_ns[series.next] = series.current_ns;
+            }
+            series.next = (series.next + 1) % m_window_frames;
+            series.last_calls = series.current_calls;
+            series.current_ns = 0;
+            series.current_calls = 0;
+        }
+        if (series.frame_ns.empty())
+        {
+            continue;
+        }
+        if (stats_count == m_stats.size())
+        {
+            m_stats.emplace_back();
+        }
+        ScopeStats& stats = m_stats[stats_count++];
+        stats.name = name;
+        stats.gpu = series.gpu;
+        stats.frames = (uint32_t)series.frame_ns.size();
+        stats.calls = series.last_calls;
+        stats.last_us = series.frame_ns[(series.next + series.frame_ns.size() - 1) % series.frame_ns.size()] / 1e3;
+        std::vector<uint64_t>& sorted = m_sorted;
+        sorted.assign(series.frame_ns.begin(), series.frame_ns.end());
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t sum = 0;
+        for (uint64_t ns : sorted)
+        {
+            sum += ns;
+        }
+        stats.min_us = sorted.front() / 1e3;
+        stats.avg_us = sum / 1e3 / sorted.size();
+        // nearest rank
+        const size_t rank = (size_t)std::ceil(0.99 * sorted.size());
+        stats.p99_us = sorted[std::max<size_t>(rank, 1) - 1] / 1e3;
+    }
+    m_stats.resize(stats_count);
+}
+
+uint64_t Profiler::dropped() const
+{
+    std::lock_guard<std::mutex> lock(m_threads_mutex);
+    uint64_t dropped = 0;
+    for (const std::unique_ptr<ThreadRing>& tr : m_threads)
+    {
+        dropped += tr->ring.dropped();
+    }
+    return dropped;
+}
+
+void Profiler::capture(uint32_t frame_count)
+{
+    m_trace.clear();
+    m_capture_frames = frame_count;
+}
+
+void Profiler::write_chrome_trace(std::ostream& out) const
+{
+    uint64_t origin_ns = UINT64_MAX;
+    for (const Event& event : m_trace)
+    {
+        origin_ns = std::min(origin_ns, event.begin_ns);
+    }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    // name the tracks, the GPU one is shown below the threads
+    bool gpu = false;
+    uint32_t thread_count = 0;
+    for (const Event& event : m_trace)
+    {
+        gpu = gpu || event.track == kGpuTrack;
+        thread_count = event.track != kGpuTrack ? std::max(thread_count, event.track + 1) : thread_count;
+    }
+    bool first = true;
+    for (uint32_t track = 0; track < thread_count; track++)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+            << ",\"args\":{\"name\":\"thread " << track << "\"}}";
+        first = false;
+    }
+    if (gpu)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << kGpuTrack
+            << ",\"args\":{\"name\":\"GPU\"}}";
+        first = false;
+    }
+    // complete events, in microseconds
+    for (const Event& event : m_trace)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":";
+        write_json_string(out, event.name);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.track << ",\"ts\":";
+        write_us(out, event.begin_ns - origin_ns);
+        out << ",\"dur\":";
+        write_us(out, event.end_ns - event.begin_ns);
+        out << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+Profiler& global()
+{
+    static Profiler profiler(240, 1u << 14, false);
+    return profiler;
+}
+
+} // namespace profiler
@@ -0,0 +1,238 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace profiler
+{
+
+// nanoseconds on the steady clock, the timebase of all events
+inline uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// track of the events measured on the GPU, CPU events are on the track of their thread
+constexpr uint32_t kGpuTrack = 0xffff;
+
+/**
+ * A measured scope. name must outlive the profiler, usually it is a string literal.
+ */
+struct Event
+{
+    const char* name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    uint32_t track;
+};
+
+/**
+ * Fixed-size ring of events, written by one thread and read by another without locks. A full ring drops events
+ * instead of blocking the writer.
+ */
+class EventRing
+{
+  public:
+    // capacity is rounded up to a power of two
+    explicit EventRing(size_t capacity);
+
+    // writer thread only, false if the event was dropped
+    bool push(const Event& event)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == m_events.size())
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_events[head & m_mask] = event;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    // reader thread only, calls fn(event) for every event pushed so far and removes them
+    template <typename F> size_t drain(F&& fn)
+    {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t count = (size_t)(head - tail);
+        for (; tail != head; tail++)
+        {
+            fn(m_events[tail & m_mask]);
+        }
+        m_tail.store(tail, std::memory_order_release);
+        return count;
+    }
+    uint64_t dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::vector<Event> m_events;
+    uint64_t m_mask;
+    // on separate cache lines, the writer and the reader each own one
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+/**
+ * Time per frame spent in a scope, summed over all calls in the frame, over the recent frames.
+ */
+struct ScopeStats
+{
+    std::string name;
+    bool gpu = false;
+    uint32_t frames = 0; // frames in the window which had the scope
+    uint32_t calls = 0;  // in the last frame with the scope
+    double last_us = 0;
+    double min_us = 0;
+    double avg_us = 0;
+    double p99_us = 0;
+};
+
+/**
+ * Collects the events of scope timers on any number of threads. Recording is lock-free, each thread writes to an
+ * EventRing of its own, which end_frame() empties once per frame into rolling statistics and, while capturing, into
+ * a trace for chrome://tracing or https://ui.perfetto.dev.
+ */
+class Profiler
+{
+  public:
+    // window_frames: frames the statistics cover, ring_capacity: events per thread and frame
+    explicit Profiler(size_t window_frames = 240, size_t ring_capacity = 1u << 14, bool enabled = true);
+    Profiler(const Profiler& rhs) = delete;
+    Profiler& operator=(const Profiler& rhs) = delete;
+
+    // a disabled profiler records nothing, scope timers cost a load of the flag
+    void set_enabled(bool enabled)
+    {
+        m_enabled.store(enabled, std::memory_order_relaxed);
+    }
+    bool enabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+    // any thread, on the thread's track
+    void record(const char* name, uint64_t begin_ns, uint64_t end_ns)
+    {
+        ThreadRing& tr = thread_ring();
+        tr.ring.push(Event{name, begin_ns, end_ns, tr.track});
+    }
+    // any thread, on kGpuTrack. begin_ns and end_ns are GPU times mapped to now_ns()
+    void record_gpu(const char* name, uint64_t begin_ns, uint64_t end_ns)
+    {
+        thread_ring().ring.push(Event{name, begin_ns, end_ns, kGpuTrack});
+    }
+
+    // collect the events of all threads into the statistics, once per frame from one thread
+    void end_frame();
+    // sorted by name, valid until the next end_frame()
+    const std::vector<ScopeStats>& stats() const
+    {
+        return m_stats;
+    }
+    // events lost to full rings so far
+    uint64_t dropped() const;
+
+    // keep the events of the next frame_count frames for write_chrome_trace, replacing an older trace
+    void capture(uint32_t frame_count);
+    // a capture is under way
+    bool capturing() const
+    {
+        return m_capture_frames > 0;
+    }
+    // the captured events in the Chrome trace event format, times relative to the first event
+    void write_chrome_trace(std::ostream& out) const;
+    const std::vector<Event>& trace() const
+    {
+        return m_trace;
+    }
+
+  private:
+    struct ThreadRing
+    {
+        ThreadRing(std::thread::id thread, uint32_t track, size_t capacity)
+            : thread(thread), track(track), ring(capacity)
+        {
+        }
+        std::thread::id thread;
+        uint32_t track;
+        EventRing ring;
+    };
+    struct Series
+    {
+        std::vector<uint64_t> frame_ns; // ring of the last window frames which had the scope
+        size_t next = 0;
+        uint64_t current_ns = 0; // sum over the frame being collected
+        uint32_t current_calls = 0;
+        uint32_t last_calls = 0;
+        bool gpu = false;
+    };
+
+    // the ring of the calling thread, created on its first event
+    ThreadRing& thread_ring();
+
+  private:
+    const uint32_t m_id; // tells the profilers apart in the per-thread cache of thread_ring()
+    const size_t m_window_frames;
+    const size_t m_ring_capacity;
+    std::atomic<bool> m_enabled;
+
+    mutable std::mutex m_threads_mutex; // guards m_threads, taken once per thread and once per end_frame
+    std::vector<std::unique_ptr<ThreadRing>> m_threads;
+
+    std::map<std::string, Series> m_series;
+    // the series of every name pointer seen so far, so end_frame() only builds a string for a new pointer
+    std::unordered_map<const char*, Series*> m_series_by_pointer;
+    std::vector<ScopeStats> m_stats;
+    std::vector<uint64_t> m_sorted; // scratch of end_frame(), kept to reuse the capacity
+    uint32_t m_capture_frames = 0;
+    std::vector<Event> m_trace;
+};
+
+// the profiler of PROFILE_SCOPE, disabled until the application enables it
+Profiler& global();
+
+/**
+ * Records the time between its construction and destruction as an event of name.
+ */
+class ScopeTimer
+{
+  public:
+    ScopeTimer(Profiler& profiler, const char* name)
+        : m_profiler(profiler.enabled() ? &profiler : nullptr), m_name(name), m_begin_ns(m_profiler ? now_ns() : 0)
+    {
+    }
+    ~ScopeTimer()
+    {
+        if (m_profiler)
+        {
+            m_profiler->record(m_name, m_begin_ns, now_ns());
+        }
+    }
+    ScopeTimer(const ScopeTimer& rhs) = delete;
+    ScopeTimer& operator=(const ScopeTimer& rhs) = delete;
+
+  private:
+    Profiler* m_profiler;
+    const char* m_name;
+    uint64_t m_begin_ns;
+};
+
+} // namespace profiler
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// time the rest of the enclosing block with the global profiler, name must be a string literal
+#define PROFILE_SCOPE(name) ::profiler::ScopeTimer PROFILE_CONCAT(profile_scope_, __LINE__)(::profiler::global(), name)
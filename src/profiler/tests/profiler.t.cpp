@@ -0,0 +1,183 @@
+#include "allocationcounter.h"
+#include "profiler.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace profiler;
+
+static const ScopeStats* find_stats(const Profiler& profiler, const std::string& name)
+{
+    for (const ScopeStats& stats : profiler.stats())
+    {
+        if (stats.name == name)
+        {
+            return &stats;
+        }
+    }
+    return nullptr;
+}
+
+TEST_CASE("EventRing drops events instead of overwriting unread ones")
+{
+    EventRing ring(3);
+    int pushed = 0;
+    while (ring.push(Event{"e", 0, (uint64_t)pushed, 0}))
+    {
+        pushed++;
+    }
+    REQUIRE(pushed == 4);
+    REQUIRE(ring.dropped() == 1);
+    std::vector<uint64_t> ends;
+    REQUIRE(ring.drain([&](const Event& e) { ends.push_back(e.end_ns); }) == 4);
+    REQUIRE(ends == std::vector<uint64_t>{0, 1, 2, 3});
+    // wrapped around
+    REQUIRE(ring.push(Event{"e", 0, 4, 0}));
+    ends.clear();
+    ring.drain([&](const Event& e) { ends.push_back(e.end_ns); });
+    REQUIRE(ends == std::vector<uint64_t>{4});
+}
+
+TEST_CASE("EventRing hands every event from the writer to the reader in order")
+{
+    const uint64_t kCount = 200'000;
+    EventRing ring(64);
+    std::thread writer([&] {
+        for (uint64_t i = 0; i < kCount;)
+        {
+            // retry instead of dropping, so the reader has to see all of them
+            if (ring.push(Event{"e", i, i, 0}))
+            {
+                i++;
+            }
+        }
+    });
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < kCount)
+    {
+        ring.drain([&](const Event& e) { ordered = ordered && e.begin_ns == expected++; });
+    }
+    writer.join();
+    REQUIRE(ordered);
+}
+
+TEST_CASE("Profiler keeps min, average and p99 of the time per frame")
+{
+    Profiler profiler(100);
+    // a scope called twice per frame, frame i takes 2 * (i + 1) us
+    for (uint64_t frame = 0; frame < 100; frame++)
+    {
+        profiler.record("update", 0, (frame + 1) * 1000);
+        profiler.record("update", 5000, 5000 + (frame + 1) * 1000);
+        profiler.end_frame();
+    }
+    const ScopeStats* update = find_stats(profiler, "update");
+    REQUIRE(update != nullptr);
+    REQUIRE_FALSE(update->gpu);
+    REQUIRE(update->frames == 100);
+    REQUIRE(update->calls == 2);
+    REQUIRE(update->last_us == 200.0);
+    REQUIRE(update->min_us == 2.0);
+    REQUIRE(update->avg_us == 101.0);
+    REQUIRE(update->p99_us == 198.0);
+
+    // the window only covers the last 100 frames
+    profiler.record("update", 0, 1000'000);
+    profiler.end_frame();
+    update = find_stats(profiler, "update");
+    REQUIRE(update->frames == 100);
+    REQUIRE(update->min_us == 4.0);
+    REQUIRE(update->p99_us == 200.0);
+    REQUIRE(update->calls == 1);
+
+    // scopes without events in a frame keep their statistics
+    profiler.record_gpu("gpu frame", 0, 3000);
+    profiler.end_frame();
+    REQUIRE(find_stats(profiler, "update")->frames == 100);
+    REQUIRE(find_stats(profiler, "gpu frame")->gpu);
+}
+
+TEST_CASE("Profiler collects the scopes of all threads")
+{
+    Profiler profiler;
+    auto work = [&profiler] {
+        for (int i = 0; i < 1000; i++)
+        {
+            ScopeTimer timer(profiler, "work");
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back(work);
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    profiler.end_frame();
+    REQUIRE(find_stats(profiler, "work")->calls == 4000);
+    REQUIRE(profiler.dropped() == 0);
+
+    profiler.set_enabled(false);
+    work();
+    profiler.end_frame();
+    REQUIRE(find_stats(profiler, "work")->frames == 1);
+}
+
+TEST_CASE("Profiler writes captured frames as a Chrome trace")
+{
+    Profiler profiler;
+    profiler.record("before capture", 0, 10);
+    profiler.end_frame();
+    profiler.capture(2);
+    REQUIRE(profiler.capturing());
+    profiler.record("frame \"1\"", 1000, 3500);
+    profiler.record_gpu("gpu", 2000, 4000);
+    profiler.end_frame();
+    profiler.record("frame 2", 5000, 6000);
+    profiler.end_frame();
+    REQUIRE_FALSE(profiler.capturing());
+    profiler.record("after capture", 7000, 8000);
+    profiler.end_frame();
+    REQUIRE(profiler.trace().size() == 3);
+
+    std::ostringstream out;
+    profiler.write_chrome_trace(out);
+    const std::string json = out.str();
+    REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(json.find("{\"name\":\"frame \\\"1\\\"\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":0.000,\"dur\":2.500}") !=
+            std::string::npos);
+    REQUIRE(json.find("\"ts\":4.000,\"dur\":1.000") != std::string::npos);
+    REQUIRE(json.find("\"args\":{\"name\":\"GPU\"}") != std::string::npos);
+    REQUIRE(json.find("before capture") == std::string::npos);
+    REQUIRE(json.find("after capture") == std::string::npos);
+}
+
+TEST_CASE("Profiler::end_frame performs no heap allocation in steady state")
+{
+    Profiler profiler(16, 256);
+    // longer than the small string buffer of std::string
+    const char* names[] = {"RenderSystem::begin_render_pass", "RenderSystem::present_pass", "record_range"};
+    auto frame = [&] {
+        for (const char* name : names)
+        {
+            profiler.record(name, 0, 1000);
+        }
+        profiler.record_gpu("gpu frame", 0, 2000);
+        profiler.end_frame();
+    };
+    // the first frame creates the thread ring and the series
+    frame();
+    const size_t allocations = allocation_count();
+    for (int i = 0; i < 100; i++)
+    {
+        frame();
+    }
+    REQUIRE(allocation_count() == allocations);
+    REQUIRE(profiler.stats().size() == 4);
+    REQUIRE(find_stats(profiler, "record_range")->frames == 16);
+}
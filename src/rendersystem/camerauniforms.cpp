@@ -0,0 +1,21 @@
+#include "camerauniforms.h"
+#include <cstddef>
+
+namespace rendersystem
+{
+
+static_assert(sizeof(CameraUniforms) == 3 * 64 + 6 * 16 + 16 && offsetof(CameraUniforms, frustum) == 3 * 64,
+              "CameraUniforms has to match the Camera block of mesh.vert");
+
+CameraUniforms make_camera_uniforms(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position)
+{
+    CameraUniforms uniforms;
+    uniforms.view = view;
+    uniforms.projection = projection;
+    uniforms.view_proj = projection * view;
+    uniforms.frustum = frustum_from_matrix(uniforms.view_proj);
+    uniforms.position = glm::vec4(position, 1.0f);
+    return uniforms;
+}
+
+} // namespace rendersystem
@@ -0,0 +1,23 @@
+#pragma once
+#include "culling.h"
+#include <glm/glm.hpp>
+
+namespace rendersystem
+{
+
+/**
+ * Camera values shared by all draws of a frame, computed once per frame. Layout matches the Camera uniform block of
+ * mesh.vert (std140).
+ */
+struct CameraUniforms
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_proj; // projection * view
+    Frustum frustum;     // world-space planes of view_proj
+    glm::vec4 position;  // world-space eye position, w = 1
+};
+
+CameraUniforms make_camera_uniforms(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position);
+
+} // namespace rendersystem
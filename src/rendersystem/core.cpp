@@ -6,10 +6,94 @@
 #define VMA_IMPLEMENTATION
 #include "check.h"
 #include "vk_mem_alloc.h"
+#include <vector>
 namespace rendersystem
 {
 
-CoreData create_core_with_window(const std::string& app_name, uint32_t width, uint32_t height)
+// select a device for the instance and create everything below it. surface may be VK_NULL_HANDLE for headless use
+static void create_device_objects(CoreData* core_data, const vkb::Instance& vkb_instance)
+{
+    // use vkbootstrap to select a GPU.
+    vkb::PhysicalDeviceSelector selector{vkb_instance};
+    if (core_data->surface != VK_NULL_HANDLE)
+    {
+        selector.set_surface(core_data->surface);
+    }
+    auto selected = selector
+                        //   .prefer_gpu_device_type()
+                        //   .require_present(true)
+                        .select();
+    if (!selected)
+    {
+        throw NoDeviceError("no suitable vulkan device: " + selected.error().message());
+    }
+    vkb::PhysicalDevice vkb_physical_device = selected.value();
+
+    // the device is created with the features in vkb_physical_device.features, add the optional ones
+    VkPhysicalDeviceFeatures supported = {};
+    vkGetPhysicalDeviceFeatures(vkb_physical_device.physical_device, &supported);
+    vkb_physical_device.features.multiDrawIndirect = supported.multiDrawIndirect;
+    vkb_physical_device.features.drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+    vkb_physical_device.features.fillModeNonSolid = supported.fillModeNonSolid;
+    core_data->multi_draw_indirect = supported.multiDrawIndirect == VK_TRUE;
+    core_data->draw_indirect_first_instance = supported.drawIndirectFirstInstance == VK_TRUE;
+    core_data->fill_mode_non_solid = supported.fillModeNonSolid == VK_TRUE;
+
+    vkb::DeviceBuilder vkb_device_builder{vkb_physical_device};
+    vkb::Device vkb_device = vkb_device_builder.build().value();
+
+    // Get the VkDevice handle used in the rest of a Vulkan application
+    core_data->device = vkb_device.device;
+    core_data->physical_device = vkb_physical_device.physical_device;
+    core_data->graphics_queue = vkb_device.get_queue(vkb::QueueType::graphics).value();
+    core_data->graphics_queue_family = vkb_device.get_queue_index(vkb::QueueType::graphics).value();
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(core_data->physical_device, &properties);
+    core_data->timestamp_period = properties.limits.timestampPeriod;
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(core_data->physical_device, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(core_data->physical_device, &family_count, families.data());
+    core_data->timestamp_valid_bits = families[core_data->graphics_queue_family].timestampValidBits;
+
+    if (core_data->surface != VK_NULL_HANDLE)
+    {
+        core_data->present_queue = vkb_device.get_queue(vkb::QueueType::present).value();
+        core_data->present_queue_family = vkb_device.get_queue_index(vkb::QueueType::present).value();
+    }
+    else
+    {
+        core_data->present_queue = core_data->graphics_queue;
+        core_data->present_queue_family = core_data->graphics_queue_family;
+    }
+
+    // prefer a transfer-only queue family (DMA engine), then any queue family without graphics
+    auto transfer_queue = vkb_device.get_dedicated_queue(vkb::QueueType::transfer);
+    auto transfer_queue_family = vkb_device.get_dedicated_queue_index(vkb::QueueType::transfer);
+    if (!transfer_queue)
+    {
+        transfer_queue = vkb_device.get_queue(vkb::QueueType::transfer);
+        transfer_queue_family = vkb_device.get_queue_index(vkb::QueueType::transfer);
+    }
+    if (transfer_queue)
+    {
+        core_data->transfer_queue = transfer_queue.value();
+        core_data->transfer_queue_family = transfer_queue_family.value();
+    }
+    else
+    {
+        core_data->transfer_queue = core_data->graphics_queue;
+        core_data->transfer_queue_family = core_data->graphics_queue_family;
+    }
+
+    VmaAllocatorCreateInfo allocatorInfo = {};
+    allocatorInfo.physicalDevice = core_data->physical_device;
+    allocatorInfo.device = core_data->device;
+    allocatorInfo.instance = core_data->instance;
+    vmaCreateAllocator(&allocatorInfo, &core_data->allocator);
+}
+
+CoreData create_core_with_window(const std::string& app_name, uint32_t width, uint32_t height, bool validation)
 {
 
     CoreData core_data = {};
@@ -25,7 +109,11 @@ CoreData create_core_with_window(const std::string& app_name, uint32_t width, ui
     glfw_extensions = glfwGetRequiredInstanceExtensions(&ext_count);
 
     vkb::InstanceBuilder builder;
-    builder.set_app_name(app_name.c_str()).request_validation_layers(true).use_default_debug_messenger();
+    builder.set_app_name(app_name.c_str()).request_validation_layers(validation);
+    if (validation)
+    {
+        builder.use_default_debug_messenger();
+    }
     for (int i = 0; i < ext_count; i++)
     {
         builder.enable_extension(glfw_extensions[i]);
@@ -39,72 +127,45 @@ CoreData create_core_with_window(const std::string& app_name, uint32_t width, ui
     {
         throw std::runtime_error("failed to create window surface!");
     }
+    create_device_objects(&core_data, vkb_instance);
+    return core_data;
+}
 
-    // use vkbootstrap to select a GPU.
-    vkb::PhysicalDeviceSelector selector{vkb_instance};
-    vkb::PhysicalDevice vkb_physical_device = selector
-                                                  .set_surface(core_data.surface)
-                                                  //   .prefer_gpu_device_type()
-                                                  //   .require_present(true)
-                                                  .select()
-                                                  .value();
-
-    vkb::DeviceBuilder vkb_device_builder{vkb_physical_device};
-    vkb::Device vkb_device = vkb_device_builder.build().value();
-
-    // Get the VkDevice handle used in the rest of a Vulkan application
-    core_data.device = vkb_device.device;
-    core_data.physical_device = vkb_physical_device.physical_device;
-    core_data.graphics_queue = vkb_device.get_queue(vkb::QueueType::graphics).value();
-    core_data.graphics_queue_family = vkb_device.get_queue_index(vkb::QueueType::graphics).value();
-
-    core_data.present_queue = vkb_device.get_queue(vkb::QueueType::present).value();
-    core_data.present_queue_family = vkb_device.get_queue_index(vkb::QueueType::present).value();
-
-    VmaAllocatorCreateInfo allocatorInfo = {};
-    allocatorInfo.physicalDevice = core_data.physical_device;
-    allocatorInfo.device = core_data.device;
-    allocatorInfo.instance = core_data.instance;
-    vmaCreateAllocator(&allocatorInfo, &core_data.allocator);
-
-    VkCommandPoolCreateInfo cmd_pool_info = {};
-    cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    cmd_pool_info.pNext = nullptr;
-    cmd_pool_info.queueFamilyIndex = core_data.graphics_queue_family;
-    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    vkCreateCommandPool(core_data.device, &cmd_pool_info, nullptr, &core_data.cmd_pool);
-
-    VkCommandBufferAllocateInfo cmd_buf_info = {};
-    cmd_buf_info.pNext = nullptr;
-    cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    cmd_buf_info.commandPool = core_data.cmd_pool;
-    cmd_buf_info.commandBufferCount = 1;
-    cmd_buf_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    vkAllocateCommandBuffers(core_data.device, &cmd_buf_info, &core_data.cmd_buf_main);
-
-    VkFenceCreateInfo fence_create_info = {};
-    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    vkCreateFence(core_data.device, &fence_create_info, nullptr, &core_data.fence_host);
-
-    VkSemaphoreCreateInfo semaphore_create_info = {};
-    semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    VK_CHECK_RESULT(vkCreateSemaphore(core_data.device, &semaphore_create_info, nullptr, &core_data.semaphore_present));
-    VK_CHECK_RESULT(vkCreateSemaphore(core_data.device, &semaphore_create_info, nullptr, &core_data.semaphore_render));
+CoreData create_core_headless(const std::string& app_name, uint32_t width, uint32_t height, bool validation)
+{
+    CoreData core_data = {};
+    core_data.window_size = VkExtent2D{width, height};
 
+    vkb::InstanceBuilder builder;
+    builder.set_app_name(app_name.c_str()).set_headless(true).request_validation_layers(validation);
+    if (validation)
+    {
+        builder.use_default_debug_messenger();
+    }
+    auto instance = builder.build();
+    if (!instance)
+    {
+        throw NoDeviceError("cannot create vulkan instance: " + instance.error().message());
+    }
+    vkb::Instance vkb_instance = instance.value();
+    core_data.instance = vkb_instance.instance;
+    core_data.debug_messenger = vkb_instance.debug_messenger;
+    create_device_objects(&core_data, vkb_instance);
     return core_data;
 }
 
 void destroy_core(CoreData* core_data)
 {
-    vkDestroyFence(core_data->device, core_data->fence_host, nullptr);
-    vkDestroySemaphore(core_data->device, core_data->semaphore_present, nullptr);
-    vkDestroySemaphore(core_data->device, core_data->semaphore_render, nullptr);
-    vkDestroyCommandPool(core_data->device, core_data->cmd_pool, nullptr);
     vmaDestroyAllocator(core_data->allocator);
     vkDestroyDevice(core_data->device, nullptr);
-    vkDestroySurfaceKHR(core_data->instance, core_data->surface, nullptr);
-    vkb::destroy_debug_utils_messenger(core_data->instance, core_data->debug_messenger);
+    if (core_data->surface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(core_data->instance, core_data->surface, nullptr);
+    }
+    if (core_data->debug_messenger != VK_NULL_HANDLE)
+    {
+        vkb::destroy_debug_utils_messenger(core_data->instance, core_data->debug_messenger);
+    }
     vkDestroyInstance(core_data->instance, nullptr);
     *core_data = {};
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "VkBootstrap.h"
+#include <stdexcept>
 #include <string>
 #include <vulkan/vulkan_core.h>
 // forward decl
@@ -26,17 +27,38 @@ struct CoreData
     uint32_t graphics_queue_family;
     VkQueue present_queue;
     uint32_t present_queue_family;
+    VkQueue transfer_queue; // aliases graphics_queue if the device has no separate transfer queue
+    uint32_t transfer_queue_family;
     VmaAllocator allocator;
-    VkCommandPool cmd_pool;
-    VkCommandBuffer cmd_buf_main;
-    VkSemaphore semaphore_present;
-    VkSemaphore semaphore_render;
-    VkFence fence_host;
+    // optional device features, enabled when supported
+    bool multi_draw_indirect;          // one vkCmdDrawIndexedIndirect may execute more than one command
+    bool draw_indirect_first_instance; // indirect commands may start at an instance other than 0
+    bool fill_mode_non_solid;          // pipelines may draw wireframes and points
+    // GPU timestamps of the graphics queue, timestamp_valid_bits is 0 if it cannot write any
+    float timestamp_period; // nanoseconds per tick
+    uint32_t timestamp_valid_bits;
 };
 /**
- * Create Vulkan objects for on-screen rendering
+ * Thrown when there is no Vulkan instance or no suitable device to render with, unlike other errors while creating
+ * the core objects. Tests skip on it.
  */
-CoreData create_core_with_window(const std::string& app_name, uint32_t width, uint32_t height);
+struct NoDeviceError : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Create Vulkan objects for on-screen rendering. validation enables the validation layers and a debug messenger
+ * printing their messages, the layers have to be installed.
+ */
+CoreData create_core_with_window(const std::string& app_name, uint32_t width, uint32_t height,
+                                 bool validation = false);
+/**
+ * Create Vulkan objects without window and surface, e.g. to run on a software driver in CI.
+ * window_size is set to width x height, present_queue aliases graphics_queue. validation as for
+ * create_core_with_window.
+ */
+CoreData create_core_headless(const std::string& app_name, uint32_t width, uint32_t height, bool validation = false);
 
 void destroy_core(CoreData* core_data);
 
@@ -0,0 +1,167 @@
+#include "culling.h"
+#if defined(__x86_64__) || defined(__SSE2__)
+#include <immintrin.h>
+#define CULLING_X86
+#endif
+
+namespace rendersystem
+{
+
+Frustum frustum_from_matrix(const glm::mat4& m)
+{
+    // Gribb/Hartmann: the planes are sums and differences of the matrix rows
+    auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    Frustum f;
+    f.planes[0] = row(3) + row(0); // left
+    f.planes[1] = row(3) - row(0); // right
+    f.planes[2] = row(3) + row(1); // bottom, top if y is flipped
+    f.planes[3] = row(3) - row(1);
+    f.planes[4] = row(3) + row(2); // near
+    f.planes[5] = row(3) - row(2); // far
+    for (glm::vec4& plane : f.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return f;
+}
+
+void BoundingSpheres::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_radius.clear();
+}
+
+void BoundingSpheres::push_back(const glm::vec3& center, float radius)
+{
+    m_x.push_back(center.x);
+    m_y.push_back(center.y);
+    m_z.push_back(center.z);
+    m_radius.push_back(radius);
+}
+
+// test the spheres [begin, end) one at a time
+static uint32_t cull_range(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                           size_t begin, size_t end, uint8_t* visible)
+{
+    uint32_t count = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        bool inside = true;
+        for (const glm::vec4& p : frustum.planes)
+        {
+            // same order of operations as the vector code, so all paths agree on spheres touching a plane
+            inside &= ((p.x * x[i] + p.w) + p.y * y[i]) + p.z * z[i] >= -radius[i];
+        }
+        visible[i] = inside ? 1 : 0;
+        count += inside ? 1 : 0;
+    }
+    return count;
+}
+
+#ifdef CULLING_X86
+static uint32_t cull_sse(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius,
+                         size_t n, uint8_t* visible)
+{
+    __m128 planes[6][4];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+        }
+    }
+    uint32_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128 sx = _mm_loadu_ps(x + i);
+        const __m128 sy = _mm_loadu_ps(y + i);
+        const __m128 sz = _mm_loadu_ps(z + i);
+        const __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(planes[p][0], sx), planes[p][3]);
+            d = _mm_add_ps(d, _mm_mul_ps(planes[p][1], sy));
+            d = _mm_add_ps(d, _mm_mul_ps(planes[p][2], sz));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_radius));
+        }
+        const int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            visible[i + lane] = (mask >> lane) & 1;
+        }
+        count += __builtin_popcount(mask);
+    }
+    return count + cull_range(frustum, x, y, z, radius, i, n, visible);
+}
+
+__attribute__((target("avx"))) static uint32_t cull_avx(const Frustum& frustum, const float* x, const float* y,
+                                                         const float* z, const float* radius, size_t n,
+                                                         uint8_t* visible)
+{
+    __m256 planes[6][4];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+        }
+    }
+    uint32_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256 sx = _mm256_loadu_ps(x + i);
+        const __m256 sy = _mm256_loadu_ps(y + i);
+        const __m256 sz = _mm256_loadu_ps(z + i);
+        const __m256 neg_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(planes[p][0], sx), planes[p][3]);
+            d = _mm256_add_ps(d, _mm256_mul_ps(planes[p][1], sy));
+            d = _mm256_add_ps(d, _mm256_mul_ps(planes[p][2], sz));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg_radius, _CMP_GE_OQ));
+        }
+        const int mask = _mm256_movemask_ps(inside);
+        for (int lane = 0; lane < 8; lane++)
+        {
+            visible[i + lane] = (mask >> lane) & 1;
+        }
+        count += __builtin_popcount(mask);
+    }
+    return count + cull_range(frustum, x, y, z, radius, i, n, visible);
+}
+#endif
+
+CullingStats BoundingSpheres::cull(const Frustum& frustum, uint8_t* visible) const
+{
+    const size_t n = size();
+    uint32_t count;
+#ifdef CULLING_X86
+    static const bool has_avx = __builtin_cpu_supports("avx");
+    if (has_avx)
+    {
+        count = cull_avx(frustum, m_x.data(), m_y.data(), m_z.data(), m_radius.data(), n, visible);
+    }
+    else
+    {
+        count = cull_sse(frustum, m_x.data(), m_y.data(), m_z.data(), m_radius.data(), n, visible);
+    }
+#else
+    count = cull_range(frustum, m_x.data(), m_y.data(), m_z.data(), m_radius.data(), 0, n, visible);
+#endif
+    return CullingStats{count, (uint32_t)n - count};
+}
+
+CullingStats BoundingSpheres::cull_scalar(const Frustum& frustum, uint8_t* visible) const
+{
+    const size_t n = size();
+    const uint32_t count = cull_range(frustum, m_x.data(), m_y.data(), m_z.data(), m_radius.data(), 0, n, visible);
+    return CullingStats{count, (uint32_t)n - count};
+}
+
+} // namespace rendersystem
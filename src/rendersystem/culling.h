@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace rendersystem
+{
+
+/**
+ * Planes of a view frustum as (normal, distance), normalized and pointing inwards: a point p lies on the inner side
+ * of a plane if dot(normal, p) + distance >= 0.
+ */
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+/**
+ * Planes of the clip volume of view_proj, e.g. in world space for projection * view. The near plane is taken at
+ * z = -w, which also contains the clip volume of depth range [0, 1].
+ */
+Frustum frustum_from_matrix(const glm::mat4& view_proj);
+
+struct CullingStats
+{
+    uint32_t visible = 0;
+    uint32_t culled = 0;
+};
+
+/**
+ * World-space bounding spheres in struct-of-arrays layout, so the frustum test checks 8 (AVX) or 4 (SSE) spheres
+ * against a plane per instruction. The instruction set is picked at runtime.
+ */
+class BoundingSpheres
+{
+  public:
+    void clear();
+    void push_back(const glm::vec3& center, float radius);
+    size_t size() const
+    {
+        return m_x.size();
+    }
+    /**
+     * Set visible[i] to 1 if sphere i intersects the frustum and to 0 otherwise. visible needs room for size()
+     * elements. Spheres touching a plane count as visible.
+     */
+    CullingStats cull(const Frustum& frustum, uint8_t* visible) const;
+    // reference for cull(), testing one sphere at a time
+    CullingStats cull_scalar(const Frustum& frustum, uint8_t* visible) const;
+
+  private:
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_radius;
+};
+
+} // namespace rendersystem
@@ -0,0 +1,181 @@
+#include "descriptors.h"
+#include "check.h"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+
+namespace rendersystem
+{
+
+DescriptorLayoutKey::DescriptorLayoutKey(const std::vector<VkDescriptorSetLayoutBinding>& layout_bindings)
+{
+    bindings.reserve(layout_bindings.size());
+    for (const VkDescriptorSetLayoutBinding& b : layout_bindings)
+    {
+        bindings.push_back(Binding{b.binding, b.descriptorType, b.descriptorCount, b.stageFlags});
+    }
+    std::sort(bindings.begin(), bindings.end(),
+              [](const Binding& a, const Binding& b) { return a.binding < b.binding; });
+}
+
+bool DescriptorLayoutKey::operator==(const DescriptorLayoutKey& rhs) const
+{
+    return std::equal(bindings.begin(), bindings.end(), rhs.bindings.begin(), rhs.bindings.end(),
+                      [](const Binding& a, const Binding& b) {
+                          return a.binding == b.binding && a.type == b.type && a.count == b.count &&
+                                 a.stages == b.stages;
+                      });
+}
+
+size_t DescriptorLayoutKey::hash() const
+{
+    size_t h = std::hash<size_t>()(bindings.size());
+    for (const Binding& b : bindings)
+    {
+        const uint64_t packed = (uint64_t)b.binding | (uint64_t)b.type << 16 | (uint64_t)b.count << 32 |
+                                (uint64_t)(b.stages & 0xffff) << 48;
+        // boost::hash_combine
+        h ^= std::hash<uint64_t>()(packed) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+void DescriptorLayoutCache::create(VkDevice device)
+{
+    m_device = device;
+}
+
+void DescriptorLayoutCache::destroy()
+{
+    for (auto& [key, layout] : m_layouts)
+    {
+        vkDestroyDescriptorSetLayout(m_device, layout, nullptr);
+    }
+    m_layouts.clear();
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::get(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+    DescriptorLayoutKey key(bindings);
+    auto it = m_layouts.find(key);
+    if (it != m_layouts.end())
+    {
+        return it->second;
+    }
+    VkDescriptorSetLayoutCreateInfo set_layout_info = {};
+    set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    set_layout_info.bindingCount = (uint32_t)bindings.size();
+    set_layout_info.pBindings = bindings.data();
+    VkDescriptorSetLayout layout;
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_device, &set_layout_info, nullptr, &layout));
+    m_layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+void DescriptorAllocator::create(VkDevice device, uint32_t sets_per_pool)
+{
+    m_device = device;
+    m_sets_per_pool = sets_per_pool;
+}
+
+void DescriptorAllocator::destroy()
+{
+    for (VkDescriptorPool pool : m_used_pools)
+    {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+    for (VkDescriptorPool pool : m_free_pools)
+    {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+    m_used_pools.clear();
+    m_free_pools.clear();
+    m_current = VK_NULL_HANDLE;
+}
+
+VkDescriptorPool DescriptorAllocator::grab_pool()
+{
+    if (!m_free_pools.empty())
+    {
+        VkDescriptorPool pool = m_free_pools.back();
+        m_free_pools.pop_back();
+        return pool;
+    }
+    // descriptors per set on average, by type
+    const VkDescriptorPoolSize sizes[] = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * m_sets_per_pool},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * m_sets_per_pool},
+    };
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = m_sets_per_pool;
+    pool_info.poolSizeCount = (uint32_t)std::size(sizes);
+    pool_info.pPoolSizes = sizes;
+    VkDescriptorPool pool;
+    VK_CHECK_RESULT(vkCreateDescriptorPool(m_device, &pool_info, nullptr, &pool));
+    return pool;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+    if (m_current == VK_NULL_HANDLE)
+    {
+        m_current = grab_pool();
+        m_used_pools.push_back(m_current);
+    }
+    VkDescriptorSetAllocateInfo set_info = {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = m_current;
+    set_info.descriptorSetCount = 1;
+    set_info.pSetLayouts = &layout;
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(m_device, &set_info, &set);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+    {
+        // the current pool is full, continue with the next one
+        m_current = grab_pool();
+        m_used_pools.push_back(m_current);
+        set_info.descriptorPool = m_current;
+        result = vkAllocateDescriptorSets(m_device, &set_info, &set);
+    }
+    VK_CHECK_RESULT(result);
+    return set;
+}
+
+void DescriptorAllocator::reset()
+{
+    for (VkDescriptorPool pool : m_used_pools)
+    {
+        vkResetDescriptorPool(m_device, pool, 0);
+        m_free_pools.push_back(pool);
+    }
+    m_used_pools.clear();
+    m_current = VK_NULL_HANDLE;
+}
+
+DescriptorWriter& DescriptorWriter::write_buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer,
+                                                 VkDeviceSize offset, VkDeviceSize range)
+{
+    assert(m_count < kMaxWrites);
+    m_buffer_infos[m_count] = VkDescriptorBufferInfo{buffer, offset, range};
+    VkWriteDescriptorSet& write = m_writes[m_count];
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstBinding = binding;
+    write.descriptorCount = 1;
+    write.descriptorType = type;
+    m_count++;
+    return *this;
+}
+
+void DescriptorWriter::update(VkDevice device, VkDescriptorSet set)
+{
+    for (uint32_t i = 0; i < m_count; i++)
+    {
+        m_writes[i].dstSet = set;
+        m_writes[i].pBufferInfo = &m_buffer_infos[i];
+    }
+    vkUpdateDescriptorSets(device, m_count, m_writes, 0, nullptr);
+}
+
+} // namespace rendersystem
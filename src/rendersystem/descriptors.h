@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace rendersystem
+{
+
+/**
+ * Bindings of a descriptor set layout, sorted by binding number so the order they were listed in does not matter.
+ * Immutable samplers are not supported.
+ */
+struct DescriptorLayoutKey
+{
+    struct Binding
+    {
+        uint32_t binding;
+        VkDescriptorType type;
+        uint32_t count;
+        VkShaderStageFlags stages;
+    };
+    std::vector<Binding> bindings;
+
+    explicit DescriptorLayoutKey(const std::vector<VkDescriptorSetLayoutBinding>& layout_bindings);
+    bool operator==(const DescriptorLayoutKey& rhs) const;
+    size_t hash() const;
+};
+
+/**
+ * Create every distinct descriptor set layout once, so pipelines with the same set layout share the handle and sets
+ * allocated for one pipeline can be bound with the other. Owns the layouts until destroy().
+ */
+class DescriptorLayoutCache
+{
+  public:
+    void create(VkDevice device);
+    void destroy();
+    VkDescriptorSetLayout get(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+    size_t size() const
+    {
+        return m_layouts.size();
+    }
+
+  private:
+    struct KeyHash
+    {
+        size_t operator()(const DescriptorLayoutKey& key) const
+        {
+            return key.hash();
+        }
+    };
+    VkDevice m_device = VK_NULL_HANDLE;
+    std::unordered_map<DescriptorLayoutKey, VkDescriptorSetLayout, KeyHash> m_layouts;
+};
+
+/**
+ * Allocate descriptor sets from a growing list of pools. Sets are not freed individually; reset() returns all of
+ * them at once, e.g. at the beginning of a frame once the GPU is done with the sets of its previous use. Not thread
+ * safe, use one allocator per frame in flight.
+ */
+class DescriptorAllocator
+{
+  public:
+    // each pool has room for sets_per_pool sets with a few uniform and storage buffers each
+    void create(VkDevice device, uint32_t sets_per_pool = 64);
+    void destroy();
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    // all sets allocated so far become invalid, the pools are kept
+    void reset();
+    // pools created so far
+    size_t pool_count() const
+    {
+        return m_used_pools.size() + m_free_pools.size();
+    }
+
+  private:
+    VkDescriptorPool grab_pool();
+
+  private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    uint32_t m_sets_per_pool = 0;
+    VkDescriptorPool m_current = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> m_used_pools; // including m_current
+    std::vector<VkDescriptorPool> m_free_pools;
+};
+
+/**
+ * Collect the buffer descriptors of one set and write them with a single vkUpdateDescriptorSets call. The writes are
+ * stored inline, so sets written every frame do not allocate.
+ */
+class DescriptorWriter
+{
+  public:
+    static constexpr uint32_t kMaxWrites = 8;
+
+    DescriptorWriter& write_buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer,
+                                   VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    void update(VkDevice device, VkDescriptorSet set);
+
+  private:
+    VkDescriptorBufferInfo m_buffer_infos[kMaxWrites] = {};
+    VkWriteDescriptorSet m_writes[kMaxWrites] = {};
+    uint32_t m_count = 0;
+};
+
+} // namespace rendersystem
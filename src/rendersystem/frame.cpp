@@ -0,0 +1,75 @@
+#include "frame.h"
+#include "camerauniforms.h"
+#include "check.h"
+#include "instances.h"
+
+namespace rendersystem
+{
+
+std::vector<FrameData> create_frames(const CoreData& core_data, uint32_t frame_count, uint32_t recording_threads,
+                                     uint32_t instance_capacity)
+{
+    std::vector<FrameData> frames(frame_count);
+    for (auto& frame : frames)
+    {
+        VkCommandPoolCreateInfo cmd_pool_info = {};
+        cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        cmd_pool_info.pNext = nullptr;
+        cmd_pool_info.queueFamilyIndex = core_data.graphics_queue_family;
+        // the whole pool is reset at the beginning of the frame
+        cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        VK_CHECK_RESULT(vkCreateCommandPool(core_data.device, &cmd_pool_info, nullptr, &frame.cmd_pool));
+
+        VkCommandBufferAllocateInfo cmd_buf_info = {};
+        cmd_buf_info.pNext = nullptr;
+        cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cmd_buf_info.commandPool = frame.cmd_pool;
+        cmd_buf_info.commandBufferCount = 1;
+        cmd_buf_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(core_data.device, &cmd_buf_info, &frame.cmd_buf_main));
+
+        VkFenceCreateInfo fence_create_info = {};
+        fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        // created signalled, so waiting on a frame that never was submitted returns immediately
+        fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        VK_CHECK_RESULT(vkCreateFence(core_data.device, &fence_create_info, nullptr, &frame.fence_host));
+
+        VkSemaphoreCreateInfo semaphore_create_info = {};
+        semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        VK_CHECK_RESULT(
+            vkCreateSemaphore(core_data.device, &semaphore_create_info, nullptr, &frame.semaphore_present));
+        VK_CHECK_RESULT(vkCreateSemaphore(core_data.device, &semaphore_create_info, nullptr, &frame.semaphore_render));
+
+        frame.recording = create_recording(core_data, recording_threads);
+        frame.instances = create_host_buffer(core_data, instance_capacity * sizeof(InstanceAttributes),
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        frame.draw_commands =
+            create_host_buffer(core_data, instance_capacity * sizeof(VkDrawIndexedIndirectCommand),
+                               VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        frame.camera = create_host_buffer(core_data, sizeof(CameraUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+        frame.descriptors.create(core_data.device);
+        // frame, culling, render pass and readback
+        frame.gpu_timers = create_gpu_timers(core_data, 8);
+    }
+    return frames;
+}
+
+void destroy_frames(VkDevice device, std::vector<FrameData>* frames)
+{
+    for (auto& frame : *frames)
+    {
+        destroy_recording(device, &frame.recording);
+        destroy_host_buffer(&frame.instances);
+        destroy_host_buffer(&frame.draw_commands);
+        destroy_host_buffer(&frame.camera);
+        frame.descriptors.destroy();
+        destroy_gpu_timers(device, &frame.gpu_timers);
+        vkDestroyFence(device, frame.fence_host, nullptr);
+        vkDestroySemaphore(device, frame.semaphore_present, nullptr);
+        vkDestroySemaphore(device, frame.semaphore_render, nullptr);
+        vkDestroyCommandPool(device, frame.cmd_pool, nullptr);
+    }
+    frames->clear();
+}
+
+} // namespace rendersystem
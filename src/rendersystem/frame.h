@@ -0,0 +1,42 @@
+#pragma once
+#include "core.h"
+#include "descriptors.h"
+#include "gputimers.h"
+#include "hostbuffer.h"
+#include "recording.h"
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace rendersystem
+{
+
+/**
+ * Hold everything a single frame in flight records into or synchronizes on. The CPU may only touch a FrameData
+ * again after fence_host is signalled, so with N frames the CPU records frame i + 1 .. i + N - 1 while the GPU still
+ * works on frame i.
+ */
+struct FrameData
+{
+    VkCommandPool cmd_pool;
+    VkCommandBuffer cmd_buf_main;
+    VkSemaphore semaphore_present;   // signalled once the acquired swapchain image can be rendered to
+    VkSemaphore semaphore_render;    // signalled once rendering finished, presentation waits on it
+    VkFence fence_host;              // signalled once the GPU finished executing cmd_buf_main
+    RecordingData recording;         // secondary command buffers of this frame
+    HostBufferData instances;        // InstanceAttributes of the instances drawn in this frame
+    HostBufferData draw_commands;    // VkDrawIndexedIndirectCommand per instance batch, used by indirect drawing
+    HostBufferData camera;           // CameraUniforms of this frame, a uniform buffer
+    DescriptorAllocator descriptors; // sets of this frame, reset once the GPU finished the previous use of the frame
+    GpuTimerData gpu_timers;         // timestamps of this frame's GPU work, for the profiler
+    uint64_t submit_ns;              // profiler::now_ns() when cmd_buf_main was submitted
+};
+
+/**
+ * Create frame_count frames, each with recording_threads secondary command buffers and initial room for
+ * instance_capacity instances and as many indirect draws.
+ */
+std::vector<FrameData> create_frames(const CoreData& core_data, uint32_t frame_count, uint32_t recording_threads,
+                                     uint32_t instance_capacity);
+void destroy_frames(VkDevice device, std::vector<FrameData>* frames);
+
+} // namespace rendersystem
@@ -0,0 +1,107 @@
+#include "geometry.h"
+#include "check.h"
+#include "core.h"
+#include "mesh.h"
+#include "upload.h"
+#include <stdexcept>
+#include <vk_mem_alloc.h>
+
+namespace rendersystem
+{
+
+GeometryArena::GeometryArena()
+    : m_allocator(), m_vertex_buffers(), m_index_buffer(), m_vb_allocations(), m_ib_allocation()
+{
+}
+
+static void create_device_buffer(const CoreData& core_data, VkDeviceSize size, VkBufferUsageFlags usage,
+                                 VkBuffer* buffer, VmaAllocation* allocation)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    // filled by transfers only
+    bufferInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    // written on the transfer queue and read on the graphics queue without ownership transfers
+    const uint32_t families[] = {core_data.graphics_queue_family, core_data.transfer_queue_family};
+    if (families[0] != families[1])
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = families;
+    }
+
+    VmaAllocationCreateInfo vmaallocInfo = {};
+    vmaallocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    VK_CHECK_RESULT(vmaCreateBuffer(core_data.allocator, &bufferInfo, &vmaallocInfo, buffer, allocation, nullptr));
+}
+
+void GeometryArena::create(const CoreData& core_data, uint32_t max_vertices, uint32_t max_indices,
+                           uint32_t max_compact_vertices)
+{
+    m_allocator = core_data.allocator;
+    const uint32_t capacities[kVertexFormatCount] = {max_vertices, max_compact_vertices};
+    for (uint32_t format = 0; format < kVertexFormatCount; format++)
+    {
+        m_vertices[format] = SubAllocator(capacities[format]);
+        if (capacities[format] > 0)
+        {
+            create_device_buffer(core_data, (VkDeviceSize)capacities[format] * vertex_stride((VertexFormat)format),
+                                 VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &m_vertex_buffers[format],
+                                 &m_vb_allocations[format]);
+        }
+    }
+    m_indices = SubAllocator(max_indices);
+    create_device_buffer(core_data, (VkDeviceSize)max_indices * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                         &m_index_buffer, &m_ib_allocation);
+}
+
+void GeometryArena::destroy()
+{
+    for (uint32_t format = 0; format < kVertexFormatCount; format++)
+    {
+        if (m_vertex_buffers[format] != VK_NULL_HANDLE)
+        {
+            vmaDestroyBuffer(m_allocator, m_vertex_buffers[format], m_vb_allocations[format]);
+        }
+        m_vertex_buffers[format] = VK_NULL_HANDLE;
+        m_vertices[format] = SubAllocator();
+    }
+    vmaDestroyBuffer(m_allocator, m_index_buffer, m_ib_allocation);
+    m_indices = SubAllocator();
+}
+
+GeometryRange GeometryArena::allocate(uint32_t vertex_count, uint32_t index_count, VertexFormat format)
+{
+    SubAllocator& vertices = m_vertices[(uint32_t)format];
+    uint64_t vertex_offset = vertices.allocate(vertex_count);
+    if (vertex_offset == SubAllocator::kInvalidOffset)
+    {
+        throw std::runtime_error("geometry arena is out of vertex space");
+    }
+    uint64_t first_index = m_indices.allocate(index_count);
+    if (first_index == SubAllocator::kInvalidOffset)
+    {
+        vertices.free(vertex_offset);
+        throw std::runtime_error("geometry arena is out of index space");
+    }
+    return GeometryRange{(uint32_t)vertex_offset, vertex_count, (uint32_t)first_index, index_count, format};
+}
+
+void GeometryArena::free(const GeometryRange& range)
+{
+    m_vertices[(uint32_t)range.format].free(range.vertex_offset);
+    m_indices.free(range.first_index);
+}
+
+uint64_t GeometryArena::upload(const GeometryRange& range, const void* vertices, const uint32_t* indices,
+                              UploadManager& uploads)
+{
+    const VkDeviceSize stride = vertex_stride(range.format);
+    uploads.enqueue(m_vertex_buffers[(uint32_t)range.format], range.vertex_offset * stride, vertices,
+                    range.vertex_count * stride);
+    return uploads.enqueue(m_index_buffer, (VkDeviceSize)range.first_index * sizeof(uint32_t), indices,
+                           (VkDeviceSize)range.index_count * sizeof(uint32_t));
+}
+
+} // namespace rendersystem
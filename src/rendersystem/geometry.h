@@ -0,0 +1,80 @@
+#pragma once
+#include "suballocator.h"
+#include "vertexformat.h"
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+// forward decl
+VK_DEFINE_HANDLE(VmaAllocation)
+VK_DEFINE_HANDLE(VmaAllocator)
+
+namespace rendersystem
+{
+struct CoreData;
+class UploadManager;
+
+/**
+ * Location of one mesh within the GeometryArena buffers, in vertices and indices. The vertices are in the vertex
+ * buffer of their format.
+ */
+struct GeometryRange
+{
+    uint32_t vertex_offset;
+    uint32_t vertex_count;
+    uint32_t first_index;
+    uint32_t index_count;
+    VertexFormat format = VertexFormat::standard;
+};
+
+/**
+ * One device-local vertex buffer per VertexFormat and one index buffer shared by all meshes. Every mesh owns a range
+ * of its vertex buffer and of the index buffer, so drawing binds the buffers once per format and addresses meshes
+ * through vertexOffset and firstIndex.
+ */
+class GeometryArena
+{
+  public:
+    GeometryArena();
+    GeometryArena(const GeometryArena& rhs) = delete;
+    // max_compact_vertices of 0 creates no buffer for VertexFormat::compact
+    void create(const CoreData& core_data, uint32_t max_vertices, uint32_t max_indices,
+                uint32_t max_compact_vertices = 0);
+    void destroy();
+
+    // throws if the arena cannot hold the mesh
+    GeometryRange allocate(uint32_t vertex_count, uint32_t index_count, VertexFormat format = VertexFormat::standard);
+    void free(const GeometryRange& range);
+    /**
+     * Enqueue the copy of the data of a range to the GPU, returns the upload batch to wait for before drawing. The
+     * vertices are in the format of the range, VertexAttributes or CompactVertex.
+     */
+    uint64_t upload(const GeometryRange& range, const void* vertices, const uint32_t* indices, UploadManager& uploads);
+
+    VkBuffer vertex_buffer(VertexFormat format = VertexFormat::standard) const
+    {
+        return m_vertex_buffers[(uint32_t)format];
+    }
+    VkBuffer index_buffer() const
+    {
+        return m_index_buffer;
+    }
+    SubAllocatorStats vertex_stats(VertexFormat format = VertexFormat::standard) const
+    {
+        return m_vertices[(uint32_t)format].stats();
+    }
+    SubAllocatorStats index_stats() const
+    {
+        return m_indices.stats();
+    }
+
+  private:
+    VmaAllocator m_allocator;
+    VkBuffer m_vertex_buffers[kVertexFormatCount];
+    VkBuffer m_index_buffer;
+    VmaAllocation m_vb_allocations[kVertexFormatCount];
+    VmaAllocation m_ib_allocation;
+    SubAllocator m_vertices[kVertexFormatCount];
+    SubAllocator m_indices;
+};
+
+} // namespace rendersystem
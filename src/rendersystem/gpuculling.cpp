@@ -0,0 +1,172 @@
+#include "gpuculling.h"
+#include "check.h"
+#include "core.h"
+#include "instances.h"
+#include "mesh.h"
+#include "pipeline.h"
+#include <algorithm>
+#include <iterator>
+#include <vk_mem_alloc.h>
+
+namespace rendersystem
+{
+
+static const uint32_t kWorkgroupSize = 64; // local_size_x of cull.comp
+static const uint32_t kBindingCount = 5;
+
+static_assert(sizeof(GpuCullObject) == 32, "GpuCullObject has to match CullObject of cull.comp");
+
+struct CullPushConstants
+{
+    glm::vec4 planes[6];
+    uint32_t object_count;
+};
+
+CullPipelineData create_cull_pipeline(VkDevice device, DescriptorLayoutCache* layouts, VkPipelineCache cache)
+{
+    CullPipelineData cp = {};
+    load_shader_module(device, "rendersystem/shaders/cull.comp.spv", &cp.comp);
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(kBindingCount);
+    for (uint32_t i = 0; i < kBindingCount; i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    cp.set_layout = layouts->get(bindings);
+
+    VkPushConstantRange push_constant = {};
+    push_constant.offset = 0;
+    push_constant.size = sizeof(CullPushConstants);
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &cp.set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &cp.pipeline_layout));
+
+    VkComputePipelineCreateInfo pipeline_info = {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = cp.comp;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = cp.pipeline_layout;
+    VK_CHECK_RESULT(vkCreateComputePipelines(device, cache, 1, &pipeline_info, nullptr, &cp.pipeline));
+    return cp;
+}
+
+void destroy_cull_pipeline(VkDevice device, CullPipelineData* cp)
+{
+    vkDestroyPipeline(device, cp->pipeline, nullptr);
+    vkDestroyPipelineLayout(device, cp->pipeline_layout, nullptr);
+    vkDestroyShaderModule(device, cp->comp, nullptr);
+    *cp = {};
+}
+
+// the buffers which only the GPU reads and writes
+static void create_device_buffers(GpuCullingData* gc)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = (VkDeviceSize)gc->capacity * sizeof(InstanceAttributes);
+    // transfer source, so tests can read the compacted instances back
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    VmaAllocationCreateInfo vmaallocInfo = {};
+    vmaallocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(gc->allocator, &bufferInfo, &vmaallocInfo, &gc->instances, &gc->instances_allocation, nullptr));
+}
+
+GpuCullingData create_gpu_culling(const CoreData& core_data, uint32_t capacity)
+{
+    GpuCullingData gc = {};
+    gc.allocator = core_data.allocator;
+    gc.capacity = std::max(1u, capacity);
+    gc.objects =
+        create_host_buffer(core_data, gc.capacity * sizeof(GpuCullObject), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    gc.visibility = create_host_buffer(core_data, gc.capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    create_device_buffers(&gc);
+    return gc;
+}
+
+void destroy_gpu_culling(VkDevice device, GpuCullingData* gc)
+{
+    vmaDestroyBuffer(gc->allocator, gc->instances, gc->instances_allocation);
+    destroy_host_buffer(&gc->objects);
+    destroy_host_buffer(&gc->visibility);
+    *gc = {};
+}
+
+void reserve_gpu_culling(GpuCullingData* gc, uint32_t count)
+{
+    if (count <= gc->capacity)
+    {
+        return;
+    }
+    gc->capacity = std::max(count, gc->capacity * 2);
+    reserve_host_buffer(&gc->objects, gc->capacity * sizeof(GpuCullObject));
+    reserve_host_buffer(&gc->visibility, gc->capacity * sizeof(uint32_t));
+    vmaDestroyBuffer(gc->allocator, gc->instances, gc->instances_allocation);
+    create_device_buffers(gc);
+}
+
+void write_cull_inputs(const std::vector<InstanceBatch>& batches, GpuCullObject* objects,
+                       VkDrawIndexedIndirectCommand* commands)
+{
+    write_draw_commands(batches, commands);
+    for (uint32_t b = 0; b < batches.size(); b++)
+    {
+        const InstanceBatch& batch = batches[b];
+        commands[b].instanceCount = 0;
+        // in the space the instance model matrices transform, which includes the PositionDecode of the mesh
+        const glm::vec4 sphere = batch.mesh->vertex_bounds();
+        for (uint32_t i = batch.first_instance; i < batch.first_instance + batch.instance_count; i++)
+        {
+            objects[i].sphere = sphere;
+            objects[i].batch = b;
+        }
+    }
+}
+
+void record_gpu_culling(VkDevice device, VkCommandBuffer cmd, const CullPipelineData& cp, const GpuCullingData& gc,
+                        DescriptorAllocator* descriptors, const Frustum& frustum, const HostBufferData& instances,
+                        const HostBufferData& commands, uint32_t instance_count)
+{
+    // the buffers may have been reallocated since the last frame, so the set is written every time
+    VkDescriptorSet set = descriptors->allocate(cp.set_layout);
+    DescriptorWriter()
+        .write_buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, instances.buffer)
+        .write_buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, gc.objects.buffer)
+        .write_buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, commands.buffer)
+        .write_buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, gc.instances)
+        .write_buffer(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, gc.visibility.buffer)
+        .update(device, set);
+
+    CullPushConstants constants = {};
+    std::copy(std::begin(frustum.planes), std::end(frustum.planes), constants.planes);
+    constants.object_count = instance_count;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cp.pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cp.pipeline_layout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(cmd, cp.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &constants);
+    vkCmdDispatch(cmd, (instance_count + kWorkgroupSize - 1) / kWorkgroupSize, 1, 1);
+
+    // draws read the counts, the vertex shader the compacted models, the host may read the visibility after the fence
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+} // namespace rendersystem
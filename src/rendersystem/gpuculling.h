@@ -0,0 +1,78 @@
+#pragma once
+#include "culling.h"
+#include "descriptors.h"
+#include "hostbuffer.h"
+#include "recording.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace rendersystem
+{
+struct CoreData;
+
+/**
+ * Culling input per instance, parallel to the InstanceAttributes of the instance. Layout matches cull.comp (std430).
+ */
+struct GpuCullObject
+{
+    glm::vec4 sphere; // bounding sphere of the mesh vertices, center and radius, see Mesh::vertex_bounds
+    uint32_t batch;   // index of the instance batch and its draw command
+    uint32_t pad[3];
+};
+
+/**
+ * The compute pipeline running cull.comp, shared by all frames.
+ */
+struct CullPipelineData
+{
+    VkShaderModule comp;
+    VkDescriptorSetLayout set_layout; // owned by the DescriptorLayoutCache
+    VkPipelineLayout pipeline_layout;
+    VkPipeline pipeline;
+};
+
+CullPipelineData create_cull_pipeline(VkDevice device, DescriptorLayoutCache* layouts,
+                                      VkPipelineCache cache = VK_NULL_HANDLE);
+void destroy_cull_pipeline(VkDevice device, CullPipelineData* cp);
+
+/**
+ * Buffers of one frame in flight for culling on the GPU. The compute shader reads the models of all instances and
+ * the GpuCullObject of each, and writes the models of the visible instances into the device-local instances buffer,
+ * compacted per draw command.
+ */
+struct GpuCullingData
+{
+    VmaAllocator allocator;
+    HostBufferData objects;    // GpuCullObject per instance
+    HostBufferData visibility; // uint32_t per instance, 1 if visible. For debugging and tests
+    VkBuffer instances;        // InstanceAttributes of the visible instances, the storage buffer to draw with
+    VmaAllocation instances_allocation;
+    uint32_t capacity; // in instances
+};
+
+GpuCullingData create_gpu_culling(const CoreData& core_data, uint32_t capacity);
+void destroy_gpu_culling(VkDevice device, GpuCullingData* gc);
+// make room for at least count instances, the GPU must not be using the buffers
+void reserve_gpu_culling(GpuCullingData* gc, uint32_t count);
+
+/**
+ * Write the GpuCullObject of every instance of batches, and one draw command per batch with an instance count of 0
+ * which the compute shader increments per visible instance. Culled batches remain as empty draws, so the CPU knows the
+ * draw count and no count buffer is needed.
+ */
+void write_cull_inputs(const std::vector<InstanceBatch>& batches, GpuCullObject* objects,
+                       VkDrawIndexedIndirectCommand* commands);
+
+/**
+ * Record the culling of instance_count instances into cmd, outside of a render pass, followed by the barrier which
+ * makes the commands and the compacted instances available to indirect drawing. instances holds the models of all
+ * instances in batch order and commands what write_cull_inputs wrote; both need VK_BUFFER_USAGE_STORAGE_BUFFER_BIT.
+ * The descriptor set is allocated from descriptors, which must not be reset before cmd has completed.
+ */
+void record_gpu_culling(VkDevice device, VkCommandBuffer cmd, const CullPipelineData& cp, const GpuCullingData& gc,
+                        DescriptorAllocator* descriptors, const Frustum& frustum, const HostBufferData& instances,
+                        const HostBufferData& commands, uint32_t instance_count);
+
+} // namespace rendersystem
@@ -0,0 +1,100 @@
+#include "gputimers.h"
+#include "check.h"
+#include "core.h"
+#include <algorithm>
+
+namespace rendersystem
+{
+
+GpuTimerData create_gpu_timers(const CoreData& core_data, uint32_t capacity)
+{
+    GpuTimerData gt = {};
+    if (core_data.timestamp_valid_bits == 0 || capacity == 0)
+    {
+        return gt;
+    }
+    gt.capacity = capacity;
+    gt.period = core_data.timestamp_period;
+    gt.valid_mask = core_data.timestamp_valid_bits >= 64 ? ~0ull : (1ull << core_data.timestamp_valid_bits) - 1;
+    gt.names.reserve(capacity);
+    gt.ticks.resize(capacity * 2);
+
+    VkQueryPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = capacity * 2;
+    VK_CHECK_RESULT(vkCreateQueryPool(core_data.device, &pool_info, nullptr, &gt.pool));
+    return gt;
+}
+
+void destroy_gpu_timers(VkDevice device, GpuTimerData* gt)
+{
+    if (gt->pool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(device, gt->pool, nullptr);
+    }
+    *gt = {};
+}
+
+void reset_gpu_timers(VkCommandBuffer cmd, GpuTimerData* gt)
+{
+    if (gt->pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(cmd, gt->pool, 0, gt->capacity * 2);
+    }
+    gt->names.clear();
+}
+
+uint32_t begin_gpu_timer(VkCommandBuffer cmd, GpuTimerData* gt, const char* name)
+{
+    if (gt->pool == VK_NULL_HANDLE || gt->names.size() == gt->capacity)
+    {
+        return UINT32_MAX;
+    }
+    const uint32_t scope = (uint32_t)gt->names.size();
+    gt->names.push_back(name);
+    // when all previous commands reached the top of the pipe
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, gt->pool, scope * 2);
+    return scope;
+}
+
+void end_gpu_timer(VkCommandBuffer cmd, const GpuTimerData& gt, uint32_t scope)
+{
+    if (scope != UINT32_MAX)
+    {
+        // when all previous commands completed
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, gt.pool, scope * 2 + 1);
+    }
+}
+
+void read_gpu_timers(VkDevice device, GpuTimerData* gt, std::vector<GpuTimerResult>* results)
+{
+    results->clear();
+    if (gt->names.empty())
+    {
+        return;
+    }
+    const uint32_t query_count = (uint32_t)gt->names.size() * 2;
+    uint64_t* ticks = gt->ticks.data();
+    VK_CHECK_RESULT(vkGetQueryPoolResults(device, gt->pool, 0, query_count, query_count * sizeof(uint64_t), ticks,
+                                          sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+    uint64_t origin = UINT64_MAX;
+    for (uint32_t i = 0; i < query_count; i++)
+    {
+        ticks[i] &= gt->valid_mask;
+    }
+    for (uint32_t i = 0; i < query_count; i += 2)
+    {
+        origin = std::min(origin, ticks[i]);
+    }
+    for (size_t i = 0; i < gt->names.size(); i++)
+    {
+        // a wrapped counter or a scope which ended before it began on some drivers, clamp instead of underflowing
+        const uint64_t begin = std::max(ticks[i * 2], origin) - origin;
+        const uint64_t end = std::max(ticks[i * 2 + 1], origin + begin) - origin;
+        results->push_back(GpuTimerResult{gt->names[i], (uint64_t)(begin * (double)gt->period),
+                                          (uint64_t)(end * (double)gt->period)});
+    }
+}
+
+} // namespace rendersystem
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace rendersystem
+{
+struct CoreData;
+
+/**
+ * Timestamp queries around the GPU work of one frame in flight, each scope a pair of queries. Written into the main
+ * command buffer, outside of render passes, and read once the frame's fence is signalled.
+ */
+struct GpuTimerData
+{
+    VkQueryPool pool;               // VK_NULL_HANDLE if the graphics queue cannot write timestamps
+    uint32_t capacity;              // scopes
+    float period;                   // nanoseconds per tick
+    uint64_t valid_mask;            // of the timestamp bits
+    std::vector<const char*> names; // of the scopes written since the last reset
+    std::vector<uint64_t> ticks;    // read_gpu_timers scratch, two per scope, so reading does not allocate
+};
+
+/**
+ * A scope in nanoseconds, relative to the beginning of the first scope of the frame.
+ */
+struct GpuTimerResult
+{
+    const char* name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+};
+
+GpuTimerData create_gpu_timers(const CoreData& core_data, uint32_t capacity);
+void destroy_gpu_timers(VkDevice device, GpuTimerData* gt);
+// forget the scopes of the previous use, first thing in the frame's command buffer
+void reset_gpu_timers(VkCommandBuffer cmd, GpuTimerData* gt);
+// the index of the scope for end_gpu_timer, UINT32_MAX if there are no timestamps or no room. name must outlive the
+// results, usually it is a string literal
+uint32_t begin_gpu_timer(VkCommandBuffer cmd, GpuTimerData* gt, const char* name);
+void end_gpu_timer(VkCommandBuffer cmd, const GpuTimerData& gt, uint32_t scope);
+// the scopes written since the last reset, once the GPU finished them
+void read_gpu_timers(VkDevice device, GpuTimerData* gt, std::vector<GpuTimerResult>* results);
+
+} // namespace rendersystem
@@ -0,0 +1,79 @@
+#include "hostbuffer.h"
+#include "check.h"
+#include "core.h"
+#include <algorithm>
+#include <vk_mem_alloc.h>
+
+namespace rendersystem
+{
+
+static HostBufferData create_buffer(const CoreData& core_data, VkDeviceSize size, VkBufferUsageFlags usage,
+                                    bool readback)
+{
+    HostBufferData hb = {};
+    hb.allocator = core_data.allocator;
+    hb.usage = usage;
+    hb.readback = readback;
+    hb.size = std::max<VkDeviceSize>(1, size);
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = hb.size;
+    bufferInfo.usage = usage;
+
+    VmaAllocationCreateInfo vmaallocInfo = {};
+    vmaallocInfo.usage = readback ? VMA_MEMORY_USAGE_GPU_TO_CPU : VMA_MEMORY_USAGE_CPU_TO_GPU;
+    vmaallocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VmaAllocationInfo allocation_info = {};
+    VK_CHECK_RESULT(
+        vmaCreateBuffer(hb.allocator, &bufferInfo, &vmaallocInfo, &hb.buffer, &hb.allocation, &allocation_info));
+    hb.data = allocation_info.pMappedData;
+    return hb;
+}
+
+HostBufferData create_host_buffer(const CoreData& core_data, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    return create_buffer(core_data, size, usage, false);
+}
+
+HostBufferData create_readback_buffer(const CoreData& core_data, VkDeviceSize size)
+{
+    return create_buffer(core_data, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true);
+}
+
+void destroy_host_buffer(HostBufferData* hb)
+{
+    if (hb->buffer != VK_NULL_HANDLE)
+    {
+        vmaDestroyBuffer(hb->allocator, hb->buffer, hb->allocation);
+    }
+    *hb = {};
+}
+
+void reserve_host_buffer(HostBufferData* hb, VkDeviceSize size)
+{
+    if (size <= hb->size)
+    {
+        return;
+    }
+    CoreData core_data = {};
+    core_data.allocator = hb->allocator;
+    const VkBufferUsageFlags usage = hb->usage;
+    const bool readback = hb->readback;
+    // grow geometrically, so a slowly growing scene does not reallocate every frame
+    const VkDeviceSize new_size = std::max(size, hb->size * 2);
+    destroy_host_buffer(hb);
+    *hb = create_buffer(core_data, new_size, usage, readback);
+}
+
+void flush_host_buffer(const HostBufferData& hb, VkDeviceSize size)
+{
+    VK_CHECK_RESULT(vmaFlushAllocation(hb.allocator, hb.allocation, 0, size));
+}
+
+void invalidate_host_buffer(const HostBufferData& hb, VkDeviceSize size)
+{
+    VK_CHECK_RESULT(vmaInvalidateAllocation(hb.allocator, hb.allocation, 0, size));
+}
+
+} // namespace rendersystem
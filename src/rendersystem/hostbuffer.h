@@ -0,0 +1,38 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+
+// forward decl
+VK_DEFINE_HANDLE(VmaAllocation)
+VK_DEFINE_HANDLE(VmaAllocator)
+
+namespace rendersystem
+{
+struct CoreData;
+
+/**
+ * Persistently mapped, host-visible buffer which the CPU fills every frame and the GPU reads once, e.g. instance
+ * attributes or indirect draw commands. Not worth a copy to device-local memory.
+ */
+struct HostBufferData
+{
+    VmaAllocator allocator;
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    VkBufferUsageFlags usage;
+    bool readback; // written by the GPU and read by the CPU, in host cached memory
+    void* data;
+    VkDeviceSize size;
+};
+
+HostBufferData create_host_buffer(const CoreData& core_data, VkDeviceSize size, VkBufferUsageFlags usage);
+// a host buffer the GPU copies results into, e.g. rendered images. Reading write-combined memory would be slow
+HostBufferData create_readback_buffer(const CoreData& core_data, VkDeviceSize size);
+void destroy_host_buffer(HostBufferData* hb);
+// make room for at least size bytes, the content is lost and the GPU must not be using the buffer
+void reserve_host_buffer(HostBufferData* hb, VkDeviceSize size);
+// make the first size bytes visible to the GPU, the memory is not necessarily host coherent
+void flush_host_buffer(const HostBufferData& hb, VkDeviceSize size);
+// make the first size bytes written by the GPU visible to the CPU, after waiting for the GPU
+void invalidate_host_buffer(const HostBufferData& hb, VkDeviceSize size);
+
+} // namespace rendersystem
@@ -0,0 +1,230 @@
+#include "instances.h"
+#include "components/coordsys.h"
+#include "mesh.h"
+#include <iterator>
+#if defined(__x86_64__) || defined(__SSE2__)
+#include <immintrin.h>
+#define INSTANCES_X86
+#endif
+
+namespace rendersystem
+{
+
+void ModelTransforms::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_qx.clear();
+    m_qy.clear();
+    m_qz.clear();
+    m_qw.clear();
+    m_s.clear();
+}
+
+void ModelTransforms::push_back(const glm::vec3& position, const glm::quat& rotation, float scale)
+{
+    m_x.push_back(position.x);
+    m_y.push_back(position.y);
+    m_z.push_back(position.z);
+    m_qx.push_back(rotation.x);
+    m_qy.push_back(rotation.y);
+    m_qz.push_back(rotation.z);
+    m_qw.push_back(rotation.w);
+    m_s.push_back(scale);
+}
+
+// the transforms [begin, end) one at a time
+static void write_models_range(const float* const soa[8], size_t begin, size_t end, const uint32_t* instance_indices,
+                               InstanceAttributes* instances)
+{
+    const float *x = soa[0], *y = soa[1], *z = soa[2], *qx = soa[3], *qy = soa[4], *qz = soa[5], *qw = soa[6];
+    const float* s = soa[7];
+    for (size_t i = begin; i < end; i++)
+    {
+        // same operations as glm::mat4_cast, so the results equal CoordSys::transform()
+        const float xx = qx[i] * qx[i], yy = qy[i] * qy[i], zz = qz[i] * qz[i];
+        const float xz = qx[i] * qz[i], xy = qx[i] * qy[i], yz = qy[i] * qz[i];
+        const float wx = qw[i] * qx[i], wy = qw[i] * qy[i], wz = qw[i] * qz[i];
+        glm::mat4& m = instances[instance_indices != nullptr ? instance_indices[i] : i].model;
+        m[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * s[i];
+        m[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * s[i];
+        m[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * s[i];
+        m[3] = glm::vec4(x[i], y[i], z[i], 1.0f);
+    }
+}
+
+#ifdef INSTANCES_X86
+static void write_models_sse(const float* const soa[8], size_t n, const uint32_t* instance_indices,
+                             InstanceAttributes* instances)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128 qx = _mm_loadu_ps(soa[3] + i);
+        const __m128 qy = _mm_loadu_ps(soa[4] + i);
+        const __m128 qz = _mm_loadu_ps(soa[5] + i);
+        const __m128 qw = _mm_loadu_ps(soa[6] + i);
+        const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        const __m128 xz = _mm_mul_ps(qx, qz), xy = _mm_mul_ps(qx, qy), yz = _mm_mul_ps(qy, qz);
+        const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+        const __m128 s = _mm_loadu_ps(soa[7] + i);
+
+        // m[column][row] holds one matrix element of 4 transforms
+        __m128 m[4][4];
+        m[0][0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+        m[0][1] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+        m[0][2] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+        m[0][3] = zero;
+        m[1][0] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+        m[1][1] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+        m[1][2] = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+        m[1][3] = zero;
+        m[2][0] = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+        m[2][1] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+        m[2][2] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+        m[2][3] = zero;
+        m[3][0] = _mm_loadu_ps(soa[0] + i);
+        m[3][1] = _mm_loadu_ps(soa[1] + i);
+        m[3][2] = _mm_loadu_ps(soa[2] + i);
+        m[3][3] = one;
+        for (int c = 0; c < 3; c++)
+        {
+            for (int r = 0; r < 3; r++)
+            {
+                m[c][r] = _mm_mul_ps(m[c][r], s);
+            }
+        }
+        // afterwards m[column][k] holds the column of transform i + k
+        for (int c = 0; c < 4; c++)
+        {
+            _MM_TRANSPOSE4_PS(m[c][0], m[c][1], m[c][2], m[c][3]);
+        }
+        // every matrix is written as a whole, which suits write-combined instance buffers
+        for (int k = 0; k < 4; k++)
+        {
+            float* out = &instances[instance_indices != nullptr ? instance_indices[i + k] : i + k].model[0][0];
+            _mm_storeu_ps(out, m[0][k]);
+            _mm_storeu_ps(out + 4, m[1][k]);
+            _mm_storeu_ps(out + 8, m[2][k]);
+            _mm_storeu_ps(out + 12, m[3][k]);
+        }
+    }
+    write_models_range(soa, i, n, instance_indices, instances);
+}
+#endif
+
+void ModelTransforms::write_models(const uint32_t* instance_indices, InstanceAttributes* instances) const
+{
+    const float* const soa[8] = {m_x.data(),  m_y.data(),  m_z.data(),  m_qx.data(),
+                                 m_qy.data(), m_qz.data(), m_qw.data(), m_s.data()};
+#ifdef INSTANCES_X86
+    // SSE2 is part of x86-64 and enabled at compile time otherwise, no runtime check needed
+    write_models_sse(soa, size(), instance_indices, instances);
+#else
+    write_models_range(soa, 0, size(), instance_indices, instances);
+#endif
+}
+
+void ModelTransforms::write_models_scalar(const uint32_t* instance_indices, InstanceAttributes* instances) const
+{
+    const float* const soa[8] = {m_x.data(),  m_y.data(),  m_z.data(),  m_qx.data(),
+                                 m_qy.data(), m_qz.data(), m_qw.data(), m_s.data()};
+    write_models_range(soa, 0, size(), instance_indices, instances);
+}
+
+void push_model_transform(ModelTransforms* transforms, const DrawItem& item)
+{
+    if (item.mesh->format() == VertexFormat::standard)
+    {
+        transforms->push_back(item.coord->position(), item.coord->rotation());
+        return;
+    }
+    // coord * translate(offset) * scale(scale), so the vertex shader reads the quantized positions as they are
+    const PositionDecode& decode = item.mesh->position_decode();
+    transforms->push_back(item.coord->position() + item.coord->rotation() * decode.offset, item.coord->rotation(),
+                          decode.scale);
+}
+
+const std::vector<InstanceBatch>& InstanceBatcher::build(const std::vector<DrawItem>& items)
+{
+    m_build++;
+    m_batches.clear();
+    m_instance_indices.resize(items.size());
+
+    // count the instances per mesh, the batch of every item is kept in m_instance_indices for now
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        BatchSlot& slot = m_batch_index[items[i].mesh];
+        if (slot.build != m_build)
+        {
+            slot = BatchSlot{(uint32_t)m_batches.size(), m_build};
+            m_batches.push_back(InstanceBatch{items[i].mesh, 0, 0});
+        }
+        m_batches[slot.batch].instance_count++;
+        m_instance_indices[i] = slot.batch;
+    }
+    // drop the meshes no longer drawn once they outnumber the drawn ones, a destroyed mesh's address may be reused
+    // but its entry is from an earlier build
+    if (m_batch_index.size() > 2 * m_batches.size() + 64)
+    {
+        for (auto it = m_batch_index.begin(); it != m_batch_index.end();)
+        {
+            it = it->second.build != m_build ? m_batch_index.erase(it) : std::next(it);
+        }
+    }
+    // the meshes of one format are drawn with one pipeline, so the compact ones go last
+    m_compact_batch_count = 0;
+    for (const InstanceBatch& batch : m_batches)
+    {
+        m_compact_batch_count += batch.mesh->format() == VertexFormat::compact ? 1 : 0;
+    }
+    if (m_compact_batch_count > 0 && m_compact_batch_count < m_batches.size())
+    {
+        // m_cursors maps the batch indices in m_instance_indices to the new ones for now
+        m_cursors.resize(m_batches.size());
+        m_reordered.resize(m_batches.size());
+        uint32_t next[kVertexFormatCount] = {0, (uint32_t)m_batches.size() - m_compact_batch_count};
+        for (size_t b = 0; b < m_batches.size(); b++)
+        {
+            m_cursors[b] = next[m_batches[b].mesh->format() == VertexFormat::compact ? 1 : 0]++;
+            m_reordered[m_cursors[b]] = m_batches[b];
+        }
+        m_batches.swap(m_reordered);
+        for (uint32_t& index : m_instance_indices)
+        {
+            index = m_cursors[index];
+        }
+    }
+    m_cursors.resize(m_batches.size());
+    uint32_t first_instance = 0;
+    for (size_t b = 0; b < m_batches.size(); b++)
+    {
+        m_batches[b].first_instance = first_instance;
+        m_cursors[b] = first_instance;
+        first_instance += m_batches[b].instance_count;
+    }
+    for (uint32_t& index : m_instance_indices)
+    {
+        index = m_cursors[index]++;
+    }
+    return m_batches;
+}
+
+const std::vector<InstanceBatch>& InstanceBatcher::build(const std::vector<DrawItem>& items,
+                                                         InstanceAttributes* instances)
+{
+    build(items);
+    m_transforms.clear();
+    for (const DrawItem& item : items)
+    {
+        push_model_transform(&m_transforms, item);
+    }
+    m_transforms.write_models(m_instance_indices.data(), instances);
+    return m_batches;
+}
+
+} // namespace rendersystem
@@ -0,0 +1,103 @@
+#pragma once
+#include "recording.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace rendersystem
+{
+
+/**
+ * Per-instance data, read by mesh.vert from a storage buffer at gl_InstanceIndex. Layout matches std430.
+ */
+struct InstanceAttributes
+{
+    glm::mat4 model;
+};
+
+/**
+ * Positions, rotations and uniform scales of transforms in struct-of-arrays layout, so their model matrices are
+ * computed for 4 transforms per instruction (SSE) in one pass, instead of one CoordSys::transform() call per draw.
+ */
+class ModelTransforms
+{
+  public:
+    void clear();
+    // the scale applies before the rotation, e.g. the PositionDecode of a mesh in VertexFormat::compact
+    void push_back(const glm::vec3& position, const glm::quat& rotation, float scale = 1.0f);
+    size_t size() const
+    {
+        return m_x.size();
+    }
+    /**
+     * Write the model matrix of transform i, equal to CoordSys::transform() for a scale of 1, to
+     * instances[instance_indices[i]], or to instances[i] if instance_indices is null.
+     */
+    void write_models(const uint32_t* instance_indices, InstanceAttributes* instances) const;
+    // reference for write_models(), computing one transform at a time
+    void write_models_scalar(const uint32_t* instance_indices, InstanceAttributes* instances) const;
+
+  private:
+    std::vector<float> m_x; // position
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_qx; // rotation
+    std::vector<float> m_qy;
+    std::vector<float> m_qz;
+    std::vector<float> m_qw;
+    std::vector<float> m_s; // scale
+};
+
+// add the model transform of item, which includes the PositionDecode of its mesh
+void push_model_transform(ModelTransforms* transforms, const DrawItem& item);
+
+/**
+ * Group draw items by mesh, so each group is drawn with one instanced draw call. Items are drawn with the pipeline of
+ * the vertex format of their mesh, and the batches of each format are contiguous, so recording binds every pipeline
+ * once.
+ */
+class InstanceBatcher
+{
+  public:
+    /**
+     * Group items by mesh and return one batch per mesh. Batches are ordered by the vertex format of their mesh, then
+     * by the first item using their mesh; items keep their order within a batch. instance_indices() tells the
+     * instance of every item.
+     */
+    const std::vector<InstanceBatch>& build(const std::vector<DrawItem>& items);
+    /**
+     * Like build(items), and write the model matrices of items, including the PositionDecode of their mesh, into
+     * instances, which needs room for items.size() elements.
+     */
+    const std::vector<InstanceBatch>& build(const std::vector<DrawItem>& items, InstanceAttributes* instances);
+    // instance index per item of the last build, for ModelTransforms::write_models
+    const std::vector<uint32_t>& instance_indices() const
+    {
+        return m_instance_indices;
+    }
+    // batches of the last build with meshes in VertexFormat::compact, they are the last ones
+    uint32_t compact_batch_count() const
+    {
+        return m_compact_batch_count;
+    }
+
+  private:
+    struct BatchSlot
+    {
+        uint32_t batch; // index into m_batches
+        uint64_t build; // the build the batch index belongs to, entries of earlier builds are reused
+    };
+    // kept across builds, so meshes drawn every frame are not inserted again
+    std::unordered_map<const Mesh*, BatchSlot> m_batch_index;
+    uint64_t m_build = 0;
+    std::vector<InstanceBatch> m_batches;
+    std::vector<uint32_t> m_instance_indices;
+    std::vector<uint32_t> m_cursors; // next instance to assign per batch
+    std::vector<InstanceBatch> m_reordered;
+    uint32_t m_compact_batch_count = 0;
+    ModelTransforms m_transforms;
+};
+
+} // namespace rendersystem
@@ -1,66 +1,45 @@
 #include "mesh.h"
 #include "check.h"
-#include <cstring>
-#include <vk_mem_alloc.h>
+#include <cassert>
+#include <stdexcept>
 
 namespace rendersystem
 {
 
-void Mesh::create(VmaAllocator vma_allocator)
+void Mesh::create(GeometryArena& arena, UploadManager& uploads, VertexFormat format)
 {
-    assert(m_vertex_buffer == nullptr);
-    assert(m_index_buffer == nullptr);
-    if (m_vertex_attributes.empty())
+    create(arena, uploads, m_vertex_attributes.data(), (uint32_t)m_vertex_attributes.size(), m_indices.data(),
+           (uint32_t)m_indices.size(), format);
+}
+
+void Mesh::create(GeometryArena& arena, UploadManager& uploads, const VertexAttributes* vertices, uint32_t vertex_count,
+                  const uint32_t* indices, uint32_t index_count, VertexFormat format)
+{
+    assert(m_range.index_count == 0);
+    if (vertex_count == 0)
     {
         throw std::runtime_error("cannot upload an empty mesh");
     }
+    m_range = arena.allocate(vertex_count, index_count, format);
+    if (format == VertexFormat::compact)
     {
-        VkBufferCreateInfo bufferInfo = {};
-        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        // this is the total size, in bytes, of the buffer we are allocating
-        bufferInfo.size = m_vertex_attributes.size() * sizeof(VertexAttributes);
-        // this buffer is going to be used as a Vertex Buffer
-        bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-
-        // let the VMA library know that this data should be writeable by CPU, but also readable by GPU
-        VmaAllocationCreateInfo vmaallocInfo = {};
-        vmaallocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-
-        // allocate the vertex buffer
-        VK_CHECK_RESULT(
-            vmaCreateBuffer(vma_allocator, &bufferInfo, &vmaallocInfo, &m_vertex_buffer, &m_vb_allocation, nullptr));
-        void* data;
-        VK_CHECK_RESULT(vmaMapMemory(vma_allocator, m_vb_allocation, &data));
-        memcpy(data, m_vertex_attributes.data(), m_vertex_attributes.size() * sizeof(VertexAttributes));
-        vmaUnmapMemory(vma_allocator, m_vb_allocation);
+        // the upload copies the data into the staging ring, so the encoded vertices are temporary
+        m_decode = rendersystem::position_decode(vertices, vertex_count);
+        std::vector<CompactVertex> compact(vertex_count);
+        encode_compact(vertices, vertex_count, m_decode, compact.data());
+        m_upload_batch = arena.upload(m_range, compact.data(), indices, uploads);
     }
-
+    else
     {
-        VkBufferCreateInfo bufferInfo = {};
-        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        // this is the total size, in bytes, of the buffer we are allocating
-        bufferInfo.size = m_indices.size() * sizeof(uint32_t);
-        // this buffer is going to be used as a Vertex Buffer
-        bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-        // let the VMA library know that this data should be writeable by CPU, but also readable by GPU
-        VmaAllocationCreateInfo vmaallocInfo = {};
-        vmaallocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-
-        // allocate the vertex buffer
-        VK_CHECK_RESULT(
-            vmaCreateBuffer(vma_allocator, &bufferInfo, &vmaallocInfo, &m_index_buffer, &m_ib_allocation, nullptr));
-        void* data;
-        VK_CHECK_RESULT(vmaMapMemory(vma_allocator, m_ib_allocation, &data));
-        memcpy(data, m_indices.data(), m_indices.size() * sizeof(uint32_t));
-        vmaUnmapMemory(vma_allocator, m_ib_allocation);
+        m_decode = PositionDecode();
+        m_upload_batch = arena.upload(m_range, vertices, indices, uploads);
     }
 }
 
-void Mesh::destroy(VmaAllocator vma_allocator)
+void Mesh::destroy(GeometryArena& arena)
 {
-    vmaDestroyBuffer(vma_allocator, m_vertex_buffer, m_vb_allocation);
-    vmaDestroyBuffer(vma_allocator, m_index_buffer, m_ib_allocation);
+    arena.free(m_range);
+    m_range = GeometryRange();
 }
 
 static VertexInputDescriptionData get_input_desc()
@@ -99,14 +78,49 @@ static VertexInputDescriptionData get_input_desc()
     uv_attribute.format = VK_FORMAT_R32G32_SFLOAT;
     uv_attribute.offset = offsetof(VertexAttributes, uv);
 
-    return VertexInputDescriptionData{.bindings{main_binding},
-                                      .attributes{position_attribute, normal_attribute, color_attribute, uv_attribute},
-                                      .flags{}};
+    // the model matrix of each instance is read from a storage buffer, see write_mesh_set
+    VertexInputDescriptionData description{.bindings{main_binding},
+                                           .attributes{position_attribute, normal_attribute, color_attribute,
+                                                       uv_attribute},
+                                           .flags{}};
+    return description;
 }
-VertexInputDescriptionData& Mesh::get_vertex_input_description()
+
+// the locations of get_input_desc() with the formats of CompactVertex, decoded by mesh_compact.vert
+static VertexInputDescriptionData get_compact_input_desc()
 {
-    static VertexInputDescriptionData description = get_input_desc();
+    VertexInputDescriptionData description = get_input_desc();
+    description.bindings[0].stride = sizeof(CompactVertex);
+    for (VkVertexInputAttributeDescription& attribute : description.attributes)
+    {
+        switch (attribute.location)
+        {
+        case 0:
+            attribute.format = VK_FORMAT_R16G16B16A16_UNORM;
+            attribute.offset = offsetof(CompactVertex, position);
+            break;
+        case 1:
+            attribute.format = VK_FORMAT_R16G16_SNORM;
+            attribute.offset = offsetof(CompactVertex, normal);
+            break;
+        case 2:
+            attribute.format = VK_FORMAT_R8G8B8A8_UNORM;
+            attribute.offset = offsetof(CompactVertex, color);
+            break;
+        default:
+            attribute.format = VK_FORMAT_R16G16_SFLOAT;
+            attribute.offset = offsetof(CompactVertex, uv);
+            break;
+        }
+    }
     return description;
 }
 
+VertexInputDescriptionData& Mesh::get_vertex_input_description(VertexFormat format)
+{
+    static VertexInputDescriptionData description = get_input_desc();
+    static VertexInputDescriptionData compact_description = get_compact_input_desc();
+    return format == VertexFormat::compact ? compact_description : description;
+}
+
 } // namespace rendersystem
\ No newline at end of file
@@ -1,13 +1,11 @@
 #pragma once
 
+#include "geometry.h"
+#include "vertexformat.h"
 #include <glm/glm.hpp>
 #include <vector>
 #include <vulkan/vulkan.h>
 
-// forward decl
-VK_DEFINE_HANDLE(VmaAllocation)
-VK_DEFINE_HANDLE(VmaAllocator)
-
 namespace tinygltf
 {
 class Model;
@@ -16,14 +14,6 @@ class Model;
 namespace rendersystem
 {
 
-struct VertexAttributes
-{
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 uv;
-    glm::vec3 color;
-};
-
 struct VertexInputDescriptionData
 {
     std::vector<VkVertexInputBindingDescription> bindings;
@@ -32,12 +22,13 @@ struct VertexInputDescriptionData
 };
 
 /**
- * Mesh structure suitable to draw via the command buffer
+ * Mesh structure suitable to draw via the command buffer. The GPU copy of the vertices and indices lives in a range
+ * of the GeometryArena, the vertices in the format given to create().
  */
 class Mesh
 {
   public:
-    Mesh() : m_vertex_attributes(), m_vertex_buffer(), m_index_buffer(), m_vb_allocation(), m_ib_allocation()
+    Mesh() : m_vertex_attributes(), m_indices(), m_range(), m_upload_batch(0), m_bounds(0.0f), m_decode()
     {
     }
     Mesh(const Mesh& rhs) = delete;
@@ -58,26 +49,53 @@ class Mesh
     {
         return m_indices;
     }
-    VkBuffer& vb()
+    const GeometryRange& range() const
+    {
+        return m_range;
+    }
+    // upload batch which has to be complete before the mesh can be drawn
+    uint64_t upload_batch() const
+    {
+        return m_upload_batch;
+    }
+    VertexFormat format() const
+    {
+        return m_range.format;
+    }
+    // maps the vertex positions to model space, the identity unless the format is VertexFormat::compact
+    const PositionDecode& position_decode() const
+    {
+        return m_decode;
+    }
+    // model-space bounding sphere as center and radius
+    const glm::vec4& bounds() const
+    {
+        return m_bounds;
+    }
+    void set_bounds(const glm::vec4& bounds)
     {
-        return m_vertex_buffer;
+        m_bounds = bounds;
     }
-    VkBuffer& ib()
+    // bounds() in the space of the vertices before position_decode(), for culling on the GPU
+    glm::vec4 vertex_bounds() const
     {
-        return m_index_buffer;
+        return glm::vec4((glm::vec3(m_bounds) - m_decode.offset) / m_decode.scale, m_bounds.w / m_decode.scale);
     }
-    void create(VmaAllocator vma_allocator);
-    void destroy(VmaAllocator vma_allocator);
+    void create(GeometryArena& arena, UploadManager& uploads, VertexFormat format = VertexFormat::standard);
+    // upload the given data instead of vertices() and indices(), the mesh keeps no CPU copy
+    void create(GeometryArena& arena, UploadManager& uploads, const VertexAttributes* vertices, uint32_t vertex_count,
+                const uint32_t* indices, uint32_t index_count, VertexFormat format = VertexFormat::standard);
+    void destroy(GeometryArena& arena);
 
   public:
-    static VertexInputDescriptionData& get_vertex_input_description();
+    static VertexInputDescriptionData& get_vertex_input_description(VertexFormat format = VertexFormat::standard);
 
   private:
     std::vector<VertexAttributes> m_vertex_attributes;
     std::vector<uint32_t> m_indices;
-    VkBuffer m_vertex_buffer;
-    VkBuffer m_index_buffer;
-    VmaAllocation m_vb_allocation;
-    VmaAllocation m_ib_allocation;
+    GeometryRange m_range;
+    uint64_t m_upload_batch;
+    glm::vec4 m_bounds;
+    PositionDecode m_decode;
 };
 } // namespace rendersystem
\ No newline at end of file
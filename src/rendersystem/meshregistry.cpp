@@ -0,0 +1,128 @@
+#include "meshregistry.h"
+
+namespace rendersystem
+{
+
+MeshRegistry::MeshRegistry(CreateFn create, DestroyFn destroy, uint32_t retire_frames)
+    : m_create(std::move(create)), m_destroy(std::move(destroy)), m_retire_frames(retire_frames), m_frame(0)
+{
+}
+
+MeshRegistry::~MeshRegistry()
+{
+    clear();
+}
+
+void MeshRegistry::begin_frame()
+{
+    m_frame++;
+    for (auto& entry : m_meshes)
+    {
+        entry.second.references = 0;
+    }
+    m_stats.references = 0;
+}
+
+MeshRegistry::MeshEntry* MeshRegistry::find(uint64_t content_hash, const Mesh* mesh)
+{
+    auto range = m_meshes.equal_range(content_hash);
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (it->second.mesh.get() == mesh)
+        {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+const MeshRegistry::MeshEntry* MeshRegistry::find(uint64_t content_hash, const Mesh* mesh) const
+{
+    return const_cast<MeshRegistry*>(this)->find(content_hash, mesh);
+}
+
+Mesh* MeshRegistry::acquire(const components::Visual3d& viz)
+{
+    MeshEntry* entry = nullptr;
+    auto geometry = m_geometries.find(viz.geometry_id());
+    if (geometry != m_geometries.end())
+    {
+        entry = find(geometry->second.content_hash, geometry->second.mesh);
+    }
+    else
+    {
+        // a new geometry id, shares the mesh of equal content if there is one
+        const uint64_t content_hash = viz.content_hash();
+        auto range = m_meshes.equal_range(content_hash);
+        for (auto it = range.first; it != range.second && entry == nullptr; it++)
+        {
+            entry = it->second.visual.same_content(viz) ? &it->second : nullptr;
+        }
+        if (entry == nullptr)
+        {
+            entry = &m_meshes.emplace(content_hash, MeshEntry{m_create(viz), viz, 0, m_frame})->second;
+            m_stats.created++;
+        }
+        else
+        {
+            m_stats.shared++;
+        }
+        geometry = m_geometries.emplace(viz.geometry_id(), GeometryEntry{content_hash, entry->mesh.get(), 0}).first;
+    }
+    geometry->second.last_used = m_frame;
+    entry->references++;
+    entry->last_used = m_frame;
+    m_stats.references++;
+    return entry->mesh.get();
+}
+
+void MeshRegistry::collect()
+{
+    for (auto it = m_meshes.begin(); it != m_meshes.end();)
+    {
+        if (m_frame - it->second.last_used > m_retire_frames)
+        {
+            m_destroy(*it->second.mesh);
+            it = m_meshes.erase(it);
+            m_stats.evicted++;
+        }
+        else
+        {
+            it++;
+        }
+    }
+    for (auto it = m_geometries.begin(); it != m_geometries.end();)
+    {
+        it = m_frame - it->second.last_used > m_retire_frames ? m_geometries.erase(it) : std::next(it);
+    }
+}
+
+void MeshRegistry::clear()
+{
+    for (auto& entry : m_meshes)
+    {
+        m_destroy(*entry.second.mesh);
+    }
+    m_meshes.clear();
+    m_geometries.clear();
+}
+
+uint32_t MeshRegistry::references(const components::Visual3d& viz) const
+{
+    auto geometry = m_geometries.find(viz.geometry_id());
+    if (geometry == m_geometries.end())
+    {
+        return 0;
+    }
+    const MeshEntry* entry = find(geometry->second.content_hash, geometry->second.mesh);
+    return entry != nullptr ? entry->references : 0;
+}
+
+MeshRegistryStats MeshRegistry::stats() const
+{
+    MeshRegistryStats s = m_stats;
+    s.meshes = (uint32_t)m_meshes.size();
+    return s;
+}
+
+} // namespace rendersystem
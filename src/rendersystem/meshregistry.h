@@ -0,0 +1,78 @@
+#pragma once
+#include "mesh.h"
+#include "visual.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace rendersystem
+{
+
+struct MeshRegistryStats
+{
+    uint32_t meshes = 0;     // meshes alive
+    uint32_t references = 0; // acquire() calls in the current frame
+    uint64_t created = 0;
+    uint64_t evicted = 0;
+    uint64_t shared = 0; // acquisitions of a new geometry id served by an existing mesh of equal content
+};
+
+/**
+ * GPU meshes deduplicated by the content of the visuals, so equal geometry is uploaded once no matter how many
+ * components or files it came from. Meshes are found by content hash and keep a CPU copy of their visual, so a hash
+ * collision is detected by comparing the data and gets a mesh of its own. References are counted per frame: every
+ * visual drawn acquires its mesh again in each frame, and a mesh nobody acquired for more than retire_frames frames is
+ * destroyed. retire_frames has to cover the frames the GPU may still be reading.
+ */
+class MeshRegistry
+{
+  public:
+    using CreateFn = std::function<std::unique_ptr<Mesh>(const components::Visual3d&)>;
+    using DestroyFn = std::function<void(Mesh&)>;
+
+    MeshRegistry(CreateFn create, DestroyFn destroy, uint32_t retire_frames);
+    MeshRegistry(const MeshRegistry& rhs) = delete;
+    ~MeshRegistry();
+
+    // start counting the references of a new frame
+    void begin_frame();
+    // mesh of the visual, created on first use
+    Mesh* acquire(const components::Visual3d& viz);
+    // destroy the meshes which were not acquired within the last retire_frames frames
+    void collect();
+    // destroy all meshes, the GPU must be idle
+    void clear();
+
+    // references of the current frame to the mesh of viz, 0 if there is none
+    uint32_t references(const components::Visual3d& viz) const;
+    MeshRegistryStats stats() const;
+
+  private:
+    struct MeshEntry
+    {
+        std::unique_ptr<Mesh> mesh;
+        components::Visual3d visual; // the content, compared once per new geometry id with an equal hash
+        uint32_t references;
+        uint64_t last_used; // frame of the last acquisition
+    };
+    struct GeometryEntry
+    {
+        uint64_t content_hash;
+        const Mesh* mesh;
+        uint64_t last_used; // the mesh is used at least as recently, so it outlives the entry
+    };
+    MeshEntry* find(uint64_t content_hash, const Mesh* mesh);
+    const MeshEntry* find(uint64_t content_hash, const Mesh* mesh) const;
+
+  private:
+    CreateFn m_create;
+    DestroyFn m_destroy;
+    uint32_t m_retire_frames;
+    uint64_t m_frame;
+    std::unordered_multimap<uint64_t, MeshEntry> m_meshes;  // by content hash, several if the hashes collide
+    std::unordered_map<size_t, GeometryEntry> m_geometries; // mesh by geometry id, saves rehashing and comparing
+    MeshRegistryStats m_stats;
+};
+
+} // namespace rendersystem
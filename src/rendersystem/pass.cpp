@@ -22,7 +22,10 @@ PassData create_basic_pass(const CoreData& core_data, const SwapChainData& swap_
     color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // offscreen images are copied to the host instead of presented
+    const bool offscreen = swap_chain_data.swapchain_khr == VK_NULL_HANDLE;
+    color_attachment.finalLayout =
+        offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference color_attachment_ref = {};
     // attachment number will index into the pAttachments array in the parent renderpass itself
@@ -75,13 +78,23 @@ PassData create_basic_pass(const CoreData& core_data, const SwapChainData& swap_
     depth_dependency.dstSubpass = 0;
     depth_dependency.srcStageMask =
         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-    depth_dependency.srcAccessMask = 0;
+    // all frames in flight share the depth image, so the clear has to wait for the depth writes of the previous frame
+    depth_dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
     depth_dependency.dstStageMask =
         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
     depth_dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-    VkSubpassDependency dependencies[2] = {dependency, depth_dependency};
-    render_pass_info.dependencyCount = 2;
+    // the copy of an offscreen image waits for the color writes and the transition to the final layout
+    VkSubpassDependency readback_dependency = {};
+    readback_dependency.srcSubpass = 0;
+    readback_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    readback_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    readback_dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    readback_dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    readback_dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkSubpassDependency dependencies[3] = {dependency, depth_dependency, readback_dependency};
+    render_pass_info.dependencyCount = offscreen ? 3 : 2;
     render_pass_info.pDependencies = dependencies;
 
     vkCreateRenderPass(core_data.device, &render_pass_info, nullptr, &rd.render_pass);
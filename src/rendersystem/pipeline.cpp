@@ -1,19 +1,49 @@
 #include "pipeline.h"
+#include "check.h"
+#include "mesh.h"
+#include "pipelineregistry.h"
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
 
 namespace rendersystem
 {
 
+bool PipelineKey::operator==(const PipelineKey& rhs) const
+{
+    return words == rhs.words && entry_points == rhs.entry_points;
+}
+
+size_t PipelineKey::hash() const
+{
+    size_t h = std::hash<size_t>()(words.size());
+    // boost::hash_combine
+    for (uint64_t word : words)
+    {
+        h ^= std::hash<uint64_t>()(word) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    for (const std::string& entry_point : entry_points)
+    {
+        h ^= std::hash<std::string>()(entry_point) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
 PipelineBuilder& PipelineBuilder::add_shader_stage(const VkPipelineShaderStageCreateInfo& info)
 {
     m_shader_stages.push_back(info);
+    m_entry_points.push_back(info.pName);
     return *this;
 }
 
 PipelineBuilder& PipelineBuilder::add_vertex_input_state(const VkPipelineVertexInputStateCreateInfo& info)
 {
     m_vertex_input_state = info;
+    m_vertex_bindings.assign(info.pVertexBindingDescriptions,
+                             info.pVertexBindingDescriptions + info.vertexBindingDescriptionCount);
+    m_vertex_attributes.assign(info.pVertexAttributeDescriptions,
+                               info.pVertexAttributeDescriptions + info.vertexAttributeDescriptionCount);
     return *this;
 }
 
@@ -91,8 +121,21 @@ PipelineBuilder& PipelineBuilder::depth_stencil(bool enabled, bool write_depth,
     return *this;
 }
 
-VkPipeline PipelineBuilder::build(VkDevice device, VkRenderPass pass, VkPipelineLayout layout)
+VkPipeline PipelineBuilder::build(VkDevice device, VkRenderPass pass, VkPipelineLayout layout,
+                                  VkPipelineCache cache) const
 {
+    // the builder may have been copied, so the pointers into it are set here
+    std::vector<VkPipelineShaderStageCreateInfo> shader_stages = m_shader_stages;
+    for (size_t i = 0; i < shader_stages.size(); i++)
+    {
+        shader_stages[i].pName = m_entry_points[i].c_str();
+    }
+    VkPipelineVertexInputStateCreateInfo vertex_input_state = m_vertex_input_state;
+    vertex_input_state.pVertexBindingDescriptions = m_vertex_bindings.data();
+    vertex_input_state.pVertexAttributeDescriptions = m_vertex_attributes.data();
+    VkPipelineColorBlendStateCreateInfo color_blend_state = m_color_blend_state;
+    color_blend_state.pAttachments = &m_color_blend_attachement_state;
+
     VkPipelineViewportStateCreateInfo viewportState = {};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.pNext = nullptr;
@@ -105,14 +148,14 @@ VkPipeline PipelineBuilder::build(VkDevice device, VkRenderPass pass, VkPipeline
     pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipeline_info.pNext = nullptr;
 
-    pipeline_info.stageCount = m_shader_stages.size();
-    pipeline_info.pStages = m_shader_stages.data();
-    pipeline_info.pVertexInputState = &m_vertex_input_state;
+    pipeline_info.stageCount = shader_stages.size();
+    pipeline_info.pStages = shader_stages.data();
+    pipeline_info.pVertexInputState = &vertex_input_state;
     pipeline_info.pInputAssemblyState = &m_input_assembly_state;
     pipeline_info.pViewportState = &viewportState;
     pipeline_info.pRasterizationState = &m_rasterization_state;
     pipeline_info.pMultisampleState = &m_multisample_state;
-    pipeline_info.pColorBlendState = &m_color_blend_state;
+    pipeline_info.pColorBlendState = &color_blend_state;
     pipeline_info.layout = layout;
     pipeline_info.renderPass = pass;
     pipeline_info.subpass = 0;
@@ -121,13 +164,86 @@ VkPipeline PipelineBuilder::build(VkDevice device, VkRenderPass pass, VkPipeline
 
     // //it's easy to error out on create graphics pipeline, so we handle it a bit better than the common VK_CHECK case
     VkPipeline newPipeline;
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &newPipeline) != VK_SUCCESS)
+    if (vkCreateGraphicsPipelines(device, cache, 1, &pipeline_info, nullptr, &newPipeline) != VK_SUCCESS)
     {
         throw std::runtime_error("cannot build vkCreateGraphicsPipelines");
     }
     return newPipeline;
 }
 
+PipelineKey PipelineBuilder::key(VkRenderPass pass, VkPipelineLayout layout) const
+{
+    PipelineKey key;
+    std::vector<uint64_t>& w = key.words;
+    auto add_float = [&w](float f) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        w.push_back(bits);
+    };
+    w.push_back((uint64_t)pass);
+    w.push_back((uint64_t)layout);
+
+    w.push_back(m_shader_stages.size());
+    for (const VkPipelineShaderStageCreateInfo& stage : m_shader_stages)
+    {
+        w.insert(w.end(), {(uint64_t)stage.flags, (uint64_t)stage.stage, (uint64_t)stage.module});
+    }
+    key.entry_points = m_entry_points;
+
+    w.push_back(m_vertex_input_state.flags);
+    w.push_back(m_vertex_bindings.size());
+    for (const VkVertexInputBindingDescription& b : m_vertex_bindings)
+    {
+        w.insert(w.end(), {b.binding, b.stride, (uint64_t)b.inputRate});
+    }
+    w.push_back(m_vertex_attributes.size());
+    for (const VkVertexInputAttributeDescription& a : m_vertex_attributes)
+    {
+        w.insert(w.end(), {a.location, a.binding, (uint64_t)a.format, a.offset});
+    }
+
+    w.insert(w.end(), {(uint64_t)m_input_assembly_state.topology, m_input_assembly_state.primitiveRestartEnable});
+
+    const VkPipelineRasterizationStateCreateInfo& r = m_rasterization_state;
+    w.insert(w.end(), {r.depthClampEnable, r.rasterizerDiscardEnable, (uint64_t)r.polygonMode, r.cullMode,
+                       (uint64_t)r.frontFace, r.depthBiasEnable});
+    add_float(r.depthBiasConstantFactor);
+    add_float(r.depthBiasClamp);
+    add_float(r.depthBiasSlopeFactor);
+    add_float(r.lineWidth);
+
+    const VkPipelineMultisampleStateCreateInfo& m = m_multisample_state;
+    w.insert(w.end(), {(uint64_t)m.rasterizationSamples, m.sampleShadingEnable, m.alphaToCoverageEnable,
+                       m.alphaToOneEnable});
+    add_float(m.minSampleShading);
+
+    const VkPipelineColorBlendAttachmentState& a = m_color_blend_attachement_state;
+    w.insert(w.end(), {a.blendEnable, (uint64_t)a.srcColorBlendFactor, (uint64_t)a.dstColorBlendFactor,
+                       (uint64_t)a.colorBlendOp, (uint64_t)a.srcAlphaBlendFactor, (uint64_t)a.dstAlphaBlendFactor,
+                       (uint64_t)a.alphaBlendOp, a.colorWriteMask});
+    w.insert(w.end(), {m_color_blend_state.logicOpEnable, (uint64_t)m_color_blend_state.logicOp,
+                       m_color_blend_state.attachmentCount});
+    for (float c : m_color_blend_state.blendConstants)
+    {
+        add_float(c);
+    }
+
+    const VkPipelineDepthStencilStateCreateInfo& d = m_depth_stencil_state;
+    w.insert(w.end(), {d.depthTestEnable, d.depthWriteEnable, (uint64_t)d.depthCompareOp, d.depthBoundsTestEnable,
+                       d.stencilTestEnable});
+    add_float(d.minDepthBounds);
+    add_float(d.maxDepthBounds);
+
+    for (float v : {m_viewport.x, m_viewport.y, m_viewport.width, m_viewport.height, m_viewport.minDepth,
+                    m_viewport.maxDepth})
+    {
+        add_float(v);
+    }
+    w.insert(w.end(), {(uint64_t)(int64_t)m_scissor.offset.x, (uint64_t)(int64_t)m_scissor.offset.y,
+                       m_scissor.extent.width, m_scissor.extent.height});
+    return key;
+}
+
 void load_shader_module(VkDevice device, const char* filePath, VkShaderModule* out_shader_module)
 {
     std::ifstream file(filePath, std::ios::ate | std::ios::binary);
@@ -159,4 +275,115 @@ void load_shader_module(VkDevice device, const char* filePath, VkShaderModule* o
     }
     *out_shader_module = shader_module;
 }
+PipelineBuilder mesh_pipeline_builder(const MeshPipelineData& pd, VkPolygonMode polygon_mode, VertexFormat format)
+{
+    const VertexInputDescriptionData& vertex_input = Mesh::get_vertex_input_description(format);
+    PipelineBuilder builder;
+    builder.add_shader_stage(
+        VkPipelineShaderStageCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                        .pNext = nullptr,
+                                        .flags = {},
+                                        .stage = VK_SHADER_STAGE_VERTEX_BIT,
+                                        .module = format == VertexFormat::compact ? pd.vert_compact : pd.vert,
+                                        .pName = "main"});
+    builder.add_shader_stage(
+        VkPipelineShaderStageCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                        .pNext = nullptr,
+                                        .flags = {},
+                                        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                                        .module = pd.frag,
+                                        .pName = "main"});
+
+    builder.add_vertex_input_state(VkPipelineVertexInputStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .flags = VkPipelineVertexInputStateCreateFlags{},
+        .vertexBindingDescriptionCount = (uint32_t)vertex_input.bindings.size(),
+        .pVertexBindingDescriptions = vertex_input.bindings.data(),
+        .vertexAttributeDescriptionCount = (uint32_t)vertex_input.attributes.size(),
+        .pVertexAttributeDescriptions = vertex_input.attributes.data()});
+    builder.add_input_assembly_state(
+        VkPipelineInputAssemblyStateCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+                                               .topology = VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST});
+
+    builder.add_rasterization_state(
+        VkPipelineRasterizationStateCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                                               .depthClampEnable = VK_FALSE,
+                                               .rasterizerDiscardEnable = VK_FALSE,
+                                               .polygonMode = polygon_mode,
+                                               .cullMode = VK_CULL_MODE_NONE,
+                                               .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+                                               .depthBiasEnable = VK_FALSE,
+                                               .depthBiasConstantFactor = 0.0f,
+                                               .depthBiasClamp = 0.0f,
+                                               .depthBiasSlopeFactor = 0.0f,
+                                               .lineWidth = 1.0f});
+    builder.add_viewport({.x = 0,
+                          .y = 0,
+                          .width = (float)pd.extent.width,
+                          .height = (float)pd.extent.height,
+                          .minDepth = 0,
+                          .maxDepth = 1});
+    builder.depth_stencil(true, true, VK_COMPARE_OP_LESS_OR_EQUAL);
+    builder.no_msaa();
+    builder.no_color_blend();
+    return builder;
+}
+
+MeshPipelineData create_mesh_pipeline(VkDevice device, VkRenderPass pass, VkExtent2D extent,
+                                      DescriptorLayoutCache* layouts, PipelineRegistry* pipelines)
+{
+    MeshPipelineData pd = {};
+    pd.pass = pass;
+    pd.extent = extent;
+    load_shader_module(device, "rendersystem/shaders/mesh.vert.spv", &pd.vert);
+    load_shader_module(device, "rendersystem/shaders/mesh_compact.vert.spv", &pd.vert_compact);
+    load_shader_module(device, "rendersystem/shaders/mesh.frag.spv", &pd.frag);
+
+    // everything the vertex shader reads besides the vertices changes once per frame
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pd.frame_set_layout = layouts->get(bindings);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.pNext = nullptr;
+    pipeline_layout_info.flags = 0;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &pd.frame_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 0;
+    pipeline_layout_info.pPushConstantRanges = nullptr;
+
+    VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &pd.pipeline_layout));
+
+    pd.pipeline = pipelines->get(mesh_pipeline_builder(pd, VK_POLYGON_MODE_FILL), pass, pd.pipeline_layout);
+    return pd;
+}
+
+void destroy_mesh_pipeline(VkDevice device, MeshPipelineData* pd)
+{
+    vkDestroyPipelineLayout(device, pd->pipeline_layout, nullptr);
+    vkDestroyShaderModule(device, pd->frag, nullptr);
+    vkDestroyShaderModule(device, pd->vert_compact, nullptr);
+    vkDestroyShaderModule(device, pd->vert, nullptr);
+    *pd = {};
+}
+
+VkDescriptorSet write_mesh_set(VkDevice device, DescriptorAllocator* descriptors, const MeshPipelineData& pd,
+                               VkBuffer camera, VkBuffer instances)
+{
+    VkDescriptorSet set = descriptors->allocate(pd.frame_set_layout);
+    DescriptorWriter()
+        .write_buffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, camera)
+        .write_buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, instances)
+        .update(device, set);
+    return set;
+}
+
 } // namespace rendersystem
\ No newline at end of file
@@ -1,13 +1,33 @@
 #pragma once
 
+#include "descriptors.h"
+#include "vertexformat.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
 
 namespace rendersystem
 {
+class PipelineRegistry;
 
 /**
- * Mechanism to build VkPipeline objects more conveniently
+ * Everything a PipelineBuilder passes to vkCreateGraphicsPipelines, flattened into plain values. Builders with the same
+ * state have equal keys even if their create infos point to different arrays. Floats are compared bitwise.
+ */
+struct PipelineKey
+{
+    std::vector<uint64_t> words;
+    std::vector<std::string> entry_points; // of the shader stages
+    bool operator==(const PipelineKey& rhs) const;
+    size_t hash() const;
+};
+
+/**
+ * Mechanism to build VkPipeline objects more conveniently. The builder keeps copies of the vertex input descriptions
+ * and entry point names it is given, so it can outlive them, e.g. to build on another thread. Specialization
+ * constants, sample masks and stencil state are not supported.
  */
 class PipelineBuilder
 {
@@ -24,22 +44,63 @@ class PipelineBuilder
     PipelineBuilder& no_color_blend();
     /**
      * Use all previous information an create the vulkan pipeline. Note that
+     * the driver looks the compiled shaders up in cache, if given, and adds them to it otherwise
      */
-    VkPipeline build(VkDevice device, VkRenderPass pass, VkPipelineLayout layout);
+    VkPipeline build(VkDevice device, VkRenderPass pass, VkPipelineLayout layout,
+                     VkPipelineCache cache = VK_NULL_HANDLE) const;
+    // the state build() would create a pipeline from
+    PipelineKey key(VkRenderPass pass, VkPipelineLayout layout) const;
 
   private:
     std::vector<VkPipelineShaderStageCreateInfo> m_shader_stages;
-    VkPipelineVertexInputStateCreateInfo m_vertex_input_state;
-    VkPipelineInputAssemblyStateCreateInfo m_input_assembly_state;
-    VkPipelineRasterizationStateCreateInfo m_rasterization_state;
-    VkPipelineMultisampleStateCreateInfo m_multisample_state;
-    VkPipelineColorBlendAttachmentState m_color_blend_attachement_state;
-    VkPipelineColorBlendStateCreateInfo m_color_blend_state;
-    VkPipelineDepthStencilStateCreateInfo m_depth_stencil_state;
-    VkViewport m_viewport;
-    VkRect2D m_scissor;
-    VkPipelineLayout m_pipeline_layout;
+    std::vector<std::string> m_entry_points; // parallel to m_shader_stages
+    VkPipelineVertexInputStateCreateInfo m_vertex_input_state = {};
+    std::vector<VkVertexInputBindingDescription> m_vertex_bindings;
+    std::vector<VkVertexInputAttributeDescription> m_vertex_attributes;
+    VkPipelineInputAssemblyStateCreateInfo m_input_assembly_state = {};
+    VkPipelineRasterizationStateCreateInfo m_rasterization_state = {};
+    VkPipelineMultisampleStateCreateInfo m_multisample_state = {};
+    VkPipelineColorBlendAttachmentState m_color_blend_attachement_state = {};
+    VkPipelineColorBlendStateCreateInfo m_color_blend_state = {};
+    VkPipelineDepthStencilStateCreateInfo m_depth_stencil_state = {};
+    VkViewport m_viewport = {};
+    VkRect2D m_scissor = {};
 };
 
 void load_shader_module(VkDevice device, const char* file_path, VkShaderModule* out_shader_module);
+
+/**
+ * Hold the pipeline used to draw Mesh objects together with the objects it was built from. The variants for other
+ * polygon modes and vertex formats come from mesh_pipeline_builder, once they are needed.
+ */
+struct MeshPipelineData
+{
+    VkPipeline pipeline; // filled polygons of VertexFormat::standard, owned by the PipelineRegistry
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorSetLayout frame_set_layout; // set 0, see write_mesh_set. Owned by the DescriptorLayoutCache
+    VkShaderModule vert;
+    VkShaderModule vert_compact; // decodes CompactVertex
+    VkShaderModule frag;
+    VkRenderPass pass;
+    VkExtent2D extent;
+};
+
+MeshPipelineData create_mesh_pipeline(VkDevice device, VkRenderPass pass, VkExtent2D extent,
+                                      DescriptorLayoutCache* layouts, PipelineRegistry* pipelines);
+// the pipelines stay with the registry
+void destroy_mesh_pipeline(VkDevice device, MeshPipelineData* pd);
+/**
+ * The state of the mesh pipeline with polygon_mode and vertices in format, to get variants from the PipelineRegistry.
+ * Modes other than VK_POLYGON_MODE_FILL need CoreData::fill_mode_non_solid.
+ */
+PipelineBuilder mesh_pipeline_builder(const MeshPipelineData& pd, VkPolygonMode polygon_mode,
+                                      VertexFormat format = VertexFormat::standard);
+
+/**
+ * Allocate set 0 of the mesh pipeline from descriptors and point it at camera, a uniform buffer holding
+ * CameraUniforms, and at instances, a storage buffer of InstanceAttributes which mesh.vert indexes with
+ * gl_InstanceIndex.
+ */
+VkDescriptorSet write_mesh_set(VkDevice device, DescriptorAllocator* descriptors, const MeshPipelineData& pd,
+                               VkBuffer camera, VkBuffer instances);
 } // namespace rendersystem
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "pipelinecache.h"
+#include "check.h"
+#include "core.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace rendersystem
+{
+
+namespace
+{
+const char kMagic[4] = {'V', 'H', 'P', 'C'};
+// the header every driver puts in front of its data, VkPipelineCacheHeaderVersionOne
+const size_t kDriverHeaderSize = 16 + VK_UUID_SIZE;
+
+uint64_t fnv1a(const uint8_t* data, size_t size)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < size; i++)
+    {
+        h = (h ^ data[i]) * UINT64_C(1099511628211);
+    }
+    return h;
+}
+
+// data the driver created for the device, judging by the header of the data itself
+bool matches_driver_header(const VkPhysicalDeviceProperties& properties, const uint8_t* data, size_t size)
+{
+    if (size < kDriverHeaderSize)
+    {
+        return false;
+    }
+    uint32_t fields[4]; // header size, header version, vendor, device
+    memcpy(fields, data, sizeof(fields));
+    return fields[0] >= kDriverHeaderSize && fields[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           fields[2] == properties.vendorID && fields[3] == properties.deviceID &&
+           memcmp(data + sizeof(fields), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::vector<uint8_t> read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        return {};
+    }
+    std::vector<uint8_t> content((size_t)file.tellg());
+    file.seekg(0);
+    file.read((char*)content.data(), content.size());
+    return file ? content : std::vector<uint8_t>();
+}
+} // namespace
+
+std::vector<uint8_t> pack_pipeline_cache(const VkPhysicalDeviceProperties& properties,
+                                         const std::vector<uint8_t>& data)
+{
+    PipelineCacheHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kPipelineCacheVersion;
+    header.vendor_id = properties.vendorID;
+    header.device_id = properties.deviceID;
+    header.driver_version = properties.driverVersion;
+    memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.data_size = data.size();
+    header.data_hash = fnv1a(data.data(), data.size());
+
+    std::vector<uint8_t> file(sizeof(header) + data.size());
+    memcpy(file.data(), &header, sizeof(header));
+    std::copy(data.begin(), data.end(), file.begin() + sizeof(header));
+    return file;
+}
+
+bool unpack_pipeline_cache(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& file,
+                           std::vector<uint8_t>* data)
+{
+    PipelineCacheHeader header;
+    if (file.size() < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+    // a driver update may change how pipelines compile while keeping the UUID, so its version is checked as well
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kPipelineCacheVersion ||
+        header.vendor_id != properties.vendorID || header.device_id != properties.deviceID ||
+        header.driver_version != properties.driverVersion ||
+        memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+        header.data_size != file.size() - sizeof(header))
+    {
+        return false;
+    }
+    const uint8_t* begin = file.data() + sizeof(header);
+    if (header.data_hash != fnv1a(begin, header.data_size) ||
+        !matches_driver_header(properties, begin, header.data_size))
+    {
+        return false;
+    }
+    data->assign(begin, begin + header.data_size);
+    return true;
+}
+
+PipelineCacheData create_pipeline_cache(const CoreData& core_data, const std::string& path)
+{
+    PipelineCacheData pc = {};
+    pc.path = path;
+    std::vector<uint8_t> data;
+    if (!path.empty())
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(core_data.physical_device, &properties);
+        pc.warm = unpack_pipeline_cache(properties, read_file(path), &data);
+    }
+    pc.loaded_size = data.size();
+
+    VkPipelineCacheCreateInfo cache_info = {};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = data.size();
+    cache_info.pInitialData = data.data();
+    VK_CHECK_RESULT(vkCreatePipelineCache(core_data.device, &cache_info, nullptr, &pc.cache));
+    return pc;
+}
+
+bool save_pipeline_cache(const CoreData& core_data, const PipelineCacheData& pc)
+{
+    if (pc.path.empty())
+    {
+        return true;
+    }
+    size_t size = 0;
+    VK_CHECK_RESULT(vkGetPipelineCacheData(core_data.device, pc.cache, &size, nullptr));
+    std::vector<uint8_t> data(size);
+    VK_CHECK_RESULT(vkGetPipelineCacheData(core_data.device, pc.cache, &size, data.data()));
+    data.resize(size);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(core_data.physical_device, &properties);
+    const std::vector<uint8_t> file = pack_pipeline_cache(properties, data);
+
+    // write to a temporary file unique across processes saving the same cache first, so that a crash or a concurrent
+    // reader never sees a partial file
+    static std::atomic<uint64_t> counter{0};
+    const std::string tmp = pc.path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(counter++);
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        out.write((const char*)file.data(), file.size());
+        if (!out)
+        {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tmp, pc.path, error);
+    if (error)
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void destroy_pipeline_cache(VkDevice device, PipelineCacheData* pc)
+{
+    vkDestroyPipelineCache(device, pc->cache, nullptr);
+    *pc = {};
+}
+
+} // namespace rendersystem
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace rendersystem
+{
+struct CoreData;
+
+/**
+ * File header of a saved pipeline cache, followed by the data returned by vkGetPipelineCacheData. Drivers are
+ * supposed to reject data of other devices themselves, but not all of them do so reliably, so the data is only passed
+ * on if the device and driver recorded here match.
+ */
+struct PipelineCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t uuid[VK_UUID_SIZE]; // VkPhysicalDeviceProperties::pipelineCacheUUID
+    uint32_t reserved;
+    uint64_t data_size;
+    uint64_t data_hash; // FNV-1a of the data
+};
+
+static const uint32_t kPipelineCacheVersion = 1;
+
+// the file content for cache data of the device with properties
+std::vector<uint8_t> pack_pipeline_cache(const VkPhysicalDeviceProperties& properties,
+                                         const std::vector<uint8_t>& data);
+/**
+ * Extract the cache data from file content written by pack_pipeline_cache. Returns false if the file is incomplete,
+ * of another version or was saved by a different device or driver version.
+ */
+bool unpack_pipeline_cache(const VkPhysicalDeviceProperties& properties, const std::vector<uint8_t>& file,
+                           std::vector<uint8_t>* data);
+
+/**
+ * A VkPipelineCache which lives in a file between runs.
+ */
+struct PipelineCacheData
+{
+    VkPipelineCache cache;
+    std::string path;     // empty if the cache is not persisted
+    bool warm;            // the cache was created with data loaded from path
+    uint64_t loaded_size; // bytes of cache data loaded from path
+};
+
+/**
+ * Create a pipeline cache with the data saved at path if the file exists and matches the device and driver, an empty
+ * one otherwise. With an empty path no file is read or written.
+ */
+PipelineCacheData create_pipeline_cache(const CoreData& core_data, const std::string& path);
+/**
+ * Write the data of the cache to its path, replacing the previous file in one step so that a crash leaves either
+ * file intact. Returns false if the file cannot be written.
+ */
+bool save_pipeline_cache(const CoreData& core_data, const PipelineCacheData& pc);
+void destroy_pipeline_cache(VkDevice device, PipelineCacheData* pc);
+
+} // namespace rendersystem
@@ -0,0 +1,98 @@
+#include "pipelineregistry.h"
+#include <chrono>
+
+namespace rendersystem
+{
+
+PipelineRegistry::PipelineRegistry(size_t background_threads)
+    : m_builder(background_threads > 0 ? std::make_unique<jobs::TaskQueue>(background_threads) : nullptr)
+{
+}
+
+void PipelineRegistry::create(VkDevice device, VkPipelineCache cache)
+{
+    m_device = device;
+    m_cache = cache;
+}
+
+void PipelineRegistry::destroy()
+{
+    for (auto& [key, entry] : m_pipelines)
+    {
+        if (entry.pending.valid())
+        {
+            try
+            {
+                entry.pipeline = entry.pending.get();
+            }
+            catch (...)
+            {
+                // the build failed, there is nothing to destroy
+            }
+        }
+        vkDestroyPipeline(m_device, entry.pipeline, nullptr);
+    }
+    m_pipelines.clear();
+}
+
+PipelineRegistry::Map::iterator PipelineRegistry::find_or_build(const PipelineBuilder& builder, VkRenderPass pass,
+                                                                VkPipelineLayout layout, bool background)
+{
+    auto [it, inserted] = m_pipelines.try_emplace(builder.key(pass, layout));
+    if (!inserted)
+    {
+        return it;
+    }
+    m_build_count++;
+    if (background && m_builder)
+    {
+        // the builder owns its state, a copy can be built after the caller's one is gone
+        it->second.pending = m_builder->submit([device = m_device, cache = m_cache, builder, pass, layout]() {
+            return builder.build(device, pass, layout, cache);
+        });
+        return it;
+    }
+    try
+    {
+        it->second.pipeline = builder.build(m_device, pass, layout, m_cache);
+    }
+    catch (...)
+    {
+        // the next call tries again
+        m_pipelines.erase(it);
+        throw;
+    }
+    return it;
+}
+
+VkPipeline PipelineRegistry::finish(Map::iterator it)
+{
+    try
+    {
+        it->second.pipeline = it->second.pending.get();
+    }
+    catch (...)
+    {
+        m_pipelines.erase(it);
+        throw;
+    }
+    return it->second.pipeline;
+}
+
+VkPipeline PipelineRegistry::get(const PipelineBuilder& builder, VkRenderPass pass, VkPipelineLayout layout)
+{
+    auto it = find_or_build(builder, pass, layout, false);
+    return it->second.pending.valid() ? finish(it) : it->second.pipeline;
+}
+
+VkPipeline PipelineRegistry::request(const PipelineBuilder& builder, VkRenderPass pass, VkPipelineLayout layout)
+{
+    auto it = find_or_build(builder, pass, layout, true);
+    if (it->second.pending.valid() && it->second.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        return finish(it);
+    }
+    return it->second.pipeline;
+}
+
+} // namespace rendersystem
@@ -0,0 +1,75 @@
+#pragma once
+#include "pipeline.h"
+#include "taskqueue.h"
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vulkan/vulkan_core.h>
+
+namespace rendersystem
+{
+
+/**
+ * Owner of all graphics pipelines, one per distinct PipelineBuilder state. Asking for the state of an existing
+ * pipeline returns it instead of compiling a duplicate, so render modes can be switched at runtime by asking for the
+ * pipeline of the new state. The shader modules, render pass and layout of a builder have to outlive its pipeline.
+ * Not thread safe.
+ */
+class PipelineRegistry
+{
+  public:
+    // background_threads == 0 builds every pipeline on the calling thread
+    explicit PipelineRegistry(size_t background_threads = 1);
+    // all pipelines are created with cache, which may be VK_NULL_HANDLE
+    void create(VkDevice device, VkPipelineCache cache);
+    // waits for the pipelines still being built, then destroys all pipelines
+    void destroy();
+
+    // the pipeline for the state of builder, built now if there is none yet
+    VkPipeline get(const PipelineBuilder& builder, VkRenderPass pass, VkPipelineLayout layout);
+    /**
+     * Like get(), but a missing pipeline is built on a background thread and VK_NULL_HANDLE is returned until it is
+     * ready, so the caller can keep drawing with another pipeline meanwhile. Build errors are rethrown by the call
+     * which finds the pipeline finished.
+     */
+    VkPipeline request(const PipelineBuilder& builder, VkRenderPass pass, VkPipelineLayout layout);
+
+    // distinct pipelines, including those being built
+    size_t size() const
+    {
+        return m_pipelines.size();
+    }
+    // calls of vkCreateGraphicsPipelines so far
+    size_t build_count() const
+    {
+        return m_build_count;
+    }
+
+  private:
+    struct Entry
+    {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        std::future<VkPipeline> pending; // valid while the pipeline is built in the background
+    };
+    struct KeyHash
+    {
+        size_t operator()(const PipelineKey& key) const
+        {
+            return key.hash();
+        }
+    };
+    using Map = std::unordered_map<PipelineKey, Entry, KeyHash>;
+    Map::iterator find_or_build(const PipelineBuilder& builder, VkRenderPass pass, VkPipelineLayout layout,
+                                bool background);
+    VkPipeline finish(Map::iterator it);
+
+  private:
+    VkDevice m_device = VK_NULL_HANDLE;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    size_t m_build_count = 0;
+    Map m_pipelines;
+    std::unique_ptr<jobs::TaskQueue> m_builder; // null without background threads
+};
+
+} // namespace rendersystem
@@ -0,0 +1,77 @@
+#include "readback.h"
+#include "core.h"
+#include <stdexcept>
+#include <string>
+
+namespace rendersystem
+{
+
+static uint32_t texel_size(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return 4;
+    default:
+        throw std::runtime_error("cannot read back images of format " + std::to_string((int)format));
+    }
+}
+
+ReadbackData create_readback(const CoreData& core_data, VkExtent2D extent, VkFormat format)
+{
+    ReadbackData rb = {};
+    rb.extent = extent;
+    rb.format = format;
+    rb.buffer = create_readback_buffer(core_data, (VkDeviceSize)extent.width * extent.height * texel_size(format));
+    return rb;
+}
+
+void destroy_readback(ReadbackData* rb)
+{
+    destroy_host_buffer(&rb->buffer);
+    *rb = {};
+}
+
+void record_readback(VkCommandBuffer cmd, VkImage image, uint64_t frame_number, ReadbackData* rb)
+{
+    // tightly packed rows, the render pass made the color writes visible to the transfer
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {rb->extent.width, rb->extent.height, 1};
+    vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, rb->buffer.buffer, 1, &region);
+
+    // make the copy available to the host, the fence wait makes it visible
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = rb->buffer.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0,
+                         nullptr);
+    rb->frame_number = frame_number;
+    rb->pending = true;
+}
+
+ReadbackImage read_readback(ReadbackData* rb)
+{
+    const uint32_t row_pitch = rb->extent.width * texel_size(rb->format);
+    invalidate_host_buffer(rb->buffer, (VkDeviceSize)row_pitch * rb->extent.height);
+    rb->pending = false;
+    return ReadbackImage{rb->frame_number, rb->extent.width, rb->extent.height, rb->format, row_pitch,
+                         (const uint8_t*)rb->buffer.data};
+}
+
+} // namespace rendersystem
@@ -0,0 +1,44 @@
+#pragma once
+#include "hostbuffer.h"
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+namespace rendersystem
+{
+struct CoreData;
+
+/**
+ * A rendered image in host memory, rows of width tightly packed texels of format, top row first.
+ */
+struct ReadbackImage
+{
+    uint64_t frame_number;
+    uint32_t width;
+    uint32_t height;
+    VkFormat format;
+    uint32_t row_pitch; // in bytes
+    const uint8_t* pixels;
+};
+
+/**
+ * Host buffer one frame in flight copies its color image into. The CPU reads it after waiting for the frame's fence,
+ * so with N frames in flight the copies of N frames are under way while the CPU records the next one.
+ */
+struct ReadbackData
+{
+    HostBufferData buffer;
+    VkExtent2D extent;
+    VkFormat format;
+    uint64_t frame_number; // of the last recorded copy
+    bool pending;          // a copy was recorded and not read yet
+};
+
+// only formats with 4 bytes per texel, e.g. VK_FORMAT_R8G8B8A8_UNORM or VK_FORMAT_B8G8R8A8_SRGB
+ReadbackData create_readback(const CoreData& core_data, VkExtent2D extent, VkFormat format);
+void destroy_readback(ReadbackData* rb);
+// copy image, which is in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL after a render pass into an offscreen swapchain
+void record_readback(VkCommandBuffer cmd, VkImage image, uint64_t frame_number, ReadbackData* rb);
+// the pixels of the recorded copy, after the GPU finished it. They stay valid until the next copy is recorded
+ReadbackImage read_readback(ReadbackData* rb);
+
+} // namespace rendersystem
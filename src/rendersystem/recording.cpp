@@ -0,0 +1,173 @@
+#include "recording.h"
+#include "check.h"
+#include "profiler.h"
+#include <algorithm>
+
+namespace rendersystem
+{
+
+// below this many draws per command buffer the cost of waking a thread outweighs the recording work
+static const size_t kMinDrawsPerBuffer = 64;
+
+RecordingData create_recording(const CoreData& core_data, uint32_t thread_count)
+{
+    RecordingData rd;
+    rd.cmd_pools.resize(thread_count);
+    rd.cmd_bufs.resize(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        VkCommandPoolCreateInfo cmd_pool_info = {};
+        cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        cmd_pool_info.queueFamilyIndex = core_data.graphics_queue_family;
+        // buffers are re-recorded every frame
+        cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        VK_CHECK_RESULT(vkCreateCommandPool(core_data.device, &cmd_pool_info, nullptr, &rd.cmd_pools[i]));
+
+        VkCommandBufferAllocateInfo cmd_buf_info = {};
+        cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cmd_buf_info.commandPool = rd.cmd_pools[i];
+        cmd_buf_info.commandBufferCount = 1;
+        cmd_buf_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(core_data.device, &cmd_buf_info, &rd.cmd_bufs[i]));
+    }
+    return rd;
+}
+
+void destroy_recording(VkDevice device, RecordingData* rd)
+{
+    for (auto pool : rd->cmd_pools)
+    {
+        vkDestroyCommandPool(device, pool, nullptr);
+    }
+    *rd = {};
+}
+
+// bind the pipeline and the vertex buffer of the vertex format
+static void bind_vertex_format(VkCommandBuffer cmd_buf, const DrawState& state, VertexFormat format)
+{
+    const bool compact = format == VertexFormat::compact;
+    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, compact ? state.compact_pipeline : state.pipeline);
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(cmd_buf, 0, 1, compact ? &state.compact_vertex_buffer : &state.vertex_buffer, &offset);
+}
+
+// begin cmd_buf and bind everything the draws of state share, with the vertex format of the first draw
+static void begin_draws(VkDevice device, VkCommandPool cmd_pool, VkCommandBuffer cmd_buf, const DrawState& state,
+                        VertexFormat format)
+{
+    // resetting the whole pool is cheaper than resetting individual buffers
+    vkResetCommandPool(device, cmd_pool, 0);
+
+    VkCommandBufferInheritanceInfo inheritance_info = {};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = state.render_pass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = state.framebuffer;
+
+    VkCommandBufferBeginInfo cmd_begin_info = {};
+    cmd_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmd_begin_info.flags =
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    cmd_begin_info.pInheritanceInfo = &inheritance_info;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmd_buf, &cmd_begin_info));
+
+    bind_vertex_format(cmd_buf, state, format);
+    vkCmdBindIndexBuffer(cmd_buf, state.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+    // camera and model matrices are bound once, every draw only passes the index of its first instance
+    vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, state.pipeline_layout, 0, 1, &state.frame_set, 0,
+                            nullptr);
+}
+
+static void record_range(VkDevice device, VkCommandPool cmd_pool, VkCommandBuffer cmd_buf, const DrawState& state,
+                         const InstanceBatch* begin, const InstanceBatch* end)
+{
+    // on the recording thread, so the trace shows how evenly the ranges are spread
+    PROFILE_SCOPE("record_range");
+    VertexFormat format = begin->mesh->format();
+    begin_draws(device, cmd_pool, cmd_buf, state, format);
+    for (const InstanceBatch* batch = begin; batch != end; batch++)
+    {
+        const GeometryRange& range = batch->mesh->range();
+        // the formats are contiguous, see InstanceBatcher
+        if (range.format != format)
+        {
+            format = range.format;
+            bind_vertex_format(cmd_buf, state, format);
+        }
+        vkCmdDrawIndexed(cmd_buf, range.index_count, batch->instance_count, range.first_index,
+                         (int32_t)range.vertex_offset, batch->first_instance);
+    }
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd_buf));
+}
+
+uint32_t record_draws(VkDevice device, RecordingData* rd, jobs::ThreadPool& pool, const DrawState& state,
+                      const std::vector<InstanceBatch>& batches)
+{
+    if (batches.empty())
+    {
+        return 0;
+    }
+    const size_t range_count = std::min(
+        {rd->cmd_bufs.size(), pool.size(), (batches.size() + kMinDrawsPerBuffer - 1) / kMinDrawsPerBuffer});
+    pool.parallel_for(range_count, [&](size_t range) {
+        const InstanceBatch* begin = batches.data() + batches.size() * range / range_count;
+        const InstanceBatch* end = batches.data() + batches.size() * (range + 1) / range_count;
+        record_range(device, rd->cmd_pools[range], rd->cmd_bufs[range], state, begin, end);
+    });
+    return (uint32_t)range_count;
+}
+
+void write_draw_commands(const std::vector<InstanceBatch>& batches, VkDrawIndexedIndirectCommand* commands)
+{
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        const GeometryRange& range = batches[i].mesh->range();
+        commands[i].indexCount = range.index_count;
+        commands[i].instanceCount = batches[i].instance_count;
+        commands[i].firstIndex = range.first_index;
+        commands[i].vertexOffset = (int32_t)range.vertex_offset;
+        commands[i].firstInstance = batches[i].first_instance;
+    }
+}
+
+uint32_t record_indirect_draws(VkDevice device, RecordingData* rd, const DrawState& state, VkBuffer commands,
+                               uint32_t draw_count, bool multi_draw, uint32_t compact_draw_count)
+{
+    if (draw_count == 0)
+    {
+        return 0;
+    }
+    const uint32_t standard_draw_count = draw_count - compact_draw_count;
+    begin_draws(device, rd->cmd_pools[0], rd->cmd_bufs[0], state,
+                standard_draw_count > 0 ? VertexFormat::standard : VertexFormat::compact);
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    // the commands [first, first + count) in one or count calls
+    auto draw = [&](uint32_t first, uint32_t count) {
+        if (multi_draw)
+        {
+            vkCmdDrawIndexedIndirect(rd->cmd_bufs[0], commands, (VkDeviceSize)first * stride, count, stride);
+            return;
+        }
+        // without multiDrawIndirect drawCount must be 0 or 1
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            vkCmdDrawIndexedIndirect(rd->cmd_bufs[0], commands, (VkDeviceSize)i * stride, 1, stride);
+        }
+    };
+    if (standard_draw_count > 0)
+    {
+        draw(0, standard_draw_count);
+    }
+    if (compact_draw_count > 0)
+    {
+        if (standard_draw_count > 0)
+        {
+            bind_vertex_format(rd->cmd_bufs[0], state, VertexFormat::compact);
+        }
+        draw(standard_draw_count, compact_draw_count);
+    }
+    VK_CHECK_RESULT(vkEndCommandBuffer(rd->cmd_bufs[0]));
+    return 1;
+}
+
+} // namespace rendersystem
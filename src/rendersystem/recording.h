@@ -0,0 +1,85 @@
+#pragma once
+#include "core.h"
+#include "mesh.h"
+#include "threadpool.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace components
+{
+class CoordSys;
+}
+
+namespace rendersystem
+{
+
+/**
+ * Hold one secondary command buffer per recording thread. Every buffer comes from its own command pool, so threads
+ * never share a pool and no locking is needed while recording.
+ */
+struct RecordingData
+{
+    std::vector<VkCommandPool> cmd_pools;
+    std::vector<VkCommandBuffer> cmd_bufs;
+};
+
+struct DrawItem
+{
+    const components::CoordSys* coord;
+    Mesh* mesh;
+};
+
+/**
+ * Instances [first_instance, first_instance + instance_count) of the instance buffer drawn with one mesh.
+ */
+struct InstanceBatch
+{
+    const Mesh* mesh;
+    uint32_t first_instance;
+    uint32_t instance_count;
+};
+
+/**
+ * State shared by all draws recorded within one render pass.
+ */
+struct DrawState
+{
+    VkRenderPass render_pass;
+    VkFramebuffer framebuffer;
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+    VkBuffer vertex_buffer; // GeometryArena buffers holding all meshes
+    VkBuffer index_buffer;
+    // pipeline and vertex buffer for meshes in VertexFormat::compact, the layout is the same
+    VkPipeline compact_pipeline;
+    VkBuffer compact_vertex_buffer;
+    // set 0 of the pipeline, see write_mesh_set. Draws address their instances by InstanceBatch::first_instance
+    VkDescriptorSet frame_set;
+};
+
+RecordingData create_recording(const CoreData& core_data, uint32_t thread_count);
+void destroy_recording(VkDevice device, RecordingData* rd);
+
+/**
+ * Record one instanced draw per batch. The batches are split into contiguous ranges, at most one per command buffer
+ * in rd, which are recorded in parallel on pool. Returns the number of recorded buffers; rd->cmd_bufs[0..n) are to be
+ * executed inside state.render_pass, which must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+ */
+uint32_t record_draws(VkDevice device, RecordingData* rd, jobs::ThreadPool& pool, const DrawState& state,
+                      const std::vector<InstanceBatch>& batches);
+
+// write one indirect draw command per batch, commands needs room for batches.size() elements
+void write_draw_commands(const std::vector<InstanceBatch>& batches, VkDrawIndexedIndirectCommand* commands);
+
+/**
+ * Record draw_count commands of the indirect buffer commands, written by write_draw_commands, into rd->cmd_bufs[0].
+ * The GPU reads the offsets and instance ranges of the draws, so recording costs the same for any number of draws
+ * if multi_draw is set (CoreData::multi_draw_indirect); otherwise every command is a separate indirect call. The last
+ * compact_draw_count commands draw meshes in VertexFormat::compact, see InstanceBatcher::compact_batch_count.
+ * The device needs CoreData::draw_indirect_first_instance. Returns the number of recorded buffers, 0 or 1.
+ */
+uint32_t record_indirect_draws(VkDevice device, RecordingData* rd, const DrawState& state, VkBuffer commands,
+                               uint32_t draw_count, bool multi_draw, uint32_t compact_draw_count = 0);
+
+} // namespace rendersystem
@@ -6,185 +6,249 @@
 #include "check.h"
 #include "components/camera.h"
 #include "components/coordsys.h"
+#include "components/registry.h"
 #include "components/visual.h"
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/quaternion.hpp"
+#include "profiler.h"
 #include <GLFW/glfw3.h>
 #include <algorithm>
 #include <assert.h>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 using namespace components;
 namespace rendersystem
 {
 
-struct MeshPushConstants
+// visuals are uploaded byte for byte
+static_assert(sizeof(StandardVertex) == sizeof(VertexAttributes) &&
+              offsetof(StandardVertex, position) == offsetof(VertexAttributes, position) &&
+              offsetof(StandardVertex, normal) == offsetof(VertexAttributes, normal) &&
+              offsetof(StandardVertex, uv) == offsetof(VertexAttributes, uv) &&
+              offsetof(StandardVertex, color) == offsetof(VertexAttributes, color));
+
+std::unique_ptr<Mesh> create_mesh_from_visual(const Visual3d& viz, GeometryArena& arena, UploadManager& uploads,
+                                              VertexFormat format)
 {
-    glm::vec4 data;
-    glm::mat4 mvp_matrix;
-};
+    auto mesh = std::make_unique<Mesh>();
+    mesh->create(arena, uploads, reinterpret_cast<const VertexAttributes*>(viz.vertices().data()),
+                 (uint32_t)viz.vertices().size(), viz.indices().data(), (uint32_t)viz.indices().size(), format);
+    mesh->set_bounds(glm::vec4(viz.bounds().center, viz.bounds().radius));
+    return mesh;
+}
 
-RenderSystem::RenderSystem()
+RenderSystem::RenderSystem(const RenderSettings& settings)
+    : m_settings(settings), m_pool(settings.recording_threads),
+      m_meshes(
+          [this](const Visual3d& viz) {
+              const VertexFormat format = viz.compact_vertices() ? VertexFormat::compact : m_settings.vertex_format;
+              if (format != m_settings.vertex_format && m_settings.geometry_max_compact_vertices == 0)
+              {
+                  throw std::runtime_error("Visual3d::set_compact_vertices needs "
+                                           "RenderSettings::geometry_max_compact_vertices > 0");
+              }
+              return create_mesh_from_visual(viz, m_geometry, m_uploads, format);
+          },
+          [this](Mesh& mesh) { mesh.destroy(m_geometry); }, std::max(1u, settings.frames_in_flight))
 {
 }
 
 GLFWwindow* RenderSystem::create(uint32_t width, uint32_t height)
 {
-    m_core = rendersystem::create_core_with_window("vulkan_human", width, height);
+    const auto create_start = std::chrono::steady_clock::now();
+    m_core = rendersystem::create_core_with_window("vulkan_human", width, height, m_settings.validation_layers);
     m_swapchain = rendersystem::create_swapchain(m_core);
+    create_renderer(create_start);
+    return m_core.window;
+}
+
+void RenderSystem::create_headless(uint32_t width, uint32_t height)
+{
+    const auto create_start = std::chrono::steady_clock::now();
+    m_core = rendersystem::create_core_headless("vulkan_human", width, height, m_settings.validation_layers);
+    // one image per frame in flight, so the frame's fence also guards its image and readback
+    m_swapchain = rendersystem::create_offscreen_swapchain(m_core, std::max(1u, m_settings.frames_in_flight),
+                                                           m_settings.offscreen_format);
+    create_renderer(create_start);
+    for (size_t i = 0; i < m_frames.size(); i++)
+    {
+        m_readbacks.push_back(rendersystem::create_readback(m_core, m_core.window_size, m_swapchain.swapchain_format));
+    }
+}
+
+void RenderSystem::create_renderer(std::chrono::steady_clock::time_point create_start)
+{
     m_pass = rendersystem::create_basic_pass(m_core, m_swapchain);
+    // only the vertex buffers meshes are created in, so a renderer without compact meshes has no buffer for them
+    const bool compact = m_settings.vertex_format == VertexFormat::compact;
+    m_geometry.create(m_core, compact ? 0 : m_settings.geometry_max_vertices, m_settings.geometry_max_indices,
+                      compact ? m_settings.geometry_max_vertices : m_settings.geometry_max_compact_vertices);
+    m_uploads.create(m_core, m_settings.staging_size);
+
+    m_layouts.create(m_core.device);
+    m_pipeline_cache = rendersystem::create_pipeline_cache(m_core, m_settings.pipeline_cache_path);
+    m_pipelines.create(m_core.device, m_pipeline_cache.cache);
+    const auto pipelines_start = std::chrono::steady_clock::now();
+    m_mesh_pipeline = rendersystem::create_mesh_pipeline(m_core.device, m_pass.render_pass, m_core.window_size,
+                                                         &m_layouts, &m_pipelines);
+    m_solid_pipelines[(uint32_t)VertexFormat::standard] = m_mesh_pipeline.pipeline;
+    if (m_core.draw_indirect_first_instance)
+    {
+        m_cull_pipeline = rendersystem::create_cull_pipeline(m_core.device, &m_layouts, m_pipeline_cache.cache);
+    }
+    const auto pipelines_end = std::chrono::steady_clock::now();
 
-    create_pipeline();
-    return m_core.window;
+    m_frames = rendersystem::create_frames(m_core, std::max(1u, m_settings.frames_in_flight), (uint32_t)m_pool.size(),
+                                           m_settings.instance_capacity);
+    if (m_core.draw_indirect_first_instance)
+    {
+        for (size_t i = 0; i < m_frames.size(); i++)
+        {
+            m_gpu_culling.push_back(rendersystem::create_gpu_culling(m_core, m_settings.instance_capacity));
+        }
+    }
+    m_image_fences.assign(m_swapchain.swapchain_images.size(), VK_NULL_HANDLE);
+
+    const auto create_end = std::chrono::steady_clock::now();
+    m_startup_stats.pipeline_cache_warm = m_pipeline_cache.warm;
+    m_startup_stats.pipeline_cache_size = m_pipeline_cache.loaded_size;
+    m_startup_stats.pipelines_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(pipelines_end - pipelines_start).count();
+    m_startup_stats.create_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(create_end - create_start).count();
 }
 
 void RenderSystem::destroy()
 {
+    finish_readbacks();
     vkDeviceWaitIdle(m_core.device);
-    vkWaitForFences(m_core.device, 1, &m_core.fence_host, VK_TRUE, UINT64_MAX);
 
-    for (auto& entry : m_meshes)
+    m_meshes.clear();
+    m_uploads.destroy();
+    m_geometry.destroy();
+    // waits for pipelines still being built with the shader modules of m_mesh_pipeline
+    m_pipelines.destroy();
+    std::fill(std::begin(m_solid_pipelines), std::end(m_solid_pipelines), VK_NULL_HANDLE);
+    std::fill(std::begin(m_wireframe_pipelines), std::end(m_wireframe_pipelines), VK_NULL_HANDLE);
+    rendersystem::destroy_mesh_pipeline(m_core.device, &m_mesh_pipeline);
+    rendersystem::destroy_frames(m_core.device, &m_frames);
+    for (GpuCullingData& gc : m_gpu_culling)
+    {
+        rendersystem::destroy_gpu_culling(m_core.device, &gc);
+    }
+    m_gpu_culling.clear();
+    for (ReadbackData& rb : m_readbacks)
+    {
+        rendersystem::destroy_readback(&rb);
+    }
+    m_readbacks.clear();
+    if (m_cull_pipeline.pipeline != VK_NULL_HANDLE)
     {
-        entry.second->destroy(m_core.allocator);
+        rendersystem::destroy_cull_pipeline(m_core.device, &m_cull_pipeline);
     }
-    vkDestroyPipeline(m_core.device, m_pipeline, nullptr);
-    vkDestroyPipelineLayout(m_core.device, m_pipeline_layout, nullptr);
-    vkDestroyShaderModule(m_core.device, m_triangle_frag, nullptr);
-    vkDestroyShaderModule(m_core.device, m_triangle_vert, nullptr);
+    m_layouts.destroy();
+    // pipelines created in this run are compiled faster next time
+    if (!rendersystem::save_pipeline_cache(m_core, m_pipeline_cache))
+    {
+        std::cerr << "cannot write pipeline cache " << m_pipeline_cache.path << std::endl;
+    }
+    rendersystem::destroy_pipeline_cache(m_core.device, &m_pipeline_cache);
 
     rendersystem::destroy_pass(m_core.device, &m_pass);
     rendersystem::destroy_swapchain(m_core, &m_swapchain);
     rendersystem::destroy_core(&m_core);
 }
 
-void RenderSystem::create_pipeline()
+uint32_t RenderSystem::begin_frame()
 {
-    rendersystem::load_shader_module(m_core.device, "rendersystem/shaders/mesh.vert.spv", &m_triangle_vert);
-    rendersystem::load_shader_module(m_core.device, "rendersystem/shaders/mesh.frag.spv", &m_triangle_frag);
-
-    rendersystem::PipelineBuilder builder;
-    builder.add_shader_stage(
-        VkPipelineShaderStageCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                                        .pNext = nullptr,
-                                        .flags = {},
-                                        .stage = VK_SHADER_STAGE_VERTEX_BIT,
-                                        .module = m_triangle_vert,
-                                        .pName = "main"});
-    builder.add_shader_stage(
-        VkPipelineShaderStageCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                                        .pNext = nullptr,
-                                        .flags = {},
-                                        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-                                        .module = m_triangle_frag,
-                                        .pName = "main"});
-
-    builder.add_vertex_input_state(VkPipelineVertexInputStateCreateInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .flags = VkPipelineVertexInputStateCreateFlags{},
-        .vertexBindingDescriptionCount = (uint32_t)Mesh::get_vertex_input_description().bindings.size(),
-        .pVertexBindingDescriptions = Mesh::get_vertex_input_description().bindings.data(),
-        .vertexAttributeDescriptionCount = (uint32_t)Mesh::get_vertex_input_description().attributes.size(),
-        .pVertexAttributeDescriptions = Mesh::get_vertex_input_description().attributes.data()});
-    builder.add_input_assembly_state(
-        VkPipelineInputAssemblyStateCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-                                               .topology = VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST});
-
-    builder.add_rasterization_state(
-        VkPipelineRasterizationStateCreateInfo{.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-                                               .depthClampEnable = VK_FALSE,
-                                               .rasterizerDiscardEnable = VK_FALSE,
-                                               .polygonMode = VK_POLYGON_MODE_FILL,
-                                               .cullMode = VK_CULL_MODE_NONE,
-                                               .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-                                               .depthBiasEnable = VK_FALSE,
-                                               .depthBiasConstantFactor = 0.0f,
-                                               .depthBiasClamp = 0.0f,
-                                               .depthBiasSlopeFactor = 0.0f,
-                                               .lineWidth = 1.0f});
-    builder.add_viewport({.x = 0,
-                          .y = 0,
-                          .width = (float)m_core.window_size.width,
-                          .height = (float)m_core.window_size.height,
-                          .minDepth = 0,
-                          .maxDepth = 1});
-    builder.depth_stencil(true, true, VK_COMPARE_OP_LESS_OR_EQUAL);
-    builder.no_msaa();
-    builder.no_color_blend();
-
-    VkPipelineLayoutCreateInfo pipeline_layout_info{};
-    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_info.pNext = nullptr;
-    // empty defaults
-    pipeline_layout_info.flags = 0;
-    pipeline_layout_info.setLayoutCount = 0;
-    pipeline_layout_info.pSetLayouts = nullptr;
-
-    // setup push constants
-    VkPushConstantRange push_constant;
-    // this push constant range starts at the beginning
-    push_constant.offset = 0;
-    // this push constant range takes up the size of a MeshPushConstants struct
-    push_constant.size = sizeof(MeshPushConstants);
-    // this push constant range is accessible only in the vertex shader
-    push_constant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-    pipeline_layout_info.pPushConstantRanges = &push_constant;
-    pipeline_layout_info.pushConstantRangeCount = 1;
-
-    VK_CHECK_RESULT(vkCreatePipelineLayout(m_core.device, &pipeline_layout_info, nullptr, &m_pipeline_layout));
-
-    m_pipeline = builder.build(m_core.device, m_pass.render_pass, m_pipeline_layout);
+    PROFILE_SCOPE("RenderSystem::begin_frame");
+    const uint64_t kTimeout = 1'000'000'000;
+    uint32_t swap_chain_index = 0;
+    FrameData& frame = current_frame();
+
+    // wait until the GPU is done with the frame that last used these resources
+    auto wait_start = std::chrono::steady_clock::now();
+    vkWaitForFences(m_core.device, 1, &frame.fence_host, VK_TRUE, UINT64_MAX);
+    frame.descriptors.reset();
+    report_gpu_timers(frame);
+    auto acquire_start = std::chrono::steady_clock::now();
+    if (headless())
+    {
+        swap_chain_index = (uint32_t)(m_frame_number % m_frames.size());
+    }
+    else
+    {
+        VK_CHECK_RESULT(vkAcquireNextImageKHR(m_core.device, m_swapchain.swapchain_khr, kTimeout,
+                                              frame.semaphore_present, nullptr, &swap_chain_index));
+        // with more swapchain images than frames in flight an image can still be in use by an older frame
+        if (m_image_fences[swap_chain_index] != VK_NULL_HANDLE && m_image_fences[swap_chain_index] != frame.fence_host)
+        {
+            vkWaitForFences(m_core.device, 1, &m_image_fences[swap_chain_index], VK_TRUE, UINT64_MAX);
+        }
+        m_image_fences[swap_chain_index] = frame.fence_host;
+    }
+    auto wait_end = std::chrono::steady_clock::now();
+
+    m_frame_stats.frame_number = m_frame_number;
+    m_frame_stats.fence_wait_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(acquire_start - wait_start).count();
+    m_frame_stats.acquire_wait_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(wait_end - acquire_start).count();
+    if (headless())
+    {
+        // the GPU finished the copy of the frame that last used these resources
+        deliver_readback(swap_chain_index);
+    }
+
+    vkResetCommandPool(m_core.device, frame.cmd_pool, 0);
+
+    VkCommandBufferBeginInfo cmd_begin_info = {};
+    cmd_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmd_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VK_CHECK_RESULT(vkBeginCommandBuffer(frame.cmd_buf_main, &cmd_begin_info));
+    reset_gpu_timers(frame.cmd_buf_main, &frame.gpu_timers);
+    // the frame itself is always timed for frame_stats(), its parts only for the profiler
+    m_gpu_profiling = profiler::global().enabled();
+    m_gpu_frame_scope = begin_gpu_timer(frame.cmd_buf_main, &frame.gpu_timers, "gpu frame");
+    return swap_chain_index;
 }
 
-void RenderSystem::draw(Entity* entity, uint64_t elapsed_us, std::shared_ptr<Camera> camera)
+void RenderSystem::report_gpu_timers(FrameData& frame)
 {
-    float elapsed_sec = (float)(elapsed_us / 1000000.0f);
-    vkCmdBindPipeline(m_core.cmd_buf_main, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
-    // bind the mesh vertex buffer with offset 0
-
-    auto coord = entity->get_component<CoordSys>();
-    auto viz = entity->get_component<Visual3d>();
-    if (!viz)
+    // the GPU starts shortly after the submission, there is no common clock without VK_EXT_calibrated_timestamps
+    read_gpu_timers(m_core.device, &frame.gpu_timers, &m_gpu_times);
+    m_frame_stats.gpu_frame_valid = !m_gpu_times.empty();
+    if (m_gpu_times.empty())
     {
         return;
     }
-    auto& render_mesh = m_meshes[viz->hash()];
-    MeshPushConstants constants;
-    // coord->rotation() = glm::rotate(coord->rotation(), 2 * elapsed_sec, glm::vec3(1, 0, 1));
-    glm::mat4 model_mat = coord->transform();
-
-    // calculate final mesh matrix
-    glm::mat4 mvp_matrix = camera->projection_mat() * camera->view_mat() * model_mat;
-    constants.mvp_matrix = mvp_matrix;
-    // upload the matrix to the GPU via push constants
-    vkCmdPushConstants(m_core.cmd_buf_main, m_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MeshPushConstants),
-                       &constants);
-
-    VkDeviceSize offset = 0;
-    vkCmdBindVertexBuffers(m_core.cmd_buf_main, 0, 1, &render_mesh->vb(), &offset);
-    vkCmdBindIndexBuffer(m_core.cmd_buf_main, render_mesh->ib(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(m_core.cmd_buf_main, render_mesh->indices().size(), 1, 0, 0, 0);
+    // the frame scope is the first one
+    m_frame_stats.gpu_frame_number = m_frame_number - m_frames.size();
+    m_frame_stats.gpu_frame_ns = m_gpu_times[0].end_ns - m_gpu_times[0].begin_ns;
+    profiler::Profiler& profiler = profiler::global();
+    if (!profiler.enabled())
+    {
+        return;
+    }
+    for (const GpuTimerResult& t : m_gpu_times)
+    {
+        profiler.record_gpu(t.name, frame.submit_ns + t.begin_ns, frame.submit_ns + t.end_ns);
+    }
 }
 
-uint32_t RenderSystem::begin_pass(VkClearColorValue clear_color)
+void RenderSystem::begin_render_pass(uint32_t swap_chain_index, VkClearColorValue clear_color)
 {
-    const uint64_t kTimeout = 1'000'000'000;
-    uint32_t swap_chain_index = 0;
-    vkWaitForFences(m_core.device, 1, &m_core.fence_host, VK_TRUE, UINT64_MAX);
-    VK_CHECK_RESULT(vkAcquireNextImageKHR(m_core.device, m_swapchain.swapchain_khr, kTimeout, m_core.semaphore_present,
-                                          nullptr, &swap_chain_index));
-    vkResetCommandBuffer(m_core.cmd_buf_main, 0);
-
-    VkCommandBufferBeginInfo cmd_begin_info = {};
-    cmd_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-    VK_CHECK_RESULT(vkBeginCommandBuffer(m_core.cmd_buf_main, &cmd_begin_info));
-
+    PROFILE_SCOPE("RenderSystem::begin_render_pass");
+    FrameData& frame = current_frame();
     VkClearValue clearValue;
     clearValue.color = clear_color;
 
@@ -203,21 +267,53 @@ uint32_t RenderSystem::begin_pass(VkClearColorValue clear_color)
     rp_info.clearValueCount = 2;
     rp_info.pClearValues = clearValues;
 
-    vkCmdBeginRenderPass(m_core.cmd_buf_main, &rp_info, VK_SUBPASS_CONTENTS_INLINE);
-
-    return swap_chain_index;
+    m_gpu_pass_scope = UINT32_MAX;
+    if (m_gpu_profiling)
+    {
+        m_gpu_pass_scope = begin_gpu_timer(frame.cmd_buf_main, &frame.gpu_timers, "gpu render pass");
+    }
+    // all draws are recorded into secondary command buffers, see present_pass
+    vkCmdBeginRenderPass(frame.cmd_buf_main, &rp_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 }
 
-void RenderSystem::present_pass(uint32_t swap_chain_index)
+void RenderSystem::present_pass(uint32_t swap_chain_index, uint32_t recorded_count)
 {
-    vkCmdEndRenderPass(m_core.cmd_buf_main);
-    VK_CHECK_RESULT(vkEndCommandBuffer(m_core.cmd_buf_main));
+    PROFILE_SCOPE("RenderSystem::present_pass");
+    FrameData& frame = current_frame();
+    if (recorded_count > 0)
+    {
+        vkCmdExecuteCommands(frame.cmd_buf_main, recorded_count, frame.recording.cmd_bufs.data());
+    }
+    vkCmdEndRenderPass(frame.cmd_buf_main);
+    end_gpu_timer(frame.cmd_buf_main, frame.gpu_timers, m_gpu_pass_scope);
+    if (headless() && m_readback)
+    {
+        const uint32_t readback_scope =
+            m_gpu_profiling ? begin_gpu_timer(frame.cmd_buf_main, &frame.gpu_timers, "gpu readback") : UINT32_MAX;
+        record_readback(frame.cmd_buf_main, m_swapchain.swapchain_images[swap_chain_index], m_frame_number,
+                        &m_readbacks[swap_chain_index]);
+        end_gpu_timer(frame.cmd_buf_main, frame.gpu_timers, readback_scope);
+    }
+    end_gpu_timer(frame.cmd_buf_main, frame.gpu_timers, m_gpu_frame_scope);
+    VK_CHECK_RESULT(vkEndCommandBuffer(frame.cmd_buf_main));
 
     VkSubmitInfo submit_info = {};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submit_info.pNext = nullptr;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &frame.cmd_buf_main;
+
+    vkResetFences(m_core.device, 1, &frame.fence_host);
+    frame.submit_ns = profiler::now_ns();
+    if (headless())
+    {
+        // nothing to acquire or present, the fence tells when the image and its readback are done
+        VK_CHECK_RESULT(vkQueueSubmit(m_core.graphics_queue, 1, &submit_info, frame.fence_host));
+        m_frame_number++;
+        return;
+    }
 
-    VkSemaphore wait_semaphores[] = {m_core.semaphore_present};
+    VkSemaphore wait_semaphores[] = {frame.semaphore_present};
     VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
 
     submit_info.waitSemaphoreCount = 1;
@@ -225,14 +321,9 @@ void RenderSystem::present_pass(uint32_t swap_chain_index)
     submit_info.pWaitDstStageMask = wait_stages;
 
     submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = &m_core.semaphore_render;
-
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &m_core.cmd_buf_main;
+    submit_info.pSignalSemaphores = &frame.semaphore_render;
 
-    vkResetFences(m_core.device, 1, &m_core.fence_host);
-
-    vkQueueSubmit(m_core.graphics_queue, 1, &submit_info, m_core.fence_host);
+    vkQueueSubmit(m_core.graphics_queue, 1, &submit_info, frame.fence_host);
 
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -242,39 +333,236 @@ void RenderSystem::present_pass(uint32_t swap_chain_index)
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &swap_chain_index;
 
-    presentInfo.pWaitSemaphores = &m_core.semaphore_render;
+    presentInfo.pWaitSemaphores = &frame.semaphore_render;
     presentInfo.waitSemaphoreCount = 1;
 
     vkQueuePresentKHR(m_core.present_queue, &presentInfo);
+    m_frame_number++;
+}
+
+void RenderSystem::deliver_readback(size_t frame_index)
+{
+    ReadbackData& rb = m_readbacks[frame_index];
+    if (rb.pending)
+    {
+        const ReadbackImage image = read_readback(&rb);
+        if (m_readback)
+        {
+            m_readback(image);
+        }
+    }
+}
+
+void RenderSystem::finish_readbacks()
+{
+    // oldest frame first, so the callback sees the frames in order
+    for (size_t i = 0; i < m_readbacks.size(); i++)
+    {
+        const size_t frame_index = (m_frame_number + i) % m_frames.size();
+        vkWaitForFences(m_core.device, 1, &m_frames[frame_index].fence_host, VK_TRUE, UINT64_MAX);
+        deliver_readback(frame_index);
+    }
+}
+
+bool RenderSystem::mesh_pipeline_ready(VertexFormat format)
+{
+    VkPipeline& solid = m_solid_pipelines[(uint32_t)format];
+    if (solid == VK_NULL_HANDLE)
+    {
+        // only the standard pipeline is built with the renderer, most scenes have no compact meshes
+        solid = m_pipelines.request(mesh_pipeline_builder(m_mesh_pipeline, VK_POLYGON_MODE_FILL, format),
+                                    m_mesh_pipeline.pass, m_mesh_pipeline.pipeline_layout);
+    }
+    return solid != VK_NULL_HANDLE;
+}
+
+VkPipeline RenderSystem::mesh_pipeline(VertexFormat format)
+{
+    const VkPipeline solid = m_solid_pipelines[(uint32_t)format];
+    if (solid == VK_NULL_HANDLE || shading_mode() == ShadingMode::solid)
+    {
+        return solid;
+    }
+    VkPipeline& wireframe = m_wireframe_pipelines[(uint32_t)format];
+    if (wireframe == VK_NULL_HANDLE)
+    {
+        wireframe = m_pipelines.request(mesh_pipeline_builder(m_mesh_pipeline, VK_POLYGON_MODE_LINE, format),
+                                        m_mesh_pipeline.pass, m_mesh_pipeline.pipeline_layout);
+    }
+    return wireframe != VK_NULL_HANDLE ? wireframe : solid;
 }
 
-void RenderSystem::process(const std::vector<Entity>& entities, uint64_t elapsed_us)
+void RenderSystem::process(Registry& registry, uint64_t elapsed_us)
 {
-    std::shared_ptr<Camera> main_camera;
-    for (auto e : entities)
+    PROFILE_SCOPE("RenderSystem::process");
+    // find the main camera in the entities
+    Camera* main_camera = nullptr;
+    m_cameras.each(registry, [&main_camera](Entity, Camera& cam) { main_camera = &cam; });
+
+    // the draw list keeps its capacity between frames
+    const DrawMode mode = draw_mode();
+    const bool cull_on_cpu = mode != DrawMode::gpu_culled;
+    m_draw_list.clear();
+    m_bounds.clear();
+    m_transforms.clear();
+    m_meshes.begin_frame();
+    {
+        PROFILE_SCOPE("TransformHierarchy::update");
+        m_hierarchy.update(&m_pool);
+    }
+    uint32_t uploading = 0;
+    // checked once per frame instead of per drawable, the missing pipelines are requested after the loop
+    bool pipeline_ready[kVertexFormatCount];
+    bool pipeline_needed[kVertexFormatCount] = {};
+    for (uint32_t f = 0; f < kVertexFormatCount; f++)
     {
-        // find the main camera in the entities
-        if (auto cam = e.get_component<Camera>(); cam != nullptr)
+        pipeline_ready[f] = m_solid_pipelines[f] != VK_NULL_HANDLE;
+    }
+    m_drawables.each(registry, [this, main_camera, cull_on_cpu, &uploading, &pipeline_ready,
+                                &pipeline_needed](Entity, CoordSys& coord, Visual3d& viz) {
+        // culling and the model matrices below read the world transform from the coordinate system
+        if (coord.node() != TransformHierarchy::kNone && m_hierarchy.valid(coord.node()))
+        {
+            coord.position() = m_hierarchy.world_position(coord.node());
+            coord.rotation() = m_hierarchy.world_rotation(coord.node());
+        }
+        // acquire even without a camera, so meshes stay alive while nothing is drawn
+        Mesh* mesh = m_meshes.acquire(viz);
+        // meshes still being uploaded are drawn once the transfer completed, and the pipeline of their format built
+        const uint32_t format = (uint32_t)mesh->format();
+        if (!pipeline_ready[format])
         {
-            main_camera = cam;
+            pipeline_needed[format] = true;
+            uploading++;
         }
-        if (auto viz = e.get_component<Visual3d>(); viz != nullptr)
+        else if (!m_uploads.is_complete(mesh->upload_batch()))
         {
-            size_t viz_com_hash = viz->hash();
-            if (m_meshes.find(viz_com_hash) == m_meshes.end())
+            uploading++;
+        }
+        else if (main_camera != nullptr)
+        {
+            m_draw_list.push_back(DrawItem{&coord, mesh});
+            if (cull_on_cpu)
             {
-                m_meshes[viz_com_hash] = create_mesh_from_vertex_data(viz->vertices(), viz->indices());
-                m_meshes[viz_com_hash]->create(m_core.allocator);
+                // the transform is rigid, so the sphere keeps its radius
+                const Bounds& bounds = viz.bounds();
+                m_bounds.push_back(coord.position() + coord.rotation() * bounds.center, bounds.radius);
             }
         }
+    });
+    for (uint32_t f = 0; f < kVertexFormatCount; f++)
+    {
+        if (pipeline_needed[f])
+        {
+            mesh_pipeline_ready((VertexFormat)f);
+        }
     }
-    uint32_t swap_chain_index = begin_pass({0.4, 0.2, 0.5});
-    for (auto e : entities)
+    // everything derived from the camera is computed once per frame, the shaders read it from a uniform buffer
+    CameraUniforms camera = make_camera_uniforms(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f));
+    m_culling_stats = CullingStats();
+    if (main_camera != nullptr)
     {
-        draw(&e, elapsed_us, main_camera);
+        camera = make_camera_uniforms(main_camera->view_mat(), main_camera->projection_mat(), main_camera->position());
     }
-
-    present_pass(swap_chain_index);
+    if (main_camera != nullptr && cull_on_cpu)
+    {
+        m_visible.resize(m_draw_list.size());
+        m_culling_stats = m_bounds.cull(camera.frustum, m_visible.data());
+        size_t kept = 0;
+        for (size_t i = 0; i < m_draw_list.size(); i++)
+        {
+            if (m_visible[i])
+            {
+                m_draw_list[kept++] = m_draw_list[i];
+            }
+        }
+        m_draw_list.resize(kept);
+    }
+    // the model matrices are computed in one batch below, from the transforms of the remaining items
+    for (const DrawItem& item : m_draw_list)
+    {
+        push_model_transform(&m_transforms, item);
+    }
+    // all meshes created this frame go to the transfer queue in one submission
+    m_uploads.flush();
+    // meshes dropped frames_in_flight frames ago are no longer read by the GPU
+    m_meshes.collect();
+
+    uint32_t swap_chain_index = begin_frame();
+    m_frame_stats.draw_count = 0;
+    m_frame_stats.instance_count = (uint32_t)m_draw_list.size();
+    m_frame_stats.uploading = uploading;
+    uint32_t recorded_count = 0;
+    if (!m_draw_list.empty())
+    {
+        PROFILE_SCOPE("RenderSystem::record");
+        // entities sharing a mesh become one instanced draw, begin_frame made sure the GPU is done with the buffers
+        FrameData& frame = current_frame();
+        memcpy(frame.camera.data, &camera, sizeof(CameraUniforms));
+        flush_host_buffer(frame.camera, sizeof(CameraUniforms));
+        const VkDeviceSize instances_size = m_draw_list.size() * sizeof(InstanceAttributes);
+        reserve_host_buffer(&frame.instances, instances_size);
+        const std::vector<InstanceBatch>& batches = m_batcher.build(m_draw_list);
+        m_frame_stats.draw_count = (uint32_t)batches.size();
+        m_transforms.write_models(m_batcher.instance_indices().data(), (InstanceAttributes*)frame.instances.data);
+        flush_host_buffer(frame.instances, instances_size);
+
+        DrawState state = {};
+        state.render_pass = m_pass.render_pass;
+        state.framebuffer = m_pass.frame_buffers[swap_chain_index];
+        state.pipeline = mesh_pipeline(VertexFormat::standard);
+        state.pipeline_layout = m_mesh_pipeline.pipeline_layout;
+        state.vertex_buffer = m_geometry.vertex_buffer();
+        state.index_buffer = m_geometry.index_buffer();
+        // the compact pipelines are only requested once there are compact meshes
+        state.compact_pipeline =
+            m_batcher.compact_batch_count() > 0 ? mesh_pipeline(VertexFormat::compact) : VK_NULL_HANDLE;
+        state.compact_vertex_buffer = m_geometry.vertex_buffer(VertexFormat::compact);
+        const VkDeviceSize commands_size = batches.size() * sizeof(VkDrawIndexedIndirectCommand);
+        const bool multi_draw = m_core.multi_draw_indirect && m_settings.multi_draw_indirect;
+        if (mode == DrawMode::gpu_culled)
+        {
+            // the compute shader goes into the main command buffer ahead of the render pass
+            GpuCullingData& gc = m_gpu_culling[m_frame_number % m_gpu_culling.size()];
+            const uint32_t instance_count = (uint32_t)m_draw_list.size();
+            reserve_gpu_culling(&gc, instance_count);
+            reserve_host_buffer(&frame.draw_commands, commands_size);
+            write_cull_inputs(batches, (GpuCullObject*)gc.objects.data,
+                              (VkDrawIndexedIndirectCommand*)frame.draw_commands.data);
+            flush_host_buffer(gc.objects, instance_count * sizeof(GpuCullObject));
+            flush_host_buffer(frame.draw_commands, commands_size);
+            const uint32_t cull_scope =
+                m_gpu_profiling ? begin_gpu_timer(frame.cmd_buf_main, &frame.gpu_timers, "gpu culling") : UINT32_MAX;
+            record_gpu_culling(m_core.device, frame.cmd_buf_main, m_cull_pipeline, gc, &frame.descriptors,
+                               camera.frustum, frame.instances, frame.draw_commands, instance_count);
+            end_gpu_timer(frame.cmd_buf_main, frame.gpu_timers, cull_scope);
+            // the vertex shader reads the compacted models instead of all of them
+            state.frame_set =
+                write_mesh_set(m_core.device, &frame.descriptors, m_mesh_pipeline, frame.camera.buffer, gc.instances);
+            recorded_count = record_indirect_draws(m_core.device, &frame.recording, state, frame.draw_commands.buffer,
+                                                   (uint32_t)batches.size(), multi_draw,
+                                                   m_batcher.compact_batch_count());
+        }
+        else if (mode == DrawMode::indirect)
+        {
+            reserve_host_buffer(&frame.draw_commands, commands_size);
+            write_draw_commands(batches, (VkDrawIndexedIndirectCommand*)frame.draw_commands.data);
+            flush_host_buffer(frame.draw_commands, commands_size);
+            state.frame_set = write_mesh_set(m_core.device, &frame.descriptors, m_mesh_pipeline, frame.camera.buffer,
+                                             frame.instances.buffer);
+            recorded_count = record_indirect_draws(m_core.device, &frame.recording, state, frame.draw_commands.buffer,
+                                                   (uint32_t)batches.size(), multi_draw,
+                                                   m_batcher.compact_batch_count());
+        }
+        else
+        {
+            state.frame_set = write_mesh_set(m_core.device, &frame.descriptors, m_mesh_pipeline, frame.camera.buffer,
+                                             frame.instances.buffer);
+            recorded_count = record_draws(m_core.device, &frame.recording, m_pool, state, batches);
+        }
+    }
+    begin_render_pass(swap_chain_index, {0.4, 0.2, 0.5});
+    present_pass(swap_chain_index, recorded_count);
 }
 
 } // namespace rendersystem
\ No newline at end of file
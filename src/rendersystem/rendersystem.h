@@ -2,15 +2,36 @@
 
 #include "VkBootstrap.h"
 #include "camera.h"
+#include "camerauniforms.h"
+#include "coordsys.h"
 #include "core.h"
+#include "culling.h"
+#include "descriptors.h"
 #include "entity.h"
+#include "frame.h"
+#include "geometry.h"
+#include "gpuculling.h"
+#include "instances.h"
 #include "mesh.h"
+#include "meshregistry.h"
 #include "pass.h"
+#include "pipeline.h"
+#include "pipelinecache.h"
+#include "pipelineregistry.h"
+#include "readback.h"
+#include "recording.h"
 #include "swapchain.h"
+#include "threadpool.h"
+#include "transformhierarchy.h"
+#include "upload.h"
+#include "view.h"
+#include "visual.h"
 #include <algorithm>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <mesh.h>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
 namespace rendersystem
@@ -40,30 +61,216 @@ std::unique_ptr<Mesh> create_mesh_from_vertex_data(const std::vector<T>& vertice
     return std::move(render_mesh);
 }
 
+// create a mesh from the vertices of the visual, without converting or copying them on the CPU unless format is compact
+std::unique_ptr<Mesh> create_mesh_from_visual(const components::Visual3d& viz, GeometryArena& arena,
+                                              UploadManager& uploads, VertexFormat format = VertexFormat::standard);
+
+enum class DrawMode
+{
+    direct,   // one vkCmdDrawIndexed per instance batch, recorded on all recording threads
+    indirect, // one vkCmdDrawIndexedIndirect over a per-frame buffer of draw commands
+    // like indirect, but a compute shader culls the instances against the frustum and writes the draw commands
+    gpu_culled,
+};
+
+enum class ShadingMode
+{
+    solid,
+    wireframe, // needs CoreData::fill_mode_non_solid
+};
+
+struct RenderSettings
+{
+    // threads recording draw commands, 0 uses one thread per hardware core
+    uint32_t recording_threads = 0;
+    // frames the CPU may record ahead of the GPU
+    uint32_t frames_in_flight = 2;
+    // capacity of the vertex and index buffers shared by all meshes, the vertices in vertex_format
+    uint32_t geometry_max_vertices = 1u << 20;
+    uint32_t geometry_max_indices = 1u << 22;
+    // of all meshes, Visual3d::set_compact_vertices selects VertexFormat::compact for single ones
+    VertexFormat vertex_format = VertexFormat::standard;
+    // capacity of a second vertex buffer for the meshes Visual3d::set_compact_vertices selected, if vertex_format is
+    // standard. Without one, drawing such a mesh throws
+    uint32_t geometry_max_compact_vertices = 0;
+    // size of the staging ring for uploads to device-local memory
+    uint64_t staging_size = 16ull << 20;
+    // initial capacity of the per-frame instance buffers, they grow on demand
+    uint32_t instance_capacity = 1024;
+    // falls back to DrawMode::direct if the device cannot draw indirect with an instance offset
+    DrawMode draw_mode = DrawMode::direct;
+    // execute all indirect draw commands of a vertex format with one call, falls back to one call per command if the
+    // device has no multiDrawIndirect
+    bool multi_draw_indirect = true;
+    // falls back to ShadingMode::solid if the device cannot draw wireframes
+    ShadingMode shading_mode = ShadingMode::solid;
+    // compiled pipelines are kept here between runs, empty to compile them on every start
+    std::string pipeline_cache_path = "pipeline_cache.bin";
+    // color format of the offscreen images of RenderSystem::create_headless
+    VkFormat offscreen_format = VK_FORMAT_R8G8B8A8_UNORM;
+    // Vulkan validation layers, which slow down every call and are missing on most CI and render farm machines
+    bool validation_layers = false;
+};
+
+/**
+ * Time spent in RenderSystem::create, with a cold or warm pipeline cache.
+ */
+struct StartupStats
+{
+    bool pipeline_cache_warm = false; // the pipeline cache file was valid for this device and driver
+    uint64_t pipeline_cache_size = 0; // bytes loaded from the pipeline cache file
+    uint64_t pipelines_us = 0;        // creating all pipelines, including loading the shader modules
+    uint64_t create_us = 0;           // all of RenderSystem::create
+};
+
+/**
+ * Time the CPU spent blocked on the GPU at the beginning of a frame, and what the frame drew.
+ */
+struct FrameStats
+{
+    uint64_t frame_number = 0;
+    uint64_t fence_wait_us = 0;   // waiting for the frame resources to be released by the GPU
+    uint64_t acquire_wait_us = 0; // waiting for the next swapchain image, 0 when headless
+    uint32_t draw_count = 0;      // instance batches, each one draw call or indirect draw command
+    uint32_t instance_count = 0;  // instances drawn, for DrawMode::gpu_culled before culling
+    uint32_t uploading = 0;       // drawables skipped because their mesh is still being uploaded or its pipeline built
+    // GPU time of the earlier frame whose resources begin_frame reused, if the device has timestamps
+    bool gpu_frame_valid = false;
+    uint64_t gpu_frame_number = 0;
+    uint64_t gpu_frame_ns = 0;
+};
+
 class RenderSystem
 {
   public:
-    RenderSystem();
+    explicit RenderSystem(const RenderSettings& settings = RenderSettings());
     GLFWwindow* create(uint32_t width, uint32_t height);
+    // render into offscreen images instead of a window, e.g. on a render farm or in CI. Nothing is presented, the
+    // frames can be read back with set_readback()
+    void create_headless(uint32_t width, uint32_t height);
+    // hands the frames still being read back to the readback callback
     void destroy();
-    void process(const std::vector<components::Entity>& entities, uint64_t elapsed_us);
+    void process(components::Registry& registry, uint64_t elapsed_us);
+    /**
+     * Parent/child transforms of the drawables whose CoordSys is attached to one. process() updates the dirty ones,
+     * on the recording threads, and copies the world transforms into the attached CoordSys before drawing.
+     */
+    components::TransformHierarchy& transform_hierarchy()
+    {
+        return m_hierarchy;
+    }
+    // takes effect with the next frame
+    void set_draw_mode(DrawMode mode)
+    {
+        m_settings.draw_mode = mode;
+    }
+    // the mode frames are drawn with, valid after create()
+    DrawMode draw_mode() const
+    {
+        return m_core.draw_indirect_first_instance ? m_settings.draw_mode : DrawMode::direct;
+    }
+    // takes effect with the next frame. The first switch to a mode builds its pipeline in the background, until then
+    // frames are drawn solid
+    void set_shading_mode(ShadingMode mode)
+    {
+        m_settings.shading_mode = mode;
+    }
+    // the mode frames are drawn with, valid after create()
+    ShadingMode shading_mode() const
+    {
+        return m_core.fill_mode_non_solid ? m_settings.shading_mode : ShadingMode::solid;
+    }
+    /**
+     * Copy every frame to host memory and call callback with it once the GPU finished the frame, which is up to
+     * frames_in_flight frames later, so the copies run asynchronously. Frames are passed in order. Headless only, an
+     * empty callback stops the copies.
+     */
+    void set_readback(std::function<void(const ReadbackImage&)> callback)
+    {
+        m_readback = std::move(callback);
+    }
+    // wait for the GPU and hand all frames still being read back to the readback callback
+    void finish_readbacks();
+    // valid after create()
+    const StartupStats& startup_stats() const
+    {
+        return m_startup_stats;
+    }
+    // stats of the most recently begun frame
+    const FrameStats& frame_stats() const
+    {
+        return m_frame_stats;
+    }
+    // visible and culled drawables of the last frame, culled on the CPU. Empty for DrawMode::gpu_culled
+    const CullingStats& culling_stats() const
+    {
+        return m_culling_stats;
+    }
 
   private:
-    void create_pipeline();
-    void draw(components::Entity* entity, uint64_t elapsed_us, std::shared_ptr<components::Camera> camera);
-    uint32_t begin_pass(VkClearColorValue clear_color);
-    void present_pass(uint32_t swap_chain_index);
+    // everything below the swapchain, create_start is when create() or create_headless() began
+    void create_renderer(std::chrono::steady_clock::time_point create_start);
+    bool headless() const
+    {
+        return m_swapchain.swapchain_khr == VK_NULL_HANDLE;
+    }
+    FrameData& current_frame()
+    {
+        return m_frames[m_frame_number % m_frames.size()];
+    }
+    // wait for the frame resources, acquire the next swapchain image and begin the main command buffer. Headless, the
+    // image is the one of the frame and the frame's previous readback is handed out
+    uint32_t begin_frame();
+    void deliver_readback(size_t frame_index);
+    // hand the GPU times of the frame's previous use to the frame stats and the profiler, after its fence was waited on
+    void report_gpu_timers(FrameData& frame);
+    void begin_render_pass(uint32_t swap_chain_index, VkClearColorValue clear_color);
+    void present_pass(uint32_t swap_chain_index, uint32_t recorded_count);
+    // the pipeline of the shading mode and vertex format, the solid one while it is still being built
+    VkPipeline mesh_pipeline(VertexFormat format);
+    // whether meshes of the format can be drawn, requests the solid pipeline of a format that is not. Called once per
+    // frame for the formats of the drawables whose pipeline was missing at the beginning of process()
+    bool mesh_pipeline_ready(VertexFormat format);
 
   private:
     rendersystem::CoreData m_core;
     rendersystem::SwapChainData m_swapchain;
     rendersystem::PassData m_pass;
+    rendersystem::DescriptorLayoutCache m_layouts; // set layouts of all pipelines
+    rendersystem::PipelineCacheData m_pipeline_cache;
+    rendersystem::PipelineRegistry m_pipelines;
+    rendersystem::MeshPipelineData m_mesh_pipeline;
+    VkPipeline m_solid_pipelines[kVertexFormatCount] = {};     // standard from m_mesh_pipeline, the others requested
+    VkPipeline m_wireframe_pipelines[kVertexFormatCount] = {}; // from m_pipelines once requested and built
+    rendersystem::CullPipelineData m_cull_pipeline;
+    std::vector<FrameData> m_frames;
+    std::vector<GpuCullingData> m_gpu_culling; // per frame in flight, parallel to m_frames
+    std::vector<VkFence> m_image_fences; // fence of the frame last rendering to each swapchain image
+    std::vector<ReadbackData> m_readbacks;  // per frame in flight, parallel to m_frames. Headless only
+    std::function<void(const ReadbackImage&)> m_readback;
+    std::vector<GpuTimerResult> m_gpu_times;
+    bool m_gpu_profiling = false;             // the frame being recorded has timer scopes for the profiler
+    uint32_t m_gpu_frame_scope = UINT32_MAX; // timer scopes of the frame being recorded
+    uint32_t m_gpu_pass_scope = UINT32_MAX;
+    uint64_t m_frame_number = 0;
+    FrameStats m_frame_stats;
+    StartupStats m_startup_stats;
+
+    RenderSettings m_settings;
+    jobs::ThreadPool m_pool;
+    components::TransformHierarchy m_hierarchy;
+    std::vector<DrawItem> m_draw_list;
+    BoundingSpheres m_bounds;     // world-space bounds per item of m_draw_list
+    ModelTransforms m_transforms; // per item of m_draw_list after culling
+    std::vector<uint8_t> m_visible;
+    CullingStats m_culling_stats;
+    InstanceBatcher m_batcher;
 
-    VkPipeline m_pipeline;
-    VkPipelineLayout m_pipeline_layout;
-    VkShaderModule m_triangle_frag;
-    VkShaderModule m_triangle_vert;
+    GeometryArena m_geometry;
+    UploadManager m_uploads;
+    MeshRegistry m_meshes;
 
-    std::unordered_map<std::size_t, std::unique_ptr<Mesh>> m_meshes;
+    components::View<components::Camera> m_cameras;
+    components::View<components::CoordSys, components::Visual3d> m_drawables;
 };
 } // namespace rendersystem
\ No newline at end of file
@@ -7,17 +7,26 @@ layout(location = 2) in vec3 vColor;
 
 layout(location = 0) out vec3 outColor;
 
-// push constants block
-layout(push_constant) uniform constants
+// per-frame camera, see CameraUniforms
+layout(set = 0, binding = 0) uniform Camera
 {
-    vec4 data;
-    mat4 mvp_matrix;
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 frustum_planes[6];
+    vec4 position;
 }
-PushConstants;
+camera;
+
+// per-instance model matrices, see InstanceAttributes. gl_InstanceIndex includes the first instance of the draw
+layout(std430, set = 0, binding = 1) readonly buffer Instances
+{
+    mat4 models[];
+};
 
 void main()
 {
     // output the position of each vertex
-    gl_Position = PushConstants.mvp_matrix * vec4(vPosition, 1.0f);
+    gl_Position = camera.view_proj * models[gl_InstanceIndex] * vec4(vPosition, 1.0f);
     outColor = vNormal;
-}
\ No newline at end of file
+}
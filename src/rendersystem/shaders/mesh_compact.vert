@@ -0,0 +1,43 @@
+// mesh.vert for vertices in VertexFormat::compact, see CompactVertex
+#version 450
+
+// 16 bit unsigned normalized, the instance model matrices include the PositionDecode of the mesh
+layout(location = 0) in vec3 vPosition;
+// octahedral encoding, 16 bit signed normalized
+layout(location = 1) in vec2 vNormal;
+layout(location = 2) in vec3 vColor;
+
+layout(location = 0) out vec3 outColor;
+
+// per-frame camera, see CameraUniforms
+layout(set = 0, binding = 0) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 view_proj;
+    vec4 frustum_planes[6];
+    vec4 position;
+}
+camera;
+
+// per-instance model matrices, see InstanceAttributes. gl_InstanceIndex includes the first instance of the draw
+layout(std430, set = 0, binding = 1) readonly buffer Instances
+{
+    mat4 models[];
+};
+
+// same as octahedral_decode in vertexformat.cpp
+vec3 octahedral_decode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0f);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0f)));
+    return normalize(n);
+}
+
+void main()
+{
+    // output the position of each vertex
+    gl_Position = camera.view_proj * models[gl_InstanceIndex] * vec4(vPosition, 1.0f);
+    outColor = octahedral_decode(vNormal);
+}
@@ -0,0 +1,155 @@
+#include "suballocator.h"
+#include <cassert>
+#include <stdexcept>
+
+namespace rendersystem
+{
+
+SubAllocator::SubAllocator(uint64_t capacity) : m_capacity(capacity), m_used(0)
+{
+    if (capacity > 0)
+    {
+        insert_free(0, capacity);
+    }
+}
+
+uint64_t SubAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0)
+    {
+        return kInvalidOffset;
+    }
+    // smallest free range that fits, padding for the alignment may require trying larger ones
+    for (auto it = m_free_by_size.lower_bound(size); it != m_free_by_size.end(); it++)
+    {
+        const uint64_t range_size = it->first;
+        const uint64_t range_offset = it->second;
+        const uint64_t offset = (range_offset + alignment - 1) / alignment * alignment;
+        const uint64_t padding = offset - range_offset;
+        if (padding + size > range_size)
+        {
+            continue;
+        }
+        erase_free(range_offset, range_size);
+        if (padding > 0)
+        {
+            insert_free(range_offset, padding);
+        }
+        if (padding + size < range_size)
+        {
+            insert_free(offset + size, range_size - padding - size);
+        }
+        m_allocated[offset] = size;
+        m_used += size;
+        return offset;
+    }
+    return kInvalidOffset;
+}
+
+void SubAllocator::free(uint64_t offset)
+{
+    auto alloc = m_allocated.find(offset);
+    if (alloc == m_allocated.end())
+    {
+        throw std::runtime_error("SubAllocator: freeing an offset that was not allocated");
+    }
+    uint64_t size = alloc->second;
+    m_allocated.erase(alloc);
+    m_used -= size;
+
+    // merge with the free ranges directly after and before
+    auto next = m_free_by_offset.lower_bound(offset);
+    if (next != m_free_by_offset.end() && next->first == offset + size)
+    {
+        uint64_t next_size = next->second;
+        erase_free(next->first, next_size);
+        size += next_size;
+    }
+    auto prev = m_free_by_offset.lower_bound(offset);
+    if (prev != m_free_by_offset.begin())
+    {
+        prev--;
+        if (prev->first + prev->second == offset)
+        {
+            uint64_t prev_offset = prev->first;
+            uint64_t prev_size = prev->second;
+            erase_free(prev_offset, prev_size);
+            offset = prev_offset;
+            size += prev_size;
+        }
+    }
+    insert_free(offset, size);
+}
+
+SubAllocatorStats SubAllocator::stats() const
+{
+    SubAllocatorStats s;
+    s.capacity = m_capacity;
+    s.used = m_used;
+    s.free = m_capacity - m_used;
+    s.largest_free = m_free_by_size.empty() ? 0 : m_free_by_size.rbegin()->first;
+    s.allocation_count = (uint32_t)m_allocated.size();
+    s.free_range_count = (uint32_t)m_free_by_offset.size();
+    return s;
+}
+
+void SubAllocator::insert_free(uint64_t offset, uint64_t size)
+{
+    m_free_by_offset[offset] = size;
+    m_free_by_size.emplace(size, offset);
+}
+
+void SubAllocator::erase_free(uint64_t offset, uint64_t size)
+{
+    m_free_by_offset.erase(offset);
+    auto range = m_free_by_size.equal_range(size);
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (it->second == offset)
+        {
+            m_free_by_size.erase(it);
+            return;
+        }
+    }
+    assert(false && "free range missing from the size index");
+}
+
+RingAllocator::RingAllocator(uint64_t capacity) : m_capacity(capacity), m_head(0), m_tail(0)
+{
+}
+
+uint64_t RingAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0 || size > m_capacity)
+    {
+        return kInvalidOffset;
+    }
+    if (m_head == m_tail)
+    {
+        // nothing in use, restart at the beginning of the ring to avoid wasting the end
+        m_head = m_tail = (m_head + m_capacity - 1) / m_capacity * m_capacity;
+    }
+    const uint64_t pos = m_head % m_capacity;
+    uint64_t offset = (pos + alignment - 1) / alignment * alignment;
+    uint64_t start = m_head + (offset - pos);
+    if (offset + size > m_capacity)
+    {
+        // skip the rest of the ring
+        offset = 0;
+        start = m_head + (m_capacity - pos);
+    }
+    if (start + size - m_tail > m_capacity)
+    {
+        return kInvalidOffset;
+    }
+    m_head = start + size;
+    return offset;
+}
+
+void RingAllocator::release(uint64_t head)
+{
+    assert(head >= m_tail && head <= m_head);
+    m_tail = head;
+}
+
+} // namespace rendersystem
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+namespace rendersystem
+{
+
+struct SubAllocatorStats
+{
+    uint64_t capacity = 0;
+    uint64_t used = 0;
+    uint64_t free = 0;
+    uint64_t largest_free = 0; // size of the largest free range
+    uint32_t allocation_count = 0;
+    uint32_t free_range_count = 0;
+
+    // 0 when all free space is one contiguous range, approaching 1 when it is scattered in small pieces
+    float fragmentation() const
+    {
+        return free == 0 ? 0.0f : 1.0f - (float)largest_free / (float)free;
+    }
+};
+
+/**
+ * Best-fit free-list allocator handing out ranges of [0, capacity). It works in abstract units (bytes, vertices,
+ * indices) and never touches the memory it manages. Neighbouring free ranges are merged when freeing.
+ */
+class SubAllocator
+{
+  public:
+    static constexpr uint64_t kInvalidOffset = UINT64_MAX;
+
+    explicit SubAllocator(uint64_t capacity = 0);
+    // returns kInvalidOffset if no free range can hold size units at the given alignment
+    uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+    // offset must have been returned by allocate
+    void free(uint64_t offset);
+    SubAllocatorStats stats() const;
+    uint64_t capacity() const
+    {
+        return m_capacity;
+    }
+
+  private:
+    void insert_free(uint64_t offset, uint64_t size);
+    void erase_free(uint64_t offset, uint64_t size);
+
+  private:
+    uint64_t m_capacity;
+    uint64_t m_used;
+    std::map<uint64_t, uint64_t> m_free_by_offset;     // offset -> size, ordered to find neighbours
+    std::multimap<uint64_t, uint64_t> m_free_by_size;   // size -> offset, ordered for best fit
+    std::unordered_map<uint64_t, uint64_t> m_allocated; // offset -> size
+};
+
+/**
+ * Ring allocator for transient data, e.g. staging memory. Ranges are handed out in order and released in the same
+ * order by passing a former head() to release(). A range never wraps around the end of the ring.
+ */
+class RingAllocator
+{
+  public:
+    static constexpr uint64_t kInvalidOffset = UINT64_MAX;
+
+    explicit RingAllocator(uint64_t capacity = 0);
+    // returns kInvalidOffset if the unreleased ranges leave no room for size units at the given alignment
+    uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+    // release all ranges allocated before head() returned the given value
+    void release(uint64_t head);
+    // monotonic position of the next allocation, not an offset into the ring
+    uint64_t head() const
+    {
+        return m_head;
+    }
+    uint64_t used() const
+    {
+        return m_head - m_tail;
+    }
+    uint64_t capacity() const
+    {
+        return m_capacity;
+    }
+
+  private:
+    uint64_t m_capacity;
+    uint64_t m_head; // both grow monotonically, the ring offset is the value modulo capacity
+    uint64_t m_tail;
+};
+
+} // namespace rendersystem
@@ -7,6 +7,25 @@
 namespace rendersystem
 {
 
+static VkImageView create_image_view(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect)
+{
+    VkImageViewCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    info.pNext = nullptr;
+
+    info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    info.image = image;
+    info.format = format;
+    info.subresourceRange.baseMipLevel = 0;
+    info.subresourceRange.levelCount = 1;
+    info.subresourceRange.baseArrayLayer = 0;
+    info.subresourceRange.layerCount = 1;
+    info.subresourceRange.aspectMask = aspect;
+    VkImageView view;
+    VK_CHECK_RESULT(vkCreateImageView(device, &info, nullptr, &view));
+    return view;
+}
+
 static void create_depth_image(const CoreData& core_data, VkImage* depth_img, VkImageView* depth_img_view,
                                VmaAllocation* alloc, VkFormat format)
 {
@@ -35,21 +54,7 @@ static void create_depth_image(const CoreData& core_data, VkImage* depth_img, Vk
     vmaCreateImage(core_data.allocator, &dimg_info, &dimg_allocinfo, depth_img, alloc, nullptr);
 
     // build a image-view for the depth image to use for rendering
-    {
-        VkImageViewCreateInfo info = {};
-        info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        info.pNext = nullptr;
-
-        info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        info.image = *depth_img;
-        info.format = dimg_info.format;
-        info.subresourceRange.baseMipLevel = 0;
-        info.subresourceRange.levelCount = 1;
-        info.subresourceRange.baseArrayLayer = 0;
-        info.subresourceRange.layerCount = 1;
-        info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-        VK_CHECK_RESULT(vkCreateImageView(core_data.device, &info, nullptr, depth_img_view));
-    }
+    *depth_img_view = create_image_view(core_data.device, *depth_img, dimg_info.format, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
 SwapChainData create_swapchain(const CoreData& core_data)
@@ -74,13 +79,58 @@ SwapChainData create_swapchain(const CoreData& core_data)
     sd.depth_image_format = VK_FORMAT_D32_SFLOAT;
     return sd;
 }
+SwapChainData create_offscreen_swapchain(const CoreData& core_data, uint32_t image_count, VkFormat format)
+{
+    SwapChainData sd = {};
+    sd.swapchain_format = format;
+
+    VkImageCreateInfo img_info = {};
+    img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    img_info.imageType = VK_IMAGE_TYPE_2D;
+    img_info.format = format;
+    img_info.extent = {core_data.window_size.width, core_data.window_size.height, 1};
+    img_info.mipLevels = 1;
+    img_info.arrayLayers = 1;
+    img_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    img_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // rendered to, then copied to a readback buffer
+    img_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    VmaAllocationCreateInfo img_allocinfo = {};
+    img_allocinfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    img_allocinfo.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    sd.swapchain_images.resize(image_count);
+    sd.swapchain_image_allocations.resize(image_count);
+    for (uint32_t i = 0; i < image_count; i++)
+    {
+        VK_CHECK_RESULT(vmaCreateImage(core_data.allocator, &img_info, &img_allocinfo, &sd.swapchain_images[i],
+                                       &sd.swapchain_image_allocations[i], nullptr));
+        sd.swapchain_image_views.push_back(
+            create_image_view(core_data.device, sd.swapchain_images[i], format, VK_IMAGE_ASPECT_COLOR_BIT));
+    }
+
+    create_depth_image(core_data, &sd.depth_image, &sd.depth_image_view, &sd.depth_image_allocation,
+                       VK_FORMAT_D32_SFLOAT);
+    sd.depth_image_format = VK_FORMAT_D32_SFLOAT;
+    return sd;
+}
+
 void destroy_swapchain(const CoreData& core_data, SwapChainData* sd)
 {
-    vkDestroySwapchainKHR(core_data.device, sd->swapchain_khr, nullptr);
+    if (sd->swapchain_khr != VK_NULL_HANDLE)
+    {
+        vkDestroySwapchainKHR(core_data.device, sd->swapchain_khr, nullptr);
+    }
     for (auto sc : sd->swapchain_image_views)
     {
         vkDestroyImageView(core_data.device, sc, nullptr);
     }
+    // the images of a real swapchain belong to swapchain_khr
+    for (size_t i = 0; i < sd->swapchain_image_allocations.size(); i++)
+    {
+        vmaDestroyImage(core_data.allocator, sd->swapchain_images[i], sd->swapchain_image_allocations[i]);
+    }
     vkDestroyImageView(core_data.device, sd->depth_image_view, nullptr);
     vmaDestroyImage(core_data.allocator, sd->depth_image, sd->depth_image_allocation);
     *sd = {};
@@ -11,7 +11,8 @@ namespace rendersystem
 {
 
 /**
- * Hold data for Vulkan swapchain management.
+ * Hold data for Vulkan swapchain management. An offscreen swapchain has no swapchain_khr, its images are allocated
+ * like the depth image and can be copied from after rendering.
  */
 struct SwapChainData
 {
@@ -19,6 +20,7 @@ struct SwapChainData
     VkFormat swapchain_format;
     std::vector<VkImage> swapchain_images;
     std::vector<VkImageView> swapchain_image_views;
+    std::vector<VmaAllocation> swapchain_image_allocations; // offscreen only
 
     VkImage depth_image;
     VkFormat depth_image_format;
@@ -27,5 +29,11 @@ struct SwapChainData
 };
 
 SwapChainData create_swapchain(const CoreData& core_data);
+/**
+ * Create image_count color images of window_size to render into without a surface, e.g. with
+ * create_core_headless. Nothing is presented, the images end the render pass in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL.
+ */
+SwapChainData create_offscreen_swapchain(const CoreData& core_data, uint32_t image_count,
+                                         VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
 void destroy_swapchain(const CoreData& core_data, SwapChainData* sd);
 } // namespace rendersystem
@@ -0,0 +1,29 @@
+#include "camera.h"
+#include "camerauniforms.h"
+#include <catch2/catch_test_macros.hpp>
+
+using namespace rendersystem;
+
+TEST_CASE("Camera uniforms are derived from view and projection")
+{
+    components::Camera camera(4 / 3.0f, 60.0f);
+    camera.position() = glm::vec3(1, 2, 3);
+    camera.rotate(0.5f, 0.2f);
+    const CameraUniforms uniforms = make_camera_uniforms(camera.view_mat(), camera.projection_mat(), camera.position());
+    REQUIRE(uniforms.view == camera.view_mat());
+    REQUIRE(uniforms.projection == camera.projection_mat());
+    REQUIRE(uniforms.view_proj == camera.projection_mat() * camera.view_mat());
+    REQUIRE(uniforms.position == glm::vec4(1, 2, 3, 1));
+    const Frustum frustum = frustum_from_matrix(uniforms.view_proj);
+    for (int i = 0; i < 6; i++)
+    {
+        REQUIRE(uniforms.frustum.planes[i] == frustum.planes[i]);
+    }
+    // the eye is behind the near plane and inside the four side planes
+    const glm::vec4 eye = uniforms.position;
+    REQUIRE(glm::dot(uniforms.frustum.planes[4], eye) < 0.0f);
+    for (int i = 0; i < 4; i++)
+    {
+        REQUIRE(glm::dot(uniforms.frustum.planes[i], eye) >= -1e-4f);
+    }
+}
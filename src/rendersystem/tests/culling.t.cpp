@@ -0,0 +1,58 @@
+#include "culling.h"
+#include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+using namespace rendersystem;
+
+// camera at the origin looking down -z, like Camera::view_mat() without rotation
+static Frustum make_frustum()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    projection[1][1] *= -1;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+    return frustum_from_matrix(projection * view);
+}
+
+TEST_CASE("Frustum culling keeps spheres intersecting the frustum")
+{
+    BoundingSpheres spheres;
+    spheres.push_back(glm::vec3(0, 0, -10), 1.0f);     // in front
+    spheres.push_back(glm::vec3(0, 0, 10), 1.0f);      // behind
+    spheres.push_back(glm::vec3(20, 0, -10), 1.0f);    // right of the 90 degree field of view
+    spheres.push_back(glm::vec3(10.5f, 0, -10), 1.0f); // straddles the right plane
+    spheres.push_back(glm::vec3(0, -20, -10), 1.0f);   // below
+    spheres.push_back(glm::vec3(0, 0, -102), 1.0f);    // beyond the far plane
+    spheres.push_back(glm::vec3(0, 0, -100.5f), 1.0f); // straddles the far plane
+
+    std::vector<uint8_t> visible(spheres.size());
+    CullingStats stats = spheres.cull(make_frustum(), visible.data());
+    REQUIRE(visible == std::vector<uint8_t>{1, 0, 0, 1, 0, 0, 1});
+    REQUIRE(stats.visible == 3);
+    REQUIRE(stats.culled == 4);
+}
+
+TEST_CASE("Vectorized frustum culling matches the scalar reference")
+{
+    const Frustum frustum = make_frustum();
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+    std::uniform_real_distribution<float> radius(0.0f, 5.0f);
+    // sizes not divisible by the vector width exercise the scalar tail
+    for (size_t n : {0, 1, 7, 8, 13, 1000, 1003})
+    {
+        BoundingSpheres spheres;
+        for (size_t i = 0; i < n; i++)
+        {
+            spheres.push_back(glm::vec3(position(rng), position(rng), position(rng)), radius(rng));
+        }
+        std::vector<uint8_t> expected(n, 2), visible(n, 2);
+        CullingStats expected_stats = spheres.cull_scalar(frustum, expected.data());
+        CullingStats stats = spheres.cull(frustum, visible.data());
+        REQUIRE(visible == expected);
+        REQUIRE(stats.visible == expected_stats.visible);
+        REQUIRE(stats.culled == expected_stats.culled);
+        REQUIRE(stats.visible + stats.culled == n);
+    }
+}
@@ -0,0 +1,85 @@
+#include "core.h"
+#include "descriptors.h"
+#include "headlessdevice.h"
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using namespace rendersystem;
+
+static VkDescriptorSetLayoutBinding make_binding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stages)
+{
+    VkDescriptorSetLayoutBinding b = {};
+    b.binding = binding;
+    b.descriptorType = type;
+    b.descriptorCount = 1;
+    b.stageFlags = stages;
+    return b;
+}
+
+TEST_CASE("Descriptor layout keys ignore the binding order")
+{
+    const VkDescriptorSetLayoutBinding camera =
+        make_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    const VkDescriptorSetLayoutBinding instances =
+        make_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    const DescriptorLayoutKey key({camera, instances});
+    const DescriptorLayoutKey reversed({instances, camera});
+    REQUIRE(key == reversed);
+    REQUIRE(key.hash() == reversed.hash());
+
+    // any difference of a binding makes a different layout
+    VkDescriptorSetLayoutBinding compute = instances;
+    compute.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    REQUIRE_FALSE(key == DescriptorLayoutKey({camera, compute}));
+    VkDescriptorSetLayoutBinding uniform = instances;
+    uniform.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    REQUIRE_FALSE(key == DescriptorLayoutKey({camera, uniform}));
+    VkDescriptorSetLayoutBinding array = instances;
+    array.descriptorCount = 2;
+    REQUIRE_FALSE(key == DescriptorLayoutKey({camera, array}));
+    REQUIRE_FALSE(key == DescriptorLayoutKey({camera}));
+}
+
+TEST_CASE("Descriptor layouts are shared and the allocator grows")
+{
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("descriptors_test", 64, 64); }))
+    {
+        return;
+    }
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+    const VkDescriptorSetLayoutBinding camera =
+        make_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    const VkDescriptorSetLayoutBinding instances =
+        make_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    const VkDescriptorSetLayout layout = layouts.get({camera, instances});
+    REQUIRE(layouts.get({instances, camera}) == layout);
+    REQUIRE(layouts.size() == 1);
+    layouts.get({camera});
+    REQUIRE(layouts.size() == 2);
+
+    // more sets than fit into one pool
+    DescriptorAllocator descriptors;
+    descriptors.create(core.device, 4);
+    std::vector<VkDescriptorSet> sets;
+    for (int i = 0; i < 10; i++)
+    {
+        sets.push_back(descriptors.allocate(layout));
+        REQUIRE(sets.back() != VK_NULL_HANDLE);
+    }
+    REQUIRE(descriptors.pool_count() >= 3);
+
+    // the pools are reused after a reset
+    const size_t pool_count = descriptors.pool_count();
+    descriptors.reset();
+    for (int i = 0; i < 10; i++)
+    {
+        REQUIRE(descriptors.allocate(layout) != VK_NULL_HANDLE);
+    }
+    REQUIRE(descriptors.pool_count() == pool_count);
+
+    descriptors.destroy();
+    layouts.destroy();
+    destroy_core(&core);
+}
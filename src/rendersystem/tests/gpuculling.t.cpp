@@ -0,0 +1,198 @@
+#include "check.h"
+#include "core.h"
+#include "culling.h"
+#include "descriptors.h"
+#include "gpuculling.h"
+#include "headlessdevice.h"
+#include "hostbuffer.h"
+#include "instances.h"
+#include "mesh.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace rendersystem;
+
+// distance of the sphere surface to the closest plane, 0 if it touches one
+static float plane_margin(const Frustum& frustum, const glm::vec3& center, float radius)
+{
+    float margin = INFINITY;
+    for (const glm::vec4& p : frustum.planes)
+    {
+        margin = std::min(margin, std::abs(glm::dot(glm::vec3(p), center) + p.w + radius));
+    }
+    return margin;
+}
+
+TEST_CASE("GPU culling matches the CPU reference")
+{
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("gpuculling_test", 64, 64); }))
+    {
+        return;
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    projection[1][1] *= -1;
+    const glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 5), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+    const Frustum frustum = frustum_from_matrix(projection * view);
+
+    // batches of different sizes, including a single instance, with off-center bounds
+    const std::vector<uint32_t> batch_sizes = {300, 1, 77, 622};
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    std::vector<InstanceBatch> batches;
+    uint32_t instance_count = 0;
+    for (uint32_t b = 0; b < batch_sizes.size(); b++)
+    {
+        meshes.push_back(std::make_unique<Mesh>());
+        meshes.back()->set_bounds(glm::vec4(0.5f * b, -0.25f * b, 1.0f, 0.5f + b));
+        batches.push_back(InstanceBatch{meshes.back().get(), instance_count, batch_sizes[b]});
+        instance_count += batch_sizes[b];
+    }
+
+    // random rigid transforms; spheres touching a plane are moved, so float differences cannot flip the result
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+    std::vector<glm::mat4> models(instance_count);
+    BoundingSpheres spheres;
+    for (const InstanceBatch& batch : batches)
+    {
+        const glm::vec4 bounds = batch.mesh->bounds();
+        for (uint32_t i = batch.first_instance; i < batch.first_instance + batch.instance_count; i++)
+        {
+            glm::vec3 center;
+            do
+            {
+                const glm::vec3 translation(position(rng), position(rng), position(rng));
+                const glm::vec3 axis = glm::normalize(glm::vec3(1.0f, angle(rng), 2.0f));
+                models[i] = glm::rotate(glm::translate(glm::mat4(1.0f), translation), angle(rng), axis);
+                center = glm::vec3(models[i] * glm::vec4(glm::vec3(bounds), 1.0f));
+            } while (plane_margin(frustum, center, bounds.w) < 0.01f);
+            spheres.push_back(center, bounds.w);
+        }
+    }
+    std::vector<uint8_t> expected(instance_count);
+    const CullingStats expected_stats = spheres.cull_scalar(frustum, expected.data());
+    REQUIRE(expected_stats.visible > 0);
+    REQUIRE(expected_stats.culled > 0);
+
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+    DescriptorAllocator descriptors;
+    descriptors.create(core.device);
+    CullPipelineData cp = create_cull_pipeline(core.device, &layouts);
+    GpuCullingData gc = create_gpu_culling(core, 16);
+    reserve_gpu_culling(&gc, instance_count);
+    REQUIRE(gc.capacity >= instance_count);
+
+    HostBufferData instances = create_host_buffer(core, instance_count * sizeof(InstanceAttributes),
+                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    HostBufferData commands = create_host_buffer(core, batches.size() * sizeof(VkDrawIndexedIndirectCommand),
+                                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    HostBufferData readback = create_host_buffer(core, instance_count * sizeof(InstanceAttributes),
+                                                 VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    for (uint32_t i = 0; i < instance_count; i++)
+    {
+        ((InstanceAttributes*)instances.data)[i].model = models[i];
+    }
+    write_cull_inputs(batches, (GpuCullObject*)gc.objects.data, (VkDrawIndexedIndirectCommand*)commands.data);
+    flush_host_buffer(instances, VK_WHOLE_SIZE);
+    flush_host_buffer(commands, VK_WHOLE_SIZE);
+    flush_host_buffer(gc.objects, VK_WHOLE_SIZE);
+
+    VkCommandPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.queueFamilyIndex = core.graphics_queue_family;
+    VkCommandPool cmd_pool;
+    VK_CHECK_RESULT(vkCreateCommandPool(core.device, &pool_info, nullptr, &cmd_pool));
+    VkCommandBufferAllocateInfo cmd_info = {};
+    cmd_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmd_info.commandPool = cmd_pool;
+    cmd_info.commandBufferCount = 1;
+    cmd_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    VkCommandBuffer cmd;
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(core.device, &cmd_info, &cmd));
+
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &begin_info));
+    record_gpu_culling(core.device, cmd, cp, gc, &descriptors, frustum, instances, commands, instance_count);
+    // the compacted models are device-local, copy them to where the test can read them
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+    VkBufferCopy copy = {0, 0, instance_count * sizeof(InstanceAttributes)};
+    vkCmdCopyBuffer(cmd, gc.instances, readback.buffer, 1, &copy);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0,
+                         nullptr);
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+
+    VkFenceCreateInfo fence_info = {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence fence;
+    VK_CHECK_RESULT(vkCreateFence(core.device, &fence_info, nullptr, &fence));
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &cmd;
+    VK_CHECK_RESULT(vkQueueSubmit(core.graphics_queue, 1, &submit_info, fence));
+    VK_CHECK_RESULT(vkWaitForFences(core.device, 1, &fence, VK_TRUE, UINT64_MAX));
+    invalidate_host_buffer(gc.visibility, VK_WHOLE_SIZE);
+    invalidate_host_buffer(commands, VK_WHOLE_SIZE);
+    invalidate_host_buffer(readback, VK_WHOLE_SIZE);
+
+    const uint32_t* visibility = (const uint32_t*)gc.visibility.data;
+    const auto* draws = (const VkDrawIndexedIndirectCommand*)commands.data;
+    const auto* compacted = (const InstanceAttributes*)readback.data;
+    for (uint32_t i = 0; i < instance_count; i++)
+    {
+        REQUIRE(visibility[i] == expected[i]);
+    }
+    for (uint32_t b = 0; b < batches.size(); b++)
+    {
+        const InstanceBatch& batch = batches[b];
+        // the visible models of the batch, in any order, at the start of its range
+        std::vector<glm::vec3> expected_positions, positions;
+        for (uint32_t i = batch.first_instance; i < batch.first_instance + batch.instance_count; i++)
+        {
+            if (expected[i])
+            {
+                expected_positions.push_back(glm::vec3(models[i][3]));
+            }
+        }
+        REQUIRE(draws[b].firstInstance == batch.first_instance);
+        REQUIRE(draws[b].instanceCount == expected_positions.size());
+        for (uint32_t i = batch.first_instance; i < batch.first_instance + draws[b].instanceCount; i++)
+        {
+            positions.push_back(glm::vec3(compacted[i].model[3]));
+        }
+        auto less = [](const glm::vec3& a, const glm::vec3& b) {
+            return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+        };
+        std::sort(expected_positions.begin(), expected_positions.end(), less);
+        std::sort(positions.begin(), positions.end(), less);
+        REQUIRE(positions == expected_positions);
+    }
+
+    vkDestroyFence(core.device, fence, nullptr);
+    vkDestroyCommandPool(core.device, cmd_pool, nullptr);
+    destroy_host_buffer(&readback);
+    destroy_host_buffer(&commands);
+    destroy_host_buffer(&instances);
+    destroy_gpu_culling(core.device, &gc);
+    destroy_cull_pipeline(core.device, &cp);
+    descriptors.destroy();
+    layouts.destroy();
+    destroy_core(&core);
+}
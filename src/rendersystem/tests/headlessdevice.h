@@ -0,0 +1,42 @@
+#pragma once
+#include "core.h"
+#include "registry.h"
+#include "rendersystem.h"
+#include <catch2/catch_test_macros.hpp>
+
+/**
+ * Create the headless Vulkan device of a GPU test or benchmark by calling create, e.g. create_core_headless() or
+ * RenderSystem::create_headless(). Returns false after a warning if there is no device, so the caller returns early.
+ * Every other error fails the test.
+ *
+ * Needs a Vulkan device but no display, e.g. lavapipe: VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json
+ * Runs from the build/src directory, so the shaders are found.
+ */
+template <typename Create> bool create_headless_device(Create&& create)
+{
+    try
+    {
+        create();
+        return true;
+    }
+    catch (const rendersystem::NoDeviceError& e)
+    {
+        WARN("skipping: " << e.what());
+        return false;
+    }
+}
+
+/**
+ * Render frames of registry until no drawable waits for its mesh upload or pipeline any more, so that measurements
+ * and images start from complete frames. Fails if that takes more than max_frames.
+ */
+inline void render_until_uploaded(rendersystem::RenderSystem& rs, components::Registry& registry,
+                                  int max_frames = 1000)
+{
+    int frames = 0;
+    do
+    {
+        rs.process(registry, 0);
+    } while (rs.frame_stats().uploading > 0 && ++frames < max_frames);
+    REQUIRE(rs.frame_stats().uploading == 0);
+}
@@ -0,0 +1,96 @@
+#include "coordsys.h"
+#include "instances.h"
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using namespace rendersystem;
+using namespace components;
+
+TEST_CASE("InstanceBatcher groups items by mesh")
+{
+    Mesh a, b, c;
+    std::vector<CoordSys> coords(6);
+    for (size_t i = 0; i < coords.size(); i++)
+    {
+        coords[i].position() = glm::vec3((float)i, 0.0f, 0.0f);
+    }
+    std::vector<DrawItem> items = {{&coords[0], &a}, {&coords[1], &b}, {&coords[2], &a},
+                                   {&coords[3], &c}, {&coords[4], &b}, {&coords[5], &a}};
+    std::vector<InstanceAttributes> instances(items.size());
+
+    InstanceBatcher batcher;
+    const std::vector<InstanceBatch>& batches = batcher.build(items, instances.data());
+    REQUIRE(batches.size() == 3);
+    REQUIRE(batches[0].mesh == &a);
+    REQUIRE(batches[0].first_instance == 0);
+    REQUIRE(batches[0].instance_count == 3);
+    REQUIRE(batches[1].mesh == &b);
+    REQUIRE(batches[1].first_instance == 3);
+    REQUIRE(batches[1].instance_count == 2);
+    REQUIRE(batches[2].mesh == &c);
+    REQUIRE(batches[2].first_instance == 5);
+    REQUIRE(batches[2].instance_count == 1);
+
+    // instances keep the order of their items within a batch
+    const size_t expected_item[] = {0, 2, 5, 1, 4, 3};
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        REQUIRE(instances[i].model == coords[expected_item[i]].transform());
+    }
+
+    // the batcher is reused every frame
+    items.resize(1);
+    REQUIRE(batcher.build(items, instances.data()).size() == 1);
+    REQUIRE(batcher.build({}, instances.data()).empty());
+}
+
+TEST_CASE("ModelTransforms match CoordSys::transform()")
+{
+    // not a multiple of 4, so the scalar tail is used too
+    std::vector<CoordSys> coords(11);
+    ModelTransforms transforms;
+    for (size_t i = 0; i < coords.size(); i++)
+    {
+        coords[i].position() = glm::vec3((float)i, -2.0f * i, 0.5f);
+        coords[i].rotation() = glm::angleAxis(0.3f * i, glm::normalize(glm::vec3(1.0f, (float)i, 2.0f)));
+        transforms.push_back(coords[i].position(), coords[i].rotation());
+    }
+    std::vector<InstanceAttributes> models(coords.size());
+    std::vector<InstanceAttributes> scalar_models(coords.size());
+    transforms.write_models(nullptr, models.data());
+    transforms.write_models_scalar(nullptr, scalar_models.data());
+    for (size_t i = 0; i < coords.size(); i++)
+    {
+        REQUIRE(models[i].model == coords[i].transform());
+        REQUIRE(scalar_models[i].model == coords[i].transform());
+    }
+
+    // written in reverse order
+    std::vector<uint32_t> indices(coords.size());
+    for (uint32_t i = 0; i < indices.size(); i++)
+    {
+        indices[i] = (uint32_t)indices.size() - 1 - i;
+    }
+    transforms.write_models(indices.data(), models.data());
+    for (size_t i = 0; i < coords.size(); i++)
+    {
+        REQUIRE(models[indices[i]].model == coords[i].transform());
+    }
+
+    // a scale multiplies the rotation, as for the PositionDecode of compact meshes
+    transforms.clear();
+    for (size_t i = 0; i < coords.size(); i++)
+    {
+        transforms.push_back(coords[i].position(), coords[i].rotation(), 0.5f);
+    }
+    transforms.write_models(nullptr, models.data());
+    for (size_t i = 0; i < coords.size(); i++)
+    {
+        const glm::mat4 expected = coords[i].transform();
+        for (int c = 0; c < 3; c++)
+        {
+            REQUIRE(models[i].model[c] == expected[c] * 0.5f);
+        }
+        REQUIRE(models[i].model[3] == expected[3]);
+    }
+}
@@ -0,0 +1,149 @@
+#include "meshregistry.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using namespace rendersystem;
+using namespace components;
+
+namespace
+{
+// meshes without GPU resources, records what was created and destroyed
+struct FakeMeshes
+{
+    std::vector<Mesh*> alive;
+    size_t destroyed = 0;
+
+    MeshRegistry make_registry(uint32_t retire_frames)
+    {
+        return MeshRegistry(
+            [this](const Visual3d& viz) {
+                auto mesh = std::make_unique<Mesh>();
+                mesh->indices() = viz.indices();
+                alive.push_back(mesh.get());
+                return mesh;
+            },
+            [this](Mesh& mesh) {
+                alive.erase(std::find(alive.begin(), alive.end(), &mesh));
+                destroyed++;
+            },
+            retire_frames);
+    }
+};
+
+Visual3d make_quad(float size)
+{
+    Visual3d viz;
+    viz.vertices().resize(4);
+    viz.vertices()[1].position = glm::vec3(size, 0, 0);
+    viz.vertices()[2].position = glm::vec3(size, size, 0);
+    viz.vertices()[3].position = glm::vec3(0, size, 0);
+    viz.indices() = {0, 1, 2, 0, 2, 3};
+    return viz;
+}
+} // namespace
+
+TEST_CASE("MeshRegistry shares meshes of equal content")
+{
+    FakeMeshes fake;
+    MeshRegistry registry = fake.make_registry(2);
+    // separately created visuals with equal geometry, e.g. the same file loaded twice
+    Visual3d a = make_quad(1.0f);
+    Visual3d b = make_quad(1.0f);
+    Visual3d c = make_quad(2.0f);
+    REQUIRE(a.geometry_id() != b.geometry_id());
+    REQUIRE(a.content_hash() == b.content_hash());
+
+    registry.begin_frame();
+    Mesh* mesh_a = registry.acquire(a);
+    REQUIRE(registry.acquire(b) == mesh_a);
+    REQUIRE(registry.acquire(Visual3d(a)) == mesh_a);
+    REQUIRE(registry.acquire(c) != mesh_a);
+    REQUIRE(registry.references(a) == 3);
+    REQUIRE(registry.references(c) == 1);
+    REQUIRE(fake.alive.size() == 2);
+    REQUIRE(registry.stats().created == 2);
+    REQUIRE(registry.stats().shared == 1);
+    REQUIRE(registry.stats().references == 4);
+}
+
+TEST_CASE("MeshRegistry creates another mesh for compact copies of a drawn visual")
+{
+    FakeMeshes fake;
+    MeshRegistry registry = fake.make_registry(2);
+    Visual3d standard = make_quad(1.0f);
+    registry.begin_frame();
+    Mesh* mesh = registry.acquire(standard);
+
+    Visual3d compact = standard;
+    compact.set_compact_vertices(true);
+    REQUIRE(compact.geometry_id() != standard.geometry_id());
+    REQUIRE(registry.acquire(compact) != mesh);
+    REQUIRE(registry.acquire(standard) == mesh);
+    REQUIRE(fake.alive.size() == 2);
+    // setting the same hint again keeps the geometry
+    const size_t id = compact.geometry_id();
+    compact.set_compact_vertices(true);
+    REQUIRE(compact.geometry_id() == id);
+}
+
+TEST_CASE("MeshRegistry evicts meshes after retire_frames frames without references")
+{
+    FakeMeshes fake;
+    MeshRegistry registry = fake.make_registry(2);
+    Visual3d kept = make_quad(1.0f);
+    Visual3d dropped = make_quad(2.0f);
+
+    registry.begin_frame();
+    registry.acquire(kept);
+    registry.acquire(dropped);
+    registry.collect();
+    // dropped is no longer drawn, but the GPU may still read it for two frames
+    for (int frame = 0; frame < 2; frame++)
+    {
+        registry.begin_frame();
+        registry.acquire(kept);
+        REQUIRE(registry.references(dropped) == 0);
+        registry.collect();
+        REQUIRE(fake.alive.size() == 2);
+    }
+    registry.begin_frame();
+    registry.acquire(kept);
+    registry.collect();
+    REQUIRE(fake.alive.size() == 1);
+    REQUIRE(fake.destroyed == 1);
+    REQUIRE(registry.stats().evicted == 1);
+    REQUIRE(fake.alive[0]->indices() == kept.indices());
+
+    // coming back creates the mesh again
+    registry.begin_frame();
+    registry.acquire(dropped);
+    REQUIRE(fake.alive.size() == 2);
+    REQUIRE(registry.stats().created == 3);
+
+    registry.clear();
+    REQUIRE(fake.alive.empty());
+}
+
+TEST_CASE("MeshRegistry keeps meshes apart which differ only in a few signs")
+{
+    // uv.y is the high half of a 64 bit word, FNV-1a over words hashed an even number of its sign flips equally
+    Visual3d quad = make_quad(1.0f);
+    Visual3d flipped = make_quad(1.0f);
+    for (size_t i = 0; i < quad.vertices().size(); i++)
+    {
+        quad.vertices()[i].uv = glm::vec2(0.25f, 0.5f);
+        flipped.vertices()[i].uv = glm::vec2(0.25f, i % 2 == 0 ? -0.5f : 0.5f);
+    }
+    REQUIRE(flipped.content_hash() != quad.content_hash());
+    REQUIRE_FALSE(flipped.same_content(quad));
+    REQUIRE(Visual3d(quad).same_content(quad));
+
+    FakeMeshes fake;
+    MeshRegistry registry = fake.make_registry(2);
+    registry.begin_frame();
+    Mesh* mesh = registry.acquire(quad);
+    REQUIRE(registry.acquire(flipped) != mesh);
+    REQUIRE(registry.stats().created == 2);
+    REQUIRE(registry.stats().shared == 0);
+}
@@ -0,0 +1,139 @@
+#include "core.h"
+#include "headlessdevice.h"
+#include "pass.h"
+#include "pipeline.h"
+#include "pipelineregistry.h"
+#include "swapchain.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rendersystem;
+
+// a pipeline like the mesh pipeline, with fake handles. The vertex input arrays are local, as in most callers
+static PipelineBuilder make_builder(VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL, float width = 640.0f,
+                                    const char* entry_point = "main")
+{
+    const std::vector<VkVertexInputBindingDescription> bindings = {{0, 44, VK_VERTEX_INPUT_RATE_VERTEX}};
+    const std::vector<VkVertexInputAttributeDescription> attributes = {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+                                                                        {1, 0, VK_FORMAT_R32G32B32_SFLOAT, 12}};
+    VkPipelineShaderStageCreateInfo vert = {};
+    vert.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vert.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vert.module = (VkShaderModule)(uintptr_t)0x10;
+    vert.pName = entry_point;
+    VkPipelineShaderStageCreateInfo frag = vert;
+    frag.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    frag.module = (VkShaderModule)(uintptr_t)0x20;
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = {};
+    vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input.vertexBindingDescriptionCount = (uint32_t)bindings.size();
+    vertex_input.pVertexBindingDescriptions = bindings.data();
+    vertex_input.vertexAttributeDescriptionCount = (uint32_t)attributes.size();
+    vertex_input.pVertexAttributeDescriptions = attributes.data();
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = polygon_mode;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    PipelineBuilder builder;
+    builder.add_shader_stage(vert)
+        .add_shader_stage(frag)
+        .add_vertex_input_state(vertex_input)
+        .add_input_assembly_state(input_assembly)
+        .add_rasterization_state(rasterization)
+        .add_viewport({0.0f, 0.0f, width, 480.0f, 0.0f, 1.0f})
+        .depth_stencil(true, true, VK_COMPARE_OP_LESS_OR_EQUAL)
+        .no_msaa()
+        .no_color_blend();
+    return builder;
+}
+
+TEST_CASE("Pipeline keys are equal for equal builder state")
+{
+    const VkRenderPass pass = (VkRenderPass)(uintptr_t)0x30;
+    const VkPipelineLayout layout = (VkPipelineLayout)(uintptr_t)0x40;
+    const PipelineBuilder builder = make_builder();
+    const PipelineKey key = builder.key(pass, layout);
+
+    // separately built, with the create infos pointing to other arrays
+    const PipelineKey same = make_builder().key(pass, layout);
+    REQUIRE(key == same);
+    REQUIRE(key.hash() == same.hash());
+    // the builder owns its state, so a copy has the same key
+    const PipelineBuilder copy = builder;
+    REQUIRE(copy.key(pass, layout) == key);
+    const std::string entry_point = "main";
+    REQUIRE(make_builder(VK_POLYGON_MODE_FILL, 640.0f, entry_point.c_str()).key(pass, layout) == key);
+
+    REQUIRE_FALSE(make_builder(VK_POLYGON_MODE_LINE).key(pass, layout) == key);
+    REQUIRE_FALSE(make_builder(VK_POLYGON_MODE_FILL, 800.0f).key(pass, layout) == key);
+    REQUIRE_FALSE(make_builder(VK_POLYGON_MODE_FILL, 640.0f, "main2").key(pass, layout) == key);
+    REQUIRE_FALSE(builder.key((VkRenderPass)(uintptr_t)0x31, layout) == key);
+    REQUIRE_FALSE(builder.key(pass, (VkPipelineLayout)(uintptr_t)0x41) == key);
+    PipelineBuilder without_depth_write = make_builder();
+    without_depth_write.depth_stencil(true, false, VK_COMPARE_OP_LESS_OR_EQUAL);
+    REQUIRE_FALSE(without_depth_write.key(pass, layout) == key);
+
+    // all variants above hash differently, a collision would only cost a comparison
+    REQUIRE(make_builder(VK_POLYGON_MODE_LINE).key(pass, layout).hash() != key.hash());
+}
+
+TEST_CASE("Pipeline registry builds every state once")
+{
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("pipeline_test", 64, 64); }))
+    {
+        return;
+    }
+    SwapChainData offscreen = {};
+    offscreen.swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
+    offscreen.depth_image_format = VK_FORMAT_D32_SFLOAT;
+    PassData pass = create_basic_pass(core, offscreen);
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+    PipelineRegistry pipelines(1);
+    pipelines.create(core.device, VK_NULL_HANDLE);
+
+    MeshPipelineData pd = create_mesh_pipeline(core.device, pass.render_pass, core.window_size, &layouts, &pipelines);
+    REQUIRE(pd.pipeline != VK_NULL_HANDLE);
+    REQUIRE(pipelines.get(mesh_pipeline_builder(pd, VK_POLYGON_MODE_FILL), pd.pass, pd.pipeline_layout) ==
+            pd.pipeline);
+    REQUIRE(pipelines.size() == 1);
+    REQUIRE(pipelines.build_count() == 1);
+
+    if (core.fill_mode_non_solid)
+    {
+        // the variant is built in the background, asking again does not build it twice
+        VkPipeline wireframe = VK_NULL_HANDLE;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (wireframe == VK_NULL_HANDLE && std::chrono::steady_clock::now() < deadline)
+        {
+            wireframe = pipelines.request(mesh_pipeline_builder(pd, VK_POLYGON_MODE_LINE), pd.pass, pd.pipeline_layout);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(wireframe != VK_NULL_HANDLE);
+        REQUIRE(wireframe != pd.pipeline);
+        REQUIRE(pipelines.size() == 2);
+        REQUIRE(pipelines.build_count() == 2);
+    }
+    else
+    {
+        WARN("the device does not support fillModeNonSolid, no wireframe variant");
+    }
+
+    pipelines.destroy();
+    destroy_mesh_pipeline(core.device, &pd);
+    layouts.destroy();
+    destroy_pass(core.device, &pass);
+    destroy_core(&core);
+}
@@ -0,0 +1,128 @@
+#include "core.h"
+#include "descriptors.h"
+#include "gpuculling.h"
+#include "headlessdevice.h"
+#include "pipelinecache.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace rendersystem;
+
+static VkPhysicalDeviceProperties make_properties()
+{
+    VkPhysicalDeviceProperties properties = {};
+    properties.vendorID = 0x10de;
+    properties.deviceID = 0x2484;
+    properties.driverVersion = 0x8a3f4000;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+    {
+        properties.pipelineCacheUUID[i] = (uint8_t)(i * 7 + 1);
+    }
+    return properties;
+}
+
+// what a driver returns from vkGetPipelineCacheData: its header followed by some payload
+static std::vector<uint8_t> make_driver_data(const VkPhysicalDeviceProperties& properties)
+{
+    const uint32_t fields[4] = {16 + VK_UUID_SIZE, VK_PIPELINE_CACHE_HEADER_VERSION_ONE, properties.vendorID,
+                                properties.deviceID};
+    std::vector<uint8_t> data(sizeof(fields) + VK_UUID_SIZE + 100);
+    memcpy(data.data(), fields, sizeof(fields));
+    memcpy(data.data() + sizeof(fields), properties.pipelineCacheUUID, VK_UUID_SIZE);
+    for (size_t i = sizeof(fields) + VK_UUID_SIZE; i < data.size(); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+    return data;
+}
+
+TEST_CASE("Pipeline cache files are only accepted by the device and driver that wrote them")
+{
+    const VkPhysicalDeviceProperties properties = make_properties();
+    const std::vector<uint8_t> data = make_driver_data(properties);
+    const std::vector<uint8_t> file = pack_pipeline_cache(properties, data);
+    std::vector<uint8_t> unpacked;
+    REQUIRE(unpack_pipeline_cache(properties, file, &unpacked));
+    REQUIRE(unpacked == data);
+
+    SECTION("other device")
+    {
+        VkPhysicalDeviceProperties other = properties;
+        other.pipelineCacheUUID[3]++;
+        REQUIRE_FALSE(unpack_pipeline_cache(other, file, &unpacked));
+        other = properties;
+        other.vendorID++;
+        REQUIRE_FALSE(unpack_pipeline_cache(other, file, &unpacked));
+        other = properties;
+        other.deviceID++;
+        REQUIRE_FALSE(unpack_pipeline_cache(other, file, &unpacked));
+    }
+    SECTION("driver update")
+    {
+        VkPhysicalDeviceProperties updated = properties;
+        updated.driverVersion++;
+        REQUIRE_FALSE(unpack_pipeline_cache(updated, file, &unpacked));
+    }
+    SECTION("damaged file")
+    {
+        std::vector<uint8_t> truncated(file.begin(), file.end() - 1);
+        REQUIRE_FALSE(unpack_pipeline_cache(properties, truncated, &unpacked));
+        REQUIRE_FALSE(unpack_pipeline_cache(properties, std::vector<uint8_t>(), &unpacked));
+        std::vector<uint8_t> flipped = file;
+        flipped.back() ^= 1;
+        REQUIRE_FALSE(unpack_pipeline_cache(properties, flipped, &unpacked));
+    }
+    SECTION("data of another device in a matching file")
+    {
+        VkPhysicalDeviceProperties other = properties;
+        other.deviceID++;
+        const std::vector<uint8_t> mixed = pack_pipeline_cache(properties, make_driver_data(other));
+        REQUIRE_FALSE(unpack_pipeline_cache(properties, mixed, &unpacked));
+    }
+}
+
+TEST_CASE("Pipeline cache survives a restart")
+{
+    CoreData core;
+    if (!create_headless_device([&] { core = create_core_headless("pipelinecache_test", 64, 64); }))
+    {
+        return;
+    }
+    const std::string path = (std::filesystem::temp_directory_path() / "pipelinecache_test.bin").string();
+    std::filesystem::remove(path);
+    DescriptorLayoutCache layouts;
+    layouts.create(core.device);
+
+    PipelineCacheData cold = create_pipeline_cache(core, path);
+    REQUIRE_FALSE(cold.warm);
+    CullPipelineData cp = create_cull_pipeline(core.device, &layouts, cold.cache);
+    destroy_cull_pipeline(core.device, &cp);
+    REQUIRE(save_pipeline_cache(core, cold));
+    destroy_pipeline_cache(core.device, &cold);
+
+    PipelineCacheData warm = create_pipeline_cache(core, path);
+    REQUIRE(warm.warm);
+    REQUIRE(warm.loaded_size > 0);
+    cp = create_cull_pipeline(core.device, &layouts, warm.cache);
+    destroy_cull_pipeline(core.device, &cp);
+    destroy_pipeline_cache(core.device, &warm);
+
+    // a file damaged on disk is ignored
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offsetof(PipelineCacheHeader, driver_version));
+        const uint32_t driver_version = 0;
+        file.write((const char*)&driver_version, sizeof(driver_version));
+    }
+    PipelineCacheData damaged = create_pipeline_cache(core, path);
+    REQUIRE_FALSE(damaged.warm);
+    destroy_pipeline_cache(core.device, &damaged);
+
+    std::filesystem::remove(path);
+    layouts.destroy();
+    destroy_core(&core);
+}
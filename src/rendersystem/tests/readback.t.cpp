@@ -0,0 +1,234 @@
+#include "components/camera.h"
+#include "components/coordsys.h"
+#include "components/registry.h"
+#include "components/visual.h"
+#include "headlessdevice.h"
+#include "rendersystem.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+
+using namespace rendersystem;
+using namespace components;
+
+TEST_CASE("Headless frames are read back in order")
+{
+    RenderSettings settings;
+    settings.frames_in_flight = 2;
+    settings.pipeline_cache_path = "";
+    RenderSystem rs(settings);
+    if (!create_headless_device([&] { rs.create_headless(64, 48); }))
+    {
+        return;
+    }
+    std::vector<uint64_t> frame_numbers;
+    std::vector<uint8_t> last;
+    rs.set_readback([&](const ReadbackImage& image) {
+        REQUIRE(image.width == 64);
+        REQUIRE(image.height == 48);
+        REQUIRE(image.row_pitch == 64 * 4);
+        frame_numbers.push_back(image.frame_number);
+        last.assign(image.pixels, image.pixels + image.row_pitch * image.height);
+    });
+
+    // without a camera only the clear color is drawn, 0.4 0.2 0.5 0 in R8G8B8A8_UNORM
+    Registry registry;
+    for (int i = 0; i < 3; i++)
+    {
+        rs.process(registry, 0);
+    }
+    // the oldest frame is handed out when its resources are reused
+    REQUIRE(frame_numbers == std::vector<uint64_t>{0});
+    rs.finish_readbacks();
+    REQUIRE(frame_numbers == std::vector<uint64_t>{0, 1, 2});
+    for (size_t i = 0; i < last.size(); i += 4)
+    {
+        REQUIRE(std::abs(last[i + 0] - 102) <= 1);
+        REQUIRE(std::abs(last[i + 1] - 51) <= 1);
+        REQUIRE(std::abs(last[i + 2] - 128) <= 1);
+        REQUIRE(last[i + 3] == 0);
+    }
+
+    // a triangle in front of the camera covers some pixels once its upload completed
+    registry.create(CoordSys(), Visual3d::make_triangle());
+    Camera cam(64 / 48.0f, 60.0f);
+    cam.position() = glm::vec3(0, 0, -2);
+    registry.create(cam);
+    bool drawn = false;
+    for (int i = 0; i < 100 && !drawn; i++)
+    {
+        rs.process(registry, 0);
+        rs.finish_readbacks();
+        for (size_t t = 0; t < last.size() && !drawn; t += 4)
+        {
+            drawn =
+                std::abs(last[t + 0] - 102) > 1 || std::abs(last[t + 1] - 51) > 1 || std::abs(last[t + 2] - 128) > 1;
+        }
+    }
+    REQUIRE(drawn);
+    rs.destroy();
+}
+
+// the last frame of registry once all of its meshes are uploaded
+static std::vector<uint8_t> render_uploaded(RenderSystem& rs, Registry& registry, std::vector<uint8_t>& last)
+{
+    render_until_uploaded(rs, registry);
+    rs.process(registry, 0);
+    rs.finish_readbacks();
+    return last;
+}
+
+TEST_CASE("Compact vertices render like standard ones")
+{
+    RenderSettings settings;
+    settings.pipeline_cache_path = "";
+    settings.geometry_max_compact_vertices = 1024;
+    RenderSystem rs(settings);
+    if (!create_headless_device([&] { rs.create_headless(64, 48); }))
+    {
+        return;
+    }
+    std::vector<uint8_t> last;
+    rs.set_readback([&](const ReadbackImage& image) {
+        last.assign(image.pixels, image.pixels + image.row_pitch * image.height);
+    });
+    Camera cam(64 / 48.0f, 60.0f);
+    cam.position() = glm::vec3(0, 0, -2);
+    Registry standard;
+    const Visual3d triangle = Visual3d::make_triangle();
+    standard.create(CoordSys(), triangle);
+    standard.create(cam);
+    // a copy of the visual after it was drawn, so its standard mesh is cached
+    render_uploaded(rs, standard, last);
+    Registry compact;
+    Visual3d compact_triangle = triangle;
+    compact_triangle.set_compact_vertices(true);
+    compact.create(CoordSys(), compact_triangle);
+    compact.create(cam);
+
+    for (DrawMode mode : {DrawMode::direct, DrawMode::indirect, DrawMode::gpu_culled})
+    {
+        rs.set_draw_mode(mode);
+        const std::vector<uint8_t> expected = render_uploaded(rs, standard, last);
+        const std::vector<uint8_t> actual = render_uploaded(rs, compact, last);
+        REQUIRE(actual.size() == expected.size());
+        // quantized positions may move an edge by a pixel, normals differ by less than a color step
+        size_t covered = 0;
+        size_t differing = 0;
+        for (size_t i = 0; i < expected.size(); i += 4)
+        {
+            covered += std::abs(expected[i + 0] - 102) > 1 || std::abs(expected[i + 2] - 128) > 1 ? 1 : 0;
+            bool same = true;
+            for (size_t c = 0; c < 3; c++)
+            {
+                same = same && std::abs(actual[i + c] - expected[i + c]) <= 1;
+            }
+            differing += same ? 0 : 1;
+        }
+        REQUIRE(covered > 0);
+        REQUIRE(differing * 20 <= covered);
+    }
+    rs.destroy();
+}
+
+TEST_CASE("Indirect draws render like direct ones")
+{
+    // with one call per draw command as well, as on devices without multiDrawIndirect
+    for (bool multi_draw : {true, false})
+    {
+        RenderSettings settings;
+        settings.pipeline_cache_path = "";
+        settings.geometry_max_compact_vertices = 1024;
+        settings.multi_draw_indirect = multi_draw;
+        RenderSystem rs(settings);
+        if (!create_headless_device([&] { rs.create_headless(64, 48); }))
+        {
+            return;
+        }
+        std::vector<uint8_t> last;
+        rs.set_readback([&](const ReadbackImage& image) {
+            last.assign(image.pixels, image.pixels + image.row_pitch * image.height);
+        });
+        // an instanced mesh, a second one and a compact one at different depths, so the draw order does not matter
+        const Visual3d triangle = Visual3d::make_triangle();
+        Visual3d green = Visual3d::make_triangle();
+        for (StandardVertex& v : green.vertices())
+        {
+            v.color = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+        green.update_bounds();
+        Visual3d compact = Visual3d::make_triangle();
+        compact.set_compact_vertices(true);
+        Registry registry;
+        const glm::vec3 positions[] = {
+            {-0.5f, 0.0f, 0.5f}, {0.5f, 0.0f, 0.0f}, {0.0f, -0.5f, 1.0f}, {0.0f, 0.5f, 1.5f}};
+        const Visual3d* visuals[] = {&triangle, &triangle, &green, &compact};
+        for (size_t i = 0; i < std::size(positions); i++)
+        {
+            CoordSys coord;
+            coord.position() = positions[i];
+            registry.create(coord, *visuals[i]);
+        }
+        Camera cam(64 / 48.0f, 60.0f);
+        cam.position() = glm::vec3(0, 0, -2);
+        registry.create(cam);
+
+        rs.set_draw_mode(DrawMode::direct);
+        const std::vector<uint8_t> expected = render_uploaded(rs, registry, last);
+        REQUIRE(rs.frame_stats().draw_count == 3);
+        for (DrawMode mode : {DrawMode::indirect, DrawMode::gpu_culled})
+        {
+            rs.set_draw_mode(mode);
+            if (rs.draw_mode() != mode)
+            {
+                WARN("skipping: the device cannot draw indirect with an instance offset");
+                break;
+            }
+            REQUIRE(render_uploaded(rs, registry, last) == expected);
+        }
+        rs.destroy();
+    }
+}
+
+TEST_CASE("Attached coordinate systems are drawn at their world transform")
+{
+    RenderSettings settings;
+    settings.pipeline_cache_path = "";
+    RenderSystem rs(settings);
+    if (!create_headless_device([&] { rs.create_headless(64, 48); }))
+    {
+        return;
+    }
+    std::vector<uint8_t> last;
+    rs.set_readback([&](const ReadbackImage& image) {
+        last.assign(image.pixels, image.pixels + image.row_pitch * image.height);
+    });
+    Camera cam(64 / 48.0f, 60.0f);
+    cam.position() = glm::vec3(0, 0, -2);
+    const Visual3d triangle = Visual3d::make_triangle();
+    Registry placed;
+    CoordSys coord;
+    coord.position() = glm::vec3(0.5f, 0.25f, 1.0f);
+    placed.create(coord, triangle);
+    placed.create(cam);
+
+    // the same offset split between a parent and its child, the coordinate system itself stays at the origin
+    TransformHierarchy& hierarchy = rs.transform_hierarchy();
+    const uint32_t parent = hierarchy.create();
+    const uint32_t child = hierarchy.create(parent);
+    hierarchy.set_local(parent, glm::vec3(0.0f, 0.25f, 1.0f), glm::quat(1, 0, 0, 0));
+    hierarchy.set_local(child, glm::vec3(0.5f, 0.0f, 0.0f), glm::quat(1, 0, 0, 0));
+    Registry attached;
+    CoordSys attached_coord;
+    attached_coord.attach(child);
+    attached.create(attached_coord, triangle);
+    attached.create(cam);
+
+    const std::vector<uint8_t> expected = render_uploaded(rs, placed, last);
+    REQUIRE(render_uploaded(rs, attached, last) == expected);
+    // moving the parent moves the drawable
+    hierarchy.set_local(parent, glm::vec3(0.0f, 0.0f, 1.0f), glm::quat(1, 0, 0, 0));
+    REQUIRE(render_uploaded(rs, attached, last) != expected);
+    rs.destroy();
+}
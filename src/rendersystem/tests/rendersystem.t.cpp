@@ -0,0 +1,68 @@
+#include "allocationcounter.h"
+#include "components/camera.h"
+#include "components/coordsys.h"
+#include "components/registry.h"
+#include "components/visual.h"
+#include "headlessdevice.h"
+#include "rendersystem.h"
+#include <catch2/catch_test_macros.hpp>
+#include <iterator>
+#include <utility>
+
+using namespace rendersystem;
+using namespace components;
+
+TEST_CASE("RenderSystem::process performs no heap allocation in steady state")
+{
+    RenderSettings settings;
+    settings.pipeline_cache_path = "";
+    RenderSystem rs(settings);
+    if (!create_headless_device([&] { rs.create_headless(64, 48); }))
+    {
+        return;
+    }
+    // a grid of instances of a few meshes in front of the camera
+    Registry registry;
+    Visual3d meshes[4];
+    for (size_t m = 0; m < std::size(meshes); m++)
+    {
+        meshes[m] = Visual3d::make_triangle();
+        for (StandardVertex& v : meshes[m].vertices())
+        {
+            v.color = glm::vec3(m / 4.0f, 1.0f, 0.0f);
+        }
+        meshes[m].update_bounds();
+    }
+    for (int i = 0; i < 256; i++)
+    {
+        CoordSys coord;
+        coord.position() = glm::vec3((i % 16) / 8.0f - 1.0f, (i / 16) / 8.0f - 1.0f, (i % 5) * 0.5f);
+        registry.create(coord, meshes[i % std::size(meshes)]);
+    }
+    Camera cam(64 / 48.0f, 60.0f);
+    cam.position() = glm::vec3(0, 0, -2);
+    registry.create(cam);
+
+    const std::pair<DrawMode, const char*> modes[] = {
+        {DrawMode::direct, "direct"}, {DrawMode::indirect, "indirect"}, {DrawMode::gpu_culled, "gpu_culled"}};
+    for (const auto& [mode, name] : modes)
+    {
+        INFO("draw mode " << name);
+        rs.set_draw_mode(mode);
+        render_until_uploaded(rs, registry);
+        // every frame in flight has grown its buffers and descriptor pools for the mode
+        for (int i = 0; i < 4; i++)
+        {
+            rs.process(registry, 0);
+        }
+        REQUIRE(rs.frame_stats().draw_count == std::size(meshes));
+
+        const size_t allocations = allocation_count();
+        for (int i = 0; i < 100; i++)
+        {
+            rs.process(registry, 16'000);
+        }
+        REQUIRE(allocation_count() == allocations);
+    }
+    rs.destroy();
+}
@@ -0,0 +1,137 @@
+#include "suballocator.h"
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+using namespace rendersystem;
+
+TEST_CASE("SubAllocator hands out non-overlapping ranges")
+{
+    SubAllocator alloc(100);
+    uint64_t a = alloc.allocate(30);
+    uint64_t b = alloc.allocate(30);
+    uint64_t c = alloc.allocate(40);
+    REQUIRE(a == 0);
+    REQUIRE(b == 30);
+    REQUIRE(c == 60);
+    REQUIRE(alloc.allocate(1) == SubAllocator::kInvalidOffset);
+    REQUIRE(alloc.stats().used == 100);
+    REQUIRE(alloc.stats().free_range_count == 0);
+}
+
+TEST_CASE("SubAllocator merges neighbouring free ranges")
+{
+    SubAllocator alloc(100);
+    uint64_t a = alloc.allocate(25);
+    uint64_t b = alloc.allocate(25);
+    uint64_t c = alloc.allocate(25);
+    alloc.allocate(25);
+
+    alloc.free(a);
+    alloc.free(c);
+    REQUIRE(alloc.stats().free_range_count == 2);
+    REQUIRE(alloc.stats().largest_free == 25);
+    REQUIRE(alloc.stats().fragmentation() == 0.5f);
+    // a range of 50 only exists once b is returned
+    REQUIRE(alloc.allocate(50) == SubAllocator::kInvalidOffset);
+
+    alloc.free(b);
+    REQUIRE(alloc.stats().free_range_count == 1);
+    REQUIRE(alloc.stats().fragmentation() == 0.0f);
+    REQUIRE(alloc.allocate(75) == 0);
+}
+
+TEST_CASE("SubAllocator picks the best fitting range")
+{
+    SubAllocator alloc(100);
+    uint64_t a = alloc.allocate(40);
+    alloc.allocate(10);
+    uint64_t c = alloc.allocate(20);
+    alloc.allocate(30);
+    alloc.free(a);
+    alloc.free(c);
+    // the 20 unit hole fits better than the 40 unit one
+    REQUIRE(alloc.allocate(15) == c);
+}
+
+TEST_CASE("SubAllocator respects alignment")
+{
+    SubAllocator alloc(256);
+    alloc.allocate(3);
+    uint64_t aligned = alloc.allocate(16, 64);
+    REQUIRE(aligned == 64);
+    // the padding in front stays usable
+    REQUIRE(alloc.allocate(61) == 3);
+    REQUIRE_THROWS(alloc.free(5));
+}
+
+TEST_CASE("SubAllocator returns to a single range after random use")
+{
+    SubAllocator alloc(1 << 20);
+    std::mt19937 rng(42);
+    std::vector<uint64_t> live;
+    for (int i = 0; i < 10'000; i++)
+    {
+        if (live.empty() || rng() % 3 != 0)
+        {
+            uint64_t offset = alloc.allocate(1 + rng() % 1000, 1u << (rng() % 5));
+            if (offset != SubAllocator::kInvalidOffset)
+            {
+                live.push_back(offset);
+            }
+        }
+        else
+        {
+            size_t idx = rng() % live.size();
+            alloc.free(live[idx]);
+            live[idx] = live.back();
+            live.pop_back();
+        }
+    }
+    REQUIRE(alloc.stats().allocation_count == live.size());
+    for (uint64_t offset : live)
+    {
+        alloc.free(offset);
+    }
+    SubAllocatorStats stats = alloc.stats();
+    REQUIRE(stats.used == 0);
+    REQUIRE(stats.free_range_count == 1);
+    REQUIRE(stats.largest_free == stats.capacity);
+}
+
+TEST_CASE("RingAllocator reuses space in allocation order")
+{
+    RingAllocator ring(100);
+    REQUIRE(ring.allocate(40) == 0);
+    const uint64_t first = ring.head();
+    REQUIRE(ring.allocate(40) == 40);
+    const uint64_t second = ring.head();
+    REQUIRE(ring.allocate(40) == RingAllocator::kInvalidOffset);
+
+    // the end of the ring is too small, the range starts over at 0 once the first one is released
+    ring.release(first);
+    REQUIRE(ring.allocate(30) == 0);
+    // the skipped end of the ring stays in use until the second range is released
+    REQUIRE(ring.used() == 90);
+    REQUIRE(ring.allocate(20) == RingAllocator::kInvalidOffset);
+
+    ring.release(second);
+    REQUIRE(ring.allocate(50) == 30);
+    REQUIRE(ring.allocate(30) == RingAllocator::kInvalidOffset);
+}
+
+TEST_CASE("RingAllocator aligns and restarts when empty")
+{
+    RingAllocator ring(64);
+    REQUIRE(ring.allocate(3) == 0);
+    REQUIRE(ring.allocate(8, 16) == 16);
+    REQUIRE(ring.allocate(65) == RingAllocator::kInvalidOffset);
+
+    // a released ring can hold its full capacity in one range
+    ring.release(ring.head());
+    REQUIRE(ring.used() == 0);
+    REQUIRE(ring.allocate(64) == 0);
+    REQUIRE(ring.allocate(1) == RingAllocator::kInvalidOffset);
+    ring.release(ring.head());
+    REQUIRE(ring.allocate(64, 16) == 0);
+}
@@ -0,0 +1,113 @@
+#include "mesh.h"
+#include "vertexformat.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace rendersystem;
+
+// random vertices within an elongated box, unit normals and uvs which wrap a few times
+static std::vector<VertexAttributes> make_vertices(size_t count)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<VertexAttributes> vertices(count);
+    for (VertexAttributes& v : vertices)
+    {
+        v.position = glm::vec3(50.0f * unit(rng), 2.0f * unit(rng) + 10.0f, 0.5f * unit(rng));
+        do
+        {
+            v.normal = glm::vec3(unit(rng), unit(rng), unit(rng));
+        } while (glm::length(v.normal) < 0.1f);
+        v.normal = glm::normalize(v.normal);
+        v.uv = glm::vec2(2.0f + 2.0f * unit(rng), 0.5f + 0.5f * unit(rng));
+        v.color = glm::vec3(0.5f + 0.5f * unit(rng), 1.0f, 0.0f);
+    }
+    // the axis directions and the corners of the folded octahedron
+    const glm::vec3 normals[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, 1e-7f, -1}};
+    for (size_t i = 0; i < std::size(normals); i++)
+    {
+        vertices[i].normal = normals[i];
+    }
+    return vertices;
+}
+
+TEST_CASE("Compact vertices stay within their error bounds")
+{
+    const std::vector<VertexAttributes> vertices = make_vertices(100'000);
+    const PositionDecode decode = position_decode(vertices.data(), vertices.size());
+    REQUIRE(decode.scale > 99.0f);
+    REQUIRE(decode.scale <= 100.0f);
+    std::vector<CompactVertex> compact(vertices.size());
+    encode_compact(vertices.data(), vertices.size(), decode, compact.data());
+
+    // half a quantization step of the largest extent, plus float rounding of the decode
+    const float position_bound = 0.5f * decode.scale / 65535.0f + 1e-5f;
+    float max_position_error = 0.0f;
+    float max_normal_error = 0.0f;
+    float max_uv_error = 0.0f;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const VertexAttributes& v = vertices[i];
+        const VertexAttributes d = decode_compact(compact[i], decode);
+        const glm::vec3 position_error = glm::abs(d.position - v.position);
+        max_position_error = std::max({max_position_error, position_error.x, position_error.y, position_error.z});
+        // the angle from the distance of the unit vectors, acos of a float dot product is too coarse near 0
+        max_normal_error = std::max(max_normal_error, 2.0f * std::asin(0.5f * glm::length(d.normal - v.normal)));
+        // half floats have 11 significant bits, uvs up to 4 are within 2^-10 of each other
+        const glm::vec2 uv_error = glm::abs(d.uv - v.uv);
+        max_uv_error = std::max({max_uv_error, uv_error.x, uv_error.y});
+        REQUIRE(std::abs(d.color.x - v.color.x) <= 0.5f / 255.0f + 1e-6f);
+    }
+    CAPTURE(max_position_error, position_bound, max_normal_error, max_uv_error);
+    REQUIRE(max_position_error <= position_bound);
+    // below 0.01 degrees
+    REQUIRE(max_normal_error < 1.5e-4f);
+    REQUIRE(max_uv_error <= 0.5f * std::ldexp(1.0f, -9));
+}
+
+TEST_CASE("Half floats round to nearest even")
+{
+    REQUIRE(float_to_half(0.0f) == 0x0000);
+    REQUIRE(float_to_half(-0.0f) == 0x8000);
+    REQUIRE(float_to_half(1.0f) == 0x3c00);
+    REQUIRE(float_to_half(-2.0f) == 0xc000);
+    REQUIRE(float_to_half(65504.0f) == 0x7bff);
+    // halfway between 65504 and 65536 rounds to the even infinity
+    REQUIRE(float_to_half(65520.0f) == 0x7c00);
+    REQUIRE(float_to_half(std::numeric_limits<float>::infinity()) == 0x7c00);
+    REQUIRE((float_to_half(std::numeric_limits<float>::quiet_NaN()) & 0x7fff) > 0x7c00);
+    // smallest subnormal, and a tie between 1 and the next half which rounds to the even 1
+    REQUIRE(float_to_half(std::ldexp(1.0f, -24)) == 0x0001);
+    REQUIRE(float_to_half(1.0f + std::ldexp(1.0f, -11)) == 0x3c00);
+    REQUIRE(float_to_half(1.0f + 3 * std::ldexp(1.0f, -11)) == 0x3c02);
+
+    // every finite half converts back exactly
+    for (uint32_t h = 0; h < 0x10000; h++)
+    {
+        if ((h & 0x7c00) != 0x7c00)
+        {
+            REQUIRE(float_to_half(half_to_float((uint16_t)h)) == h);
+        }
+    }
+}
+
+TEST_CASE("Compact vertices take less than half the memory")
+{
+    REQUIRE(vertex_stride(VertexFormat::standard) == 44);
+    REQUIRE(vertex_stride(VertexFormat::compact) == 20);
+    REQUIRE(vertex_stride(VertexFormat::compact) * 2 < vertex_stride(VertexFormat::standard));
+
+    // the same locations in both formats, so one fragment shader serves both
+    const VertexInputDescriptionData& standard = Mesh::get_vertex_input_description(VertexFormat::standard);
+    const VertexInputDescriptionData& compact = Mesh::get_vertex_input_description(VertexFormat::compact);
+    REQUIRE(compact.bindings[0].stride == sizeof(CompactVertex));
+    REQUIRE(compact.attributes.size() == standard.attributes.size());
+    for (size_t i = 0; i < compact.attributes.size(); i++)
+    {
+        REQUIRE(compact.attributes[i].location == standard.attributes[i].location);
+        REQUIRE(compact.attributes[i].offset < sizeof(CompactVertex));
+    }
+}
@@ -0,0 +1,217 @@
+#include "upload.h"
+#include "check.h"
+#include "core.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vk_mem_alloc.h>
+
+namespace rendersystem
+{
+
+// offsets of copy regions, well above the optimal buffer copy offset alignment of common devices
+static const VkDeviceSize kStagingAlignment = 16;
+
+UploadManager::UploadManager()
+    : m_device(), m_allocator(), m_queue(), m_cmd_pool(), m_staging(), m_staging_allocation(),
+      m_staging_data(nullptr), m_next_batch(1), m_completed(0)
+{
+}
+
+void UploadManager::create(const CoreData& core_data, VkDeviceSize staging_size)
+{
+    // enqueue copies in chunks of whole alignment units, a smaller ring would never make progress
+    if (staging_size < kStagingAlignment)
+    {
+        throw std::runtime_error("staging size of " + std::to_string(staging_size) +
+                                 " bytes is below the staging alignment of " + std::to_string(kStagingAlignment));
+    }
+    m_device = core_data.device;
+    m_allocator = core_data.allocator;
+    m_queue = core_data.transfer_queue;
+    m_ring = RingAllocator(staging_size);
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = staging_size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    // CPU_ONLY memory is host coherent, so writes need no flush before the submission
+    VmaAllocationCreateInfo vmaallocInfo = {};
+    vmaallocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    vmaallocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VmaAllocationInfo allocation_info = {};
+    VK_CHECK_RESULT(vmaCreateBuffer(m_allocator, &bufferInfo, &vmaallocInfo, &m_staging, &m_staging_allocation,
+                                    &allocation_info));
+    m_staging_data = (char*)allocation_info.pMappedData;
+
+    VkCommandPoolCreateInfo cmd_pool_info = {};
+    cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmd_pool_info.queueFamilyIndex = core_data.transfer_queue_family;
+    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    VK_CHECK_RESULT(vkCreateCommandPool(m_device, &cmd_pool_info, nullptr, &m_cmd_pool));
+}
+
+void UploadManager::destroy()
+{
+    while (!m_in_flight.empty())
+    {
+        wait_oldest();
+    }
+    for (Batch& batch : m_idle)
+    {
+        vkDestroyFence(m_device, batch.fence, nullptr);
+    }
+    m_idle.clear();
+    m_pending.clear();
+    vkDestroyCommandPool(m_device, m_cmd_pool, nullptr);
+    vmaDestroyBuffer(m_allocator, m_staging, m_staging_allocation);
+    m_staging_data = nullptr;
+}
+
+uint64_t UploadManager::enqueue(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size)
+{
+    // data larger than the ring is split into chunks, which may end up in several batches
+    const char* src = (const char*)data;
+    while (size > 0)
+    {
+        const VkDeviceSize chunk = std::min(size, m_ring.capacity() - m_ring.capacity() % kStagingAlignment);
+        uint64_t offset;
+        while ((offset = m_ring.allocate(chunk, kStagingAlignment)) == RingAllocator::kInvalidOffset)
+        {
+            // the ring is full of pending copies, submit them to get their space back eventually
+            if (m_in_flight.empty())
+            {
+                flush();
+            }
+            wait_oldest();
+            m_stats.stalls++;
+        }
+        memcpy(m_staging_data + offset, src, chunk);
+        m_pending.push_back(Copy{dst, VkBufferCopy{offset, dst_offset, chunk}});
+        m_stats.bytes += chunk;
+        m_stats.copies++;
+
+        src += chunk;
+        dst_offset += chunk;
+        size -= chunk;
+    }
+    return m_next_batch;
+}
+
+void UploadManager::flush()
+{
+    if (m_pending.empty())
+    {
+        return;
+    }
+    Batch batch;
+    if (!m_idle.empty())
+    {
+        batch = m_idle.back();
+        m_idle.pop_back();
+    }
+    else
+    {
+        VkCommandBufferAllocateInfo cmd_buf_info = {};
+        cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cmd_buf_info.commandPool = m_cmd_pool;
+        cmd_buf_info.commandBufferCount = 1;
+        cmd_buf_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(m_device, &cmd_buf_info, &batch.cmd_buf));
+
+        VkFenceCreateInfo fence_create_info = {};
+        fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VK_CHECK_RESULT(vkCreateFence(m_device, &fence_create_info, nullptr, &batch.fence));
+    }
+
+    VkCommandBufferBeginInfo cmd_begin_info = {};
+    cmd_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmd_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(batch.cmd_buf, &cmd_begin_info));
+    // one copy command per run of copies into the same buffer
+    for (size_t i = 0; i < m_pending.size();)
+    {
+        m_regions.clear();
+        const VkBuffer dst = m_pending[i].dst;
+        for (; i < m_pending.size() && m_pending[i].dst == dst; i++)
+        {
+            m_regions.push_back(m_pending[i].region);
+        }
+        vkCmdCopyBuffer(batch.cmd_buf, m_staging, dst, (uint32_t)m_regions.size(), m_regions.data());
+    }
+    VK_CHECK_RESULT(vkEndCommandBuffer(batch.cmd_buf));
+
+    // the fence signal makes the copies available to all later work, which starts only once the host has seen the
+    // fence through is_complete() or wait()
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &batch.cmd_buf;
+    VK_CHECK_RESULT(vkQueueSubmit(m_queue, 1, &submit_info, batch.fence));
+
+    batch.id = m_next_batch++;
+    batch.staging_head = m_ring.head();
+    m_in_flight.push_back(batch);
+    m_pending.clear();
+    m_stats.batches++;
+}
+
+bool UploadManager::is_complete(uint64_t batch)
+{
+    if (batch >= m_next_batch && m_pending.empty())
+    {
+        // nothing was enqueued into the collecting batch, it only depends on the ones before
+        batch = m_next_batch - 1;
+    }
+    if (batch > m_completed)
+    {
+        retire();
+    }
+    return batch <= m_completed;
+}
+
+void UploadManager::wait(uint64_t batch)
+{
+    if (batch >= m_next_batch)
+    {
+        flush();
+    }
+    while (!is_complete(batch))
+    {
+        wait_oldest();
+    }
+}
+
+UploadStats UploadManager::stats() const
+{
+    UploadStats s = m_stats;
+    s.staging_used = m_ring.used();
+    return s;
+}
+
+void UploadManager::retire()
+{
+    while (!m_in_flight.empty() && vkGetFenceStatus(m_device, m_in_flight.front().fence) == VK_SUCCESS)
+    {
+        Batch& batch = m_in_flight.front();
+        VK_CHECK_RESULT(vkResetFences(m_device, 1, &batch.fence));
+        m_completed = batch.id;
+        m_ring.release(batch.staging_head);
+        m_idle.push_back(batch);
+        m_in_flight.pop_front();
+    }
+}
+
+void UploadManager::wait_oldest()
+{
+    if (m_in_flight.empty())
+    {
+        throw std::runtime_error("UploadManager: waiting without a submitted batch");
+    }
+    VK_CHECK_RESULT(vkWaitForFences(m_device, 1, &m_in_flight.front().fence, VK_TRUE, UINT64_MAX));
+    retire();
+}
+
+} // namespace rendersystem
@@ -0,0 +1,89 @@
+#pragma once
+#include "suballocator.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+// forward decl
+VK_DEFINE_HANDLE(VmaAllocation)
+VK_DEFINE_HANDLE(VmaAllocator)
+
+namespace rendersystem
+{
+struct CoreData;
+
+struct UploadStats
+{
+    uint64_t bytes = 0;       // total bytes copied
+    uint64_t copies = 0;      // enqueued copy regions
+    uint64_t batches = 0;     // submissions to the transfer queue
+    uint64_t stalls = 0;      // waits for the GPU because the staging ring was full
+    uint64_t staging_used = 0; // staging bytes not yet released by the GPU
+};
+
+/**
+ * Copy data into device-local buffers through a persistently mapped staging ring. Copies are collected into a batch
+ * which flush() submits to the transfer queue as one command buffer; a fence per batch tells when the batch and its
+ * staging memory are done. Destination buffers must be usable by the transfer and the graphics queue family.
+ *
+ * Batches have increasing ids, so a single id answers whether all copies enqueued up to that point are complete.
+ */
+class UploadManager
+{
+  public:
+    UploadManager();
+    UploadManager(const UploadManager& rhs) = delete;
+    // throws if staging_size cannot hold an aligned chunk of at least 16 bytes
+    void create(const CoreData& core_data, VkDeviceSize staging_size);
+    void destroy();
+
+    // copy size bytes into dst at dst_offset, returns the id of the batch the copy is part of.
+    // Blocks only if the staging ring is full of copies the GPU did not finish yet.
+    uint64_t enqueue(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size);
+    // submit the enqueued copies, does nothing if there are none
+    void flush();
+    // true once the batch and all batches before it completed on the GPU
+    bool is_complete(uint64_t batch);
+    // flush if necessary and block until the batch completed
+    void wait(uint64_t batch);
+
+    UploadStats stats() const;
+
+  private:
+    struct Batch
+    {
+        VkCommandBuffer cmd_buf;
+        VkFence fence;
+        uint64_t id;
+        uint64_t staging_head; // ring head after the last copy of the batch
+    };
+    struct Copy
+    {
+        VkBuffer dst;
+        VkBufferCopy region;
+    };
+    // release all in-flight batches whose fence is signaled
+    void retire();
+    void wait_oldest();
+
+  private:
+    VkDevice m_device;
+    VmaAllocator m_allocator;
+    VkQueue m_queue;
+    VkCommandPool m_cmd_pool;
+    VkBuffer m_staging;
+    VmaAllocation m_staging_allocation;
+    char* m_staging_data;
+    RingAllocator m_ring;
+
+    std::vector<Copy> m_pending;
+    std::vector<VkBufferCopy> m_regions; // scratch for grouping m_pending by destination
+    std::deque<Batch> m_in_flight;
+    std::vector<Batch> m_idle;
+    uint64_t m_next_batch;  // id of the batch collecting copies
+    uint64_t m_completed;   // all batches up to this id are complete
+    UploadStats m_stats;
+};
+
+} // namespace rendersystem
@@ -0,0 +1,194 @@
+#include "vertexformat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rendersystem
+{
+
+namespace
+{
+
+// the conversions of the vertex input stage, VK_FORMAT_*_UNORM and VK_FORMAT_*_SNORM
+uint16_t to_unorm16(float v)
+{
+    return (uint16_t)std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f);
+}
+
+float from_unorm16(uint16_t v)
+{
+    return v / 65535.0f;
+}
+
+int16_t to_snorm16(float v)
+{
+    return (int16_t)std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+float from_snorm16(int16_t v)
+{
+    return std::max(v / 32767.0f, -1.0f);
+}
+
+uint8_t to_unorm8(float v)
+{
+    return (uint8_t)std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f);
+}
+
+float sign_not_zero(float v)
+{
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+} // namespace
+
+size_t vertex_stride(VertexFormat format)
+{
+    return format == VertexFormat::compact ? sizeof(CompactVertex) : sizeof(VertexAttributes);
+}
+
+PositionDecode position_decode(const VertexAttributes* vertices, size_t count)
+{
+    PositionDecode decode;
+    if (count == 0)
+    {
+        return decode;
+    }
+    glm::vec3 min = vertices[0].position;
+    glm::vec3 max = vertices[0].position;
+    for (size_t i = 1; i < count; i++)
+    {
+        min = glm::min(min, vertices[i].position);
+        max = glm::max(max, vertices[i].position);
+    }
+    const glm::vec3 extent = max - min;
+    decode.offset = min;
+    decode.scale = std::max({extent.x, extent.y, extent.z});
+    // all vertices in one point still need a valid mapping
+    if (decode.scale <= 0.0f)
+    {
+        decode.scale = 1.0f;
+    }
+    return decode;
+}
+
+void encode_compact(const VertexAttributes* vertices, size_t count, const PositionDecode& decode, CompactVertex* out)
+{
+    const float inv_scale = 1.0f / decode.scale;
+    for (size_t i = 0; i < count; i++)
+    {
+        const VertexAttributes& v = vertices[i];
+        CompactVertex& c = out[i];
+        const glm::vec3 p = (v.position - decode.offset) * inv_scale;
+        c.position[0] = to_unorm16(p.x);
+        c.position[1] = to_unorm16(p.y);
+        c.position[2] = to_unorm16(p.z);
+        c.position[3] = 0;
+        const glm::vec2 n = octahedral_encode(v.normal);
+        c.normal[0] = to_snorm16(n.x);
+        c.normal[1] = to_snorm16(n.y);
+        c.uv[0] = float_to_half(v.uv.x);
+        c.uv[1] = float_to_half(v.uv.y);
+        c.color[0] = to_unorm8(v.color.x);
+        c.color[1] = to_unorm8(v.color.y);
+        c.color[2] = to_unorm8(v.color.z);
+        c.color[3] = 255;
+    }
+}
+
+VertexAttributes decode_compact(const CompactVertex& vertex, const PositionDecode& decode)
+{
+    VertexAttributes v;
+    v.position = decode.offset + decode.scale * glm::vec3(from_unorm16(vertex.position[0]),
+                                                          from_unorm16(vertex.position[1]),
+                                                          from_unorm16(vertex.position[2]));
+    v.normal = octahedral_decode(glm::vec2(from_snorm16(vertex.normal[0]), from_snorm16(vertex.normal[1])));
+    v.uv = glm::vec2(half_to_float(vertex.uv[0]), half_to_float(vertex.uv[1]));
+    v.color = glm::vec3(vertex.color[0], vertex.color[1], vertex.color[2]) / 255.0f;
+    return v;
+}
+
+glm::vec2 octahedral_encode(const glm::vec3& n)
+{
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.0f)
+    {
+        return glm::vec2(0.0f);
+    }
+    // project onto the octahedron, then fold the lower half over the diagonals
+    glm::vec2 e(n.x / l1, n.y / l1);
+    if (n.z < 0.0f)
+    {
+        e = glm::vec2((1.0f - std::abs(e.y)) * sign_not_zero(e.x), (1.0f - std::abs(e.x)) * sign_not_zero(e.y));
+    }
+    return e;
+}
+
+glm::vec3 octahedral_decode(const glm::vec2& e)
+{
+    // same as mesh_compact.vert
+    glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    const float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+uint16_t float_to_half(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    const uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    const uint32_t magnitude = x & 0x7fffffff;
+    if (magnitude >= 0x7f800000)
+    {
+        // infinity, or a quiet NaN
+        return (uint16_t)(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+    }
+    if (magnitude >= 0x477ff000)
+    {
+        // rounds to 65520 or more
+        return (uint16_t)(sign | 0x7c00);
+    }
+    if (magnitude < 0x38800000)
+    {
+        // below the smallest normal half 2^-14, in multiples of 2^-24. May round up to the smallest normal
+        float a;
+        memcpy(&a, &magnitude, sizeof(a));
+        return (uint16_t)(sign | (uint16_t)std::nearbyint(a * 16777216.0f));
+    }
+    // rebias the exponent from 127 to 15 and drop 13 mantissa bits, a carry correctly increments the exponent
+    uint32_t h = (magnitude - 0x38000000) >> 13;
+    const uint32_t rest = magnitude & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1) != 0))
+    {
+        h++;
+    }
+    return (uint16_t)(sign | h);
+}
+
+float half_to_float(uint16_t h)
+{
+    const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1f;
+    const uint32_t mantissa = h & 0x3ff;
+    if (exponent == 0)
+    {
+        const float magnitude = std::ldexp((float)mantissa, -24);
+        return sign != 0 ? -magnitude : magnitude;
+    }
+    uint32_t x;
+    if (exponent == 31)
+    {
+        x = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+} // namespace rendersystem
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace rendersystem
+{
+
+struct VertexAttributes
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+    glm::vec3 color;
+};
+
+/**
+ * Layout of the vertices of a mesh on the GPU, chosen per mesh. Each format has its own vertex buffer in the
+ * GeometryArena and its own mesh pipeline.
+ */
+enum class VertexFormat : uint32_t
+{
+    standard, // VertexAttributes, 44 bytes of floats
+    compact,  // CompactVertex, 20 bytes
+};
+const uint32_t kVertexFormatCount = 2;
+
+/**
+ * Quantized vertex, decoded by the vertex input stage and mesh_compact.vert:
+ * - position: 16 bit unsigned normalized per axis, relative to the mesh bounds, see PositionDecode. w is unused since
+ *   three component 16 bit formats are optional for vertex buffers
+ * - normal: octahedral encoding, 16 bit signed normalized per component
+ * - uv: half floats
+ * - color: 8 bit unsigned normalized, alpha is 1
+ */
+struct CompactVertex
+{
+    uint16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+    uint8_t color[4];
+};
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex has to match its vertex input description");
+
+/**
+ * Maps quantized positions in [0, 1]^3 back to model space: offset + scale * p. The scale is the same for all axes,
+ * so folded into the model matrix it keeps bounding spheres spheres.
+ */
+struct PositionDecode
+{
+    glm::vec3 offset = glm::vec3(0.0f);
+    float scale = 1.0f;
+};
+
+size_t vertex_stride(VertexFormat format);
+
+// the cube around the positions of vertices, scaled to the largest extent of their bounding box
+PositionDecode position_decode(const VertexAttributes* vertices, size_t count);
+// quantize count vertices into out, positions relative to decode
+void encode_compact(const VertexAttributes* vertices, size_t count, const PositionDecode& decode, CompactVertex* out);
+// what the GPU reads from an encoded vertex, for tests
+VertexAttributes decode_compact(const CompactVertex& vertex, const PositionDecode& decode);
+
+// octahedral mapping of a unit vector to the square [-1, 1]^2, and back to a unit vector
+glm::vec2 octahedral_encode(const glm::vec3& n);
+glm::vec3 octahedral_decode(const glm::vec2& e);
+// IEEE 754 binary16, rounded to nearest even. Out of range values become infinity
+uint16_t float_to_half(float f);
+float half_to_float(uint16_t h);
+
+} // namespace rendersystem
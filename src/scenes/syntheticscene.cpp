@@ -0,0 +1,92 @@
+#include "syntheticscene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+
+namespace scenes
+{
+
+SceneConfig scene_config()
+{
+    const char* env = std::getenv("BENCHMARK_SCENE");
+    const std::string size = env != nullptr && *env != '\0' ? env : "small";
+    if (size == "small")
+    {
+        return SceneConfig{size, 1'000, 16, 8, 64, 100.0f};
+    }
+    if (size == "medium")
+    {
+        return SceneConfig{size, 10'000, 64, 8, 256, 200.0f};
+    }
+    if (size == "large")
+    {
+        return SceneConfig{size, 50'000, 256, 8, 512, 400.0f};
+    }
+    char* end = nullptr;
+    const unsigned long entities = std::strtoul(size.c_str(), &end, 10);
+    if (entities == 0 || *end != '\0')
+    {
+        throw std::invalid_argument("BENCHMARK_SCENE must be small, medium, large or an entity count: " + size);
+    }
+    // density and mesh sharing of the medium scene
+    return SceneConfig{size + " entities",
+                       (uint32_t)entities,
+                       std::max(1u, (uint32_t)entities / 150),
+                       8,
+                       256,
+                       200.0f * std::cbrt(entities / 10'000.0f)};
+}
+
+components::Visual3d make_sphere(uint32_t resolution, uint32_t variant)
+{
+    components::Visual3d viz;
+    const float radius = 0.5f + 0.5f * (variant % 8) / 7.0f;
+    const glm::vec3 color((variant % 3) / 2.0f, (variant % 5) / 4.0f, (variant % 7) / 6.0f);
+    const float pi = 3.14159265f;
+    for (uint32_t ring = 0; ring <= resolution; ring++)
+    {
+        const float theta = pi * ring / resolution;
+        for (uint32_t segment = 0; segment <= resolution; segment++)
+        {
+            const float phi = 2.0f * pi * segment / resolution;
+            const glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            const glm::vec2 uv(segment / (float)resolution, ring / (float)resolution);
+            viz.vertices().push_back(components::StandardVertex{radius * normal, normal, uv, color});
+        }
+    }
+    const uint32_t row = resolution + 1;
+    for (uint32_t ring = 0; ring < resolution; ring++)
+    {
+        for (uint32_t segment = 0; segment < resolution; segment++)
+        {
+            const uint32_t i = ring * row + segment;
+            viz.indices().insert(viz.indices().end(), {i, i + row, i + 1, i + 1, i + row, i + row + 1});
+        }
+    }
+    viz.update_bounds();
+    return viz;
+}
+
+SyntheticScene::SyntheticScene(const SceneConfig& config) : m_config(config)
+{
+    for (uint32_t i = 0; i < config.meshes; i++)
+    {
+        m_meshes.push_back(make_sphere(config.mesh_resolution, i));
+    }
+    std::mt19937 rng(config.seed);
+    std::uniform_real_distribution<float> position(-config.extent / 2, config.extent / 2);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> mesh(0, config.meshes - 1);
+    for (uint32_t i = 0; i < config.entities; i++)
+    {
+        components::CoordSys coord;
+        coord.position() = glm::vec3(position(rng), position(rng), position(rng));
+        coord.rotation() = glm::angleAxis(3.0f * value(rng), glm::normalize(glm::vec3(value(rng), 1.0f, value(rng))));
+        m_registry.create(coord, m_meshes[mesh(rng)]);
+    }
+    m_registry.create(components::Camera(4 / 3.0f, 60.0f));
+}
+
+} // namespace scenes
@@ -0,0 +1,67 @@
+#pragma once
+#include "camera.h"
+#include "coordsys.h"
+#include "registry.h"
+#include "visual.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace scenes
+{
+
+/**
+ * Size of a generated scene. The same seed always generates the same scene, so results of different commits compare.
+ */
+struct SceneConfig
+{
+    std::string name;
+    uint32_t entities;        // each a CoordSys and a Visual3d
+    uint32_t meshes;          // distinct geometries shared by the entities
+    uint32_t mesh_resolution; // segments around a mesh, (resolution + 1)^2 vertices
+    uint32_t gltf_grid;       // vertices per side of the grid in the glTF import benchmarks
+    float extent;             // entities are spread over a cube of this edge length around the camera
+    uint32_t seed = 1;
+};
+
+/**
+ * The scene size from the BENCHMARK_SCENE environment variable: small (default), medium, large or an entity count.
+ */
+SceneConfig scene_config();
+
+/**
+ * UV sphere with resolution segments around and resolution rings, radius 0.5 to 1 depending on the variant.
+ */
+components::Visual3d make_sphere(uint32_t resolution, uint32_t variant);
+
+/**
+ * Entities with random transforms and one of config.meshes spheres, and a camera at the origin. Copies of a
+ * Visual3d share its geometry id, so the renderer uploads each mesh once and draws the entities instanced.
+ */
+class SyntheticScene
+{
+  public:
+    explicit SyntheticScene(const SceneConfig& config);
+    SyntheticScene(const SyntheticScene& rhs) = delete;
+    SyntheticScene& operator=(const SyntheticScene& rhs) = delete;
+
+    const SceneConfig& config() const
+    {
+        return m_config;
+    }
+    components::Registry& registry()
+    {
+        return m_registry;
+    }
+    const std::vector<components::Visual3d>& meshes() const
+    {
+        return m_meshes;
+    }
+
+  private:
+    SceneConfig m_config;
+    std::vector<components::Visual3d> m_meshes;
+    components::Registry m_registry;
+};
+
+} // namespace scenes
@@ -0,0 +1,52 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace spatial
+{
+
+/**
+ * Axis-aligned bounding box. An Aabb with min > max is empty, merging with it yields the other box.
+ */
+struct Aabb
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    glm::vec3 center() const
+    {
+        return 0.5f * (min + max);
+    }
+    glm::vec3 extent() const
+    {
+        return 0.5f * (max - min);
+    }
+    // the cost measure of the surface area heuristic
+    float surface_area() const
+    {
+        const glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    bool contains(const Aabb& rhs) const
+    {
+        return glm::all(glm::lessThanEqual(min, rhs.min)) && glm::all(glm::greaterThanEqual(max, rhs.max));
+    }
+    bool overlaps(const Aabb& rhs) const
+    {
+        return glm::all(glm::lessThanEqual(min, rhs.max)) && glm::all(glm::greaterThanEqual(max, rhs.min));
+    }
+    bool operator==(const Aabb& rhs) const
+    {
+        return min == rhs.min && max == rhs.max;
+    }
+    bool operator!=(const Aabb& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+inline Aabb merge(const Aabb& a, const Aabb& b)
+{
+    return Aabb{glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+} // namespace spatial
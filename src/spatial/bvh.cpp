@@ -0,0 +1,296 @@
+#include "bvh.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace spatial
+{
+
+uint32_t Bvh::allocate_node()
+{
+    if (m_free == kNull)
+    {
+        m_nodes.push_back(Node{});
+        m_free = (uint32_t)m_nodes.size() - 1;
+        m_nodes[m_free].parent = kNull;
+    }
+    const uint32_t node = m_free;
+    m_free = m_nodes[node].parent;
+    m_nodes[node] = Node{Aabb{}, kNull, kNull, kNull, 0};
+    return node;
+}
+
+void Bvh::free_node(uint32_t node)
+{
+    m_nodes[node].parent = m_free;
+    m_free = node;
+}
+
+void Bvh::refit_ancestors(uint32_t node)
+{
+    for (; node != kNull; node = m_nodes[node].parent)
+    {
+        Node& n = m_nodes[node];
+        n.box = merge(m_nodes[n.left].box, m_nodes[n.right].box);
+    }
+}
+
+uint32_t Bvh::insert(const Aabb& box, uint32_t user_data)
+{
+    const uint32_t leaf = allocate_node();
+    m_nodes[leaf].box = box;
+    m_nodes[leaf].user_data = user_data;
+    m_leaf_count++;
+    if (m_root == kNull)
+    {
+        m_root = leaf;
+        return leaf;
+    }
+
+    // descend to the sibling which increases the surface area of the tree the least
+    uint32_t sibling = m_root;
+    while (!m_nodes[sibling].is_leaf())
+    {
+        const Node& node = m_nodes[sibling];
+        const float area = node.box.surface_area();
+        const float merged_area = merge(node.box, box).surface_area();
+        // pairing with this node creates a parent of merged_area
+        const float cost = 2.0f * merged_area;
+        // descending enlarges this node, whichever child is picked
+        const float inheritance_cost = 2.0f * (merged_area - area);
+        auto child_cost = [&](uint32_t child) {
+            const Node& c = m_nodes[child];
+            const float enlarged = merge(c.box, box).surface_area();
+            return inheritance_cost + (c.is_leaf() ? enlarged : enlarged - c.box.surface_area());
+        };
+        const float left_cost = child_cost(node.left);
+        const float right_cost = child_cost(node.right);
+        if (cost < left_cost && cost < right_cost)
+        {
+            break;
+        }
+        sibling = left_cost < right_cost ? node.left : node.right;
+    }
+
+    const uint32_t old_parent = m_nodes[sibling].parent;
+    const uint32_t new_parent = allocate_node();
+    m_nodes[new_parent].parent = old_parent;
+    m_nodes[new_parent].left = sibling;
+    m_nodes[new_parent].right = leaf;
+    m_nodes[sibling].parent = new_parent;
+    m_nodes[leaf].parent = new_parent;
+    if (old_parent == kNull)
+    {
+        m_root = new_parent;
+    }
+    else if (m_nodes[old_parent].left == sibling)
+    {
+        m_nodes[old_parent].left = new_parent;
+    }
+    else
+    {
+        m_nodes[old_parent].right = new_parent;
+    }
+    refit_ancestors(new_parent);
+    return leaf;
+}
+
+void Bvh::remove(uint32_t leaf)
+{
+    assert(m_nodes[leaf].is_leaf());
+    m_leaf_count--;
+    if (leaf == m_root)
+    {
+        m_root = kNull;
+        free_node(leaf);
+        return;
+    }
+    // the sibling takes the place of the parent
+    const uint32_t parent = m_nodes[leaf].parent;
+    const uint32_t grand_parent = m_nodes[parent].parent;
+    const uint32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+    m_nodes[sibling].parent = grand_parent;
+    if (grand_parent == kNull)
+    {
+        m_root = sibling;
+    }
+    else
+    {
+        if (m_nodes[grand_parent].left == parent)
+        {
+            m_nodes[grand_parent].left = sibling;
+        }
+        else
+        {
+            m_nodes[grand_parent].right = sibling;
+        }
+        refit_ancestors(grand_parent);
+    }
+    free_node(parent);
+    free_node(leaf);
+}
+
+void Bvh::refit(uint32_t leaf, const Aabb& box)
+{
+    assert(m_nodes[leaf].is_leaf());
+    m_nodes[leaf].box = box;
+    for (uint32_t node = m_nodes[leaf].parent; node != kNull; node = m_nodes[node].parent)
+    {
+        Node& n = m_nodes[node];
+        const Aabb merged = merge(m_nodes[n.left].box, m_nodes[n.right].box);
+        // the ancestors only depend on the box of this node
+        if (merged == n.box)
+        {
+            break;
+        }
+        n.box = merged;
+    }
+}
+
+uint32_t Bvh::build_range(BuildItem* items, size_t count, uint32_t parent)
+{
+    if (count == 1)
+    {
+        m_nodes[items[0].leaf].parent = parent;
+        return items[0].leaf;
+    }
+    Aabb centers{glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+    for (size_t i = 0; i < count; i++)
+    {
+        centers = merge(centers, Aabb{items[i].center, items[i].center});
+    }
+    // split at the median of the centers along the axis they spread the most
+    const glm::vec3 size = centers.max - centers.min;
+    const int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+    const size_t half = count / 2;
+    std::nth_element(items, items + half, items + count,
+                     [axis](const BuildItem& a, const BuildItem& b) { return a.center[axis] < b.center[axis]; });
+
+    const uint32_t node = allocate_node();
+    const uint32_t left = build_range(items, half, node);
+    const uint32_t right = build_range(items + half, count - half, node);
+    // allocate_node may have reallocated m_nodes
+    Node& n = m_nodes[node];
+    n.parent = parent;
+    n.left = left;
+    n.right = right;
+    n.box = merge(m_nodes[left].box, m_nodes[right].box);
+    return node;
+}
+
+void Bvh::build_leaves(const std::vector<uint32_t>& leaves)
+{
+    // the centers are copied next to the leaf ids, so partitioning does not chase into m_nodes
+    std::vector<BuildItem> items(leaves.size());
+    for (size_t i = 0; i < leaves.size(); i++)
+    {
+        items[i] = BuildItem{m_nodes[leaves[i]].box.center(), leaves[i]};
+    }
+    m_root = build_range(items.data(), items.size(), kNull);
+}
+
+void Bvh::build(const std::vector<Aabb>& boxes, const std::vector<uint32_t>& user_data,
+                std::vector<uint32_t>* leaves)
+{
+    assert(boxes.size() == user_data.size());
+    clear();
+    m_nodes.reserve(2 * boxes.size());
+    leaves->resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+        const uint32_t leaf = allocate_node();
+        m_nodes[leaf].box = boxes[i];
+        m_nodes[leaf].user_data = user_data[i];
+        (*leaves)[i] = leaf;
+    }
+    m_leaf_count = boxes.size();
+    if (!boxes.empty())
+    {
+        build_leaves(*leaves);
+    }
+}
+
+void Bvh::rebuild()
+{
+    if (m_root == kNull)
+    {
+        return;
+    }
+    std::vector<uint32_t> leaves;
+    leaves.reserve(m_leaf_count);
+    std::vector<uint32_t> stack = {m_root};
+    while (!stack.empty())
+    {
+        const uint32_t node = stack.back();
+        stack.pop_back();
+        if (m_nodes[node].is_leaf())
+        {
+            leaves.push_back(node);
+        }
+        else
+        {
+            stack.push_back(m_nodes[node].left);
+            stack.push_back(m_nodes[node].right);
+            free_node(node);
+        }
+    }
+    build_leaves(leaves);
+}
+
+void Bvh::clear()
+{
+    m_nodes.clear();
+    m_root = kNull;
+    m_free = kNull;
+    m_leaf_count = 0;
+}
+
+uint32_t Bvh::height(uint32_t node) const
+{
+    if (m_nodes[node].is_leaf())
+    {
+        return 1;
+    }
+    return 1 + std::max(height(m_nodes[node].left), height(m_nodes[node].right));
+}
+
+uint32_t Bvh::height() const
+{
+    return m_root == kNull ? 0 : height(m_root);
+}
+
+bool Bvh::validate() const
+{
+    if (m_root == kNull)
+    {
+        return m_leaf_count == 0;
+    }
+    if (m_nodes[m_root].parent != kNull)
+    {
+        return false;
+    }
+    size_t leaf_count = 0;
+    std::vector<uint32_t> stack = {m_root};
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        const uint32_t index = stack.back();
+        stack.pop_back();
+        if (node.is_leaf())
+        {
+            leaf_count++;
+            continue;
+        }
+        for (uint32_t child : {node.left, node.right})
+        {
+            if (m_nodes[child].parent != index || !node.box.contains(m_nodes[child].box))
+            {
+                return false;
+            }
+            stack.push_back(child);
+        }
+    }
+    return leaf_count == m_leaf_count;
+}
+
+} // namespace spatial
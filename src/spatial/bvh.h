@@ -0,0 +1,264 @@
+#pragma once
+#include "aabb.h"
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+namespace spatial
+{
+
+namespace detail
+{
+/**
+ * Stack of the nodes still to visit during a traversal. The first N entries live in a local array, deeper ones spill
+ * to the heap, so queries on a reasonably balanced tree do not allocate.
+ */
+template <typename T, size_t N = 64> class TraversalStack
+{
+  public:
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+    void push(const T& value)
+    {
+        if (m_size < N)
+        {
+            m_fixed[m_size] = value;
+        }
+        else
+        {
+            m_overflow.push_back(value);
+        }
+        m_size++;
+    }
+    T pop()
+    {
+        m_size--;
+        if (m_size < N)
+        {
+            return m_fixed[m_size];
+        }
+        const T value = m_overflow.back();
+        m_overflow.pop_back();
+        return value;
+    }
+
+  private:
+    T m_fixed[N];
+    std::vector<T> m_overflow;
+    size_t m_size = 0;
+};
+} // namespace detail
+
+/**
+ * Dynamic bounding volume hierarchy: a binary tree of Aabb with one object per leaf. Objects are inserted, moved and
+ * removed one at a time, or the whole tree is built top-down at once. Leaves are identified by the id insert() or
+ * build() returned, which stays valid until the leaf is removed, also across rebuild().
+ *
+ * Moving an object refits the boxes of its ancestors without changing the topology. The tree quality degrades when
+ * objects travel far from where they were inserted; rebuild() restores it.
+ */
+class Bvh
+{
+  public:
+    static constexpr uint32_t kNull = UINT32_MAX;
+
+    // add a leaf holding user_data, placed by the surface area heuristic
+    uint32_t insert(const Aabb& box, uint32_t user_data);
+    void remove(uint32_t leaf);
+    // set the box of a leaf and update its ancestors up to the first one which does not change
+    void refit(uint32_t leaf, const Aabb& box);
+    // replace the tree by a top-down build over boxes, leaves[i] receives the leaf of boxes[i]
+    void build(const std::vector<Aabb>& boxes, const std::vector<uint32_t>& user_data, std::vector<uint32_t>* leaves);
+    // rebuild the tree top-down from its current leaves, keeping the leaf ids
+    void rebuild();
+    void clear();
+
+    // number of leaves
+    size_t size() const
+    {
+        return m_leaf_count;
+    }
+    bool empty() const
+    {
+        return m_leaf_count == 0;
+    }
+    uint32_t user_data(uint32_t leaf) const
+    {
+        return m_nodes[leaf].user_data;
+    }
+    const Aabb& bounds(uint32_t leaf) const
+    {
+        return m_nodes[leaf].box;
+    }
+    // longest path from the root to a leaf, 0 for an empty tree
+    uint32_t height() const;
+    // true if parent links are consistent and every box contains the boxes of its children, for tests
+    bool validate() const;
+
+    /**
+     * Call fn(user_data) for every leaf whose box overlaps box.
+     */
+    template <typename F> void query(const Aabb& box, F&& fn) const;
+    /**
+     * Call fn(user_data) for every leaf whose box is not completely on the outer side of one of the planes. Planes are
+     * (normal, distance) pointing inwards, e.g. the six planes of a view frustum. Subtrees completely inside all planes
+     * are reported without further tests, so a leaf may intersect the volume only conservatively.
+     */
+    template <typename F> void query(const glm::vec4* planes, size_t plane_count, F&& fn) const;
+    /**
+     * Call fn(user_data, t) for the leaves whose box the ray origin + t * direction hits for t in [0, t_max], t being
+     * where the ray enters the box. fn returns the new t_max: return t_max to find all hits, the distance of an exact
+     * hit to find the closest one, or 0 to stop. Leaves are not visited in order of t.
+     */
+    template <typename F> void raycast(const glm::vec3& origin, const glm::vec3& direction, float t_max, F&& fn) const;
+
+  private:
+    struct Node
+    {
+        Aabb box;
+        uint32_t parent; // next free node while the node is in the free list
+        uint32_t left;   // kNull for leaves
+        uint32_t right;
+        uint32_t user_data;
+
+        bool is_leaf() const
+        {
+            return left == kNull;
+        }
+    };
+
+    uint32_t allocate_node();
+    void free_node(uint32_t node);
+    // recompute the boxes from node up to the root
+    void refit_ancestors(uint32_t node);
+    struct BuildItem
+    {
+        glm::vec3 center;
+        uint32_t leaf;
+    };
+    uint32_t build_range(BuildItem* items, size_t count, uint32_t parent);
+    // build the tree top-down over leaves, which are not part of any tree
+    void build_leaves(const std::vector<uint32_t>& leaves);
+    uint32_t height(uint32_t node) const;
+
+  private:
+    std::vector<Node> m_nodes;
+    uint32_t m_root = kNull;
+    uint32_t m_free = kNull;
+    size_t m_leaf_count = 0;
+};
+
+template <typename F> void Bvh::query(const Aabb& box, F&& fn) const
+{
+    if (m_root == kNull)
+    {
+        return;
+    }
+    detail::TraversalStack<uint32_t> stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.pop()];
+        if (!node.box.overlaps(box))
+        {
+            continue;
+        }
+        if (node.is_leaf())
+        {
+            fn(node.user_data);
+        }
+        else
+        {
+            stack.push(node.left);
+            stack.push(node.right);
+        }
+    }
+}
+
+template <typename F> void Bvh::query(const glm::vec4* planes, size_t plane_count, F&& fn) const
+{
+    if (m_root == kNull)
+    {
+        return;
+    }
+    // the second element tells whether the node is known to be inside all planes
+    detail::TraversalStack<std::pair<uint32_t, bool>> stack;
+    stack.push({m_root, false});
+    while (!stack.empty())
+    {
+        const auto [index, inside] = stack.pop();
+        const Node& node = m_nodes[index];
+        bool all_inside = inside;
+        if (!inside)
+        {
+            const glm::vec3 center = node.box.center();
+            const glm::vec3 extent = node.box.extent();
+            bool outside = false;
+            all_inside = true;
+            for (size_t p = 0; p < plane_count && !outside; p++)
+            {
+                const glm::vec3 normal(planes[p]);
+                // distance of the center and projected half size of the box along the normal
+                const float distance = glm::dot(normal, center) + planes[p].w;
+                const float radius = glm::dot(glm::abs(normal), extent);
+                outside = distance < -radius;
+                all_inside = all_inside && distance >= radius;
+            }
+            if (outside)
+            {
+                continue;
+            }
+        }
+        if (node.is_leaf())
+        {
+            fn(node.user_data);
+        }
+        else
+        {
+            stack.push({node.left, all_inside});
+            stack.push({node.right, all_inside});
+        }
+    }
+}
+
+template <typename F>
+void Bvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float t_max, F&& fn) const
+{
+    if (m_root == kNull)
+    {
+        return;
+    }
+    // slab test; a zero component gives infinities, which compare correctly unless the origin lies on a slab plane
+    const glm::vec3 inv_direction = 1.0f / direction;
+    detail::TraversalStack<uint32_t> stack;
+    stack.push(m_root);
+    while (!stack.empty() && t_max > 0.0f)
+    {
+        const Node& node = m_nodes[stack.pop()];
+        const glm::vec3 t0 = (node.box.min - origin) * inv_direction;
+        const glm::vec3 t1 = (node.box.max - origin) * inv_direction;
+        const glm::vec3 t_near = glm::min(t0, t1);
+        const glm::vec3 t_far = glm::max(t0, t1);
+        const float enter = glm::max(glm::max(t_near.x, t_near.y), glm::max(t_near.z, 0.0f));
+        const float exit = glm::min(glm::min(t_far.x, t_far.y), glm::min(t_far.z, t_max));
+        if (enter > exit)
+        {
+            continue;
+        }
+        if (node.is_leaf())
+        {
+            t_max = fn(node.user_data, enter);
+        }
+        else
+        {
+            stack.push(node.left);
+            stack.push(node.right);
+        }
+    }
+}
+
+} // namespace spatial
@@ -0,0 +1,92 @@
+#include "entityindex.h"
+
+namespace spatial
+{
+
+using namespace components;
+
+Aabb world_bounds(const CoordSys& coord, const Bounds& bounds)
+{
+    // the extent of the rotated box along each world axis is the extent projected by the absolute rotation matrix
+    const glm::mat3 rotation = glm::mat3_cast(coord.rotation());
+    const glm::vec3 center = coord.position() + rotation * (0.5f * (bounds.min + bounds.max));
+    const glm::vec3 half = 0.5f * (bounds.max - bounds.min);
+    const glm::mat3 abs_rotation(glm::abs(rotation[0]), glm::abs(rotation[1]), glm::abs(rotation[2]));
+    const glm::vec3 extent = abs_rotation * half;
+    return Aabb{center - extent, center + extent};
+}
+
+EntityIndexStats EntityIndex::sync(Registry& registry)
+{
+    EntityIndexStats stats;
+    m_sync_count++;
+    const bool bulk = m_bvh.empty();
+    m_new_boxes.clear();
+    m_new_entities.clear();
+    m_view.each(registry, [this, &stats, bulk](Entity e, CoordSys& coord, Visual3d& viz) {
+        if (e.index() >= m_entries.size())
+        {
+            m_entries.resize(e.index() + 1);
+        }
+        Entry& entry = m_entries[e.index()];
+        // the entity was destroyed and its index reused since the last sync
+        if (entry.leaf != Bvh::kNull && entry.generation != e.generation())
+        {
+            m_bvh.remove(entry.leaf);
+            entry.leaf = Bvh::kNull;
+            stats.removed++;
+        }
+        if (entry.leaf == Bvh::kNull)
+        {
+            if (bulk)
+            {
+                m_new_boxes.push_back(world_bounds(coord, viz.bounds()));
+                m_new_entities.push_back(e.index());
+            }
+            else
+            {
+                entry.leaf = m_bvh.insert(world_bounds(coord, viz.bounds()), e.index());
+            }
+            stats.inserted++;
+        }
+        else if (coord.position() != entry.position || coord.rotation() != entry.rotation)
+        {
+            m_bvh.refit(entry.leaf, world_bounds(coord, viz.bounds()));
+            stats.refitted++;
+        }
+        entry.generation = e.generation();
+        entry.position = coord.position();
+        entry.rotation = coord.rotation();
+        entry.last_sync = m_sync_count;
+    });
+
+    if (bulk)
+    {
+        m_bvh.build(m_new_boxes, m_new_entities, &m_new_leaves);
+        for (size_t i = 0; i < m_new_entities.size(); i++)
+        {
+            m_entries[m_new_entities[i]].leaf = m_new_leaves[i];
+        }
+    }
+    else
+    {
+        for (Entry& entry : m_entries)
+        {
+            if (entry.leaf != Bvh::kNull && entry.last_sync != m_sync_count)
+            {
+                m_bvh.remove(entry.leaf);
+                entry.leaf = Bvh::kNull;
+                stats.removed++;
+            }
+        }
+    }
+    return stats;
+}
+
+void EntityIndex::clear()
+{
+    m_bvh.clear();
+    m_entries.clear();
+}
+
+} // namespace spatial
@@ -0,0 +1,74 @@
+#pragma once
+#include "aabb.h"
+#include "bvh.h"
+#include "coordsys.h"
+#include "entity.h"
+#include "view.h"
+#include "visual.h"
+#include <cstdint>
+#include <vector>
+
+namespace spatial
+{
+
+// world-space box of the model-space box of bounds transformed by coord
+Aabb world_bounds(const components::CoordSys& coord, const components::Bounds& bounds);
+
+struct EntityIndexStats
+{
+    uint32_t inserted = 0;
+    uint32_t refitted = 0;
+    uint32_t removed = 0;
+};
+
+/**
+ * Bvh over the world bounds of all entities with a CoordSys and a Visual3d, kept in sync with the registry. The user
+ * data of the leaves is the entity index, entity() turns it back into a handle.
+ */
+class EntityIndex
+{
+  public:
+    /**
+     * Insert new entities, refit the ones whose position or rotation changed and remove the ones which are gone or
+     * lost a component. Changes of Visual3d::bounds() alone are not detected. When the index is empty, e.g. on the
+     * first call, the tree is built top-down.
+     */
+    EntityIndexStats sync(components::Registry& registry);
+    void clear();
+
+    const Bvh& bvh() const
+    {
+        return m_bvh;
+    }
+    // restore the tree quality after entities travelled far, see Bvh::rebuild()
+    void rebuild()
+    {
+        m_bvh.rebuild();
+    }
+    // the entity of a leaf's user data as of the last sync()
+    components::Entity entity(components::Registry& registry, uint32_t entity_index) const
+    {
+        return components::Entity(&registry, entity_index, m_entries[entity_index].generation);
+    }
+
+  private:
+    struct Entry
+    {
+        uint32_t leaf = Bvh::kNull;
+        uint32_t generation = 0;
+        uint64_t last_sync = 0;
+        glm::vec3 position{0.0f};
+        glm::quat rotation{1, 0, 0, 0};
+    };
+
+    Bvh m_bvh;
+    std::vector<Entry> m_entries; // indexed by entity index
+    uint64_t m_sync_count = 0;
+    // entities to insert in this sync, kept to reuse the capacity
+    std::vector<Aabb> m_new_boxes;
+    std::vector<uint32_t> m_new_entities;
+    std::vector<uint32_t> m_new_leaves;
+    components::View<components::CoordSys, components::Visual3d> m_view;
+};
+
+} // namespace spatial
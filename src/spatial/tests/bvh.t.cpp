@@ -0,0 +1,250 @@
+#include "allocationcounter.h"
+#include "bvh.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+using namespace spatial;
+
+static std::vector<Aabb> random_boxes(size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+    std::vector<Aabb> boxes(count);
+    for (Aabb& box : boxes)
+    {
+        box.min = glm::vec3(position(rng), position(rng), position(rng));
+        box.max = box.min + glm::vec3(size(rng), size(rng), size(rng));
+    }
+    return boxes;
+}
+
+static std::vector<uint32_t> sorted(std::vector<uint32_t> v)
+{
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+// the user data of all boxes overlapping query, by testing every box
+static std::vector<uint32_t> brute_force(const std::vector<Aabb>& boxes, const std::vector<bool>& alive,
+                                         const Aabb& query)
+{
+    std::vector<uint32_t> result;
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        if (alive[i] && boxes[i].overlaps(query))
+        {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+static std::vector<uint32_t> query(const Bvh& bvh, const Aabb& box)
+{
+    std::vector<uint32_t> result;
+    bvh.query(box, [&result](uint32_t user_data) { result.push_back(user_data); });
+    return sorted(result);
+}
+
+TEST_CASE("Empty bvh")
+{
+    Bvh bvh;
+    REQUIRE(bvh.empty());
+    REQUIRE(bvh.height() == 0);
+    REQUIRE(bvh.validate());
+    REQUIRE(query(bvh, Aabb{glm::vec3(-1), glm::vec3(1)}).empty());
+    bvh.rebuild();
+    REQUIRE(bvh.empty());
+}
+
+TEST_CASE("Bvh queries match brute force after inserts, refits and removes")
+{
+    std::mt19937 rng(3);
+    std::vector<Aabb> boxes = random_boxes(2000, rng);
+    std::vector<bool> alive(boxes.size(), true);
+    std::vector<uint32_t> leaves(boxes.size());
+
+    Bvh bvh;
+    SECTION("inserted")
+    {
+        for (uint32_t i = 0; i < boxes.size(); i++)
+        {
+            leaves[i] = bvh.insert(boxes[i], i);
+        }
+    }
+    SECTION("built")
+    {
+        std::vector<uint32_t> user_data(boxes.size());
+        for (uint32_t i = 0; i < boxes.size(); i++)
+        {
+            user_data[i] = i;
+        }
+        bvh.build(boxes, user_data, &leaves);
+    }
+    REQUIRE(bvh.size() == boxes.size());
+    REQUIRE(bvh.validate());
+    // a balanced tree of 2000 leaves has a height of 12
+    REQUIRE(bvh.height() < 40);
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        REQUIRE(bvh.user_data(leaves[i]) == i);
+        REQUIRE(bvh.bounds(leaves[i]) == boxes[i]);
+    }
+
+    // move a third of the boxes, remove a tenth
+    std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+    for (uint32_t i = 0; i < boxes.size(); i += 3)
+    {
+        const glm::vec3 delta(offset(rng), offset(rng), offset(rng));
+        boxes[i] = Aabb{boxes[i].min + delta, boxes[i].max + delta};
+        bvh.refit(leaves[i], boxes[i]);
+    }
+    for (uint32_t i = 0; i < boxes.size(); i += 10)
+    {
+        bvh.remove(leaves[i]);
+        alive[i] = false;
+    }
+    REQUIRE(bvh.size() == boxes.size() - 200);
+    REQUIRE(bvh.validate());
+
+    const std::vector<Aabb> queries = random_boxes(50, rng);
+    for (const Aabb& q : queries)
+    {
+        const Aabb grown{q.min - 10.0f, q.max + 10.0f};
+        REQUIRE(query(bvh, grown) == brute_force(boxes, alive, grown));
+    }
+
+    // rebuilding keeps the leaf ids
+    bvh.rebuild();
+    REQUIRE(bvh.validate());
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        if (alive[i])
+        {
+            REQUIRE(bvh.user_data(leaves[i]) == i);
+        }
+    }
+    for (const Aabb& q : queries)
+    {
+        const Aabb grown{q.min - 10.0f, q.max + 10.0f};
+        REQUIRE(query(bvh, grown) == brute_force(boxes, alive, grown));
+    }
+}
+
+TEST_CASE("Bvh frustum query")
+{
+    // the inner side of the planes is the box [-10, 10]^3
+    const glm::vec4 planes[6] = {{1, 0, 0, 10}, {-1, 0, 0, 10}, {0, 1, 0, 10},
+                                 {0, -1, 0, 10}, {0, 0, 1, 10}, {0, 0, -1, 10}};
+    const Aabb volume{glm::vec3(-10), glm::vec3(10)};
+
+    std::mt19937 rng(5);
+    std::vector<Aabb> boxes = random_boxes(3000, rng);
+    std::vector<bool> alive(boxes.size(), true);
+    Bvh bvh;
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        bvh.insert(boxes[i], i);
+    }
+    std::vector<uint32_t> result;
+    bvh.query(planes, 6, [&result](uint32_t user_data) { result.push_back(user_data); });
+    // axis-aligned planes make the test exact
+    REQUIRE(sorted(result) == brute_force(boxes, alive, volume));
+    REQUIRE(!result.empty());
+}
+
+TEST_CASE("Bvh raycast")
+{
+    Bvh bvh;
+    // a row of unit boxes along x, at x = 0, 2, 4, ...
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        bvh.insert(Aabb{glm::vec3(2.0f * i, 0, 0), glm::vec3(2.0f * i + 1, 1, 1)}, i);
+    }
+    bvh.insert(Aabb{glm::vec3(0, 5, 0), glm::vec3(1, 6, 1)}, 100);
+
+    const glm::vec3 origin(-1.0f, 0.5f, 0.5f);
+    const glm::vec3 direction(1, 0, 0);
+    SECTION("all hits")
+    {
+        std::vector<uint32_t> hits;
+        bvh.raycast(origin, direction, 100.0f, [&hits](uint32_t user_data, float t) {
+            REQUIRE(t == 1.0f + 2.0f * user_data);
+            hits.push_back(user_data);
+            return 100.0f;
+        });
+        REQUIRE(sorted(hits) == std::vector<uint32_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+    }
+    SECTION("closest hit")
+    {
+        uint32_t closest = Bvh::kNull;
+        float closest_t = 100.0f;
+        bvh.raycast(origin, direction, closest_t, [&](uint32_t user_data, float t) {
+            REQUIRE(t <= closest_t);
+            closest = user_data;
+            closest_t = t;
+            return t;
+        });
+        REQUIRE(closest == 0);
+        REQUIRE(closest_t == 1.0f);
+    }
+    SECTION("limited length")
+    {
+        std::vector<uint32_t> hits;
+        bvh.raycast(origin, direction, 4.5f, [&hits](uint32_t user_data, float) {
+            hits.push_back(user_data);
+            return 4.5f;
+        });
+        REQUIRE(sorted(hits) == std::vector<uint32_t>{0, 1});
+    }
+    SECTION("diagonal miss")
+    {
+        bool hit = false;
+        bvh.raycast(glm::vec3(0, 3, 0.5f), glm::normalize(glm::vec3(1, 1, 0)), 100.0f, [&hit](uint32_t, float t) {
+            hit = true;
+            return t;
+        });
+        REQUIRE(!hit);
+    }
+}
+
+TEST_CASE("Bvh traversal stack spills beyond its fixed capacity")
+{
+    detail::TraversalStack<uint32_t, 4> stack;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        stack.push(i);
+    }
+    for (uint32_t i = 10; i-- > 0;)
+    {
+        REQUIRE_FALSE(stack.empty());
+        REQUIRE(stack.pop() == i);
+    }
+    REQUIRE(stack.empty());
+}
+
+TEST_CASE("Bvh queries do not allocate")
+{
+    const glm::vec4 planes[6] = {{1, 0, 0, 10}, {-1, 0, 0, 10}, {0, 1, 0, 10},
+                                 {0, -1, 0, 10}, {0, 0, 1, 10}, {0, 0, -1, 10}};
+    std::mt19937 rng(9);
+    const std::vector<Aabb> boxes = random_boxes(3000, rng);
+    Bvh bvh;
+    for (uint32_t i = 0; i < boxes.size(); i++)
+    {
+        bvh.insert(boxes[i], i);
+    }
+
+    size_t found = 0;
+    const size_t before = allocation_count();
+    bvh.query(Aabb{glm::vec3(-20), glm::vec3(20)}, [&found](uint32_t) { found++; });
+    bvh.query(planes, 6, [&found](uint32_t) { found++; });
+    bvh.raycast(glm::vec3(-100, 0, 0), glm::vec3(1, 0, 0), 200.0f, [&found](uint32_t, float) {
+        found++;
+        return 200.0f;
+    });
+    REQUIRE(allocation_count() == before);
+    REQUIRE(found > 0);
+}
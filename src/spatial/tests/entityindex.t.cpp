@@ -0,0 +1,91 @@
+#include "entityindex.h"
+#include "registry.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+using namespace spatial;
+using namespace components;
+
+static Entity create_triangle(Registry& registry, const glm::vec3& position)
+{
+    CoordSys coord;
+    coord.position() = position;
+    return registry.create(coord, Visual3d::make_triangle());
+}
+
+static std::vector<uint32_t> query(const EntityIndex& index, const Aabb& box)
+{
+    std::vector<uint32_t> result;
+    index.bvh().query(box, [&result](uint32_t entity_index) { result.push_back(entity_index); });
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST_CASE("World bounds of a rotated box")
+{
+    Bounds bounds = {};
+    bounds.min = glm::vec3(-1, -2, -3);
+    bounds.max = glm::vec3(1, 2, 5);
+    CoordSys coord;
+    coord.position() = glm::vec3(10, 0, 0);
+    // a quarter turn around z maps x to y and y to -x
+    coord.rotation() = glm::angleAxis(glm::radians(90.0f), glm::vec3(0, 0, 1));
+    const Aabb box = world_bounds(coord, bounds);
+    const float eps = 1e-5f;
+    REQUIRE(glm::all(glm::lessThan(glm::abs(box.min - glm::vec3(8, -1, -3)), glm::vec3(eps))));
+    REQUIRE(glm::all(glm::lessThan(glm::abs(box.max - glm::vec3(12, 1, 5)), glm::vec3(eps))));
+}
+
+TEST_CASE("Entity index follows the registry")
+{
+    Registry registry;
+    std::vector<Entity> entities;
+    for (int i = 0; i < 100; i++)
+    {
+        entities.push_back(create_triangle(registry, glm::vec3(10.0f * i, 0, 0)));
+    }
+    // not indexed without a Visual3d
+    registry.create(CoordSys());
+
+    EntityIndex index;
+    EntityIndexStats stats = index.sync(registry);
+    REQUIRE(stats.inserted == 100);
+    REQUIRE(index.bvh().size() == 100);
+    REQUIRE(index.bvh().validate());
+    const Aabb around_third{glm::vec3(25, -5, -5), glm::vec3(35, 5, 5)};
+    REQUIRE(query(index, around_third) == std::vector<uint32_t>{entities[3].index()});
+    REQUIRE(index.entity(registry, entities[3].index()) == entities[3]);
+
+    // nothing changed
+    stats = index.sync(registry);
+    REQUIRE(stats.inserted == 0);
+    REQUIRE(stats.refitted == 0);
+    REQUIRE(stats.removed == 0);
+
+    // move entity 50 next to entity 3, remove entity 3, add one more
+    entities[50].get_component<CoordSys>()->position() = glm::vec3(31, 0, 0);
+    registry.destroy(entities[3]);
+    Entity added = create_triangle(registry, glm::vec3(29, 0, 0));
+    stats = index.sync(registry);
+    REQUIRE(stats.refitted == 1);
+    REQUIRE(stats.removed == 1);
+    REQUIRE(stats.inserted == 1);
+    REQUIRE(index.bvh().size() == 100);
+    REQUIRE(index.bvh().validate());
+    std::vector<uint32_t> expected = {entities[50].index(), added.index()};
+    std::sort(expected.begin(), expected.end());
+    REQUIRE(query(index, around_third) == expected);
+    REQUIRE(index.entity(registry, added.index()) == added);
+
+    // losing a component removes the entity from the index
+    entities[50].remove_component<Visual3d>();
+    stats = index.sync(registry);
+    REQUIRE(stats.removed == 1);
+    REQUIRE(query(index, around_third) == std::vector<uint32_t>{added.index()});
+
+    index.rebuild();
+    REQUIRE(index.bvh().validate());
+    REQUIRE(query(index, around_third) == std::vector<uint32_t>{added.index()});
+}